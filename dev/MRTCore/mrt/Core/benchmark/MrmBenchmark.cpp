@@ -0,0 +1,929 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Generates a synthetic PRI file with the mrmex builders and measures how the MRM C API performs against it.
+// Results are written as JSON so runs can be compared over time.
+//
+// Usage: MrmBenchmark.exe [-resources N] [-languages N] [-scales N] [-depth N] [-fanout N]
+//                         [-iterations N] [-batch N] [-threads N] [-pri path] [-out path] [-keep]
+
+#include <Windows.h>
+#include <Psapi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strsafe.h>
+#include "wil/resource.h"
+#include "mrm/BaseInternal.h"
+#include "mrm/build/Base.h"
+#include "mrm/build/MrmBuilders.h"
+
+#include "MRM.h"
+
+using namespace Microsoft::Resources;
+using namespace Microsoft::Resources::Build;
+
+namespace
+{
+
+const UINT32 MaxDepth = 16;
+const UINT32 MaxResourceNameLength = 32 + (MaxDepth * 16);
+
+const PCWSTR LanguageValues[] = {L"en-US", L"fr-FR", L"de-DE", L"ja-JP", L"es-ES", L"it-IT", L"pt-BR", L"zh-CN",
+                                 L"ko-KR", L"ru-RU", L"nl-NL", L"sv-SE", L"pl-PL", L"tr-TR", L"ar-SA", L"he-IL"};
+
+const PCWSTR ScaleValues[] = {L"100", L"125", L"150", L"200", L"400"};
+
+// Sample translations for the string encoding passes, chosen so values end up stored as ASCII, UTF-8 and UTF-16.
+const PCWSTR LocalizedValues[] = {L"Open settings",
+                                  L"Ouvrir les param\u00E8tres",
+                                  L"Einstellungen \u00F6ffnen",
+                                  L"\u8A2D\u5B9A\u3092\u958B\u304F",
+                                  L"Abrir configuraci\u00F3n",
+                                  L"\u041E\u0442\u043A\u0440\u044B\u0442\u044C \u043F\u0430\u0440\u0430\u043C\u0435\u0442\u0440\u044B"};
+
+// The names builder passes use a fixed shape so their timings can be compared across runs regardless of
+// the PRI options.
+const UINT32 NamesBenchmarkItems = 100000;
+const UINT32 NamesBenchmarkDepth = 8;
+
+struct BenchmarkOptions
+{
+    UINT32 numResources;
+    UINT32 numLanguages;
+    UINT32 numScales;
+    UINT32 depth;
+    UINT32 fanout;
+    UINT32 iterations;
+    UINT32 batchSize;
+    UINT32 numThreads;
+    WCHAR priPath[MAX_PATH];
+    PCWSTR outputPath;
+    bool keepPri;
+};
+
+struct BenchmarkResults
+{
+    UINT32 numCandidates;
+    UINT64 priFileSize;
+    double buildMs;
+    double parallelBuildMs;
+    bool parallelBuildIdentical;
+    double dedupeMs;
+    double noDedupeMs;
+    UINT64 dedupePrivateBytes;
+    UINT64 noDedupePrivateBytes;
+    double namesFlatMs;
+    double namesDeepMs;
+    double optimizedStringsMs;
+    double batchedOptimizedStringsMs;
+    double coldLoadMs;
+    double createResourceManagerMs;
+    double singleLookupsPerSecond;
+    double batchedLookupsPerSecond;
+    double decisionHitNs;
+    double decisionMissNs;
+    double threadSameValueNs;
+    double threadSwitchNs;
+    UINT64 workingSetBaseline;
+    UINT64 workingSetLoaded;
+    UINT64 workingSetAfterLookups;
+    UINT64 privateBytesBaseline;
+    UINT64 privateBytesLoaded;
+    UINT64 privateBytesAfterLookups;
+};
+
+class Stopwatch
+{
+public:
+    Stopwatch()
+    {
+        QueryPerformanceFrequency(&m_frequency);
+        Restart();
+    }
+
+    void Restart() { QueryPerformanceCounter(&m_start); }
+
+    double ElapsedMs() const
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return ((now.QuadPart - m_start.QuadPart) * 1000.0) / m_frequency.QuadPart;
+    }
+
+private:
+    LARGE_INTEGER m_frequency;
+    LARGE_INTEGER m_start;
+};
+
+void GetMemoryUsage(_Out_ UINT64* workingSet, _Out_ UINT64* privateBytes)
+{
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    counters.cb = sizeof(counters);
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)))
+    {
+        *workingSet = counters.WorkingSetSize;
+        *privateBytes = counters.PrivateUsage;
+    }
+    else
+    {
+        *workingSet = 0;
+        *privateBytes = 0;
+    }
+}
+
+bool TryParseUInt32(_In_ PCWSTR value, UINT32 minValue, UINT32 maxValue, _Out_ UINT32* result)
+{
+    PWSTR end = nullptr;
+    unsigned long parsed = wcstoul(value, &end, 10);
+    if ((end == value) || (*end != L'\0') || (parsed < minValue) || (parsed > maxValue))
+    {
+        return false;
+    }
+    *result = static_cast<UINT32>(parsed);
+    return true;
+}
+
+HRESULT ParseOptions(int argc, _In_reads_(argc) PWSTR* argv, _Out_ BenchmarkOptions* options)
+{
+    options->numResources = 1000;
+    options->numLanguages = 4;
+    options->numScales = 3;
+    options->depth = 2;
+    options->fanout = 8;
+    options->iterations = 100000;
+    options->batchSize = 32;
+    options->numThreads = 4;
+    options->priPath[0] = L'\0';
+    options->outputPath = nullptr;
+    options->keepPri = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        PCWSTR arg = argv[i];
+        PCWSTR value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool valid = true;
+
+        if (_wcsicmp(arg, L"-keep") == 0)
+        {
+            options->keepPri = true;
+            continue;
+        }
+
+        RETURN_HR_IF(E_INVALIDARG, value == nullptr);
+
+        if (_wcsicmp(arg, L"-resources") == 0)
+        {
+            valid = TryParseUInt32(value, 1, 1000000, &options->numResources);
+        }
+        else if (_wcsicmp(arg, L"-languages") == 0)
+        {
+            valid = TryParseUInt32(value, 1, ARRAYSIZE(LanguageValues), &options->numLanguages);
+        }
+        else if (_wcsicmp(arg, L"-scales") == 0)
+        {
+            valid = TryParseUInt32(value, 0, ARRAYSIZE(ScaleValues), &options->numScales);
+        }
+        else if (_wcsicmp(arg, L"-depth") == 0)
+        {
+            valid = TryParseUInt32(value, 0, MaxDepth, &options->depth);
+        }
+        else if (_wcsicmp(arg, L"-fanout") == 0)
+        {
+            valid = TryParseUInt32(value, 1, 1000, &options->fanout);
+        }
+        else if (_wcsicmp(arg, L"-iterations") == 0)
+        {
+            valid = TryParseUInt32(value, 1, 100000000, &options->iterations);
+        }
+        else if (_wcsicmp(arg, L"-batch") == 0)
+        {
+            valid = TryParseUInt32(value, 1, 4096, &options->batchSize);
+        }
+        else if (_wcsicmp(arg, L"-threads") == 0)
+        {
+            valid = TryParseUInt32(value, 1, MAXIMUM_WAIT_OBJECTS, &options->numThreads);
+        }
+        else if (_wcsicmp(arg, L"-pri") == 0)
+        {
+            valid = SUCCEEDED(StringCchCopyW(options->priPath, ARRAYSIZE(options->priPath), value));
+        }
+        else if (_wcsicmp(arg, L"-out") == 0)
+        {
+            options->outputPath = value;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        RETURN_HR_IF(E_INVALIDARG, !valid);
+        i++;
+    }
+
+    if (options->priPath[0] == L'\0')
+    {
+        WCHAR tempPath[MAX_PATH];
+        DWORD length = GetTempPathW(ARRAYSIZE(tempPath), tempPath);
+        RETURN_LAST_ERROR_IF((length == 0) || (length >= ARRAYSIZE(tempPath)));
+        RETURN_IF_FAILED(StringCchPrintfW(
+            options->priPath, ARRAYSIZE(options->priPath), L"%sMrmBenchmark-%u.pri", tempPath, GetCurrentProcessId()));
+    }
+
+    return S_OK;
+}
+
+// Resource names nest "depth" levels deep below the resources subtree, with "fanout" children per level,
+// so that deeper trees exercise more of the hierarchical name lookup.
+HRESULT FormatResourceName(_In_ const BenchmarkOptions& options, UINT32 index, _Out_writes_(cchName) PWSTR name, size_t cchName)
+{
+    RETURN_IF_FAILED(StringCchCopyW(name, cchName, L"resources/"));
+
+    UINT32 group = index;
+    for (UINT32 level = 0; level < options.depth; level++)
+    {
+        size_t used = wcslen(name);
+        RETURN_IF_FAILED(StringCchPrintfW(name + used, cchName - used, L"Group%u_%u/", level, group % options.fanout));
+        group /= options.fanout;
+    }
+
+    size_t used = wcslen(name);
+    return StringCchPrintfW(name + used, cchName - used, L"String%u", index);
+}
+
+// Every resource gets one candidate per language and scale combination, so the number of candidates in
+// each decision grows with the size of the qualifier space.
+HRESULT BuildPriFile(
+    _In_ const BenchmarkOptions& options,
+    bool parallel,
+    _In_ PCWSTR priPath,
+    _Out_ UINT32* numCandidates,
+    _Out_ double* buildMs)
+{
+    Stopwatch timer;
+
+    AutoDeletePtr<CoreProfile> profile;
+    RETURN_IF_FAILED(CoreProfile::ChooseDefaultProfile(&profile));
+
+    AutoDeletePtr<PriFileBuilder> priBuilder;
+    RETURN_IF_FAILED(PriFileBuilder::CreateInstance(L"MrmBenchmark", profile, &priBuilder));
+    priBuilder->SetParallelBuild(parallel);
+
+    PriSectionBuilder* priSection = priBuilder->GetDescriptor();
+    AutoDeletePtr<DecisionInfoQualifierSetBuilder> qualifierSet;
+    RETURN_IF_FAILED(priSection->GetQualifierSetBuilder(&qualifierSet));
+
+    UINT32 numScales = (options.numScales > 0) ? options.numScales : 1;
+    WCHAR name[MaxResourceNameLength];
+    WCHAR value[MaxResourceNameLength + 32];
+
+    *numCandidates = 0;
+    for (UINT32 i = 0; i < options.numResources; i++)
+    {
+        RETURN_IF_FAILED(FormatResourceName(options, i, name, ARRAYSIZE(name)));
+
+        for (UINT32 language = 0; language < options.numLanguages; language++)
+        {
+            for (UINT32 scale = 0; scale < numScales; scale++)
+            {
+                // The first language and scale are the defaults used when nothing in the context matches.
+                double fallbackScore = ((language == 0) && (scale == 0)) ? 1.0 : 0.0;
+
+                qualifierSet->Reset();
+                RETURN_IF_FAILED(qualifierSet->AddQualifier(L"Language", LanguageValues[language], fallbackScore));
+                if (options.numScales > 0)
+                {
+                    RETURN_IF_FAILED(qualifierSet->AddQualifier(L"Scale", ScaleValues[scale], fallbackScore));
+                }
+
+                RETURN_IF_FAILED(StringCchPrintfW(
+                    value, ARRAYSIZE(value), L"String%u %s %s", i, LanguageValues[language], ScaleValues[scale]));
+                RETURN_IF_FAILED(priSection->AddCandidateWithString(
+                    nullptr, name, MrmEnvironment::ResourceValueType_Utf16String, value, qualifierSet));
+                (*numCandidates)++;
+            }
+        }
+    }
+
+    RETURN_IF_FAILED(priBuilder->WriteToFile(priPath));
+    *buildMs = timer.ElapsedMs();
+
+    return S_OK;
+}
+
+HRESULT ReadWholeFile(_In_ PCWSTR path, _Inout_ unique_deffree_ptr<BYTE>& contents, _Out_ UINT32* size)
+{
+    wil::unique_hfile file(CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+    RETURN_LAST_ERROR_IF(!file);
+
+    LARGE_INTEGER fileSize;
+    RETURN_IF_WIN32_BOOL_FALSE(GetFileSizeEx(file.get(), &fileSize));
+    RETURN_HR_IF(E_OUTOFMEMORY, (fileSize.QuadPart <= 0) || (fileSize.QuadPart > MAXDWORD));
+
+    contents.reset(_DefArray_Alloc(BYTE, static_cast<size_t>(fileSize.QuadPart)));
+    RETURN_IF_NULL_ALLOC(contents.get());
+
+    DWORD bytesRead = 0;
+    RETURN_IF_WIN32_BOOL_FALSE(ReadFile(file.get(), contents.get(), static_cast<DWORD>(fileSize.QuadPart), &bytesRead, nullptr));
+    RETURN_HR_IF(E_FAIL, bytesRead != static_cast<DWORD>(fileSize.QuadPart));
+
+    *size = bytesRead;
+    return S_OK;
+}
+
+// Builds the PRI file serially, which is the file the rest of the benchmark loads, and then builds it again
+// with sections generated in parallel so the two build times can be compared. Both builds must produce the
+// same bytes.
+HRESULT GeneratePriFile(_In_ const BenchmarkOptions& options, _Out_ BenchmarkResults* results)
+{
+    RETURN_IF_FAILED(BuildPriFile(options, false, options.priPath, &results->numCandidates, &results->buildMs));
+
+    WCHAR parallelPriPath[MAX_PATH];
+    RETURN_IF_FAILED(StringCchPrintfW(parallelPriPath, ARRAYSIZE(parallelPriPath), L"%s.parallel", options.priPath));
+    auto deleteParallelPri = wil::scope_exit([&] { DeleteFileW(parallelPriPath); });
+
+    UINT32 numParallelCandidates;
+    RETURN_IF_FAILED(BuildPriFile(options, true, parallelPriPath, &numParallelCandidates, &results->parallelBuildMs));
+
+    unique_deffree_ptr<BYTE> serialContents;
+    unique_deffree_ptr<BYTE> parallelContents;
+    UINT32 serialSize;
+    UINT32 parallelSize;
+    RETURN_IF_FAILED(ReadWholeFile(options.priPath, serialContents, &serialSize));
+    RETURN_IF_FAILED(ReadWholeFile(parallelPriPath, parallelContents, &parallelSize));
+
+    results->priFileSize = serialSize;
+    results->parallelBuildIdentical =
+        (serialSize == parallelSize) && (memcmp(serialContents.get(), parallelContents.get(), serialSize) == 0);
+
+    return S_OK;
+}
+
+// Adds localized values straight to a data item orchestrator. Every other resource is left untranslated,
+// so its value is repeated for each language the way it is in a partially localized project.
+HRESULT MeasureDeduplicationPass(
+    _In_ const BenchmarkOptions& options,
+    bool deduplicate,
+    _Out_ double* elapsedMs,
+    _Out_ UINT64* privateBytes)
+{
+    AutoDeletePtr<CoreProfile> profile;
+    RETURN_IF_FAILED(CoreProfile::ChooseDefaultProfile(&profile));
+
+    AutoDeletePtr<PriFileBuilder> priBuilder;
+    RETURN_IF_FAILED(PriFileBuilder::CreateInstance(L"MrmBenchmark", profile, &priBuilder));
+
+    DataItemOrchestrator* dataItems = priBuilder->GetDescriptor()->GetDataItemOrchestrator();
+    UINT32 numItems = options.numResources * options.numLanguages;
+
+    // The orchestrator doesn't own the references it hands out, so they are kept until the pass is measured.
+    unique_deffree_ptr<IBuildInstanceReference*> references(_DefArray_AllocZeroed(IBuildInstanceReference*, numItems));
+    RETURN_IF_NULL_ALLOC(references.get());
+    auto deleteReferences = wil::scope_exit([&] {
+        for (UINT32 i = 0; i < numItems; i++)
+        {
+            delete references.get()[i];
+        }
+    });
+
+    UINT64 workingSetBefore;
+    UINT64 privateBytesBefore;
+    GetMemoryUsage(&workingSetBefore, &privateBytesBefore);
+
+    Stopwatch timer;
+    if (deduplicate)
+    {
+        RETURN_IF_FAILED(dataItems->ReserveDeduplicationCapacity(numItems));
+    }
+    else
+    {
+        dataItems->DisableDeduplication();
+    }
+
+    WCHAR value[64];
+    for (UINT32 i = 0; i < options.numResources; i++)
+    {
+        for (UINT32 language = 0; language < options.numLanguages; language++)
+        {
+            UINT32 valueLanguage = ((i % 2) == 0) ? 0 : language;
+            RETURN_IF_FAILED(StringCchPrintfW(value, ARRAYSIZE(value), L"String%u %s", i, LanguageValues[valueLanguage]));
+            RETURN_IF_FAILED(dataItems->AddStringAndCreateInstanceReference(
+                value, static_cast<int>(language), &references.get()[(i * options.numLanguages) + language]));
+        }
+    }
+    *elapsedMs = timer.ElapsedMs();
+
+    UINT64 workingSetAfter;
+    UINT64 privateBytesAfter;
+    GetMemoryUsage(&workingSetAfter, &privateBytesAfter);
+    *privateBytes = (privateBytesAfter > privateBytesBefore) ? (privateBytesAfter - privateBytesBefore) : 0;
+
+    return S_OK;
+}
+
+HRESULT MeasureDeduplication(_In_ const BenchmarkOptions& options, _Out_ BenchmarkResults* results)
+{
+    RETURN_IF_FAILED(MeasureDeduplicationPass(options, true, &results->dedupeMs, &results->dedupePrivateBytes));
+    RETURN_IF_FAILED(MeasureDeduplicationPass(options, false, &results->noDedupeMs, &results->noDedupePrivateBytes));
+    return S_OK;
+}
+
+// Adds names straight to a hierarchical names builder and generates the section. The flat pass puts every
+// item in one scope; the deep pass spreads them over NamesBenchmarkDepth levels of four-way nested scopes.
+HRESULT MeasureNamesBuildPass(bool deep, _Out_ double* elapsedMs)
+{
+    AutoDeletePtr<HierarchicalNamesBuilder> names;
+    RETURN_IF_FAILED(HierarchicalNamesBuilder::CreateInstance(HierarchicalNamesBuilder::BuildAsciiOrUtf16, &names));
+
+    Stopwatch timer;
+    WCHAR name[MaxResourceNameLength];
+    for (UINT32 i = 0; i < NamesBenchmarkItems; i++)
+    {
+        // Step through the items with a stride coprime to the count so names don't arrive in sorted order.
+        UINT32 index = static_cast<UINT32>((static_cast<UINT64>(i) * 7919) % NamesBenchmarkItems);
+
+        if (deep)
+        {
+            RETURN_IF_FAILED(StringCchCopyW(name, ARRAYSIZE(name), L"Deep"));
+            for (UINT32 level = 0; level < NamesBenchmarkDepth; level++)
+            {
+                WCHAR segment[16];
+                RETURN_IF_FAILED(StringCchPrintfW(segment, ARRAYSIZE(segment), L"/Level%u", (index >> (level * 2)) & 3));
+                RETURN_IF_FAILED(StringCchCatW(name, ARRAYSIZE(name), segment));
+            }
+
+            WCHAR leaf[32];
+            RETURN_IF_FAILED(StringCchPrintfW(leaf, ARRAYSIZE(leaf), L"/Item%u", index));
+            RETURN_IF_FAILED(StringCchCatW(name, ARRAYSIZE(name), leaf));
+        }
+        else
+        {
+            RETURN_IF_FAILED(StringCchPrintfW(name, ARRAYSIZE(name), L"Flat/Item%u", index));
+        }
+
+        ItemInfo* item;
+        RETURN_IF_FAILED(names->GetOrAddItem(name, &item));
+    }
+
+    RETURN_IF_FAILED(names->Finalize());
+
+    UINT32 cbNames = names->GetMaxSizeInBytes();
+    unique_deffree_ptr<BYTE> buffer(_DefArray_AllocZeroed(BYTE, cbNames));
+    RETURN_IF_NULL_ALLOC(buffer.get());
+    RETURN_IF_FAILED(names->Build(buffer.get(), cbNames, nullptr));
+    *elapsedMs = timer.ElapsedMs();
+
+    return S_OK;
+}
+
+HRESULT MeasureNamesBuild(_Out_ BenchmarkResults* results)
+{
+    RETURN_IF_FAILED(MeasureNamesBuildPass(false, &results->namesFlatMs));
+    RETURN_IF_FAILED(MeasureNamesBuildPass(true, &results->namesDeepMs));
+    return S_OK;
+}
+
+// Adds localized values to a data item orchestrator with optimal payload encoding, either one at a time
+// or as a single batch the way PriSectionBuilder adds its queued strings.
+HRESULT MeasureOptimizedStringsPass(_In_ const BenchmarkOptions& options, bool batched, _Out_ double* elapsedMs)
+{
+    AutoDeletePtr<CoreProfile> profile;
+    RETURN_IF_FAILED(CoreProfile::ChooseDefaultProfile(&profile));
+
+    AutoDeletePtr<PriFileBuilder> priBuilder;
+    RETURN_IF_FAILED(PriFileBuilder::CreateInstance(L"MrmBenchmark", profile, &priBuilder));
+
+    DataItemOrchestrator* dataItems = priBuilder->GetDescriptor()->GetDataItemOrchestrator();
+    UINT32 numItems = options.numResources * options.numLanguages;
+
+    // The values are formatted up front so that only the orchestrator is timed.
+    const UINT32 cchValue = 64;
+    unique_deffree_ptr<WCHAR> values(_DefArray_AllocZeroed(WCHAR, numItems * cchValue));
+    unique_deffree_ptr<DataItemOrchestrator::OptimizedString> strings(
+        _DefArray_AllocZeroed(DataItemOrchestrator::OptimizedString, numItems));
+    RETURN_IF_NULL_ALLOC(values.get());
+    RETURN_IF_NULL_ALLOC(strings.get());
+    auto deleteReferences = wil::scope_exit([&] {
+        for (UINT32 i = 0; i < numItems; i++)
+        {
+            delete strings.get()[i].result;
+        }
+    });
+
+    for (UINT32 i = 0; i < options.numResources; i++)
+    {
+        for (UINT32 language = 0; language < options.numLanguages; language++)
+        {
+            UINT32 index = (i * options.numLanguages) + language;
+            PWSTR value = &values.get()[index * cchValue];
+            PCWSTR localizedValue = LocalizedValues[language % ARRAYSIZE(LocalizedValues)];
+            RETURN_IF_FAILED(StringCchPrintfW(value, cchValue, L"%s %u", localizedValue, i));
+
+            strings.get()[index].originalType = MrmEnvironment::ResourceValueType_Utf16String;
+            strings.get()[index].value = value;
+            strings.get()[index].qualifierSetIndex = static_cast<int>(language);
+        }
+    }
+
+    RETURN_IF_FAILED(dataItems->ReserveDeduplicationCapacity(numItems));
+
+    Stopwatch timer;
+    if (batched)
+    {
+        RETURN_IF_FAILED(dataItems->AddOptimizedStringsAndCreateInstanceReferences(numItems, strings.get()));
+    }
+    else
+    {
+        for (UINT32 i = 0; i < numItems; i++)
+        {
+            DataItemOrchestrator::OptimizedString* pString = &strings.get()[i];
+            RETURN_IF_FAILED(dataItems->AddOptimizedStringAndCreateInstanceReference(
+                pString->originalType, pString->value, pString->qualifierSetIndex, &pString->result, &pString->optimalType));
+        }
+    }
+    *elapsedMs = timer.ElapsedMs();
+
+    return S_OK;
+}
+
+HRESULT MeasureOptimizedStrings(_In_ const BenchmarkOptions& options, _Out_ BenchmarkResults* results)
+{
+    RETURN_IF_FAILED(MeasureOptimizedStringsPass(options, false, &results->optimizedStringsMs));
+    RETURN_IF_FAILED(MeasureOptimizedStringsPass(options, true, &results->batchedOptimizedStringsMs));
+    return S_OK;
+}
+
+class ResourceNames
+{
+public:
+    ResourceNames() : m_names(nullptr), m_pointers(nullptr), m_count(0) {}
+
+    ~ResourceNames()
+    {
+        _DefFree(m_names);
+        _DefFree(m_pointers);
+    }
+
+    HRESULT Init(_In_ const BenchmarkOptions& options)
+    {
+        m_names = _DefArray_Alloc(WCHAR, static_cast<size_t>(options.numResources) * MaxResourceNameLength);
+        RETURN_IF_NULL_ALLOC(m_names);
+        m_pointers = _DefArray_Alloc(PCWSTR, options.numResources);
+        RETURN_IF_NULL_ALLOC(m_pointers);
+
+        for (UINT32 i = 0; i < options.numResources; i++)
+        {
+            PWSTR name = m_names + (static_cast<size_t>(i) * MaxResourceNameLength);
+            RETURN_IF_FAILED(FormatResourceName(options, i, name, MaxResourceNameLength));
+            m_pointers[i] = name;
+        }
+        m_count = options.numResources;
+        return S_OK;
+    }
+
+    // Steps through the names with a stride that is coprime to the count so consecutive lookups don't
+    // share a subtree.
+    UINT32 GetLookupIndex(UINT32 iteration) const { return static_cast<UINT32>((static_cast<UINT64>(iteration) * 7919) % m_count); }
+
+    PCWSTR Get(UINT32 index) const { return m_pointers[index]; }
+
+    const PCWSTR* GetArray(UINT32 first) const { return m_pointers + first; }
+
+    UINT32 Count() const { return m_count; }
+
+private:
+    PWSTR m_names;
+    PCWSTR* m_pointers;
+    UINT32 m_count;
+};
+
+HRESULT MeasureResourceManagerCreation(_In_ const BenchmarkOptions& options, _Out_ BenchmarkResults* results)
+{
+    MrmManagerHandle manager = nullptr;
+    Stopwatch timer;
+
+    // The first load pays for opening and mapping the newly written file and for any one-time
+    // initialization in the runtime.
+    RETURN_IF_FAILED(MrmCreateResourceManager(options.priPath, &manager));
+    results->coldLoadMs = timer.ElapsedMs();
+    MrmDestroyResourceManager(manager);
+
+    const UINT32 createIterations = 20;
+    timer.Restart();
+    for (UINT32 i = 0; i < createIterations; i++)
+    {
+        RETURN_IF_FAILED(MrmCreateResourceManager(options.priPath, &manager));
+        MrmDestroyResourceManager(manager);
+    }
+    results->createResourceManagerMs = timer.ElapsedMs() / createIterations;
+
+    return S_OK;
+}
+
+HRESULT MeasureLookups(
+    _In_ const BenchmarkOptions& options,
+    _In_ const ResourceNames& names,
+    MrmManagerHandle manager,
+    MrmContextHandle context,
+    _Out_ BenchmarkResults* results)
+{
+    Stopwatch timer;
+    for (UINT32 i = 0; i < options.iterations; i++)
+    {
+        PWSTR resourceString = nullptr;
+        RETURN_IF_FAILED(MrmLoadStringResource(manager, context, nullptr, names.Get(names.GetLookupIndex(i)), &resourceString));
+        MrmFreeResource(resourceString);
+    }
+    results->singleLookupsPerSecond = (options.iterations * 1000.0) / timer.ElapsedMs();
+
+    UINT32 batchSize = (options.batchSize < names.Count()) ? options.batchSize : names.Count();
+    UINT32 numBatches = (options.iterations + batchSize - 1) / batchSize;
+    timer.Restart();
+    for (UINT32 i = 0; i < numBatches; i++)
+    {
+        UINT32 first = static_cast<UINT32>((static_cast<UINT64>(i) * batchSize) % (names.Count() - batchSize + 1));
+        PWSTR* resourceStrings = nullptr;
+        RETURN_IF_FAILED(MrmLoadStringResources(manager, context, nullptr, batchSize, names.GetArray(first), &resourceStrings));
+        MrmFreeResource(resourceStrings);
+    }
+    results->batchedLookupsPerSecond = (static_cast<double>(numBatches) * batchSize * 1000.0) / timer.ElapsedMs();
+
+    return S_OK;
+}
+
+// A hit looks up the same resource repeatedly in an unchanged context, so every evaluation of its decision
+// after the first is served from the cache. A miss changes the context language before every lookup, which
+// invalidates cached evaluations; the cost of changing the qualifier alone is measured separately and
+// subtracted.
+HRESULT MeasureDecisionLatency(
+    _In_ const BenchmarkOptions& options,
+    _In_ const ResourceNames& names,
+    MrmManagerHandle manager,
+    MrmContextHandle context,
+    _Out_ BenchmarkResults* results)
+{
+    PCWSTR resourceId = names.Get(0);
+    PCWSTR languages[2] = {LanguageValues[0], LanguageValues[(options.numLanguages > 1) ? 1 : 0]};
+
+    RETURN_IF_FAILED(MrmSetQualifier(context, L"Language", languages[0]));
+
+    Stopwatch timer;
+    for (UINT32 i = 0; i < options.iterations; i++)
+    {
+        PWSTR resourceString = nullptr;
+        RETURN_IF_FAILED(MrmLoadStringResource(manager, context, nullptr, resourceId, &resourceString));
+        MrmFreeResource(resourceString);
+    }
+    results->decisionHitNs = (timer.ElapsedMs() * 1000000.0) / options.iterations;
+
+    timer.Restart();
+    for (UINT32 i = 0; i < options.iterations; i++)
+    {
+        RETURN_IF_FAILED(MrmSetQualifier(context, L"Language", languages[i & 1]));
+    }
+    double setQualifierMs = timer.ElapsedMs();
+
+    timer.Restart();
+    for (UINT32 i = 0; i < options.iterations; i++)
+    {
+        PWSTR resourceString = nullptr;
+        RETURN_IF_FAILED(MrmSetQualifier(context, L"Language", languages[i & 1]));
+        RETURN_IF_FAILED(MrmLoadStringResource(manager, context, nullptr, resourceId, &resourceString));
+        MrmFreeResource(resourceString);
+    }
+    double missMs = timer.ElapsedMs() - setQualifierMs;
+    results->decisionMissNs = ((missMs > 0.0) ? missMs : 0.0) * 1000000.0 / options.iterations;
+
+    return S_OK;
+}
+
+struct ContextThread
+{
+    MrmManagerHandle manager;
+    MrmContextHandle context;
+    PCWSTR resourceId;
+    PCWSTR languages[2];
+    UINT32 iterations;
+    HRESULT hr;
+};
+
+DWORD WINAPI RunContextThread(_In_ LPVOID parameter)
+{
+    ContextThread* thread = static_cast<ContextThread*>(parameter);
+    thread->hr = S_OK;
+    for (UINT32 i = 0; SUCCEEDED(thread->hr) && (i < thread->iterations); i++)
+    {
+        thread->hr = MrmSetQualifier(thread->context, L"Language", thread->languages[i & 1]);
+        if (SUCCEEDED(thread->hr))
+        {
+            PWSTR resourceString = nullptr;
+            thread->hr = MrmLoadStringResource(thread->manager, thread->context, nullptr, thread->resourceId, &resourceString);
+            MrmFreeResource(resourceString);
+        }
+    }
+    return 0;
+}
+
+// Runs one thread per context, each with a different language, and reports the wall time per lookup.
+// When the threads only ever set the language their context already has, lookups should stay as cheap as
+// cache hits; when each thread alternates between two languages, every lookup follows a real change.
+HRESULT RunContextThreads(
+    _In_ const BenchmarkOptions& options,
+    _In_ const ResourceNames& names,
+    MrmManagerHandle manager,
+    bool switchLanguages,
+    _Out_ double* nsPerLookup)
+{
+    *nsPerLookup = 0.0;
+
+    ContextThread threads[MAXIMUM_WAIT_OBJECTS] = {};
+    HANDLE handles[MAXIMUM_WAIT_OBJECTS] = {};
+    UINT32 iterationsPerThread = (options.iterations + options.numThreads - 1) / options.numThreads;
+
+    auto cleanup = wil::scope_exit([&] {
+        for (UINT32 i = 0; i < options.numThreads; i++)
+        {
+            if (handles[i] != nullptr)
+            {
+                CloseHandle(handles[i]);
+            }
+            if (threads[i].context != nullptr)
+            {
+                MrmDestroyResourceContext(threads[i].context);
+            }
+        }
+    });
+
+    for (UINT32 i = 0; i < options.numThreads; i++)
+    {
+        ContextThread* thread = &threads[i];
+        thread->manager = manager;
+        thread->resourceId = names.Get(i % names.Count());
+        thread->languages[0] = LanguageValues[i % options.numLanguages];
+        thread->languages[1] = switchLanguages ? LanguageValues[(i + 1) % options.numLanguages] : thread->languages[0];
+        thread->iterations = iterationsPerThread;
+        RETURN_IF_FAILED(MrmCreateResourceContext(manager, &thread->context));
+    }
+
+    Stopwatch timer;
+    for (UINT32 i = 0; i < options.numThreads; i++)
+    {
+        handles[i] = CreateThread(nullptr, 0, RunContextThread, &threads[i], 0, nullptr);
+        RETURN_LAST_ERROR_IF_NULL(handles[i]);
+    }
+    RETURN_LAST_ERROR_IF(WaitForMultipleObjects(options.numThreads, handles, TRUE, INFINITE) == WAIT_FAILED);
+    double elapsedMs = timer.ElapsedMs();
+
+    for (UINT32 i = 0; i < options.numThreads; i++)
+    {
+        RETURN_IF_FAILED(threads[i].hr);
+    }
+
+    *nsPerLookup = (elapsedMs * 1000000.0) / (static_cast<double>(iterationsPerThread) * options.numThreads);
+    return S_OK;
+}
+
+HRESULT MeasureThreadContexts(
+    _In_ const BenchmarkOptions& options,
+    _In_ const ResourceNames& names,
+    MrmManagerHandle manager,
+    _Out_ BenchmarkResults* results)
+{
+    RETURN_IF_FAILED(RunContextThreads(options, names, manager, false, &results->threadSameValueNs));
+    RETURN_IF_FAILED(RunContextThreads(options, names, manager, true, &results->threadSwitchNs));
+    return S_OK;
+}
+
+HRESULT RunBenchmarks(_In_ const BenchmarkOptions& options, _Out_ BenchmarkResults* results)
+{
+    ZeroMemory(results, sizeof(*results));
+
+    RETURN_IF_FAILED(GeneratePriFile(options, results));
+    RETURN_IF_FAILED(MeasureDeduplication(options, results));
+    RETURN_IF_FAILED(MeasureNamesBuild(results));
+    RETURN_IF_FAILED(MeasureOptimizedStrings(options, results));
+
+    ResourceNames names;
+    RETURN_IF_FAILED(names.Init(options));
+
+    RETURN_IF_FAILED(MeasureResourceManagerCreation(options, results));
+
+    GetMemoryUsage(&results->workingSetBaseline, &results->privateBytesBaseline);
+
+    MrmManagerHandle manager = nullptr;
+    RETURN_IF_FAILED(MrmCreateResourceManager(options.priPath, &manager));
+    auto destroyManager = wil::scope_exit([&] { MrmDestroyResourceManager(manager); });
+
+    MrmContextHandle context = nullptr;
+    RETURN_IF_FAILED(MrmCreateResourceContext(manager, &context));
+    auto destroyContext = wil::scope_exit([&] { MrmDestroyResourceContext(context); });
+
+    GetMemoryUsage(&results->workingSetLoaded, &results->privateBytesLoaded);
+
+    RETURN_IF_FAILED(MeasureLookups(options, names, manager, context, results));
+    RETURN_IF_FAILED(MeasureDecisionLatency(options, names, manager, context, results));
+    RETURN_IF_FAILED(MeasureThreadContexts(options, names, manager, results));
+
+    GetMemoryUsage(&results->workingSetAfterLookups, &results->privateBytesAfterLookups);
+
+    return S_OK;
+}
+
+void WriteResults(_In_ FILE* out, _In_ const BenchmarkOptions& options, _In_ const BenchmarkResults& results)
+{
+    fprintf(out, "{\n");
+    fprintf(out, "  \"config\": {\n");
+    fprintf(out, "    \"resources\": %u,\n", options.numResources);
+    fprintf(out, "    \"languages\": %u,\n", options.numLanguages);
+    fprintf(out, "    \"scales\": %u,\n", options.numScales);
+    fprintf(out, "    \"depth\": %u,\n", options.depth);
+    fprintf(out, "    \"fanout\": %u,\n", options.fanout);
+    fprintf(out, "    \"iterations\": %u,\n", options.iterations);
+    fprintf(out, "    \"batchSize\": %u,\n", options.batchSize);
+    fprintf(out, "    \"threads\": %u,\n", options.numThreads);
+    fprintf(out, "    \"candidates\": %u\n", results.numCandidates);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"build\": {\n");
+    fprintf(out, "    \"timeMs\": %.3f,\n", results.buildMs);
+    fprintf(out, "    \"parallelTimeMs\": %.3f,\n", results.parallelBuildMs);
+    fprintf(out, "    \"parallelIdentical\": %s,\n", results.parallelBuildIdentical ? "true" : "false");
+    fprintf(out, "    \"dedupeMs\": %.3f,\n", results.dedupeMs);
+    fprintf(out, "    \"noDedupeMs\": %.3f,\n", results.noDedupeMs);
+    fprintf(out, "    \"dedupePrivateBytes\": %llu,\n", results.dedupePrivateBytes);
+    fprintf(out, "    \"noDedupePrivateBytes\": %llu,\n", results.noDedupePrivateBytes);
+    fprintf(out, "    \"namesItems\": %u,\n", NamesBenchmarkItems);
+    fprintf(out, "    \"namesFlatMs\": %.3f,\n", results.namesFlatMs);
+    fprintf(out, "    \"namesDeepMs\": %.3f,\n", results.namesDeepMs);
+    fprintf(out, "    \"optimizedStringsMs\": %.3f,\n", results.optimizedStringsMs);
+    fprintf(out, "    \"batchedOptimizedStringsMs\": %.3f,\n", results.batchedOptimizedStringsMs);
+    fprintf(out, "    \"priFileBytes\": %llu\n", results.priFileSize);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"load\": {\n");
+    fprintf(out, "    \"coldLoadMs\": %.3f,\n", results.coldLoadMs);
+    fprintf(out, "    \"createResourceManagerMs\": %.3f\n", results.createResourceManagerMs);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"lookup\": {\n");
+    fprintf(out, "    \"singlePerSecond\": %.1f,\n", results.singleLookupsPerSecond);
+    fprintf(out, "    \"batchedPerSecond\": %.1f,\n", results.batchedLookupsPerSecond);
+    fprintf(out, "    \"decisionHitNs\": %.1f,\n", results.decisionHitNs);
+    fprintf(out, "    \"decisionMissNs\": %.1f,\n", results.decisionMissNs);
+    fprintf(out, "    \"threadSameValueNs\": %.1f,\n", results.threadSameValueNs);
+    fprintf(out, "    \"threadSwitchNs\": %.1f\n", results.threadSwitchNs);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"memory\": {\n");
+    fprintf(out, "    \"workingSetBaselineBytes\": %llu,\n", results.workingSetBaseline);
+    fprintf(out, "    \"workingSetLoadedBytes\": %llu,\n", results.workingSetLoaded);
+    fprintf(out, "    \"workingSetAfterLookupsBytes\": %llu,\n", results.workingSetAfterLookups);
+    fprintf(out, "    \"privateBytesBaseline\": %llu,\n", results.privateBytesBaseline);
+    fprintf(out, "    \"privateBytesLoaded\": %llu,\n", results.privateBytesLoaded);
+    fprintf(out, "    \"privateBytesAfterLookups\": %llu\n", results.privateBytesAfterLookups);
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n");
+}
+
+} // namespace
+
+int __cdecl wmain(int argc, _In_reads_(argc) PWSTR* argv)
+{
+    BenchmarkOptions options;
+    HRESULT hr = ParseOptions(argc, argv, &options);
+    if (FAILED(hr))
+    {
+        fwprintf(
+            stderr,
+            L"Usage: MrmBenchmark.exe [-resources N] [-languages N] [-scales N] [-depth N] [-fanout N]\n"
+            L"                        [-iterations N] [-batch N] [-threads N] [-pri path] [-out path] [-keep]\n");
+        return 1;
+    }
+
+    BenchmarkResults results;
+    hr = RunBenchmarks(options, &results);
+
+    if (!options.keepPri)
+    {
+        DeleteFileW(options.priPath);
+    }
+
+    if (FAILED(hr))
+    {
+        fwprintf(stderr, L"Benchmark failed (0x%08x)\n", hr);
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (options.outputPath != nullptr)
+    {
+        if (_wfopen_s(&out, options.outputPath, L"w") != 0)
+        {
+            fwprintf(stderr, L"Unable to open %s\n", options.outputPath);
+            return 1;
+        }
+    }
+
+    WriteResults(out, options, results);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
@@ -25,6 +25,8 @@ typedef struct
     UnifiedResourceView* unifiedView = nullptr;
     const PriFile* priFile = nullptr;
     ProviderResolver* resolver = nullptr;
+    CandidateStringCache* stringCache = nullptr;
+    ResourceNameCache* nameCache = nullptr;
 } MrmObjects;
 
 constexpr wchar_t ResourceUriPrefix[] = L"ms-resource://";
@@ -109,10 +111,10 @@ static HRESULT GetQualifierInfoFromCandidateImpl(
             continue;
         }
 
-        StringResult name;
+        InlineStringResult name;
         RETURN_IF_FAILED(resourceManager->unifiedView->GetUnifiedEnvironment()->GetQualifierNameFromAtom(nameAtom, &name));
 
-        StringResult value;
+        InlineStringResult value;
         bool isLiteral;
         if (SUCCEEDED(qualifierResult.Operand2IsLiteral(&isLiteral)) && isLiteral)
         {
@@ -152,6 +154,204 @@ static HRESULT GetQualifierInfoFromCandidate(
     return hr;
 }
 
+static ProviderResolver* GetResolver(_In_ MrmObjects* resourceManagerObjects, _In_opt_ void* resourceContext)
+{
+    if (resourceContext == nullptr)
+    {
+        return resourceManagerObjects->resolver;
+    }
+
+    return reinterpret_cast<ProviderResolver*>(resourceContext);
+}
+
+static HRESULT GetResourceMapSubtree(
+    _In_ MrmObjects* resourceManagerObjects,
+    _In_opt_ void* resourceMap,
+    _Outptr_ const ResourceMapSubtree** internalResourceMap)
+{
+    if (resourceMap == nullptr)
+    {
+        // The primary resource map is the default.
+        const IResourceMapBase* primaryMap;
+        RETURN_IF_FAILED(resourceManagerObjects->priFile->GetPrimaryResourceMap(&primaryMap));
+        *internalResourceMap = primaryMap->GetRootSubtree();
+    }
+    else
+    {
+        // Use the supplied resource map.
+        *internalResourceMap = reinterpret_cast<ResourceMapSubtree*>(resourceMap);
+    }
+
+    return S_OK;
+}
+
+// Remembers which candidate each decision selected during a single batch call, so that resources sharing
+// a decision (typically every string localized into the same set of languages) are only evaluated once.
+class BatchDecisionCache
+{
+public:
+    static const int NotEvaluated = -1;
+    static const int NoMatch = -2;
+
+    ~BatchDecisionCache() { delete[] m_results; }
+
+    int Get(_In_ const IDecision* decision) const
+    {
+        int index = decision->GetIndex();
+        if ((decision->GetPool() != m_pool) || (index < 0) || (index >= m_numDecisions))
+        {
+            return NotEvaluated;
+        }
+        return m_results[index];
+    }
+
+    void Set(_In_ const IDecision* decision, int result)
+    {
+        if (m_pool == nullptr)
+        {
+            // Sized on first use. Decisions from any other pool simply aren't cached.
+            const IDecisionInfo* pool = decision->GetPool();
+            int numDecisions = (pool != nullptr) ? pool->GetNumDecisions() : 0;
+            m_results = (numDecisions > 0) ? new (std::nothrow) int[numDecisions] : nullptr;
+            if (m_results == nullptr)
+            {
+                return;
+            }
+
+            for (int i = 0; i < numDecisions; i++)
+            {
+                m_results[i] = NotEvaluated;
+            }
+            m_pool = pool;
+            m_numDecisions = numDecisions;
+        }
+
+        int index = decision->GetIndex();
+        if ((decision->GetPool() == m_pool) && (index >= 0) && (index < m_numDecisions))
+        {
+            m_results[index] = result;
+        }
+    }
+
+private:
+    const IDecisionInfo* m_pool = nullptr;
+    int* m_results = nullptr;
+    int m_numDecisions = 0;
+};
+
+static HRESULT SelectCandidate(
+    _In_ ProviderResolver* resolver,
+    _In_ const NamedResourceResult* namedResource,
+    _Inout_opt_ BatchDecisionCache* decisionCache,
+    _Out_ ResourceCandidateResult* resourceCandidate)
+{
+    // Repeated lookups of the same resource in an unchanged context reuse the earlier selection.
+    const IRawResourceMap* rawMap = namedResource->GetRawResourceMap();
+    int resourceIndex = namedResource->GetResourceIndexInSchema();
+    int resolvedIndex;
+    LONG64 generation;
+    if (resolver->TryGetResolvedCandidate(rawMap, resourceIndex, &resolvedIndex, &generation))
+    {
+        RETURN_IF_FAILED(namedResource->GetCandidate(resolvedIndex, resourceCandidate));
+        return S_OK;
+    }
+
+    DecisionResult decision;
+    RETURN_IF_FAILED(namedResource->GetDecision(&decision));
+
+    int resultIndex = (decisionCache != nullptr) ? decisionCache->Get(&decision) : BatchDecisionCache::NotEvaluated;
+    if (resultIndex == BatchDecisionCache::NotEvaluated)
+    {
+        QualifierSetResult qualifierSet;
+        RETURN_IF_FAILED(resolver->EvaluateDecision(&decision, &resultIndex, &qualifierSet));
+
+        bool isMatch, isDefault, isMatchAsDefault;
+        RETURN_IF_FAILED(resolver->EvaluateQualifierSet(&qualifierSet, &isMatch, &isDefault, &isMatchAsDefault, nullptr));
+
+        if (!isMatch && !isDefault)
+        {
+            resultIndex = BatchDecisionCache::NoMatch;
+        }
+
+        if (decisionCache != nullptr)
+        {
+            decisionCache->Set(&decision, resultIndex);
+        }
+    }
+
+    if (resultIndex == BatchDecisionCache::NoMatch)
+    {
+        return HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE);
+    }
+
+    RETURN_IF_FAILED(namedResource->GetCandidate(resultIndex, resourceCandidate));
+    resolver->SetResolvedCandidate(rawMap, resourceIndex, generation, resultIndex);
+    return S_OK;
+}
+
+// Splits an ms-resource URI into its authority, which names the root resource map and may be empty, and
+// the resource path that follows it. Both point into the URI, so neither has a length limit.
+static HRESULT ParseResourceUri(
+    _In_ PCWSTR uri,
+    _Outptr_result_buffer_(*rootResourceMapLength) PCWSTR* rootResourceMap,
+    _Out_ size_t* rootResourceMapLength,
+    _Outptr_ PCWSTR* relativeResourceId)
+{
+    *rootResourceMap = nullptr;
+    *rootResourceMapLength = 0;
+    *relativeResourceId = nullptr;
+
+    // CompareStringOrdinal stops at neither null, so make sure the URI is at least as long as the prefix first.
+    RETURN_HR_IF(E_INVALIDARG, wcsnlen(uri, ResourceUriPrefixLength + 1) <= static_cast<size_t>(ResourceUriPrefixLength));
+    RETURN_HR_IF(
+        E_INVALIDARG,
+        CompareStringOrdinal(ResourceUriPrefix, ResourceUriPrefixLength, uri, ResourceUriPrefixLength, TRUE) != CSTR_EQUAL);
+
+    PCWSTR authority = uri + ResourceUriPrefixLength;
+    PCWSTR slash = wcschr(authority, L'/');
+
+    // If the URI ends before it has any paths it is not a valid resource reference, and there needs to be
+    // a resource left after the slash.
+    RETURN_HR_IF(E_INVALIDARG, (slash == nullptr) || (slash[1] == L'\0'));
+
+    *rootResourceMap = authority;
+    *rootResourceMapLength = static_cast<size_t>(slash - authority);
+    *relativeResourceId = slash + 1;
+    return S_OK;
+}
+
+static HRESULT GetResourceMapByAuthority(
+    _In_ MrmObjects* resourceManagerObjects,
+    _In_reads_(rootResourceMapLength) PCWSTR rootResourceMap,
+    size_t rootResourceMapLength,
+    _Outptr_ const IResourceMapBase** internalResourceMap)
+{
+    *internalResourceMap = nullptr;
+
+    if (rootResourceMapLength == 0)
+    {
+        // In full MRT, ms-resource:/// is a valid shortcut that refers to the primary resource map. Retain this functionality here.
+        return resourceManagerObjects->priFile->GetPrimaryResourceMap(internalResourceMap);
+    }
+
+    RETURN_HR_IF(E_INVALIDARG, rootResourceMapLength > static_cast<size_t>(INT_MAX));
+
+    int numMaps = resourceManagerObjects->priFile->GetNumResourceMaps();
+    for (int i = 0; i < numMaps; i++)
+    {
+        const IResourceMapBase* map;
+        if (SUCCEEDED(resourceManagerObjects->priFile->GetResourceMap(i, &map)) &&
+            (CompareStringOrdinal(map->GetSchema()->GetSimpleId(), -1, rootResourceMap, static_cast<int>(rootResourceMapLength), TRUE) ==
+             CSTR_EQUAL))
+        {
+            *internalResourceMap = map;
+            return S_OK;
+        }
+    }
+
+    return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+}
+
 static HRESULT LoadResourceCandidate(
     _In_ void* resourceManager,
     _In_opt_ void* resourceContext,
@@ -184,101 +384,41 @@ static HRESULT LoadResourceCandidate(
         *qualifierValues = nullptr;
     }
 
-    StringResult nameResult;
+    InlineStringResult nameResult;
     size_t nameStringLength;
 
     MrmObjects* resourceManagerObjects = reinterpret_cast<MrmObjects*>(resourceManager);
-
-    ProviderResolver* resolver;
-    if (resourceContext == nullptr)
-    {
-        resolver = resourceManagerObjects->resolver;
-    }
-    else
-    {
-        resolver = reinterpret_cast<ProviderResolver*>(resourceContext);
-    }
+    ProviderResolver* resolver = GetResolver(resourceManagerObjects, resourceContext);
 
     NamedResourceResult namedResource;
 
     if (index == INDEX_RESOURCE_URI)
     {
-        if ((wcslen(resourceIdOrUri) <= static_cast<size_t>(ResourceUriPrefixLength)) ||
-            (CompareStringOrdinal(ResourceUriPrefix, ResourceUriPrefixLength, resourceIdOrUri, ResourceUriPrefixLength, TRUE) !=
-             CSTR_EQUAL))
-        {
-            return E_INVALIDARG;
-        }
-
-        // Root resource maps are the authority of the URI, and are limited to 255 characters.
-        wchar_t rootResourceMap[256] = {};
-        unsigned int i = 0;
-        for (; i < ARRAYSIZE(rootResourceMap); i++)
-        {
-            wchar_t currentCharacter = resourceIdOrUri[ResourceUriPrefixLength + i];
-            if (currentCharacter == L'\0')
-            {
-                // If the URI ends before it has any paths it is not a valid resource reference.
-                return E_INVALIDARG;
-            }
-
-            if (currentCharacter == L'/')
-            {
-                break;
-            }
-
-            rootResourceMap[i] = currentCharacter;
-        }
-
-        if (i == ARRAYSIZE(rootResourceMap))
-        {
-            // The root resource map was too long.
-            return E_INVALIDARG;
-        }
-
-        rootResourceMap[i] = L'\0';
-
-        // The above loop ends at the slash, so go one after.
-        const wchar_t* relativeResourceId = &resourceIdOrUri[ResourceUriPrefixLength + i + 1];
-        if (relativeResourceId[0] == L'\0')
-        {
-            // There needs to be a resource left.
-            return E_INVALIDARG;
-        }
+        PCWSTR rootResourceMap;
+        size_t rootResourceMapLength;
+        PCWSTR relativeResourceId;
+        RETURN_IF_FAILED(ParseResourceUri(resourceIdOrUri, &rootResourceMap, &rootResourceMapLength, &relativeResourceId));
 
         const IResourceMapBase* internalResourceMap;
+        RETURN_IF_FAILED(GetResourceMapByAuthority(resourceManagerObjects, rootResourceMap, rootResourceMapLength, &internalResourceMap));
 
-        if (i == 0)
-        {
-            // In full MRT, ms-resource:/// is a valid shortcut that refers to the primary resource map. Retain this functionality here.
-            RETURN_IF_FAILED(resourceManagerObjects->priFile->GetPrimaryResourceMap(&internalResourceMap));
-        }
-        else
-        {
-            RETURN_IF_FAILED(resourceManagerObjects->priFile->GetResourceMapById(rootResourceMap, &internalResourceMap));
-        }
+        const ResourceMapSubtree* rootSubtree = internalResourceMap->GetRootSubtree();
+        RETURN_HR_IF_NULL(E_DEF_NOT_READY, rootSubtree);
 
-        RETURN_IF_FAILED_WITH_EXPECTED(internalResourceMap->GetResource(relativeResourceId, &namedResource), HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+        RETURN_IF_FAILED_WITH_EXPECTED(
+            resourceManagerObjects->nameCache->GetResource(rootSubtree, relativeResourceId, &namedResource),
+            HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
     }
     else
     {
         const ResourceMapSubtree* internalResourceMap;
-        if (resourceMap == nullptr)
-        {
-            // The primary resource map is the default.
-            const IResourceMapBase* resourceMap;
-            RETURN_IF_FAILED(resourceManagerObjects->priFile->GetPrimaryResourceMap(&resourceMap));
-            internalResourceMap = resourceMap->GetRootSubtree();
-        }
-        else
-        {
-            // Use the supplied resource map.
-            internalResourceMap = reinterpret_cast<ResourceMapSubtree*>(resourceMap);
-        }
+        RETURN_IF_FAILED(GetResourceMapSubtree(resourceManagerObjects, resourceMap, &internalResourceMap));
 
         if (index == INDEX_RESOURCE_ID)
         {
-            RETURN_IF_FAILED_WITH_EXPECTED(internalResourceMap->GetResource(resourceIdOrUri, &namedResource), HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+            RETURN_IF_FAILED_WITH_EXPECTED(
+                resourceManagerObjects->nameCache->GetResource(internalResourceMap, resourceIdOrUri, &namedResource),
+                HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
         }
         else
         {
@@ -294,22 +434,7 @@ static HRESULT LoadResourceCandidate(
         }
     }
 
-    DecisionResult decision;
-    RETURN_IF_FAILED(namedResource.GetDecision(&decision));
-
-    QualifierSetResult qualifierSet;
-    int resultIndex;
-    RETURN_IF_FAILED(resolver->EvaluateDecision(&decision, &resultIndex, &qualifierSet));
-
-    bool isMatch, isDefault, isMatchAsDefault;
-    RETURN_IF_FAILED(resolver->EvaluateQualifierSet(&qualifierSet, &isMatch, &isDefault, &isMatchAsDefault, nullptr));
-
-    if (!isMatch && !isDefault)
-    {
-        return HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE);
-    }
-
-    RETURN_IF_FAILED(namedResource.GetCandidate(resultIndex, resourceCandidate));
+    RETURN_IF_FAILED(SelectCandidate(resolver, &namedResource, nullptr, resourceCandidate));
 
     if ((qualifierCount != nullptr) && (qualifierNames != nullptr) && (qualifierValues != nullptr))
     {
@@ -320,8 +445,8 @@ static HRESULT LoadResourceCandidate(
     {
         if (!nameResult.IsEmpty())
         {
-            // This will not fail
-            nameResult.ReleaseContents(resourceName, &nameStringLength);
+            // Only fails if the name has to be moved out of the result's inline buffer.
+            RETURN_IF_FAILED(nameResult.ReleaseContents(resourceName, &nameStringLength));
         }
     }
     return S_OK;
@@ -339,7 +464,7 @@ static HRESULT LoadStringResource(
     RETURN_IF_FAILED_WITH_EXPECTED(LoadResourceCandidate(resourceManager, resourceContext, resourceMap, index, resourceIdOrUri, &candidate, nullptr, nullptr, nullptr, nullptr),
         HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
 
-    StringResult stringResult;
+    InlineStringResult stringResult;
     if (!candidate.TryGetStringValue(&stringResult))
     {
         return HRESULT_FROM_WIN32(ERROR_MRM_RESOURCE_TYPE_MISMATCH);
@@ -378,6 +503,179 @@ static HRESULT LoadEmbeddedResource(
     return S_OK;
 }
 
+static HRESULT LoadStringResourceView(
+    _In_ void* resourceManager,
+    _In_opt_ void* resourceContext,
+    _In_opt_ void* resourceMap,
+    int index,
+    _In_opt_ PCWSTR resourceIdOrUri,
+    _Outptr_ PCWSTR* resourceString,
+    _Out_opt_ UINT32* resourceStringLength)
+{
+    *resourceString = nullptr;
+    if (resourceStringLength != nullptr)
+    {
+        *resourceStringLength = 0;
+    }
+
+    ResourceCandidateResult candidate;
+    RETURN_IF_FAILED_WITH_EXPECTED(LoadResourceCandidate(resourceManager, resourceContext, resourceMap, index, resourceIdOrUri, &candidate, nullptr, nullptr, nullptr, nullptr),
+        HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+
+    // The value either points into the PRI file or was decoded into the manager's cache, so nothing is copied here.
+    MrmObjects* resourceManagerObjects = reinterpret_cast<MrmObjects*>(resourceManager);
+    PCWSTR value;
+    size_t length;
+    RETURN_IF_FAILED(resourceManagerObjects->stringCache->GetStringValue(&candidate, &value, &length));
+
+    UINT32 length32;
+    RETURN_IF_FAILED(SizeTToUInt32(length, &length32));
+
+    *resourceString = value;
+    if (resourceStringLength != nullptr)
+    {
+        *resourceStringLength = length32;
+    }
+    return S_OK;
+}
+
+// Per-item state for the batch loaders. Values stay referenced into the PRI file where possible and are
+// copied exactly once, into the arena returned to the caller.
+struct BatchResourceItem
+{
+    HRESULT status = S_OK;
+    MrmType type = MrmType_Unknown;
+    StringResult name;
+    StringResult string;
+    BlobResult blob;
+};
+
+static HRESULT LoadResourceBatchItem(
+    _In_ ResourceNameCache* nameCache,
+    _In_ const ResourceMapSubtree* resourceMap,
+    _In_ ProviderResolver* resolver,
+    _Inout_ BatchDecisionCache* decisionCache,
+    _In_opt_ PCWSTR resourceId,
+    UINT32 index,
+    _Inout_ BatchResourceItem* item)
+{
+    NamedResourceResult namedResource;
+    if (resourceId != nullptr)
+    {
+        RETURN_IF_FAILED_WITH_EXPECTED(
+            nameCache->GetResource(resourceMap, resourceId, &namedResource), HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+    }
+    else
+    {
+        RETURN_HR_IF(E_INVALIDARG, index > static_cast<UINT32>(INT_MAX));
+        RETURN_IF_FAILED(resourceMap->GetDescendentResource(static_cast<int>(index), &namedResource));
+        RETURN_IF_FAILED(resourceMap->GetDescendentResourceName(static_cast<int>(index), &item->name));
+    }
+
+    ResourceCandidateResult candidate;
+    RETURN_IF_FAILED_WITH_EXPECTED(
+        SelectCandidate(resolver, &namedResource, decisionCache, &candidate), HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE));
+
+    MrmEnvironment::ResourceValueType internalResourceType;
+    RETURN_IF_FAILED(candidate.GetResourceValueType(&internalResourceType));
+
+    if (MrmEnvironment::IsBinaryResourceValueType(internalResourceType))
+    {
+        RETURN_HR_IF(E_UNEXPECTED, !candidate.TryGetBlobValue(&item->blob));
+        item->type = MrmType_Embedded;
+    }
+    else
+    {
+        RETURN_HR_IF(E_UNEXPECTED, !candidate.TryGetStringValue(&item->string));
+
+        if (MrmEnvironment::IsStringResourceValueType(internalResourceType))
+        {
+            item->type = MrmType_String;
+        }
+        else if (MrmEnvironment::IsPathResourceValueType(internalResourceType))
+        {
+            item->type = MrmType_Path;
+        }
+        else
+        {
+            return E_UNEXPECTED;
+        }
+    }
+
+    return S_OK;
+}
+
+// Resolves every item against one resource map and resolver. Failures specific to an item are recorded in
+// that item's status; only failures that affect the whole batch are returned.
+static HRESULT LoadResourceBatch(
+    _In_ void* resourceManager,
+    _In_opt_ void* resourceContext,
+    _In_opt_ void* resourceMap,
+    UINT32 count,
+    _In_reads_opt_(count) const PCWSTR* resourceIds,
+    _In_reads_opt_(count) const UINT32* resourceIndices,
+    _Out_writes_(count) BatchResourceItem* items)
+{
+    MrmObjects* resourceManagerObjects = reinterpret_cast<MrmObjects*>(resourceManager);
+    ProviderResolver* resolver = GetResolver(resourceManagerObjects, resourceContext);
+
+    const ResourceMapSubtree* internalResourceMap;
+    RETURN_IF_FAILED(GetResourceMapSubtree(resourceManagerObjects, resourceMap, &internalResourceMap));
+
+    BatchDecisionCache decisionCache;
+    for (UINT32 i = 0; i < count; i++)
+    {
+        PCWSTR resourceId = (resourceIds != nullptr) ? resourceIds[i] : nullptr;
+        UINT32 index = (resourceIndices != nullptr) ? resourceIndices[i] : 0;
+
+        if ((resourceIds != nullptr) && ((resourceId == nullptr) || (*resourceId == L'\0')))
+        {
+            items[i].status = E_INVALIDARG;
+            continue;
+        }
+
+        items[i].status = LoadResourceBatchItem(
+            resourceManagerObjects->nameCache, internalResourceMap, resolver, &decisionCache, resourceId, index, &items[i]);
+        RETURN_HR_IF(E_OUTOFMEMORY, items[i].status == E_OUTOFMEMORY);
+    }
+
+    return S_OK;
+}
+
+// Blocks in a batch arena are 8-byte aligned so embedded data can be used in place.
+static size_t AlignArenaBlock(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+
+static HRESULT AddArenaBlock(_Inout_ size_t* arenaSize, size_t blockSize)
+{
+    size_t paddedSize;
+    RETURN_IF_FAILED(SizeTAdd(blockSize, 7, &paddedSize));
+    RETURN_IF_FAILED(SizeTAdd(*arenaSize, paddedSize & ~static_cast<size_t>(7), arenaSize));
+    return S_OK;
+}
+
+static HRESULT AddArenaString(_Inout_ size_t* arenaSize, _In_ const StringResult* string)
+{
+    size_t sizeInBytes;
+    RETURN_IF_FAILED(SizeTAdd(string->GetLength(), 1, &sizeInBytes));
+    RETURN_IF_FAILED(SizeTMult(sizeInBytes, sizeof(wchar_t), &sizeInBytes));
+    return AddArenaBlock(arenaSize, sizeInBytes);
+}
+
+// The arena was sized by AddArenaString, so this cannot overrun it.
+static PWSTR CopyStringToArena(_In_ const StringResult* string, _Inout_ BYTE** next)
+{
+    size_t length = string->GetLength();
+    PWSTR destination = reinterpret_cast<PWSTR>(*next);
+    if (length > 0)
+    {
+        CopyMemory(destination, string->GetRef(), length * sizeof(wchar_t));
+    }
+    destination[length] = L'\0';
+
+    *next += AlignArenaBlock((length + 1) * sizeof(wchar_t));
+    return destination;
+}
+
 static HRESULT LoadStringOrEmbeddedResource(
     _In_ void* resourceManager,
     _In_opt_ void* resourceContext,
@@ -430,7 +728,7 @@ static HRESULT LoadStringOrEmbeddedResource(
     }
     else
     {
-        StringResult stringResult;
+        InlineStringResult stringResult;
         if (!candidate.TryGetStringValue(&stringResult))
         {
             return E_UNEXPECTED;
@@ -483,6 +781,18 @@ static void DestroyResourceManager(_In_ void* resourceManager)
         resourceManagerObjects->resolver = nullptr;
     }
 
+    if (resourceManagerObjects->stringCache != nullptr)
+    {
+        delete resourceManagerObjects->stringCache;
+        resourceManagerObjects->stringCache = nullptr;
+    }
+
+    if (resourceManagerObjects->nameCache != nullptr)
+    {
+        delete resourceManagerObjects->nameCache;
+        resourceManagerObjects->nameCache = nullptr;
+    }
+
     delete resourceManagerObjects;
 
     return;
@@ -503,6 +813,9 @@ STDAPI MrmCreateResourceManager(_In_ PCWSTR priFileName, _Out_ MrmManagerHandle*
     RETURN_IF_FAILED(CoreProfile::ChooseDefaultProfile(&resourceManagerObjects->profile));
     RETURN_IF_FAILED(UnifiedResourceView::CreateInstance(resourceManagerObjects->profile, &resourceManagerObjects->unifiedView));
 
+    // Only read what the first lookup needs; everything else in the PRI file is set up when it is first used.
+    resourceManagerObjects->unifiedView->SetLazySectionLoad(true);
+
     HRESULT hr = S_OK;
     if (wcschr(priFileName, L'\\') == nullptr)
     {
@@ -528,6 +841,9 @@ STDAPI MrmCreateResourceManager(_In_ PCWSTR priFileName, _Out_ MrmManagerHandle*
         primaryMap->GetDecisionInfo(),
         &resourceManagerObjects->resolver));
 
+    RETURN_IF_FAILED(CandidateStringCache::CreateInstance(&resourceManagerObjects->stringCache));
+    RETURN_IF_FAILED(ResourceNameCache::CreateInstance(&resourceManagerObjects->nameCache));
+
     *resourceManager = reinterpret_cast<MrmManagerHandle>(resourceManagerObjects.release());
     return S_OK;
 }
@@ -601,7 +917,7 @@ STDAPI MrmGetAllQualifierNamesImpl(_In_ MrmContextHandle resourceContext, _Out_
         Atom nameAtom;
         RETURN_IF_FAILED(qualifierNameAtoms->Get(i, &nameAtom));
 
-        StringResult result;
+        InlineStringResult result;
         RETURN_IF_FAILED(environment->GetName(UnifiedEnvironment::QualifierNames, nameAtom, &result));
 
         // This ensures the string result holds a copy of the data we can return to the caller, not a pointer to the PRI file.
@@ -629,7 +945,7 @@ STDAPI MrmGetQualifier(_In_ MrmContextHandle resourceContext, _In_ PCWSTR qualif
 {
     RETURN_HR_IF_NULL(E_INVALIDARG, resourceContext);
 
-    StringResult stringResult;
+    InlineStringResult stringResult;
     RETURN_IF_FAILED(reinterpret_cast<ProviderResolver*>(resourceContext)->GetQualifierValue(qualifierName, &stringResult));
 
     // This ensures the string result holds a copy of the data we can return to the caller, not a pointer to the internal cache.
@@ -731,6 +1047,29 @@ STDAPI MrmLoadStringResourceFromResourceUri(
     return S_OK;
 }
 
+STDAPI MrmLoadStringResourceView(
+    _In_ MrmManagerHandle resourceManager,
+    _In_opt_ MrmContextHandle resourceContext,
+    _In_opt_ MrmMapHandle resourceMap,
+    _In_ PCWSTR resourceId,
+    _Outptr_ PCWSTR* resourceString,
+    _Out_opt_ UINT32* resourceStringLength)
+{
+    RETURN_IF_FAILED_WITH_EXPECTED(LoadStringResourceView(resourceManager, resourceContext, resourceMap, INDEX_RESOURCE_ID, resourceId, resourceString, resourceStringLength), HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+    return S_OK;
+}
+
+STDAPI MrmLoadStringResourceViewFromResourceUri(
+    _In_ MrmManagerHandle resourceManager,
+    _In_opt_ MrmContextHandle resourceContext,
+    _In_ PCWSTR resourceUri,
+    _Outptr_ PCWSTR* resourceString,
+    _Out_opt_ UINT32* resourceStringLength)
+{
+    RETURN_IF_FAILED_WITH_EXPECTED(LoadStringResourceView(resourceManager, resourceContext, nullptr, INDEX_RESOURCE_URI, resourceUri, resourceString, resourceStringLength), HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+    return S_OK;
+}
+
 STDAPI MrmLoadEmbeddedResource(
     _In_ MrmManagerHandle resourceManager,
     _In_opt_ MrmContextHandle resourceContext,
@@ -854,6 +1193,135 @@ STDAPI MrmLoadStringOrEmbeddedResourceByIndexWithQualifierValues(
     return S_OK;
 }
 
+STDAPI MrmLoadStringResources(
+    _In_ MrmManagerHandle resourceManager,
+    _In_opt_ MrmContextHandle resourceContext,
+    _In_opt_ MrmMapHandle resourceMap,
+    UINT32 count,
+    _In_reads_(count) const PCWSTR* resourceIds,
+    _Outptr_result_buffer_(count) PWSTR** resourceStrings)
+{
+    *resourceStrings = nullptr;
+    RETURN_HR_IF(E_INVALIDARG, (resourceManager == nullptr) || (count == 0) || (resourceIds == nullptr));
+
+    std::unique_ptr<BatchResourceItem[]> items(new (std::nothrow) BatchResourceItem[count]);
+    RETURN_IF_NULL_ALLOC(items);
+    RETURN_IF_FAILED(LoadResourceBatch(resourceManager, resourceContext, resourceMap, count, resourceIds, nullptr, items.get()));
+
+    size_t arenaSize = 0;
+    size_t headerSize;
+    RETURN_IF_FAILED(SizeTMult(count, sizeof(PWSTR), &headerSize));
+    RETURN_IF_FAILED(AddArenaBlock(&arenaSize, headerSize));
+    for (UINT32 i = 0; i < count; i++)
+    {
+        if (SUCCEEDED(items[i].status) && (items[i].type != MrmType_Embedded))
+        {
+            RETURN_IF_FAILED(AddArenaString(&arenaSize, &items[i].string));
+        }
+    }
+
+    BYTE* arena = reinterpret_cast<BYTE*>(MrmAllocateBuffer(arenaSize));
+    RETURN_IF_NULL_ALLOC(arena);
+
+    PWSTR* strings = reinterpret_cast<PWSTR*>(arena);
+    BYTE* next = arena + AlignArenaBlock(headerSize);
+    for (UINT32 i = 0; i < count; i++)
+    {
+        // Missing resources and embedded data have no string value.
+        strings[i] = (SUCCEEDED(items[i].status) && (items[i].type != MrmType_Embedded)) ? CopyStringToArena(&items[i].string, &next) : nullptr;
+    }
+
+    *resourceStrings = strings;
+    return S_OK;
+}
+
+STDAPI MrmLoadResourceCandidates(
+    _In_ MrmManagerHandle resourceManager,
+    _In_opt_ MrmContextHandle resourceContext,
+    _In_opt_ MrmMapHandle resourceMap,
+    UINT32 count,
+    _In_reads_opt_(count) const PCWSTR* resourceIds,
+    _In_reads_opt_(count) const UINT32* resourceIndices,
+    _Outptr_result_buffer_(count) MrmResourceValue** resourceValues)
+{
+    *resourceValues = nullptr;
+    RETURN_HR_IF(E_INVALIDARG, (resourceManager == nullptr) || (count == 0));
+    RETURN_HR_IF(E_INVALIDARG, (resourceIds == nullptr) == (resourceIndices == nullptr));
+
+    std::unique_ptr<BatchResourceItem[]> items(new (std::nothrow) BatchResourceItem[count]);
+    RETURN_IF_NULL_ALLOC(items);
+    RETURN_IF_FAILED(LoadResourceBatch(resourceManager, resourceContext, resourceMap, count, resourceIds, resourceIndices, items.get()));
+
+    size_t arenaSize = 0;
+    size_t headerSize;
+    RETURN_IF_FAILED(SizeTMult(count, sizeof(MrmResourceValue), &headerSize));
+    RETURN_IF_FAILED(AddArenaBlock(&arenaSize, headerSize));
+    for (UINT32 i = 0; i < count; i++)
+    {
+        if (FAILED(items[i].status))
+        {
+            continue;
+        }
+
+        if (resourceIndices != nullptr)
+        {
+            RETURN_IF_FAILED(AddArenaString(&arenaSize, &items[i].name));
+        }
+
+        if (items[i].type == MrmType_Embedded)
+        {
+            RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW), items[i].blob.GetSize() > UINT32_MAX);
+            RETURN_IF_FAILED(AddArenaBlock(&arenaSize, items[i].blob.GetSize()));
+        }
+        else
+        {
+            RETURN_IF_FAILED(AddArenaString(&arenaSize, &items[i].string));
+        }
+    }
+
+    BYTE* arena = reinterpret_cast<BYTE*>(MrmAllocateBuffer(arenaSize));
+    RETURN_IF_NULL_ALLOC(arena);
+    ZeroMemory(arena, headerSize);
+
+    MrmResourceValue* values = reinterpret_cast<MrmResourceValue*>(arena);
+    BYTE* next = arena + AlignArenaBlock(headerSize);
+    for (UINT32 i = 0; i < count; i++)
+    {
+        values[i].status = items[i].status;
+        if (FAILED(items[i].status))
+        {
+            values[i].type = MrmType_Unknown;
+            continue;
+        }
+
+        values[i].type = items[i].type;
+        if (resourceIndices != nullptr)
+        {
+            values[i].name = CopyStringToArena(&items[i].name, &next);
+        }
+
+        if (items[i].type == MrmType_Embedded)
+        {
+            size_t size;
+            const void* data = items[i].blob.GetRef(&size);
+            if (size > 0)
+            {
+                CopyMemory(next, data, size);
+            }
+            values[i].data.data = next;
+            values[i].data.size = static_cast<UINT32>(size);
+            next += AlignArenaBlock(size);
+        }
+        else
+        {
+            values[i].string = CopyStringToArena(&items[i].string, &next);
+        }
+    }
+
+    *resourceValues = values;
+    return S_OK;
+}
+
 STDAPI_(void*) MrmAllocateBuffer(size_t size) { return Def_Alloc(size); }
 
 STDAPI_(void) MrmFreeResource(_In_opt_ void* resource)
@@ -58,6 +58,24 @@ extern "C"
         _In_ PCWSTR resourceUri,
         _Outptr_ PWSTR* resourceString);
 
+    // Returns a borrowed view of a string resource instead of a copy. The string is owned by the resource manager
+    // and stays valid until MrmDestroyResourceManager; it must not be freed. Strings stored in the PRI file as
+    // UTF-16 are returned in place, and any other string is decoded once and cached by the manager.
+    STDAPI MrmLoadStringResourceView(
+        _In_ MrmManagerHandle resourceManager,
+        _In_opt_ MrmContextHandle resourceContext,
+        _In_opt_ MrmMapHandle resourceMap,
+        _In_ PCWSTR resourceId,
+        _Outptr_ PCWSTR* resourceString,
+        _Out_opt_ UINT32* resourceStringLength);
+
+    STDAPI MrmLoadStringResourceViewFromResourceUri(
+        _In_ MrmManagerHandle resourceManager,
+        _In_opt_ MrmContextHandle resourceContext,
+        _In_ PCWSTR resourceUri,
+        _Outptr_ PCWSTR* resourceString,
+        _Out_opt_ UINT32* resourceStringLength);
+
     STDAPI MrmLoadEmbeddedResource(
         _In_ MrmManagerHandle resourceManager,
         _In_opt_ MrmContextHandle resourceContext,
@@ -123,6 +141,39 @@ extern "C"
         _Outptr_result_buffer_(*qualifierCount) PWSTR** qualifierNames,
         _Outptr_result_buffer_(*qualifierCount) PWSTR** qualifierValues);
 
+    // Result of one item in a batch lookup. Strings and data point into the buffer returned by the batch call.
+    struct MrmResourceValue
+    {
+        HRESULT status;
+        MrmType type;
+        PCWSTR name;
+        PCWSTR string;
+        MrmResourceData data;
+    };
+
+    // Batch lookups resolve every item against the same resource map and context, evaluating each decision
+    // shared by the items only once. All results are returned in a single buffer that is released with one
+    // call to MrmFreeResource. Items that can't be loaded don't fail the call: MrmLoadStringResources returns
+    // nullptr for them and MrmLoadResourceCandidates reports the failure in the item's status.
+    STDAPI MrmLoadStringResources(
+        _In_ MrmManagerHandle resourceManager,
+        _In_opt_ MrmContextHandle resourceContext,
+        _In_opt_ MrmMapHandle resourceMap,
+        UINT32 count,
+        _In_reads_(count) const PCWSTR* resourceIds,
+        _Outptr_result_buffer_(count) PWSTR** resourceStrings);
+
+    // Exactly one of resourceIds and resourceIndices must be supplied. The name of each resource is returned
+    // for lookups by index.
+    STDAPI MrmLoadResourceCandidates(
+        _In_ MrmManagerHandle resourceManager,
+        _In_opt_ MrmContextHandle resourceContext,
+        _In_opt_ MrmMapHandle resourceMap,
+        UINT32 count,
+        _In_reads_opt_(count) const PCWSTR* resourceIds,
+        _In_reads_opt_(count) const UINT32* resourceIndices,
+        _Outptr_result_buffer_(count) MrmResourceValue** resourceValues);
+
     STDAPI_(void*) MrmAllocateBuffer(size_t size);
     STDAPI_(void) MrmFreeResource(_In_opt_ void* resource);
 
@@ -145,6 +145,185 @@ public:
         MrmDestroyResourceManager(resourceManager);
     }
 
+    TEST_METHOD(ReadResourceStringFromFullUri_LongResourceMapName)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        // Resource map names are no longer limited to 255 characters; this one simply doesn't exist.
+        wchar_t* resourceString;
+        VERIFY_ARE_EQUAL(
+            MrmLoadStringResourceFromResourceUri(
+                resourceManager,
+                nullptr,
+                L"ms-resource://"
+                L"1234567890112345678901234567890112345678901234567890112345678901234567890112345678901234567890112345678901234567890112345"
+                L"6789012345678901123456789012345678901123456789012345678901123456789012345678901123456789012345678901234567890123456789012"
+                L"345678901234567890123456/resources/IDS_MANIFEST_MUSIC_APP_NAME",
+                &resourceString),
+            HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
+
+        MrmDestroyResourceManager(resourceManager);
+    }
+
+    TEST_METHOD(ReadResourceStringByNameRepeatedly)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        // Names are looked up once and then served from the name cache, which must still honor case
+        // and separator insensitivity and must not confuse names in different resource maps.
+        const PCWSTR names[] = { L"resources/IDS_MANIFEST_MUSIC_APP_NAME", L"RESOURCES/ids_manifest_music_app_name", L"resources\\IDS_MANIFEST_MUSIC_APP_NAME" };
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int i = 0; i < ARRAYSIZE(names); i++)
+            {
+                wchar_t* resourceString;
+                VERIFY_ARE_EQUAL(MrmLoadStringResource(resourceManager, nullptr, nullptr, names[i], &resourceString), S_OK);
+                VerifyStringEqual(resourceString, L"Groove Music");
+                MrmFreeResource(resourceString);
+
+                VERIFY_ARE_EQUAL(MrmLoadStringResource(resourceManager, nullptr, nullptr, L"resources/IDS_WHATS_NEW_1710_2_EQUALIZER_TITLE", &resourceString), S_OK);
+                MrmFreeResource(resourceString);
+            }
+
+            wchar_t* resourceString;
+            VERIFY_ARE_EQUAL(MrmLoadStringResourceFromResourceUri(resourceManager, nullptr, L"ms-resource://Microsoft.ZuneMusic/resources/IDS_MANIFEST_MUSIC_APP_NAME", &resourceString), S_OK);
+            VerifyStringEqual(resourceString, L"Groove Music");
+            MrmFreeResource(resourceString);
+
+            VERIFY_ARE_EQUAL(MrmLoadStringResource(resourceManager, nullptr, nullptr, L"resources/IDS_MANIFEST_MUSIC_APP_NAME_NOT_THERE", &resourceString), HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+        }
+
+        MrmDestroyResourceManager(resourceManager);
+    }
+
+    // Counts the heap allocations mrm.dll makes on the test thread by patching its HeapAlloc import.
+    static inline DWORD s_allocatingThreadId = 0;
+    static inline UINT32 s_heapAllocCount = 0;
+    static inline void* s_lastHeapAlloc = nullptr;
+
+    static LPVOID WINAPI CountingHeapAlloc(_In_ HANDLE heap, _In_ DWORD flags, _In_ SIZE_T bytes)
+    {
+        LPVOID allocation = HeapAlloc(heap, flags, bytes);
+        if (GetCurrentThreadId() == s_allocatingThreadId)
+        {
+            s_heapAllocCount++;
+            s_lastHeapAlloc = allocation;
+        }
+        return allocation;
+    }
+
+    static void** FindHeapAllocImport(_In_ HMODULE module)
+    {
+        BYTE* base = reinterpret_cast<BYTE*>(module);
+        IMAGE_NT_HEADERS* ntHeaders = reinterpret_cast<IMAGE_NT_HEADERS*>(base + reinterpret_cast<IMAGE_DOS_HEADER*>(base)->e_lfanew);
+        IMAGE_DATA_DIRECTORY& imports = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+
+        for (IMAGE_IMPORT_DESCRIPTOR* descriptor = reinterpret_cast<IMAGE_IMPORT_DESCRIPTOR*>(base + imports.VirtualAddress);
+             (imports.VirtualAddress != 0) && (descriptor->Name != 0);
+             descriptor++)
+        {
+            IMAGE_THUNK_DATA* names = reinterpret_cast<IMAGE_THUNK_DATA*>(base + descriptor->OriginalFirstThunk);
+            IMAGE_THUNK_DATA* addresses = reinterpret_cast<IMAGE_THUNK_DATA*>(base + descriptor->FirstThunk);
+            for (; names->u1.AddressOfData != 0; names++, addresses++)
+            {
+                if (!IMAGE_SNAP_BY_ORDINAL(names->u1.Ordinal) &&
+                    (strcmp(reinterpret_cast<IMAGE_IMPORT_BY_NAME*>(base + names->u1.AddressOfData)->Name, "HeapAlloc") == 0))
+                {
+                    return reinterpret_cast<void**>(&addresses->u1.Function);
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    static void PatchImport(_In_ void** importSlot, _In_ void* function)
+    {
+        DWORD oldProtect;
+        VERIFY_WIN32_BOOL_SUCCEEDED(VirtualProtect(importSlot, sizeof(*importSlot), PAGE_READWRITE, &oldProtect));
+        *importSlot = function;
+        VERIFY_WIN32_BOOL_SUCCEEDED(VirtualProtect(importSlot, sizeof(*importSlot), oldProtect, &oldProtect));
+    }
+
+    TEST_METHOD(ReadShortResourceStringWithoutHeapAllocations)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        // The first lookup sets up sections and caches, so only a repeated lookup is measured.
+        wchar_t* resourceString;
+        VERIFY_ARE_EQUAL(MrmLoadStringResource(resourceManager, nullptr, nullptr, L"resources/IDS_MANIFEST_MUSIC_APP_NAME", &resourceString), S_OK);
+        VERIFY_IS_TRUE(wcslen(resourceString) <= 64);
+        MrmFreeResource(resourceString);
+
+        HMODULE mrmModule = GetModuleHandleW(L"mrm.dll");
+        VERIFY_IS_NOT_NULL(mrmModule);
+        void** heapAllocImport = FindHeapAllocImport(mrmModule);
+        VERIFY_IS_NOT_NULL(heapAllocImport);
+
+        void* originalHeapAlloc = *heapAllocImport;
+        s_allocatingThreadId = GetCurrentThreadId();
+        s_heapAllocCount = 0;
+        s_lastHeapAlloc = nullptr;
+        PatchImport(heapAllocImport, reinterpret_cast<void*>(CountingHeapAlloc));
+
+        HRESULT hr = MrmLoadStringResource(resourceManager, nullptr, nullptr, L"resources/IDS_MANIFEST_MUSIC_APP_NAME", &resourceString);
+
+        PatchImport(heapAllocImport, originalHeapAlloc);
+        s_allocatingThreadId = 0;
+
+        VERIFY_ARE_EQUAL(hr, S_OK);
+        VerifyStringEqual(resourceString, L"Groove Music");
+
+        // Strings of up to 64 characters are built in an inline buffer, so the only heap allocation
+        // is the buffer handed back to the caller.
+        VERIFY_ARE_EQUAL(s_heapAllocCount, 1u);
+        VERIFY_ARE_EQUAL(s_lastHeapAlloc, static_cast<void*>(resourceString));
+
+        MrmFreeResource(resourceString);
+        MrmDestroyResourceManager(resourceManager);
+    }
+
+    static DWORD WINAPI ReadResourceStringThreadProc(_In_ LPVOID parameter)
+    {
+        MrmManagerHandle resourceManager = reinterpret_cast<MrmManagerHandle>(parameter);
+
+        wchar_t* resourceString;
+        HRESULT hr = MrmLoadStringResource(resourceManager, nullptr, nullptr, L"resources/IDS_MANIFEST_MUSIC_APP_NAME", &resourceString);
+        if (SUCCEEDED(hr))
+        {
+            hr = (wcscmp(resourceString, L"Groove Music") == 0) ? S_OK : E_FAIL;
+            MrmFreeResource(resourceString);
+        }
+        return static_cast<DWORD>(hr);
+    }
+
+    TEST_METHOD(ReadResourceStringFromManyThreads)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        // Sections of the PRI file are only set up on first use, so the first reads race to set them up.
+        HANDLE threads[8];
+        for (int i = 0; i < ARRAYSIZE(threads); i++)
+        {
+            threads[i] = CreateThread(nullptr, 0, ReadResourceStringThreadProc, resourceManager, 0, nullptr);
+            VERIFY_IS_NOT_NULL(threads[i]);
+        }
+
+        VERIFY_ARE_EQUAL(WaitForMultipleObjects(ARRAYSIZE(threads), threads, TRUE, INFINITE), WAIT_OBJECT_0);
+        for (int i = 0; i < ARRAYSIZE(threads); i++)
+        {
+            DWORD exitCode;
+            VERIFY_IS_TRUE(GetExitCodeThread(threads[i], &exitCode));
+            VERIFY_ARE_EQUAL(exitCode, static_cast<DWORD>(S_OK));
+            CloseHandle(threads[i]);
+        }
+
+        MrmDestroyResourceManager(resourceManager);
+    }
+
     TEST_METHOD(ReadResourceStringWithQualifierOverride)
     {
         MrmManagerHandle resourceManager;
@@ -234,6 +413,67 @@ public:
         MrmDestroyResourceManager(resourceManager);
     }
 
+    TEST_METHOD(SetQualifierToSameValue)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        MrmContextHandle resourceContext;
+        VERIFY_ARE_EQUAL(MrmCreateResourceContext(resourceManager, &resourceContext), S_OK);
+
+        // Setting the value the qualifier already has keeps the cached results, which must still be right.
+        const PCWSTR languages[] = { L"en-GB", L"en-GB", L"EN-GB", L"en-US", L"en-US", L"en-GB" };
+        const PCWSTR expected[] = { L"Equaliser", L"Equaliser", L"Equaliser", L"Equalizer", L"Equalizer", L"Equaliser" };
+        for (int i = 0; i < ARRAYSIZE(languages); i++)
+        {
+            VERIFY_ARE_EQUAL(MrmSetQualifier(resourceContext, L"Language", languages[i]), S_OK);
+
+            wchar_t* qualifierValue;
+            VERIFY_ARE_EQUAL(MrmGetQualifier(resourceContext, L"Language", &qualifierValue), S_OK);
+            VerifyStringEqual(qualifierValue, languages[i]);
+            MrmFreeResource(qualifierValue);
+
+            wchar_t* resourceString;
+            VERIFY_ARE_EQUAL(MrmLoadStringResource(resourceManager, resourceContext, nullptr, L"resources/IDS_WHATS_NEW_1710_2_EQUALIZER_TITLE", &resourceString), S_OK);
+            VerifyStringEqual(resourceString, expected[i]);
+            MrmFreeResource(resourceString);
+        }
+
+        MrmDestroyResourceContext(resourceContext);
+        MrmDestroyResourceManager(resourceManager);
+    }
+
+    TEST_METHOD(RepeatedReadAcrossQualifierChanges)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        MrmContextHandle resourceContext;
+        VERIFY_ARE_EQUAL(MrmCreateResourceContext(resourceManager, &resourceContext), S_OK);
+
+        // Repeated reads are served from the resolved resource cache, which must not outlive a qualifier change.
+        const PCWSTR languages[] = { L"en-US", L"en-GB", L"en-US" };
+        const PCWSTR expected[] = { L"Equalizer", L"Equaliser", L"Equalizer" };
+        for (int i = 0; i < ARRAYSIZE(languages); i++)
+        {
+            VERIFY_ARE_EQUAL(MrmSetQualifier(resourceContext, L"Language", languages[i]), S_OK);
+
+            for (int j = 0; j < 3; j++)
+            {
+                wchar_t* resourceString;
+                VERIFY_ARE_EQUAL(MrmLoadStringResource(resourceManager, resourceContext, nullptr, L"resources/IDS_WHATS_NEW_1710_2_EQUALIZER_TITLE", &resourceString), S_OK);
+                VerifyStringEqual(resourceString, expected[i]);
+                MrmFreeResource(resourceString);
+
+                VERIFY_ARE_EQUAL(MrmLoadStringResource(resourceManager, nullptr, nullptr, L"resources/IDS_WHATS_NEW_1710_2_EQUALIZER_TITLE", &resourceString), S_OK);
+                MrmFreeResource(resourceString);
+            }
+        }
+
+        MrmDestroyResourceContext(resourceContext);
+        MrmDestroyResourceManager(resourceManager);
+    }
+
     TEST_METHOD(ReadEmbeddedResourceFromFullUri)
     {
         MrmManagerHandle resourceManager;
@@ -272,6 +512,43 @@ public:
         MrmDestroyResourceManager(resourceManager);
     }
 
+    TEST_METHOD(ReadResourceStringView)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        PCWSTR resourceString;
+        UINT32 resourceStringLength;
+        VERIFY_ARE_EQUAL(MrmLoadStringResourceView(resourceManager, nullptr, nullptr, L"resources/IDS_MANIFEST_MUSIC_APP_NAME", &resourceString, &resourceStringLength), S_OK);
+        VerifyStringEqual(resourceString, L"Groove Music");
+        VERIFY_ARE_EQUAL(resourceStringLength, static_cast<UINT32>(wcslen(L"Groove Music")));
+
+        // Views are owned by the manager, so loading the same resource again returns the same string.
+        PCWSTR secondString;
+        VERIFY_ARE_EQUAL(MrmLoadStringResourceViewFromResourceUri(resourceManager, nullptr, L"ms-resource:///resources/IDS_MANIFEST_MUSIC_APP_NAME", &secondString, nullptr), S_OK);
+        VERIFY_ARE_EQUAL(resourceString, secondString);
+
+        // Paths are built from the package root, so they come from the manager's cache.
+        MrmType resourceType;
+        wchar_t* copiedString;
+        MrmResourceData resourceData {};
+        VERIFY_ARE_EQUAL(MrmLoadStringOrEmbeddedResource(resourceManager, nullptr, nullptr, L"Files/Assets/AppList.png", &resourceType, &copiedString, &resourceData), S_OK);
+        VERIFY_IS_TRUE(resourceType == MrmType_Path);
+
+        VERIFY_ARE_EQUAL(MrmLoadStringResourceView(resourceManager, nullptr, nullptr, L"Files/Assets/AppList.png", &resourceString, &resourceStringLength), S_OK);
+        VerifyStringEqual(resourceString, copiedString);
+        VERIFY_ARE_EQUAL(resourceStringLength, static_cast<UINT32>(wcslen(copiedString)));
+        VERIFY_ARE_EQUAL(MrmLoadStringResourceView(resourceManager, nullptr, nullptr, L"Files/Assets/AppList.png", &secondString, nullptr), S_OK);
+        VERIFY_ARE_EQUAL(resourceString, secondString);
+        MrmFreeResource(copiedString);
+
+        VERIFY_ARE_EQUAL(MrmLoadStringResourceView(resourceManager, nullptr, nullptr, L"Files/Controls/AlbumBasicInfoControl.xbf", &resourceString, &resourceStringLength), HRESULT_FROM_WIN32(ERROR_MRM_RESOURCE_TYPE_MISMATCH));
+        VERIFY_IS_NULL(resourceString);
+        VERIFY_ARE_EQUAL(resourceStringLength, 0u);
+
+        MrmDestroyResourceManager(resourceManager);
+    }
+
     TEST_METHOD(ReadStringOrEmbeddedResource)
     {
         MrmManagerHandle resourceManager;
@@ -549,6 +826,97 @@ public:
         MrmDestroyResourceManager(resourceManager);
     }
 
+    TEST_METHOD(ReadStringResourcesBatch)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        PCWSTR resourceIds[] = {
+            L"resources/IDS_MANIFEST_MUSIC_APP_NAME",
+            L"resources/wrongresource",
+            L"Files/Controls/AlbumBasicInfoControl.xbf",
+            L"resources/IDS_MANIFEST_MUSIC_APP_NAME",
+        };
+
+        PWSTR* resourceStrings;
+        VERIFY_ARE_EQUAL(MrmLoadStringResources(resourceManager, nullptr, nullptr, ARRAYSIZE(resourceIds), resourceIds, &resourceStrings), S_OK);
+
+        VerifyStringEqual(resourceStrings[0], L"Groove Music");
+        VERIFY_IS_NULL(resourceStrings[1]);
+        VERIFY_IS_NULL(resourceStrings[2]);
+        VerifyStringEqual(resourceStrings[3], L"Groove Music");
+        VERIFY_ARE_NOT_EQUAL(resourceStrings[0], resourceStrings[3]);
+
+        // The whole batch is released with a single call.
+        MrmFreeResource(resourceStrings);
+        MrmDestroyResourceManager(resourceManager);
+    }
+
+    TEST_METHOD(LoadResourceCandidatesBatch)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        MrmMapHandle childResourceMap;
+        VERIFY_ARE_EQUAL(MrmGetChildResourceMap(resourceManager, nullptr, L"Microsoft.UI.Xaml", &childResourceMap), S_OK);
+
+        MrmMapHandle childChildResourceMap;
+        VERIFY_ARE_EQUAL(MrmGetChildResourceMap(resourceManager, childResourceMap, L"Resources", &childChildResourceMap), S_OK);
+
+        UINT32 count;
+        VERIFY_ARE_EQUAL(MrmGetResourceCount(resourceManager, childChildResourceMap, &count), S_OK);
+
+        UINT32 indices[78];
+        VERIFY_ARE_EQUAL(count, static_cast<UINT32>(ARRAYSIZE(indices)));
+        for (UINT32 i = 0; i < count; i++)
+        {
+            indices[i] = i;
+        }
+
+        MrmResourceValue* values;
+        VERIFY_ARE_EQUAL(MrmLoadResourceCandidates(resourceManager, nullptr, childChildResourceMap, count, nullptr, indices, &values), S_OK);
+
+        // Every item must match what the single-item API returns.
+        for (UINT32 i = 0; i < count; i++)
+        {
+            MrmType resourceType;
+            wchar_t* resourceString = nullptr;
+            wchar_t* resourceName = nullptr;
+            MrmResourceData resourceData {};
+            VERIFY_ARE_EQUAL(MrmLoadStringOrEmbeddedResourceByIndex(resourceManager, nullptr, childChildResourceMap, i, &resourceType, &resourceName, &resourceString, &resourceData), S_OK);
+
+            VERIFY_ARE_EQUAL(values[i].status, S_OK);
+            VERIFY_IS_TRUE(values[i].type == resourceType);
+            VerifyStringEqual(resourceName, values[i].name);
+            VerifyStringEqual(resourceString, values[i].string);
+
+            MrmFreeResource(resourceName);
+            MrmFreeResource(resourceString);
+        }
+        MrmFreeResource(values);
+
+        PCWSTR resourceIds[] = { L"Files/Controls/AlbumBasicInfoControl.xbf", L"resources/wrongresource" };
+        VERIFY_ARE_EQUAL(MrmLoadResourceCandidates(resourceManager, nullptr, nullptr, ARRAYSIZE(resourceIds), resourceIds, nullptr, &values), S_OK);
+
+        VERIFY_ARE_EQUAL(values[0].status, S_OK);
+        VERIFY_IS_TRUE(values[0].type == MrmType_Embedded);
+        VERIFY_IS_NULL(values[0].name);
+        VERIFY_IS_NULL(values[0].string);
+        VERIFY_IS_NOT_NULL(values[0].data.data);
+        VERIFY_ARE_EQUAL(values[0].data.size, 15002u);
+
+        VERIFY_ARE_EQUAL(values[1].status, HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+        VERIFY_IS_TRUE(values[1].type == MrmType_Unknown);
+
+        MrmFreeResource(values);
+
+        // Exactly one of names and indices must be supplied.
+        VERIFY_ARE_EQUAL(MrmLoadResourceCandidates(resourceManager, nullptr, nullptr, ARRAYSIZE(resourceIds), resourceIds, indices, &values), E_INVALIDARG);
+        VERIFY_ARE_EQUAL(MrmLoadResourceCandidates(resourceManager, nullptr, nullptr, ARRAYSIZE(resourceIds), nullptr, nullptr, &values), E_INVALIDARG);
+
+        MrmDestroyResourceManager(resourceManager);
+    }
+
     TEST_METHOD(InvalidPriName)
     {
         MrmManagerHandle resourceManager;
@@ -599,6 +967,51 @@ public:
         }
     }
 
+    TEST_METHOD(ConcurrentResolveScaling)
+    {
+        MrmManagerHandle resourceManager;
+        VERIFY_ARE_EQUAL(MrmCreateResourceManager(L".\\resources.pri", &resourceManager), S_OK);
+
+        const UINT32 maxThreads = min(8u, max(1u, GetActiveProcessorCount(ALL_PROCESSOR_GROUPS)));
+        const UINT32 iterationsPerThread = 2000;
+
+        for (UINT32 numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+        {
+            ResolveThreadContext context[8] = {};
+            HANDLE threads[8] = {};
+
+            LARGE_INTEGER frequency;
+            LARGE_INTEGER start;
+            LARGE_INTEGER end;
+            QueryPerformanceFrequency(&frequency);
+            QueryPerformanceCounter(&start);
+
+            for (UINT32 i = 0; i < numThreads; i++)
+            {
+                context[i].resourceManager = resourceManager;
+                context[i].iterations = iterationsPerThread;
+                context[i].result = S_OK;
+                threads[i] = CreateThread(nullptr, 0, ResolveThreadProc, &context[i], 0, nullptr);
+                VERIFY_IS_NOT_NULL(threads[i]);
+            }
+
+            VERIFY_ARE_EQUAL(WaitForMultipleObjects(numThreads, threads, TRUE, INFINITE), WAIT_OBJECT_0);
+            QueryPerformanceCounter(&end);
+
+            for (UINT32 i = 0; i < numThreads; i++)
+            {
+                CloseHandle(threads[i]);
+                VERIFY_ARE_EQUAL(context[i].result, S_OK);
+            }
+
+            double seconds = static_cast<double>(end.QuadPart - start.QuadPart) / static_cast<double>(frequency.QuadPart);
+            double lookupsPerSecond = (numThreads * iterationsPerThread) / ((seconds > 0) ? seconds : 1e-9);
+            Log::Comment(String().Format(L"%u thread(s): %.0f lookups/sec", numThreads, lookupsPerSecond));
+        }
+
+        MrmDestroyResourceManager(resourceManager);
+    }
+
     TEST_METHOD(GetFilePath)
     {
         wchar_t* path;
@@ -617,6 +1030,37 @@ public:
     }
 
 private:
+    struct ResolveThreadContext
+    {
+        MrmManagerHandle resourceManager;
+        UINT32 iterations;
+        HRESULT result;
+    };
+
+    static DWORD WINAPI ResolveThreadProc(LPVOID parameter)
+    {
+        ResolveThreadContext* context = static_cast<ResolveThreadContext*>(parameter);
+        for (UINT32 i = 0; i < context->iterations; i++)
+        {
+            wchar_t* resourceString;
+            HRESULT hr = MrmLoadStringResource(context->resourceManager, nullptr, nullptr, L"resources/IDS_MANIFEST_MUSIC_APP_NAME", &resourceString);
+            if (SUCCEEDED(hr) && (wcscmp(resourceString, L"Groove Music") != 0))
+            {
+                hr = E_UNEXPECTED;
+            }
+            if (SUCCEEDED(hr))
+            {
+                MrmFreeResource(resourceString);
+            }
+            if (FAILED(hr))
+            {
+                context->result = hr;
+                break;
+            }
+        }
+        return 0;
+    }
+
     void VerifyQualifierValue(UINT32 qualifierCount, PWSTR* qualifierNames, PWSTR* qualifierValues, PCWSTR name, PCWSTR expectedValue)
     {
         VERIFY_IS_GREATER_THAN(qualifierCount, 0u);
@@ -53,21 +53,7 @@ void ResourceContext::InitializeQualifierValueMap()
         {
             for (uint32_t i = 0; i < m_qualifierNames.size(); i++)
             {
-                // Override the default behavior
-                if (m_qualifierNames[i] == c_languageQualifierName)
-                {
-                    auto languages = GetLangugageContext();
-                    if (!languages.empty())
-                    {
-                        m_qualifierValueMap.Insert(m_qualifierNames[i], languages);
-                        continue;
-                    }
-                }
-
-                wchar_t* value;
-                winrt::check_hresult(MrmGetQualifier(m_resourceContext, m_qualifierNames[i].c_str(), &value));
-                string_resoure_ptr stringValue(value);
-                m_qualifierValueMap.Insert(m_qualifierNames[i], stringValue.get());
+                m_qualifierValueMap.Insert(m_qualifierNames[i], GetQualifierValue(m_resourceContext, m_qualifierNames[i]));
             }
         }
         else
@@ -79,6 +65,7 @@ void ResourceContext::InitializeQualifierValueMap()
 
 winrt::Windows::Foundation::Collections::IMap<hstring, hstring> ResourceContext::QualifierValues()
 {
+    slim_lock_guard const guard {m_lock};
     InitializeQualifierValueMap();
 
     return m_qualifierValueMap;
@@ -92,15 +79,66 @@ void ResourceContext::Apply()
         return;
     }
 
+    slim_lock_guard const guard {m_lock};
     InitializeQualifierValueMap();
 
     for (auto const& eachValue : m_qualifierValueMap)
     {
-        if (!eachValue.Value().empty())
+        hstring value = eachValue.Value();
+        if (value.empty())
         {
-            winrt::check_hresult(MrmSetQualifier(m_resourceContext, eachValue.Key().c_str(), eachValue.Value().c_str()));
+            continue;
         }
+
+        auto applied = m_appliedQualifierValues.find(eachValue.Key());
+        if ((applied != m_appliedQualifierValues.end()) && (applied->second == value))
+        {
+            // Unchanged since the last Apply. Skip it so the resolver keeps its cached decisions.
+            continue;
+        }
+
+        winrt::check_hresult(MrmSetQualifier(m_resourceContext, eachValue.Key().c_str(), value.c_str()));
+        m_appliedQualifierValues[eachValue.Key()] = value;
+    }
+}
+
+void ResourceContext::RefreshQualifierValues()
+{
+    slim_lock_guard const guard {m_lock};
+    InitializeQualifierValueMap();
+
+    // The language list is the only qualifier value that can change at runtime. The profile gives every
+    // other qualifier a fixed value, so those were read once by InitializeQualifierValueMap and are not
+    // read again here. Apply() then only pushes the language list if it actually changed.
+    auto languages = GetLangugageContext();
+    if (languages.empty())
+    {
+        // Application languages are unavailable; keep whatever the context was initialized with.
+        return;
     }
+
+    if (m_qualifierValueMap.HasKey(c_languageQualifierName) && (m_qualifierValueMap.Lookup(c_languageQualifierName) != languages))
+    {
+        m_qualifierValueMap.Insert(c_languageQualifierName, languages);
+    }
+}
+
+hstring ResourceContext::GetQualifierValue(MrmContextHandle resourceContext, hstring const& qualifierName)
+{
+    // Override the default behavior
+    if (qualifierName == c_languageQualifierName)
+    {
+        auto languages = GetLangugageContext();
+        if (!languages.empty())
+        {
+            return languages;
+        }
+    }
+
+    wchar_t* value;
+    winrt::check_hresult(MrmGetQualifier(resourceContext, qualifierName.c_str(), &value));
+    string_resoure_ptr stringValue(value);
+    return hstring(stringValue.get());
 }
 
 hstring ResourceContext::GetLangugageContext()
@@ -3,6 +3,7 @@
 
 #pragma once
 #include "ResourceContext.g.h"
+#include <map>
 
 namespace winrt::Microsoft::Windows::ApplicationModel::Resources::implementation
 {
@@ -16,16 +17,23 @@ struct ResourceContext : ResourceContextT<ResourceContext>
     winrt::Windows::Foundation::Collections::IMap<hstring, hstring> QualifierValues();
 
     void Apply();
+    void RefreshQualifierValues();
     MrmContextHandle GetContextHandle() { return m_resourceContext; }
 
 private:
     void InitializeQualifierNames();
     void InitializeQualifierValueMap();
     hstring GetLangugageContext();
+    hstring GetQualifierValue(MrmContextHandle resourceContext, hstring const& qualifierName);
 
     MrmContextHandle m_resourceContext = nullptr;
     com_array<hstring> m_qualifierNames;
     winrt::Windows::Foundation::Collections::IMap<hstring, hstring> m_qualifierValueMap = nullptr;
+
+    // Values last pushed to m_resourceContext by Apply(). Setting a qualifier invalidates the resolver's
+    // decision cache, so Apply() only calls MrmSetQualifier for values that differ from these.
+    std::map<hstring, hstring> m_appliedQualifierValues;
+    slim_mutex m_lock;
 };
 
 } // namespace winrt::Microsoft::Windows::ApplicationModel::Resources::implementation
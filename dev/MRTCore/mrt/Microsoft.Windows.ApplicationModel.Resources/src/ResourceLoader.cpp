@@ -41,19 +41,22 @@ hstring ResourceLoader::GetDefaultResourceFilePath()
 
 hstring ResourceLoader::GetString(hstring const& resourceId)
 {
-    wchar_t* resourceString;
-    winrt::check_hresult(MrmLoadStringResource(m_resourceManager, nullptr, m_currentResourceMap, resourceId.c_str(), &resourceString));
+    // The view is owned by m_resourceManager, so the hstring is the only copy made.
+    PCWSTR resourceString;
+    UINT32 resourceStringLength;
+    winrt::check_hresult(MrmLoadStringResourceView(
+        m_resourceManager, nullptr, m_currentResourceMap, resourceId.c_str(), &resourceString, &resourceStringLength));
 
-    string_resoure_ptr resourceContainer(resourceString);
-    return winrt::to_hstring(resourceContainer.get());
+    return hstring(resourceString, resourceStringLength);
 }
 
 hstring ResourceLoader::GetStringForUri(winrt::Windows::Foundation::Uri const& resourceUri)
 {
-    wchar_t* resourceString;
-    winrt::check_hresult(MrmLoadStringResourceFromResourceUri(m_resourceManager, nullptr, resourceUri.ToString().c_str(), &resourceString));
+    PCWSTR resourceString;
+    UINT32 resourceStringLength;
+    winrt::check_hresult(MrmLoadStringResourceViewFromResourceUri(
+        m_resourceManager, nullptr, resourceUri.ToString().c_str(), &resourceString, &resourceStringLength));
 
-    string_resoure_ptr resourceContainer(resourceString);
-    return winrt::to_hstring(resourceContainer.get());
+    return hstring(resourceString, resourceStringLength);
 }
 } // namespace winrt::Microsoft::Windows::ApplicationModel::Resources::implementation
@@ -52,6 +52,22 @@ Microsoft::Windows::ApplicationModel::Resources::ResourceContext ResourceManager
     return winrt::make<ResourceContext>(contextHandle);
 }
 
+Microsoft::Windows::ApplicationModel::Resources::ResourceContext ResourceManager::GetDefaultResourceContext()
+{
+    Microsoft::Windows::ApplicationModel::Resources::ResourceContext context = nullptr;
+    {
+        slim_lock_guard const guard {m_defaultContextLock};
+        if (m_defaultResourceContext == nullptr)
+        {
+            m_defaultResourceContext = CreateResourceContext();
+        }
+        context = m_defaultResourceContext;
+    }
+
+    context.as<ResourceContext>()->RefreshQualifierValues();
+    return context;
+}
+
 winrt::event_token ResourceManager::ResourceNotFound(winrt::Windows::Foundation::TypedEventHandler<
                                                      Microsoft::Windows::ApplicationModel::Resources::ResourceManager,
                                                      Microsoft::Windows::ApplicationModel::Resources::ResourceNotFoundEventArgs> const& handler)
@@ -14,6 +14,7 @@ struct ResourceManager : ResourceManagerT<ResourceManager>
 
     Microsoft::Windows::ApplicationModel::Resources::ResourceMap MainResourceMap();
     Microsoft::Windows::ApplicationModel::Resources::ResourceContext CreateResourceContext();
+    Microsoft::Windows::ApplicationModel::Resources::ResourceContext GetDefaultResourceContext();
 
     winrt::event_token ResourceNotFound(winrt::Windows::Foundation::TypedEventHandler<
                                         Microsoft::Windows::ApplicationModel::Resources::ResourceManager,
@@ -30,6 +31,12 @@ private:
     MrmManagerHandle m_resourceManagerHandle = nullptr;
     slim_mutex m_lock;
 
+    // Context used when callers don't supply one. Reusing it keeps the resolver's decision cache warm
+    // across lookups instead of rebuilding it for every new context. Its language list is refreshed
+    // on every use; no other qualifier value changes at runtime.
+    Microsoft::Windows::ApplicationModel::Resources::ResourceContext m_defaultResourceContext = nullptr;
+    slim_mutex m_defaultContextLock;
+
     winrt::event<winrt::Windows::Foundation::TypedEventHandler<
         Microsoft::Windows::ApplicationModel::Resources::ResourceManager,
         Microsoft::Windows::ApplicationModel::Resources::ResourceNotFoundEventArgs>>
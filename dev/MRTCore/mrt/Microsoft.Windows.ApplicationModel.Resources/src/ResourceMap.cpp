@@ -56,12 +56,10 @@ Resources::ResourceMap ResourceMap::TryGetSubtree(hstring const& reference)
 
 Resources::ResourceCandidate ResourceMap::GetValueImpl(const Resources::ResourceContext* context, hstring const& resource, bool treatNotFoundAsOk)
 {
-    // Always use a context as we override the languages.
-    Resources::ResourceContext resourceContext = (context != nullptr) ? *context : m_resourceManager.CreateResourceContext();
-
     if (m_resourceManagerHandle == nullptr)
     {
         // Resource is not managed by MRT. Handle with event handler
+        Resources::ResourceContext resourceContext = (context != nullptr) ? *context : m_resourceManager.CreateResourceContext();
         Resources::ResourceCandidate candidate = m_resourceManager.as<ResourceManager>()->HandleResourceNotFound(resourceContext, resource);
         if (candidate != nullptr)
         {
@@ -75,6 +73,9 @@ Resources::ResourceCandidate ResourceMap::GetValueImpl(const Resources::Resource
         winrt::throw_hresult(HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
     }
 
+    // Always use a context as we override the languages.
+    Resources::ResourceContext resourceContext =
+        (context != nullptr) ? *context : m_resourceManager.as<ResourceManager>()->GetDefaultResourceContext();
     resourceContext.as<Resources::implementation::ResourceContext>()->Apply();
 
     MrmType resourceType;
@@ -91,7 +92,9 @@ Resources::ResourceCandidate ResourceMap::GetValueImpl(const Resources::Resource
         &resourceData);
     if (IsResourceNotFound(hr))
     {
-        Resources::ResourceCandidate candidate = m_resourceManager.as<ResourceManager>()->HandleResourceNotFound(resourceContext, resource);
+        // Don't hand the shared default context to event handlers, which could modify it.
+        Resources::ResourceContext eventContext = (context != nullptr) ? resourceContext : m_resourceManager.CreateResourceContext();
+        Resources::ResourceCandidate candidate = m_resourceManager.as<ResourceManager>()->HandleResourceNotFound(eventContext, resource);
         if (candidate != nullptr)
         {
             return candidate;
@@ -172,7 +175,7 @@ IKeyValuePair<hstring, Resources::ResourceCandidate> ResourceMap::GetValueByInde
 {
     // Always use a context as we override the languages.
     Microsoft::Windows::ApplicationModel::Resources::ResourceContext resourceContext =
-        (context != nullptr) ? *context : m_resourceManager.CreateResourceContext();
+        (context != nullptr) ? *context : m_resourceManager.as<ResourceManager>()->GetDefaultResourceContext();
 
     resourceContext.as<Resources::implementation::ResourceContext>()->Apply();
 
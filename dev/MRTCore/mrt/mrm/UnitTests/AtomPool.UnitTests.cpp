@@ -161,8 +161,279 @@ class FileAtomPoolUnitTests : public WEX::TestClass<FileAtomPoolUnitTests>, publ
     BEGIN_TEST_METHOD(BigPoolBuilderReaderTests)
         TEST_METHOD_PROPERTY(L"DataSource", L"Table:AtomPool.UnitTests.xml#BigAtomPoolTests")
     END_TEST_METHOD()
+
+    TEST_METHOD(HashVersionTests);
+    TEST_METHOD(HashTableTests);
+
+protected:
+    static const int CorpusNameLength = 96;
+
+    static int BuildNameCorpus(__in int maxNames, __out_ecount(maxNames* CorpusNameLength) WCHAR* pNames);
+    static int CountHashCollisions(__in_ecount(numNames* CorpusNameLength) const WCHAR* pNames, __in int numNames, __in Atom::HashMethod method);
+    static void TimeLookups(
+        __in_ecount(numNames* CorpusNameLength) const WCHAR* pNames,
+        __in int numNames,
+        __in bool useLegacyHash,
+        __out double* pMicrosecondsOut);
 };
 
+// Builds names shaped like the ones in real PRI files: long, mostly ASCII, with shared prefixes and suffixes.
+int FileAtomPoolUnitTests::BuildNameCorpus(__in int maxNames, __out_ecount(maxNames* CorpusNameLength) WCHAR* pNames)
+{
+    static const PCWSTR assets[] = {L"Square44x44Logo", L"Square150x150Logo", L"Wide310x150Logo", L"StoreLogo", L"SplashScreen",
+                                    L"LockScreenLogo", L"BadgeLogo", L"Square71x71Logo", L"Square310x310Logo", L"AppList"};
+    static const PCWSTR qualifiers[] = {L"scale-100", L"scale-125", L"scale-150", L"scale-200", L"scale-400",
+                                        L"targetsize-16", L"targetsize-24_altform-unplated", L"targetsize-32", L"targetsize-48_altform-lightunplated",
+                                        L"contrast-black_scale-200", L"contrast-white_scale-200", L"theme-dark_scale-100"};
+    static const PCWSTR sections[] = {L"SETTINGS", L"PLAYBACK", L"LIBRARY", L"ACCOUNT", L"NOTIFICATIONS", L"EQUALIZER", L"WHATS_NEW"};
+    static const PCWSTR suffixes[] = {L"TITLE", L"DESCRIPTION", L"TOOLTIP", L"AUTOMATION_NAME", L"BUTTON_TEXT"};
+
+    int numNames = 0;
+    for (int folder = 0; (folder < 8) && (numNames < maxNames); folder++)
+    {
+        for (int a = 0; (a < ARRAYSIZE(assets)) && (numNames < maxNames); a++)
+        {
+            for (int q = 0; (q < ARRAYSIZE(qualifiers)) && (numNames < maxNames); q++)
+            {
+                VERIFY_SUCCEEDED(StringCchPrintf(
+                    &pNames[numNames++ * CorpusNameLength], CorpusNameLength, L"Files/Assets/Folder%d/%s.%s.png", folder, assets[a], qualifiers[q]));
+            }
+        }
+    }
+
+    for (int i = 0; numNames < maxNames; i++)
+    {
+        VERIFY_SUCCEEDED(StringCchPrintf(
+            &pNames[numNames++ * CorpusNameLength],
+            CorpusNameLength,
+            L"resources/IDS_%s_ITEM_%d_%s",
+            sections[i % ARRAYSIZE(sections)],
+            i / ARRAYSIZE(sections),
+            suffixes[(i / 3) % ARRAYSIZE(suffixes)]));
+    }
+
+    return numNames;
+}
+
+static int __cdecl CompareHashes(const void* p1, const void* p2)
+{
+    Atom::Hash h1 = *static_cast<const Atom::Hash*>(p1);
+    Atom::Hash h2 = *static_cast<const Atom::Hash*>(p2);
+    return ((h1 < h2) ? -1 : ((h1 > h2) ? 1 : 0));
+}
+
+// Counts the names whose stored (32-bit) hash matches the hash of some other name in the corpus.
+int FileAtomPoolUnitTests::CountHashCollisions(
+    __in_ecount(numNames* CorpusNameLength) const WCHAR* pNames,
+    __in int numNames,
+    __in Atom::HashMethod method)
+{
+    Atom::Hash* pHashes = new Atom::Hash[numNames];
+    for (int i = 0; i < numNames; i++)
+    {
+        pHashes[i] = Atom::HashString(&pNames[i * CorpusNameLength], method);
+    }
+    qsort(pHashes, numNames, sizeof(Atom::Hash), CompareHashes);
+
+    int numColliding = 0;
+    for (int i = 1; i < numNames; i++)
+    {
+        if (pHashes[i] == pHashes[i - 1])
+        {
+            numColliding++;
+        }
+    }
+
+    delete[] pHashes;
+    return numColliding;
+}
+
+void FileAtomPoolUnitTests::TimeLookups(
+    __in_ecount(numNames* CorpusNameLength) const WCHAR* pNames,
+    __in int numNames,
+    __in bool useLegacyHash,
+    __out double* pMicrosecondsOut)
+{
+    FileAtomPoolBuilder* pBuilder = NULL;
+    const FileAtomPool* pReader = NULL;
+    Atom atom;
+
+    *pMicrosecondsOut = 0;
+
+    VERIFY_SUCCEEDED(FileAtomPoolBuilder::CreateInstance(L"Corpus", true, &pBuilder));
+    VERIFY_SUCCEEDED(pBuilder->SetUseHashV2(!useLegacyHash));
+    for (int i = 0; i < numNames; i++)
+    {
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddAtom(&pNames[i * CorpusNameLength], &atom));
+    }
+    pBuilder->SetPoolIndex(1);
+
+    BuildHelper pool;
+    VERIFY_SUCCEEDED(pool.Build(pBuilder));
+    VERIFY_SUCCEEDED(FileAtomPool::CreateInstance(pool.GetBuffer(), pool.GetBufferSize(), (FileAtomPool**)&pReader));
+
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+    LARGE_INTEGER end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    int numFound = 0;
+    for (int i = 0; i < numNames; i++)
+    {
+        Atom::Index index;
+        if (pReader->TryGetIndex(&pNames[i * CorpusNameLength], &index) && (index == i))
+        {
+            numFound++;
+        }
+    }
+
+    QueryPerformanceCounter(&end);
+    VERIFY_ARE_EQUAL(numNames, numFound);
+
+    *pMicrosecondsOut = (static_cast<double>(end.QuadPart - start.QuadPart) * 1000000.0) / static_cast<double>(frequency.QuadPart);
+
+    delete pReader;
+    delete pBuilder;
+}
+
+void FileAtomPoolUnitTests::HashVersionTests(void)
+{
+    const Atom::HashMethod v2 = Atom::HashMethodVersion2;
+    const Atom::HashMethod v2CaseInsensitive = static_cast<Atom::HashMethod>(Atom::HashMethodVersion2 | Atom::HashMethodCaseInsensitive);
+
+    // Case folding only applies when asked for.
+    VERIFY_ARE_EQUAL(Atom::HashString(L"Files/Assets/Logo.PNG", v2CaseInsensitive), Atom::HashString(L"files/assets/logo.png", v2CaseInsensitive));
+    VERIFY_ARE_NOT_EQUAL(Atom::HashString(L"Files/Assets/Logo.PNG", v2), Atom::HashString(L"files/assets/logo.png", v2));
+    VERIFY_ARE_EQUAL(Atom::HashString64(L"\x00C9T\x00C9", Atom::HashMethodCaseInsensitive), Atom::HashString64(L"\x00E9t\x00E9", Atom::HashMethodCaseInsensitive));
+
+    // The legacy hash must not change; existing files depend on it.
+    VERIFY_ARE_EQUAL(static_cast<Atom::Hash>(0xD2A8), Atom::HashString(L"ab", Atom::HashMethodDefault));
+
+    // New pools default to the legacy hash so shipped readers can read them. Pools of both versions
+    // round-trip, and the header says which hash each one uses.
+    FileAtomPoolBuilder* pBuilder = NULL;
+    const FileAtomPool* pReader = NULL;
+    Atom atom;
+    for (int legacy = 0; legacy < 2; legacy++)
+    {
+        VERIFY_SUCCEEDED(FileAtomPoolBuilder::CreateInstance(L"Test", true, &pBuilder));
+        VERIFY_IS_FALSE(pBuilder->GetUsesHashV2());
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddAtom(L"str1", &atom));
+        VERIFY_SUCCEEDED(pBuilder->SetUseHashV2(legacy == 0));
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddAtom(L"str2", &atom));
+        pBuilder->SetPoolIndex(1);
+
+        BuildHelper pool;
+        VERIFY_SUCCEEDED(pool.Build(pBuilder));
+        const DEFFILE_ATOMPOOL_HEADER* pHdr = reinterpret_cast<const DEFFILE_ATOMPOOL_HEADER*>(pool.GetBuffer());
+        VERIFY_ARE_EQUAL((legacy != 0), ((pHdr->flags & DEFFILE_ATOMPOOL_HASH_V2) == 0));
+
+        VERIFY_SUCCEEDED(FileAtomPool::CreateInstance(pool.GetBuffer(), pool.GetBufferSize(), (FileAtomPool**)&pReader));
+        VERIFY_IS_TRUE(pReader->TryGetAtom(L"STR1", &atom) && (atom.GetIndex() == 0));
+        VERIFY_IS_TRUE(pReader->TryGetAtom(L"str2", &atom) && (atom.GetIndex() == 1));
+
+        delete pReader;
+        pReader = NULL;
+        delete pBuilder;
+        pBuilder = NULL;
+    }
+
+    // Collision statistics and lookup timings over a realistic set of names.
+    const int maxNames = 4000;
+    WCHAR* pNames = new WCHAR[maxNames * CorpusNameLength];
+    int numNames = BuildNameCorpus(maxNames, pNames);
+
+    int legacyCollisions = CountHashCollisions(pNames, numNames, Atom::HashMethodCaseInsensitive);
+    int v2Collisions = CountHashCollisions(pNames, numNames, v2CaseInsensitive);
+    String logmsg;
+    logmsg.Format(L"%d names: %d legacy hash collisions, %d version 2 hash collisions", numNames, legacyCollisions, v2Collisions);
+    Log::Comment(logmsg);
+
+    // With a 32-bit hash and a few thousand names, a well-mixed hash should see at most a stray collision.
+    VERIFY_IS_LESS_THAN_OR_EQUAL(v2Collisions, 2);
+    VERIFY_IS_LESS_THAN_OR_EQUAL(v2Collisions, legacyCollisions);
+
+    double legacyMicroseconds;
+    double v2Microseconds;
+    TimeLookups(pNames, numNames, true, &legacyMicroseconds);
+    TimeLookups(pNames, numNames, false, &v2Microseconds);
+    logmsg.Format(L"%d lookups: legacy hash %.0f us, version 2 hash %.0f us", numNames, legacyMicroseconds, v2Microseconds);
+    Log::Comment(logmsg);
+
+    delete[] pNames;
+}
+
+void FileAtomPoolUnitTests::HashTableTests(void)
+{
+    const int maxNames = 600;
+    WCHAR* pNames = new WCHAR[maxNames * CorpusNameLength];
+    int numNames = BuildNameCorpus(maxNames, pNames);
+
+    FileAtomPoolBuilder* pBuilder = NULL;
+    const FileAtomPool* pReader = NULL;
+    Atom atom;
+    Atom::Index index;
+
+    VERIFY_SUCCEEDED(FileAtomPoolBuilder::CreateInstance(L"Corpus", true, &pBuilder));
+    for (int i = 0; i < numNames; i++)
+    {
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddAtom(&pNames[i * CorpusNameLength], &atom));
+        VERIFY_ARE_EQUAL(i, atom.GetIndex());
+    }
+
+    // The builder finds existing atoms through its own table.
+    for (int i = 0; i < numNames; i++)
+    {
+        VERIFY_IS_TRUE(pBuilder->TryGetIndex(&pNames[i * CorpusNameLength], &index));
+        VERIFY_ARE_EQUAL(i, index);
+    }
+    VERIFY_IS_FALSE(pBuilder->TryGetIndex(L"resources/NotInThePool", &index));
+    pBuilder->SetPoolIndex(1);
+
+    BuildHelper pool;
+    VERIFY_SUCCEEDED(pool.Build(pBuilder));
+    DEFFILE_ATOMPOOL_HEADER* pHdr = reinterpret_cast<DEFFILE_ATOMPOOL_HEADER*>(pool.GetBuffer());
+    VERIFY_IS_TRUE((pHdr->flags & DEFFILE_ATOMPOOL_HASH_TABLE) != 0);
+
+    // Look up every name through the stored table, then again with the flag cleared so the reader
+    // falls back to a table built on first lookup, as it does for older files.
+    for (int stored = 1; stored >= 0; stored--)
+    {
+        if (!stored)
+        {
+            pHdr->flags &= ~DEFFILE_ATOMPOOL_HASH_TABLE;
+        }
+
+        VERIFY_SUCCEEDED(FileAtomPool::CreateInstance(pool.GetBuffer(), pool.GetBufferSize(), (FileAtomPool**)&pReader));
+        for (int i = 0; i < numNames; i++)
+        {
+            VERIFY_IS_TRUE(pReader->TryGetIndex(&pNames[i * CorpusNameLength], &index));
+            VERIFY_ARE_EQUAL(i, index);
+        }
+        VERIFY_IS_TRUE(pReader->TryGetAtom(L"FILES/ASSETS/FOLDER0/STORELOGO.SCALE-100.PNG", &atom));
+        VERIFY_IS_FALSE(pReader->TryGetIndex(L"resources/NotInThePool", &index));
+
+        delete pReader;
+        pReader = NULL;
+    }
+
+    // A table that isn't a power of two, or that has no room for an empty bucket, is rejected.
+    pHdr->flags |= DEFFILE_ATOMPOOL_HASH_TABLE;
+    UINT32 cbTableOffset = BaseFile::PadData(FileAtomPool::GetSizeInBytes(pHdr), BaseFile::Align32Bit);
+    DEFFILE_ATOMPOOL_HASHTABLE* pTable = reinterpret_cast<DEFFILE_ATOMPOOL_HASHTABLE*>(pool.GetBuffer() + cbTableOffset);
+    VERIFY_ARE_EQUAL(FileAtomPool::GetHashTableNumBuckets(numNames), pTable->nBuckets);
+
+    pTable->nBuckets = static_cast<UINT32>(numNames);
+    VERIFY_ARE_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+        FileAtomPool::CreateInstance(pool.GetBuffer(), pool.GetBufferSize(), (FileAtomPool**)&pReader));
+    VERIFY_IS_NULL(pReader);
+
+    delete pBuilder;
+    delete[] pNames;
+}
+
 void FileAtomPoolUnitTests::New_ParamChecks(void)
 {
     BYTE buf[1000];
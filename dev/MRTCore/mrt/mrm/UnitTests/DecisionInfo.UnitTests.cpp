@@ -47,6 +47,8 @@ public:
     BEGIN_TEST_METHOD(UnifiedDecisionInfoTests)
         TEST_METHOD_PROPERTY(L"DataSource", L"Table:DecisionInfo.UnitTests.xml#MergeTests")
     END_TEST_METHOD();
+
+    TEST_METHOD(CompiledQualifierEvaluationTests);
 };
 
 bool DecisionInfoUnitTests::ClassSetup() { return true; }
@@ -104,6 +106,131 @@ void DecisionInfoUnitTests::SimpleBuilderTests()
     validate.ValidateDecisions(pBuilder, pEnvironment);
 }
 
+void DecisionInfoUnitTests::CompiledQualifierEvaluationTests()
+{
+    static const PCWSTR qualifierNames[] = {L"scale", L"target", L"contrast", L"theme", L"layoutdir", L"dxfl"};
+    static const PCWSTR values[] = {
+        L"", L"80", L"100", L"140", L"150", L"200", L"400", L"16", L"256", L"standard", L"high", L"BLACK", L"white", L"dark",
+        L"Light", L"LTR", L"rtl", L"DX9", L"dx10", L"dx11", L"dx12", L"en-US", L"bogus", L"100;200", L"-5", L"99999"};
+    String tmp;
+
+    AutoDeletePtr<CoreProfile> pProfile;
+    VERIFY_SUCCEEDED(CoreProfile::ChooseDefaultProfile(&pProfile));
+    AutoDeletePtr<AtomPoolGroup> pAtoms;
+    VERIFY_SUCCEEDED(AtomPoolGroup::CreateInstance(&pAtoms));
+    AutoDeletePtr<UnifiedEnvironment> pEnvironment;
+    VERIFY_SUCCEEDED(UnifiedEnvironment::CreateInstance(pProfile, pAtoms, &pEnvironment));
+    AutoDeletePtr<DecisionInfoBuilder> pBuilder;
+    VERIFY_SUCCEEDED(DecisionInfoBuilder::CreateInstance(pEnvironment, &pBuilder));
+
+    // Wherever a type compiles both values, the compiled score must match the score from the strings.
+    for (int n = 0; n < ARRAYSIZE(qualifierNames); n++)
+    {
+        const IBuildQualifierType* pType;
+        VERIFY_SUCCEEDED(pEnvironment->GetTypeOfQualifier(qualifierNames[n], &pType));
+
+        int numCompiled = 0;
+        for (int a = 0; a < ARRAYSIZE(values); a++)
+        {
+            QualifierResult qualifier;
+            StringResult literal;
+            IQualifierType::CompiledValue assetValue;
+            if (FAILED(pBuilder->GetOrAddQualifier(qualifierNames[n], values[a], 500, 0.0, &qualifier)) ||
+                FAILED(pType->ValidateQualifier(&qualifier)) || FAILED(qualifier.GetOperand2Literal(&literal)) ||
+                !pType->TryCompileValue(literal.GetRef(), &assetValue))
+            {
+                continue;
+            }
+
+            for (int c = 0; c < ARRAYSIZE(values); c++)
+            {
+                IQualifierType::CompiledValue contextValue;
+                if (!pType->TryCompileValue(values[c], &contextValue))
+                {
+                    continue;
+                }
+
+                double score = 0.0;
+                (void)pType->Evaluate(&qualifier, values[c], &score);
+                double compiledScore = pType->EvaluateCompiled(assetValue, contextValue);
+                if (score != compiledScore)
+                {
+                    Log::Error(tmp.Format(
+                        L"[ %s-%s in context %s: compiled score %f, expected %f ]",
+                        qualifierNames[n],
+                        values[a],
+                        values[c],
+                        compiledScore,
+                        score));
+                }
+                VERIFY_ARE_EQUAL(score, compiledScore);
+                numCompiled++;
+            }
+        }
+
+        Log::Comment(tmp.Format(L"[ %s: %d compiled comparisons ]", qualifierNames[n], numCompiled));
+    }
+
+    // Numeric and enumerated qualifiers have compiled forms.
+    const IBuildQualifierType* pScaleType;
+    const IBuildQualifierType* pContrastType;
+    IQualifierType::CompiledValue compiled;
+    VERIFY_SUCCEEDED(pEnvironment->GetTypeOfQualifier(L"scale", &pScaleType));
+    VERIFY_SUCCEEDED(pEnvironment->GetTypeOfQualifier(L"contrast", &pContrastType));
+    VERIFY_IS_TRUE(pScaleType->TryCompileValue(L"150", &compiled));
+    VERIFY_ARE_EQUAL(150, compiled.value);
+    VERIFY_IS_FALSE(pScaleType->TryCompileValue(L"scale", &compiled));
+    VERIFY_IS_TRUE(pContrastType->TryCompileValue(L"High", &compiled));
+    VERIFY_IS_FALSE(pContrastType->TryCompileValue(L"bogus", &compiled));
+
+    // Language lists are split once, and scoring against the split list must match scoring the string.
+    static const PCWSTR languages[] = {L"en-US", L"EN-us", L"fr", L"fr-FR", L"de-DE", L"ja"};
+    static const PCWSTR languageLists[] = {L"en-US", L"fr-FR;en-US", L"de-DE;fr;en-US", L"ja;JA;en-us", L"x-bogus;fr", L"fr;", L"de"};
+    const IBuildQualifierType* pLanguageType;
+    VERIFY_SUCCEEDED(pEnvironment->GetTypeOfQualifier(L"language", &pLanguageType));
+    for (int a = 0; a < ARRAYSIZE(languages); a++)
+    {
+        QualifierResult qualifier;
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddQualifier(L"language", languages[a], 500, 0.0, &qualifier));
+
+        for (int c = 0; c < ARRAYSIZE(languageLists); c++)
+        {
+            IQualifierType::CompiledList contextList;
+            VERIFY_IS_TRUE(pLanguageType->TryCompileValueList(languageLists[c], &contextList));
+
+            double score = 0.0;
+            double compiledScore = 0.0;
+            HRESULT hr = pLanguageType->Evaluate(&qualifier, languageLists[c], &score);
+            HRESULT compiledHr = pLanguageType->EvaluateCompiledList(&qualifier, contextList, &compiledScore);
+            IQualifierType::FreeCompiledList(&contextList);
+
+            if (score != compiledScore)
+            {
+                Log::Error(tmp.Format(
+                    L"[ language-%s in context %s: compiled score %f, expected %f ]",
+                    languages[a],
+                    languageLists[c],
+                    compiledScore,
+                    score));
+            }
+            VERIFY_ARE_EQUAL(hr, compiledHr);
+            VERIFY_ARE_EQUAL(score, compiledScore);
+        }
+    }
+
+    IQualifierType::CompiledList list;
+    VERIFY_IS_TRUE(pLanguageType->TryCompileValueList(L"de-DE;fr;", &list));
+    VERIFY_ARE_EQUAL(3u, list.numValues);
+    VERIFY_ARE_EQUAL(0, wcscmp(list.pList, L"de-DE;fr;"));
+    VERIFY_ARE_EQUAL(0, wcscmp(list.ppValues[1], L"fr"));
+    VERIFY_ARE_EQUAL(0, wcscmp(list.ppValues[2], L""));
+    IQualifierType::FreeCompiledList(&list);
+
+    // A list with leading whitespace, and types that don't take lists, are left to Evaluate.
+    VERIFY_IS_FALSE(pLanguageType->TryCompileValueList(L" de-DE;fr", &list));
+    VERIFY_IS_FALSE(pScaleType->TryCompileValueList(L"100", &list));
+}
+
 void DecisionInfoUnitTests::SimpleBuilderReaderTests()
 {
     TestHPri pri;
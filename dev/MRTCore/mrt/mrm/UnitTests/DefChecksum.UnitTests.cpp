@@ -39,6 +39,7 @@ public:
         TEST_METHOD_PROPERTY(L"DataSource", L"Table:DefChecksum.UnitTests.xml#FileChecksumTests")
     END_TEST_METHOD()
     TEST_METHOD(FileChecksumFailsForMissingFile);
+    TEST_METHOD(Crc32ImplementationTests);
 };
 
 void DefChecksumUnitTests::IntegerChecksumTests(void)
@@ -356,4 +357,83 @@ void DefChecksumUnitTests::FileChecksumFailsForMissingFile(void)
     VERIFY_FAILED(DefChecksum::ComputeFileChecksum(0, L"missingfile.htm", &checksum));
 }
 
+void DefChecksumUnitTests::Crc32ImplementationTests(void)
+{
+    const DEF_CRC32_IMPLEMENTATION implementations[] = {
+        DefCrc32Implementation_Bytewise, DefCrc32Implementation_SliceBy8, DefCrc32Implementation_Hardware};
+    String tmp;
+
+    Log::Comment(tmp.Format(
+        L"[ Hardware CRC32 %s ]",
+        (_DefIsCrc32ImplementationSupported(DefCrc32Implementation_Hardware) ? L"is supported" : L"is not supported; using slicing-by-8")));
+
+    // Standard check value for the ISO 3309 CRC32
+    const char check[] = "123456789";
+    for (int i = 0; i < ARRAYSIZE(implementations); i++)
+    {
+        VERIFY_ARE_EQUAL(
+            0xcbf43926u,
+            _DefComputeCrc32WithImplementation(implementations[i], 0, reinterpret_cast<const BYTE*>(check), sizeof(check) - 1));
+    }
+    VERIFY_ARE_EQUAL(0xcbf43926u, _DefComputeCrc32(0, reinterpret_cast<const BYTE*>(check), sizeof(check) - 1));
+
+    // Compare every implementation against the bytewise one over random buffers, alignments, lengths and
+    // partial CRCs. Lengths cluster around the block sizes used by the faster implementations.
+    const UINT32 cbBuffer = 16 * 1024;
+    BYTE* pBuffer = _DefArray_Alloc(BYTE, cbBuffer);
+    VERIFY_IS_NOT_NULL(pBuffer);
+
+    UINT32 seed = 0x2545f491;
+    for (UINT32 i = 0; i < cbBuffer; i++)
+    {
+        seed = (seed * 1103515245) + 12345;
+        pBuffer[i] = static_cast<BYTE>(seed >> 16);
+    }
+
+    int numMismatches = 0;
+    for (int iteration = 0; (iteration < 20000) && (numMismatches < 10); iteration++)
+    {
+        seed = (seed * 1103515245) + 12345;
+        UINT32 offset = (seed >> 8) % 64;
+        seed = (seed * 1103515245) + 12345;
+        UINT32 cbData = ((iteration % 16) == 0) ? ((seed >> 4) % (cbBuffer - offset)) : ((seed >> 4) % 300);
+        seed = (seed * 1103515245) + 12345;
+        UINT32 partialCrc = seed;
+
+        UINT32 expected = _DefComputeCrc32WithImplementation(DefCrc32Implementation_Bytewise, partialCrc, pBuffer + offset, cbData);
+        for (int i = 1; i < ARRAYSIZE(implementations); i++)
+        {
+            UINT32 actual = _DefComputeCrc32WithImplementation(implementations[i], partialCrc, pBuffer + offset, cbData);
+            if (actual != expected)
+            {
+                Log::Error(tmp.Format(
+                    L"[ Implementation %d: offset %u, length %u, partial 0x%08x: expected 0x%08x, got 0x%08x ]",
+                    implementations[i],
+                    offset,
+                    cbData,
+                    partialCrc,
+                    expected,
+                    actual));
+                numMismatches++;
+            }
+        }
+
+        if (_DefComputeCrc32(partialCrc, pBuffer + offset, cbData) != expected)
+        {
+            Log::Error(tmp.Format(L"[ _DefComputeCrc32: offset %u, length %u: mismatch ]", offset, cbData));
+            numMismatches++;
+        }
+    }
+
+    // Computing a CRC in pieces must match computing it in one call.
+    UINT32 whole = _DefComputeCrc32WithImplementation(DefCrc32Implementation_Hardware, 0, pBuffer, cbBuffer);
+    UINT32 pieces = _DefComputeCrc32WithImplementation(DefCrc32Implementation_Hardware, 0, pBuffer, 1000);
+    pieces = _DefComputeCrc32WithImplementation(DefCrc32Implementation_SliceBy8, pieces, pBuffer + 1000, 3);
+    pieces = _DefComputeCrc32WithImplementation(DefCrc32Implementation_Hardware, pieces, pBuffer + 1003, cbBuffer - 1003);
+    VERIFY_ARE_EQUAL(whole, pieces);
+
+    _DefFree(pBuffer);
+    VERIFY_ARE_EQUAL(0, numMismatches);
+}
+
 }; // namespace UnitTests
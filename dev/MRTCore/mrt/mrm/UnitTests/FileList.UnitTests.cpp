@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "StdAfx.h"
+#include "Helpers.h"
+#include "mrm/build/Base.h"
+#include "mrm/build/FileBuilder.h"
+#include "mrm/build/FileListBuilder.h"
+#include "mrm/readers/FileLists.h"
+
+using namespace WEX::Common;
+using namespace WEX::TestExecution;
+using namespace WEX::Logging;
+
+using namespace Microsoft::Resources;
+using namespace Microsoft::Resources::Build;
+
+namespace UnitTests
+{
+class FileListUnitTests : public WEX::TestClass<FileListUnitTests>
+{
+    TEST_CLASS(FileListUnitTests);
+
+    TEST_METHOD(PathLookupTests);
+
+private:
+    void BuildTestFileList(_In_ BuildHelper* pBuild);
+};
+
+void FileListUnitTests::BuildTestFileList(_In_ BuildHelper* pBuild)
+{
+    const PCWSTR folders[] = { L"app", L"Assets" };
+    const PCWSTR appFiles[] = { L"readme.txt", L"resources.pri" };
+    const PCWSTR assetFiles[] = { L"logo.png", L"Square44x44Logo.png", L"icon.png" };
+
+    AutoDeletePtr<FileBuilder> pFileBuilder;
+    VERIFY_SUCCEEDED(FileBuilder::CreateInstance(gTestPriFileMagic, 4, &pFileBuilder));
+    AutoDeletePtr<FileListBuilder> pBuilder;
+    VERIFY_SUCCEEDED(FileListBuilder::CreateInstance(pFileBuilder, FileListBuilder::BuildAsciiOrUtf16, &pBuilder));
+
+    FolderInfo* pRoot;
+    VERIFY_SUCCEEDED(pBuilder->GetOrAddRootFolder(L"C:", &pRoot));
+    FolderInfo* pApp;
+    VERIFY_SUCCEEDED(pRoot->GetOrAddSubfolder(folders[0], &pApp));
+    FolderInfo* pAssets;
+    VERIFY_SUCCEEDED(pApp->GetOrAddSubfolder(folders[1], &pAssets));
+
+    FileInfo* pFile;
+    for (int i = 0; i < ARRAYSIZE(appFiles); i++)
+    {
+        VERIFY_SUCCEEDED(pApp->GetOrAddFile(appFiles[i], &pFile));
+    }
+    for (int i = 0; i < ARRAYSIZE(assetFiles); i++)
+    {
+        VERIFY_SUCCEEDED(pAssets->GetOrAddFile(assetFiles[i], &pFile));
+    }
+
+    VERIFY_SUCCEEDED(pBuild->Build(pBuilder));
+}
+
+void FileListUnitTests::PathLookupTests()
+{
+    BuildHelper build;
+    BuildTestFileList(&build);
+
+    AutoDeletePtr<FileFileList> pList;
+    VERIFY_SUCCEEDED(FileFileList::CreateInstance(build.GetBuffer(), build.GetBufferSize(), &pList));
+    VERIFY_ARE_EQUAL(pList->GetTotalNumFiles(), 5);
+    VERIFY_ARE_EQUAL(pList->GetTotalNumFolders(), 3);
+
+    // GetFilePath takes the entry index plus one, and rejects anything past the last file.
+    StringResult path;
+    VERIFY_ARE_EQUAL(pList->GetFilePath(0, &path), E_INVALIDARG);
+    VERIFY_ARE_EQUAL(pList->GetFilePath(pList->GetTotalNumFiles() + 1, &path), HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND));
+
+    // Every file is found by its own path and by its path in another case.
+    // Lookups return the 0-based entry index.
+    StringResult variant;
+    for (int i = 0; i < pList->GetTotalNumFiles(); i++)
+    {
+        VERIFY_SUCCEEDED(pList->GetFilePath(i + 1, &path));
+        Log::Comment(String().Format(L"File %d: %s", i, path.GetRef()));
+
+        int index = -1;
+        VERIFY_IS_TRUE(pList->TryGetFileIndex(path.GetRef(), &index));
+        VERIFY_ARE_EQUAL(index, i);
+
+        VERIFY_SUCCEEDED(variant.SetCopy(path.GetRef()));
+        PWSTR pVariant = const_cast<PWSTR>(variant.GetRef());
+        for (PWSTR pCh = pVariant; *pCh != L'\0'; pCh++)
+        {
+            *pCh = towlower(*pCh);
+        }
+        VERIFY_IS_TRUE(pList->TryGetFileIndex(pVariant, &index));
+        VERIFY_ARE_EQUAL(index, i);
+
+        int folderIndex = -1;
+        VERIFY_IS_FALSE(pList->TryGetFolderIndex(path.GetRef(), &folderIndex));
+    }
+
+    for (int i = 0; i < pList->GetTotalNumFolders(); i++)
+    {
+        VERIFY_SUCCEEDED(pList->GetFolderPath(i, &path));
+        Log::Comment(String().Format(L"Folder %d: %s", i, path.GetRef()));
+
+        int index = -1;
+        VERIFY_IS_TRUE(pList->TryGetFolderIndex(path.GetRef(), &index));
+        VERIFY_ARE_EQUAL(index, i);
+
+        VERIFY_SUCCEEDED(variant.SetCopy(path.GetRef()));
+        PWSTR pVariant = const_cast<PWSTR>(variant.GetRef());
+        for (PWSTR pCh = pVariant; *pCh != L'\0'; pCh++)
+        {
+            *pCh = towupper(*pCh);
+        }
+        VERIFY_IS_TRUE(pList->TryGetFolderIndex(pVariant, &index));
+        VERIFY_ARE_EQUAL(index, i);
+    }
+
+    int index = -1;
+    VERIFY_IS_FALSE(pList->TryGetFileIndex(L"C:\\app\\missing.png", &index));
+    VERIFY_ARE_EQUAL(index, -1);
+    VERIFY_IS_FALSE(pList->TryGetFileIndex(L"C:\\app\\Assets", &index));
+    VERIFY_IS_FALSE(pList->TryGetFileIndex(L"C:\\app\\Assets\\logo.png.bak", &index));
+    VERIFY_IS_FALSE(pList->TryGetFolderIndex(L"C:\\other", &index));
+}
+
+} // namespace UnitTests
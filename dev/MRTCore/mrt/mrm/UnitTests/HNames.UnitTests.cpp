@@ -37,6 +37,14 @@ class HierarchicalNamesUnitTests : public WEX::TestClass<HierarchicalNamesUnitTe
     BEGIN_TEST_METHOD(LargeBuilderReaderTests)
         TEST_METHOD_PROPERTY(L"DataSource", L"Table:HNames.UnitTests.xml#LargeBuilderReaderTests")
     END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(WideScopeLookupTests)
+        TEST_METHOD_PROPERTY(L"DataSource", L"Table:HNames.UnitTests.xml#WideScopeLookupTests")
+    END_TEST_METHOD()
+
+    TEST_METHOD(InsertionOrderTests);
+
+    TEST_METHOD(NonAsciiCaseTests);
 };
 
 void CheckNames(_In_ const IHierarchicalNames* pNames)
@@ -795,4 +803,214 @@ void HierarchicalNamesUnitTests::LargeBuilderReaderTests(void)
     }
 }
 
+void HierarchicalNamesUnitTests::WideScopeLookupTests(void)
+{
+    HRESULT hr = S_OK;
+    String tmp;
+
+    int numItems = -1;
+    int numPasses = 1;
+    String nameFormat = L"Resources/String%d";
+
+    if (FAILED(TestData::TryGetValue(L"NumItems", numItems)))
+    {
+        Log::Error(L"[ NumItems not defined ]");
+        return;
+    }
+
+    if (FAILED(TestData::TryGetValue(L"NameFormat", nameFormat)))
+    {
+        Log::Warning(L"[ NameFormat not defined. Using default ]");
+    }
+
+    if (FAILED(TestData::TryGetValue(L"NumPasses", numPasses)))
+    {
+        Log::Warning(L"[ NumPasses not defined. Using default ]");
+    }
+
+    int buildFlags = 0;
+    if (FAILED(TestData::TryGetValue(L"BuildFlags", buildFlags)))
+    {
+        Log::Warning(L"[ BuildFlags not defined. Using default ]");
+    }
+
+    AutoDeletePtr<HierarchicalNamesBuilder> pBuilder;
+    hr = HierarchicalNamesBuilder::CreateInstance(buildFlags, &pBuilder);
+    VERIFY_HRESULT_EXPR((pBuilder != NULL), hr);
+
+    WCHAR nameBuf[MAX_PATH];
+    for (int iItem = 0; iItem < numItems; iItem++)
+    {
+        VERIFY_SUCCEEDED(StringCchPrintf(nameBuf, ARRAYSIZE(nameBuf), (PCWSTR)nameFormat, iItem));
+
+        ItemInfo* item;
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddItem(nameBuf, &item));
+    }
+
+    BuildHelper names;
+    VERIFY_HRESULT(names.Build(pBuilder));
+
+    const DEFFILE_SECTION_TYPEID& type =
+        ((buildFlags & HierarchicalNamesBuilder::BuildAsciiOrUtf16) != 0) ? gHierarchicalNamesExSectionType : gHierarchicalNamesSectionType;
+
+    AutoDeletePtr<HierarchicalNames> pReader;
+    hr = HierarchicalNames::CreateInstance(type, names.GetBuffer(), names.GetBufferSize(), &pReader);
+    VERIFY_HRESULT_EXPR((pReader != NULL), hr);
+
+    SYSTEMTIME start;
+    SYSTEMTIME checkpoint;
+    SYSTEMTIME elapsed;
+
+    GetSystemTime(&start);
+    for (int iPass = 0; iPass < numPasses; iPass++)
+    {
+        for (int iItem = 0; iItem < numItems; iItem++)
+        {
+            VERIFY_SUCCEEDED(StringCchPrintf(nameBuf, ARRAYSIZE(nameBuf), (PCWSTR)nameFormat, iItem));
+
+            // Alternate passes look up the upper-cased name to exercise case folding.
+            if ((iPass % 2) != 0)
+            {
+                CharUpperBuff(nameBuf, static_cast<DWORD>(wcslen(nameBuf)));
+            }
+
+            int itemIndex = -1;
+            if (!pReader->Contains(nameBuf, nullptr, &itemIndex) || (itemIndex < 0))
+            {
+                Log::Error(tmp.Format(L"[ Couldn't find '%s' in hierarchical names ]", nameBuf));
+                return;
+            }
+
+            // Names one past the end of the set must not be found.
+            VERIFY_SUCCEEDED(StringCchPrintf(nameBuf, ARRAYSIZE(nameBuf), (PCWSTR)nameFormat, numItems + iItem));
+            if (pReader->Contains(nameBuf))
+            {
+                Log::Error(tmp.Format(L"[ Unexpectedly found '%s' in hierarchical names ]", nameBuf));
+                return;
+            }
+        }
+    }
+    GetSystemTime(&checkpoint);
+    ComputeElapsedTime(start, checkpoint, &elapsed);
+
+    Log::Comment(tmp.Format(
+        L"[ %d passes of %d hit and %d miss lookups (elapsed: %02d:%02d:%02d:%03d) ]",
+        numPasses,
+        numItems,
+        numItems,
+        elapsed.wHour,
+        elapsed.wMinute,
+        elapsed.wSecond,
+        elapsed.wMilliseconds));
+}
+
+// Adds a wide scope, a few nested scopes and names that differ only by case in the given order.
+static void AddInsertionOrderNames(_In_ HierarchicalNamesBuilder* pBuilder, _In_ int numItems, _In_ bool reverse)
+{
+    WCHAR nameBuf[MAX_PATH];
+    for (int i = 0; i < numItems; i++)
+    {
+        int iItem = (reverse ? (numItems - 1 - i) : i);
+        if ((iItem % 3) == 0)
+        {
+            VERIFY_SUCCEEDED(StringCchPrintf(nameBuf, ARRAYSIZE(nameBuf), L"Files/Level%d/Item%d", iItem % 7, iItem));
+        }
+        else
+        {
+            VERIFY_SUCCEEDED(StringCchPrintf(nameBuf, ARRAYSIZE(nameBuf), L"Resources/%cString%d", L'a' + (iItem % 26), iItem));
+        }
+
+        ItemInfo* pItem;
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddItem(nameBuf, &pItem));
+
+        // The same name in a different case refers to the same item.
+        CharUpperBuff(nameBuf, static_cast<DWORD>(wcslen(nameBuf)));
+        ItemInfo* pSameItem;
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddItem(nameBuf, &pSameItem));
+        VERIFY_ARE_EQUAL(pItem, pSameItem);
+    }
+}
+
+void HierarchicalNamesUnitTests::InsertionOrderTests(void)
+{
+    const int numItems = 2000;
+
+    // Item indices follow insertion order, so only the scope and name layout can be compared
+    // directly. Build the same names in both orders and check each against its own lookups.
+    AutoDeletePtr<HierarchicalNamesBuilder> pForward;
+    VERIFY_SUCCEEDED(HierarchicalNamesBuilder::CreateInstance(0, &pForward));
+    AddInsertionOrderNames(pForward, numItems, false);
+
+    AutoDeletePtr<HierarchicalNamesBuilder> pReverse;
+    VERIFY_SUCCEEDED(HierarchicalNamesBuilder::CreateInstance(0, &pReverse));
+    AddInsertionOrderNames(pReverse, numItems, true);
+
+    VERIFY_ARE_EQUAL(pForward->GetNumNames(), pReverse->GetNumNames());
+    VERIFY_ARE_EQUAL(pForward->GetNumScopes(), pReverse->GetNumScopes());
+
+    BuildHelper forwardNames;
+    VERIFY_SUCCEEDED(forwardNames.Build(pForward));
+    BuildHelper reverseNames;
+    VERIFY_SUCCEEDED(reverseNames.Build(pReverse));
+    VERIFY_ARE_EQUAL(forwardNames.GetWrittenSize(), reverseNames.GetWrittenSize());
+
+    AutoDeletePtr<HierarchicalNames> pForwardReader;
+    VERIFY_SUCCEEDED(HierarchicalNames::CreateInstance(
+        gHierarchicalNamesSectionType, forwardNames.GetBuffer(), forwardNames.GetBufferSize(), &pForwardReader));
+    AutoDeletePtr<HierarchicalNames> pReverseReader;
+    VERIFY_SUCCEEDED(HierarchicalNames::CreateInstance(
+        gHierarchicalNamesSectionType, reverseNames.GetBuffer(), reverseNames.GetBufferSize(), &pReverseReader));
+
+    // Name nodes are laid out from the sorted children, so every name must land at the same name
+    // index in both builds, and the reader's sorted lookups must find it there.
+    StringResult forwardName;
+    StringResult reverseName;
+    for (int i = 1; i < pForwardReader->GetNumNames(); i++)
+    {
+        VERIFY_IS_TRUE(pForwardReader->TryGetName(i, &forwardName));
+        VERIFY_IS_TRUE(pReverseReader->TryGetName(i, &reverseName));
+        VERIFY_IS_TRUE(DefString_IEqual(forwardName.GetRef(), reverseName.GetRef()));
+
+        int nameIndex = -1;
+        VERIFY_IS_TRUE(pForwardReader->Contains(forwardName.GetRef(), nullptr, nullptr, &nameIndex));
+        VERIFY_ARE_EQUAL(nameIndex, i);
+        VERIFY_IS_TRUE(pReverseReader->Contains(forwardName.GetRef(), nullptr, nullptr, &nameIndex));
+        VERIFY_ARE_EQUAL(nameIndex, i);
+    }
+}
+
+void HierarchicalNamesUnitTests::NonAsciiCaseTests(void)
+{
+    AutoDeletePtr<HierarchicalNamesBuilder> pBuilder;
+    VERIFY_SUCCEEDED(HierarchicalNamesBuilder::CreateInstance(0, &pBuilder));
+
+    // Enough siblings that both the builder and the reader look children up through their hash index.
+    WCHAR nameBuf[MAX_PATH];
+    ItemInfo* pItem;
+    for (int i = 0; i < 32; i++)
+    {
+        VERIFY_SUCCEEDED(StringCchPrintf(nameBuf, ARRAYSIZE(nameBuf), L"Names/Item%d", i));
+        VERIFY_SUCCEEDED(pBuilder->GetOrAddItem(nameBuf, &pItem));
+    }
+
+    // Names that differ only in the case of a non-ASCII character are the same node.
+    VERIFY_SUCCEEDED(pBuilder->GetOrAddItem(L"Names/a\u00e9", &pItem));
+    int numNames = pBuilder->GetNumNames();
+    ItemInfo* pSameItem;
+    VERIFY_SUCCEEDED(pBuilder->GetOrAddItem(L"Names/a\u00c9", &pSameItem));
+    VERIFY_ARE_EQUAL(pItem, pSameItem);
+    VERIFY_ARE_EQUAL(numNames, pBuilder->GetNumNames());
+
+    BuildHelper names;
+    VERIFY_SUCCEEDED(names.Build(pBuilder));
+    AutoDeletePtr<HierarchicalNames> pReader;
+    VERIFY_SUCCEEDED(HierarchicalNames::CreateInstance(gHierarchicalNamesSectionType, names.GetBuffer(), names.GetBufferSize(), &pReader));
+
+    int nameIndex = -1;
+    int otherNameIndex = -1;
+    VERIFY_IS_TRUE(pReader->Contains(L"Names/a\u00e9", nullptr, nullptr, &nameIndex));
+    VERIFY_IS_TRUE(pReader->Contains(L"NAMES/A\u00c9", nullptr, nullptr, &otherNameIndex));
+    VERIFY_ARE_EQUAL(nameIndex, otherNameIndex);
+}
+
 }; // namespace UnitTests
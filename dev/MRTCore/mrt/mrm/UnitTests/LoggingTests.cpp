@@ -13,6 +13,7 @@ class LoggingTests : public WEX::TestClass<LoggingTests>
     TEST_CLASS(LoggingTests);
 
     TEST_METHOD(LogInMemory);
+    TEST_METHOD(ResolvedResourceCacheCounters);
 };
 
 void LoggingTests::LogInMemory()
@@ -26,4 +27,19 @@ void LoggingTests::LogInMemory()
         LOG_ERROR_IN_MEMORY(0x80070002 + i, 100 + i, nullptr, L"MRT rocks");
     }
 }
+
+void LoggingTests::ResolvedResourceCacheCounters()
+{
+    UINT64 hitsBefore, missesBefore;
+    GetResolvedResourceCacheCounters(&hitsBefore, &missesBefore);
+
+    LogResolvedResourceCacheLookup(true);
+    LogResolvedResourceCacheLookup(true);
+    LogResolvedResourceCacheLookup(false);
+
+    UINT64 hits, misses;
+    GetResolvedResourceCacheCounters(&hits, &misses);
+    VERIFY_ARE_EQUAL(hitsBefore + 2, hits);
+    VERIFY_ARE_EQUAL(missesBefore + 1, misses);
+}
 } // namespace UnitTests
\ No newline at end of file
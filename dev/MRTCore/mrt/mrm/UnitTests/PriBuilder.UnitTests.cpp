@@ -32,6 +32,26 @@ public:
     BEGIN_TEST_METHOD(DeduplicationTests)
         TEST_METHOD_PROPERTY(L"DataSource", L"Table:PriBuilder.UnitTests.xml#DeduplicationTests")
     END_TEST_METHOD();
+
+    BEGIN_TEST_METHOD(ParallelBuildTests)
+        TEST_METHOD_PROPERTY(L"DataSource", L"Table:PriBuilder.UnitTests.xml#SimpleBuildTests")
+    END_TEST_METHOD();
+
+    BEGIN_TEST_METHOD(StreamingBuildTests)
+        TEST_METHOD_PROPERTY(L"DataSource", L"Table:PriBuilder.UnitTests.xml#SimpleBuildTests")
+    END_TEST_METHOD();
+
+    BEGIN_TEST_METHOD(OptimizedStringTests)
+        TEST_METHOD_PROPERTY(L"DataSource", L"Table:PriBuilder.UnitTests.xml#SimpleBuildTests")
+    END_TEST_METHOD();
+
+    BEGIN_TEST_METHOD(BatchedOptimizedStringTests)
+        TEST_METHOD_PROPERTY(L"DataSource", L"Table:PriBuilder.UnitTests.xml#SimpleBuildTests")
+    END_TEST_METHOD();
+
+    BEGIN_TEST_METHOD(QueuedStringTests)
+        TEST_METHOD_PROPERTY(L"DataSource", L"Table:PriBuilder.UnitTests.xml#SimpleBuildTests")
+    END_TEST_METHOD();
 };
 
 void PriBuilderUnitTests::SimpleBuilderReaderTests()
@@ -67,6 +87,366 @@ void PriBuilderUnitTests::SimpleBuilderReaderTests()
     TestHPri::VerifyAgainstTestVars(pri.GetPriFile(), L"", pri.GetTestDI(), L"");
 }
 
+void PriBuilderUnitTests::ParallelBuildTests()
+{
+    String tmp;
+
+    AutoDeletePtr<CoreProfile> pProfile;
+    VERIFY_SUCCEEDED(CoreProfile::ChooseDefaultProfile(&pProfile));
+
+    // Build the same PRI serially and in parallel. The files must be identical.
+    TestHPri serialPri;
+    TestHPri parallelPri;
+    Log::Comment(L"[ Setting up test PRIs ]");
+    if (FAILED(serialPri.InitFromTestVars(L"", NULL, pProfile, NULL)) || FAILED(parallelPri.InitFromTestVars(L"", NULL, pProfile, NULL)))
+    {
+        Log::Error(L"[ Couldn't init TestPri ]");
+        return;
+    }
+
+    parallelPri.GetFileBuilder()->SetParallelBuild(true);
+    VERIFY_IS_FALSE(serialPri.GetFileBuilder()->GetParallelBuild());
+    VERIFY_IS_TRUE(parallelPri.GetFileBuilder()->GetParallelBuild());
+
+    Log::Comment(L"[ Building test PRIs ]");
+    VERIFY_SUCCEEDED(serialPri.Build());
+    VERIFY_SUCCEEDED(parallelPri.Build());
+
+    if (serialPri.GetBuffer() == nullptr)
+    {
+        VERIFY_IS_NULL(parallelPri.GetBuffer());
+        return;
+    }
+
+    Log::Comment(
+        tmp.Format(L"[ Comparing %u sections, %u bytes ]", serialPri.GetFileBuilder()->GetNumSections(), serialPri.GetBufferSize()));
+    VERIFY_IS_NOT_NULL(parallelPri.GetBuffer());
+    VERIFY_ARE_EQUAL(serialPri.GetBufferSize(), parallelPri.GetBufferSize());
+    VERIFY_ARE_EQUAL(0, memcmp(serialPri.GetBuffer(), parallelPri.GetBuffer(), serialPri.GetBufferSize()));
+
+    Log::Comment(L"[ Verifying parallel PRI ]");
+    VERIFY_SUCCEEDED(parallelPri.CreateReader(pProfile));
+    TestHPri::VerifyAgainstTestVars(parallelPri.GetPriFile(), L"", parallelPri.GetTestDI(), L"");
+}
+
+void PriBuilderUnitTests::StreamingBuildTests()
+{
+    String tmp;
+
+    AutoDeletePtr<CoreProfile> pProfile;
+    VERIFY_SUCCEEDED(CoreProfile::ChooseDefaultProfile(&pProfile));
+
+    // Build the same PRI in memory and streamed to a file. The files must be identical.
+    TestHPri bufferedPri;
+    TestHPri streamingPri;
+    Log::Comment(L"[ Setting up test PRIs ]");
+    if (FAILED(bufferedPri.InitFromTestVars(L"", NULL, pProfile, NULL)) || FAILED(streamingPri.InitFromTestVars(L"", NULL, pProfile, NULL)))
+    {
+        Log::Error(L"[ Couldn't init TestPri ]");
+        return;
+    }
+
+    Log::Comment(L"[ Building buffered test PRI ]");
+    VERIFY_SUCCEEDED(bufferedPri.Build());
+    if (bufferedPri.GetBuffer() == nullptr)
+    {
+        return;
+    }
+
+    WCHAR tempPath[MAX_PATH];
+    WCHAR priPath[MAX_PATH];
+    VERIFY_IS_TRUE(GetTempPathW(ARRAYSIZE(tempPath), tempPath) != 0);
+    VERIFY_IS_TRUE(GetTempFileNameW(tempPath, L"pri", 0, priPath) != 0);
+
+    Log::Comment(tmp.Format(L"[ Streaming test PRI to %s ]", priPath));
+    streamingPri.GetFileBuilder()->SetStreamingGeneration(true);
+    VERIFY_SUCCEEDED(streamingPri.WriteToFile(priPath));
+    VERIFY_ARE_EQUAL(Done, streamingPri.GetFileBuilder()->GetPhase());
+
+    size_t cbStreamed = 0;
+    void* pStreamed = nullptr;
+    VERIFY_SUCCEEDED(BaseFile::LoadFileData(priPath, &cbStreamed, &pStreamed));
+    DeleteFileW(priPath);
+
+    Log::Comment(tmp.Format(L"[ Comparing %u bytes ]", bufferedPri.GetBufferSize()));
+    VERIFY_ARE_EQUAL(static_cast<size_t>(bufferedPri.GetBufferSize()), cbStreamed);
+    VERIFY_ARE_EQUAL(0, memcmp(bufferedPri.GetBuffer(), pStreamed, cbStreamed));
+    Def_Free(pStreamed);
+}
+
+void PriBuilderUnitTests::OptimizedStringTests()
+{
+    String tmp;
+
+    TestHPri pri;
+    AutoDeletePtr<CoreProfile> pProfile;
+    VERIFY_SUCCEEDED(CoreProfile::ChooseDefaultProfile(&pProfile));
+
+    Log::Comment(L"[ Setting up test PRI ]");
+    if (FAILED(pri.InitFromTestVars(L"", NULL, pProfile, NULL)))
+    {
+        Log::Error(L"[ Couldn't init TestPri ]");
+        return;
+    }
+
+    int qualifierSetIndex;
+    VERIFY_SUCCEEDED(pri.GetPriSectionBuilder()->GetDecisionInfoBuilder()->GetOrAddQualifierSet(nullptr, &qualifierSetIndex));
+    DataItemOrchestrator* dataItems = pri.GetPriSectionBuilder()->GetDataItemOrchestrator();
+
+    // The ASCII check looks at eight code units at a time where SIMD is available, then four, then one, so
+    // the non-ASCII strings put their first wide code unit in each of those steps.
+    struct
+    {
+        MrmEnvironment::ResourceValueType originalType;
+        PCWSTR value;
+        MrmEnvironment::ResourceValueType expectedType;
+    } const cases[] = {
+        {MrmEnvironment::ResourceValueType_Utf16String, L"abc", MrmEnvironment::ResourceValueType_AsciiString},
+        {MrmEnvironment::ResourceValueType_Utf16String, L"Plain value 42", MrmEnvironment::ResourceValueType_AsciiString},
+        {MrmEnvironment::ResourceValueType_Utf16String, L"Gr\u00F6\u00DFe 42", MrmEnvironment::ResourceValueType_Utf8String},
+        {MrmEnvironment::ResourceValueType_Utf16String, L"Plain caf\u00E9", MrmEnvironment::ResourceValueType_Utf8String},
+        {MrmEnvironment::ResourceValueType_Utf16String, L"Plain ca\u00E9fes", MrmEnvironment::ResourceValueType_Utf8String},
+        {MrmEnvironment::ResourceValueType_Utf16String, L"Plain value caf\u00E9", MrmEnvironment::ResourceValueType_Utf8String},
+        {MrmEnvironment::ResourceValueType_Utf16String, L"Plain values, all ASCII", MrmEnvironment::ResourceValueType_AsciiString},
+        {MrmEnvironment::ResourceValueType_Utf16String, L"\u8A2D\u5B9A\u3092\u958B\u304F", MrmEnvironment::ResourceValueType_Utf16String},
+        {MrmEnvironment::ResourceValueType_Utf16Path, L"Assets\\Logo.png", MrmEnvironment::ResourceValueType_AsciiPath},
+        {MrmEnvironment::ResourceValueType_Utf16Path, L"Assets\\Gr\u00F6\u00DFe.png", MrmEnvironment::ResourceValueType_Utf8Path},
+    };
+
+    // The deduplication map keeps pointing at the references it hands out, so they have to outlive every add.
+    AutoDeletePtr<IBuildInstanceReference> references[ARRAYSIZE(cases)];
+    for (int i = 0; i < ARRAYSIZE(cases); i++)
+    {
+        MrmEnvironment::ResourceValueType optimalType;
+        VERIFY_SUCCEEDED(dataItems->AddOptimizedStringAndCreateInstanceReference(
+            cases[i].originalType, cases[i].value, qualifierSetIndex, &references[i], &optimalType));
+
+        Log::Comment(tmp.Format(L"[ \"%s\" is stored as value type %d ]", cases[i].value, optimalType));
+        VERIFY_IS_NOT_NULL(references[i]);
+        VERIFY_ARE_EQUAL(static_cast<int>(optimalType), static_cast<int>(cases[i].expectedType));
+    }
+
+    // Strings can only be optimized from UTF-16.
+    AutoDeletePtr<IBuildInstanceReference> pReference;
+    MrmEnvironment::ResourceValueType optimalType;
+    VERIFY_ARE_EQUAL(
+        dataItems->AddOptimizedStringAndCreateInstanceReference(
+            MrmEnvironment::ResourceValueType_AsciiString, L"abc", qualifierSetIndex, &pReference, &optimalType),
+        E_DEF_INCOMPATIBLE_VALUE_TYPE);
+}
+
+void PriBuilderUnitTests::BatchedOptimizedStringTests()
+{
+    String tmp;
+
+    AutoDeletePtr<CoreProfile> pProfile;
+    VERIFY_SUCCEEDED(CoreProfile::ChooseDefaultProfile(&pProfile));
+
+    // Enough strings that the batch is encoded on the thread pool. Every third string repeats an earlier
+    // one, and the values cycle through strings that are best stored as ASCII, UTF-8 and UTF-16.
+    const UINT32 numStrings = 2000;
+    PCWSTR const valueFormats[] = {L"Plain value %u", L"Gr\u00F6\u00DFe %u", L"\u8A2D\u5B9A\u3092\u958B\u304F %u"};
+    WCHAR values[numStrings][32];
+    for (UINT32 i = 0; i < numStrings; i++)
+    {
+        UINT32 valueIndex = ((i % 3) == 2) ? (i / 2) : i;
+        swprintf_s(values[i], valueFormats[valueIndex % ARRAYSIZE(valueFormats)], valueIndex);
+    }
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        bool deduplicate = (pass == 0);
+
+        // Add the same strings one at a time and as a batch. The PRI files must be identical.
+        TestHPri singlePri;
+        TestHPri batchedPri;
+        Log::Comment(tmp.Format(L"[ Setting up test PRIs, deduplication %s ]", deduplicate ? L"on" : L"off"));
+        if (FAILED(singlePri.InitFromTestVars(L"", NULL, pProfile, NULL)) || FAILED(batchedPri.InitFromTestVars(L"", NULL, pProfile, NULL)))
+        {
+            Log::Error(L"[ Couldn't init TestPri ]");
+            return;
+        }
+
+        // Spread the strings over the neutral qualifier set and an en-US one.
+        int singleQualifierSets[2];
+        int batchedQualifierSets[2];
+        TestHPri* pris[] = {&singlePri, &batchedPri};
+        int* qualifierSets[] = {singleQualifierSets, batchedQualifierSets};
+        for (int i = 0; i < 2; i++)
+        {
+            DecisionInfoBuilder* pDecisions = pris[i]->GetPriSectionBuilder()->GetDecisionInfoBuilder();
+            AutoDeletePtr<DecisionInfoQualifierSetBuilder> qualifierSetBuilder;
+            VERIFY_SUCCEEDED(DecisionInfoQualifierSetBuilder::CreateInstance(pDecisions, &qualifierSetBuilder));
+            VERIFY_SUCCEEDED(pDecisions->GetOrAddQualifierSet(nullptr, &qualifierSets[i][0]));
+            VERIFY_SUCCEEDED(qualifierSetBuilder->AddQualifier(L"Language", L"en-US", 0.0));
+            VERIFY_SUCCEEDED(pDecisions->GetOrAddQualifierSet(qualifierSetBuilder, &qualifierSets[i][1]));
+        }
+
+        DataItemOrchestrator* singleDataItems = singlePri.GetPriSectionBuilder()->GetDataItemOrchestrator();
+        DataItemOrchestrator* batchedDataItems = batchedPri.GetPriSectionBuilder()->GetDataItemOrchestrator();
+        if (!deduplicate)
+        {
+            singleDataItems->DisableDeduplication();
+            batchedDataItems->DisableDeduplication();
+        }
+
+        unique_deffree_ptr<IBuildInstanceReference*> singleReferences(_DefArray_AllocZeroed(IBuildInstanceReference*, numStrings));
+        unique_deffree_ptr<DataItemOrchestrator::OptimizedString> batchedStrings(
+            _DefArray_AllocZeroed(DataItemOrchestrator::OptimizedString, numStrings));
+        VERIFY_IS_NOT_NULL(singleReferences.get());
+        VERIFY_IS_NOT_NULL(batchedStrings.get());
+
+        // The orchestrator doesn't own the references it hands out.
+        auto deleteReferences = wil::scope_exit([&] {
+            for (UINT32 i = 0; i < numStrings; i++)
+            {
+                delete singleReferences.get()[i];
+                delete batchedStrings.get()[i].result;
+            }
+        });
+
+        Log::Comment(tmp.Format(L"[ Adding %u strings ]", numStrings));
+        for (UINT32 i = 0; i < numStrings; i++)
+        {
+            MrmEnvironment::ResourceValueType optimalType;
+            VERIFY_SUCCEEDED(singleDataItems->AddOptimizedStringAndCreateInstanceReference(
+                MrmEnvironment::ResourceValueType_Utf16String,
+                values[i],
+                singleQualifierSets[i % 2],
+                &singleReferences.get()[i],
+                &optimalType));
+
+            batchedStrings.get()[i].originalType = MrmEnvironment::ResourceValueType_Utf16String;
+            batchedStrings.get()[i].value = values[i];
+            batchedStrings.get()[i].qualifierSetIndex = batchedQualifierSets[i % 2];
+        }
+        VERIFY_SUCCEEDED(batchedDataItems->AddOptimizedStringsAndCreateInstanceReferences(numStrings, batchedStrings.get()));
+
+        for (UINT32 i = 0; i < numStrings; i++)
+        {
+            VERIFY_IS_NOT_NULL(batchedStrings.get()[i].result);
+            if (i < ARRAYSIZE(valueFormats))
+            {
+                Log::Comment(tmp.Format(L"[ \"%s\" is stored as value type %d ]", values[i], batchedStrings.get()[i].optimalType));
+            }
+        }
+
+        Log::Comment(L"[ Building test PRIs ]");
+        VERIFY_SUCCEEDED(singlePri.Build());
+        VERIFY_SUCCEEDED(batchedPri.Build());
+
+        if (singlePri.GetBuffer() == nullptr)
+        {
+            VERIFY_IS_NULL(batchedPri.GetBuffer());
+            continue;
+        }
+
+        Log::Comment(tmp.Format(L"[ Comparing %u bytes ]", singlePri.GetBufferSize()));
+        VERIFY_IS_NOT_NULL(batchedPri.GetBuffer());
+        VERIFY_ARE_EQUAL(singlePri.GetBufferSize(), batchedPri.GetBufferSize());
+        VERIFY_ARE_EQUAL(0, memcmp(singlePri.GetBuffer(), batchedPri.GetBuffer(), singlePri.GetBufferSize()));
+    }
+}
+
+void PriBuilderUnitTests::QueuedStringTests()
+{
+    String tmp;
+
+    AutoDeletePtr<CoreProfile> pProfile;
+    VERIFY_SUCCEEDED(CoreProfile::ChooseDefaultProfile(&pProfile));
+
+    // Add the same candidates through the string queue and one at a time through the orchestrator and map
+    // builder. An embedded data candidate every hundred strings forces the queue to flush part way through.
+    TestHPri queuedPri;
+    TestHPri singlePri;
+    Log::Comment(L"[ Setting up test PRIs ]");
+    if (FAILED(queuedPri.InitFromTestVars(L"", NULL, pProfile, NULL)) || FAILED(singlePri.InitFromTestVars(L"", NULL, pProfile, NULL)))
+    {
+        Log::Error(L"[ Couldn't init TestPri ]");
+        return;
+    }
+
+    PriSectionBuilder* queuedBuilder = queuedPri.GetPriSectionBuilder();
+    PriSectionBuilder* singleBuilder = singlePri.GetPriSectionBuilder();
+    ResourceMapSectionBuilder* singleMap;
+    VERIFY_SUCCEEDED(singleBuilder->GetOrAddPrimaryResourceMapBuilder(&singleMap));
+
+    AutoDeletePtr<DecisionInfoQualifierSetBuilder> queuedQualifiers;
+    AutoDeletePtr<DecisionInfoQualifierSetBuilder> singleQualifiers;
+    VERIFY_SUCCEEDED(queuedBuilder->GetQualifierSetBuilder(&queuedQualifiers));
+    VERIFY_SUCCEEDED(singleBuilder->GetQualifierSetBuilder(&singleQualifiers));
+
+    PCWSTR const languages[] = {L"en-US", L"de-DE", L"ja-JP"};
+    PCWSTR const valueFormats[] = {L"Plain value %u", L"Gr\u00F6\u00DFe %u", L"\u8A2D\u5B9A\u3092\u958B\u304F %u"};
+    const BYTE embeddedData[] = {0x01, 0x02, 0x03, 0x04};
+    const UINT32 numResources = 1000;
+
+    Log::Comment(tmp.Format(L"[ Adding %u resources ]", numResources));
+    for (UINT32 i = 0; i < numResources; i++)
+    {
+        WCHAR name[32];
+        WCHAR value[32];
+        swprintf_s(name, L"Resources/String%u", i);
+
+        // Every other resource repeats its value in each language, so deduplication has work to do.
+        for (int language = 0; language < ARRAYSIZE(languages); language++)
+        {
+            UINT32 valueIndex = ((i % 2) == 0) ? i : (i + language);
+            swprintf_s(value, valueFormats[valueIndex % ARRAYSIZE(valueFormats)], valueIndex);
+
+            queuedQualifiers->Reset();
+            VERIFY_SUCCEEDED(queuedQualifiers->AddQualifier(L"Language", languages[language], (language == 0) ? 1.0 : 0.0));
+            VERIFY_SUCCEEDED(queuedBuilder->AddCandidateWithString(
+                nullptr, name, MrmEnvironment::ResourceValueType_Utf16String, value, queuedQualifiers));
+
+            singleQualifiers->Reset();
+            VERIFY_SUCCEEDED(singleQualifiers->AddQualifier(L"Language", languages[language], (language == 0) ? 1.0 : 0.0));
+            AutoDeletePtr<IBuildInstanceReference> reference;
+            int qualifierSetIndex;
+            MrmEnvironment::ResourceValueType optimalType;
+            VERIFY_SUCCEEDED(singleBuilder->GetDataItemOrchestrator()->AddOptimizedStringAndCreateInstanceReference(
+                MrmEnvironment::ResourceValueType_Utf16String, value, singleQualifiers, &reference, &qualifierSetIndex, &optimalType));
+            VERIFY_SUCCEEDED(singleMap->AddCandidate(name, optimalType, reference, qualifierSetIndex));
+            reference.Detach();
+        }
+
+        if ((i % 100) == 99)
+        {
+            swprintf_s(name, L"Resources/Data%u", i);
+            VERIFY_SUCCEEDED(queuedBuilder->AddCandidateWithEmbeddedData(
+                nullptr, name, MrmEnvironment::ResourceValueType_EmbeddedData, embeddedData, sizeof(embeddedData), nullptr));
+            VERIFY_SUCCEEDED(singleBuilder->AddCandidateWithEmbeddedData(
+                nullptr, name, MrmEnvironment::ResourceValueType_EmbeddedData, embeddedData, sizeof(embeddedData), nullptr));
+        }
+    }
+
+    Log::Comment(L"[ Building test PRIs ]");
+    VERIFY_SUCCEEDED(queuedPri.Build());
+    VERIFY_SUCCEEDED(singlePri.Build());
+
+    VERIFY_IS_NOT_NULL(queuedPri.GetBuffer());
+    VERIFY_IS_NOT_NULL(singlePri.GetBuffer());
+    Log::Comment(tmp.Format(L"[ Comparing %u bytes ]", singlePri.GetBufferSize()));
+    VERIFY_ARE_EQUAL(singlePri.GetBufferSize(), queuedPri.GetBufferSize());
+    VERIFY_ARE_EQUAL(0, memcmp(singlePri.GetBuffer(), queuedPri.GetBuffer(), singlePri.GetBufferSize()));
+
+    // A duplicate candidate is only detected when the queue is flushed.
+    TestHPri duplicatePri;
+    if (FAILED(duplicatePri.InitFromTestVars(L"", NULL, pProfile, NULL)))
+    {
+        Log::Error(L"[ Couldn't init TestPri ]");
+        return;
+    }
+
+    PriSectionBuilder* duplicateBuilder = duplicatePri.GetPriSectionBuilder();
+    VERIFY_SUCCEEDED(duplicateBuilder->AddCandidateWithString(
+        nullptr, L"Resources/Duplicate", MrmEnvironment::ResourceValueType_Utf16String, L"First", nullptr));
+    VERIFY_SUCCEEDED(duplicateBuilder->AddCandidateWithString(
+        nullptr, L"Resources/Duplicate", MrmEnvironment::ResourceValueType_Utf16String, L"Second", nullptr));
+    VERIFY_FAILED(duplicateBuilder->FlushQueuedStrings());
+    VERIFY_SUCCEEDED(duplicateBuilder->FlushQueuedStrings());
+}
+
 void PriBuilderUnitTests::DeduplicationTests()
 {
     String tmp;
@@ -318,6 +698,47 @@ void PriBuilderUnitTests::DeduplicationTests()
     VERIFY(
         (actualDataValueSize1 * 2 == ((wcslen(utf16String1) + 1) * sizeof(wchar_t))) &&
         (actualDataValueSize2 * 2 == ((wcslen(utf16String2) + 1) * sizeof(wchar_t))));
+
+    // 7.) Add enough distinct strings to grow the deduplication map past its reserved size, then add
+    //     each of them again.
+    // Expected result: 1) Every string added the second time is found in the map
+    //                  2) The indice of the inner references match those from the first pass
+    // Actual result:   VERIFY PASS
+    const int numDistinctStrings = 3000;
+    int firstPassIndices[numDistinctStrings];
+    WCHAR manyString[32];
+
+    Log::Comment(L"[ Deduplication: 7 - Add many distinct strings twice ]");
+    dataItemOrchestrator = pri.GetPriSectionBuilder()->GetDataItemOrchestrator();
+    VERIFY_IS_TRUE(dataItemOrchestrator->UseDeduplication());
+    UINT32 numItemsBefore = dataItemOrchestrator->GetNumDeduplicatedItems();
+    VERIFY_SUCCEEDED(dataItemOrchestrator->ReserveDeduplicationCapacity(numDistinctStrings / 2));
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < numDistinctStrings; i++)
+        {
+            swprintf_s(manyString, L"Distinct value %d", i);
+            VERIFY_SUCCEEDED(dataItemOrchestrator->AddStringAndCreateInstanceReference(
+                manyString, qualifierSetBuilder, (IBuildInstanceReference**)&dataReference1, &qualifierSetIndex));
+
+            // References from the first pass are the ones held by the map, so only the clones from the
+            // second pass can be released here.
+            if (pass == 0)
+            {
+                firstPassIndices[i] = dataReference1->GetInnerReference().index;
+                continue;
+            }
+
+            int secondPassIndex = dataReference1->GetInnerReference().index;
+            delete dataReference1;
+            if (firstPassIndices[i] != secondPassIndex)
+            {
+                VERIFY_FAIL(L"[ DeduplicationTests 7 : A repeated string was not deduplicated ]");
+            }
+        }
+    }
+    VERIFY_ARE_EQUAL(dataItemOrchestrator->GetNumDeduplicatedItems(), numItemsBefore + numDistinctStrings);
 }
 
 } // namespace UnitTests
\ No newline at end of file
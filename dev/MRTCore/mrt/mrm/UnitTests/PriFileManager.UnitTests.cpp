@@ -294,6 +294,64 @@ void PriFileManagerUnitTests::BasicSingleFileTests()
 
     TestHPri::VerifyAgainstTestVars(pPri, L"", pri.GetTestDI(), L"");
 
+    Log::Comment(L"[ Verifying mapped and loaded BaseFile agree ]");
+    VERIFY_IS_TRUE(pBaseFile->IsFileDataMapped());
+
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+    LARGE_INTEGER mapped;
+    LARGE_INTEGER loaded;
+    QueryPerformanceFrequency(&frequency);
+
+    QueryPerformanceCounter(&start);
+    AutoDeletePtr<BaseFile> pMappedFile;
+    VERIFY_SUCCEEDED(BaseFile::CreateInstance(BaseFile::DefaultFlags, (PCWSTR)priFilePath, &pMappedFile));
+    QueryPerformanceCounter(&mapped);
+    AutoDeletePtr<BaseFile> pLoadedFile;
+    VERIFY_SUCCEEDED(BaseFile::CreateInstance(BaseFile::LoadFileFlag, (PCWSTR)priFilePath, &pLoadedFile));
+    QueryPerformanceCounter(&loaded);
+
+    VERIFY_IS_TRUE(pMappedFile->IsFileDataMapped());
+    VERIFY_IS_FALSE(pLoadedFile->IsFileDataMapped());
+    VERIFY_ARE_EQUAL(pMappedFile->GetFileSizeInBytes(), pLoadedFile->GetFileSizeInBytes());
+    VERIFY_ARE_EQUAL(0, memcmp(pMappedFile->GetFileHeader(), pLoadedFile->GetFileHeader(), pMappedFile->GetFileSizeInBytes()));
+
+    Log::Comment(tmp.Format(
+        L"[ Mapped in %I64d us, loaded in %I64d us ]",
+        ((mapped.QuadPart - start.QuadPart) * 1000000) / frequency.QuadPart,
+        ((loaded.QuadPart - mapped.QuadPart) * 1000000) / frequency.QuadPart));
+
+    Log::Comment(L"[ Verifying managers share one mapping of the file ]");
+    int numSharedFiles = BaseFile::GetNumSharedInstances();
+    VERIFY_IS_TRUE(numSharedFiles > 0);
+    {
+        AutoDeletePtr<AtomPoolGroup> pOtherAtoms;
+        VERIFY_SUCCEEDED(AtomPoolGroup::CreateInstance(&pOtherAtoms));
+        AutoDeletePtr<UnifiedEnvironment> pOtherEnvironment;
+        VERIFY_SUCCEEDED(UnifiedEnvironment::CreateInstance(pProfile, pOtherAtoms, &pOtherEnvironment));
+        AutoDeletePtr<PriFileManager> pOtherManager;
+        VERIFY_SUCCEEDED(PriFileManager::CreateInstance(pOtherEnvironment, &pOtherManager));
+
+        ManagedFile* pOtherFile;
+        VERIFY_SUCCEEDED(pOtherManager->GetOrAddFile((PCWSTR)priFilePath, L"", LoadPriFlags::Preload, &pOtherFile));
+        const BaseFile* pOtherBaseFile;
+        VERIFY_SUCCEEDED(pOtherFile->GetBaseFile(&pOtherBaseFile));
+        VERIFY_ARE_EQUAL(pBaseFile, pOtherBaseFile);
+        VERIFY_ARE_EQUAL(numSharedFiles, BaseFile::GetNumSharedInstances());
+
+        // Files opened with different flags aren't shared.
+        const BaseFile* pLoadedSharedFile;
+        VERIFY_SUCCEEDED(BaseFile::GetSharedInstance(BaseFile::LoadFileFlag, (PCWSTR)priFilePath, &pLoadedSharedFile));
+        VERIFY_ARE_NOT_EQUAL(pBaseFile, pLoadedSharedFile);
+        VERIFY_IS_FALSE(pLoadedSharedFile->IsFileDataMapped());
+        VERIFY_ARE_EQUAL(numSharedFiles + 1, BaseFile::GetNumSharedInstances());
+        BaseFile::ReleaseSharedInstance(pLoadedSharedFile);
+    }
+
+    // The first manager still holds the file.
+    VERIFY_ARE_EQUAL(numSharedFiles, BaseFile::GetNumSharedInstances());
+    VERIFY_IS_TRUE(pBaseFile->IsFileDataMapped());
+
     // MethodCleanup cleans up our data
 }
 
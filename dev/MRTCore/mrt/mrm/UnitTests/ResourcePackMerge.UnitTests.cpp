@@ -35,6 +35,10 @@ public:
         TEST_METHOD_PROPERTY(L"DataSource", L"Table:ResourcePackMerge.UnitTests.xml#LoadPriWitMergeTests")
     END_TEST_METHOD();
 
+    BEGIN_TEST_METHOD(IncrementalMergeTest)
+        TEST_METHOD_PROPERTY(L"DataSource", L"Table:ResourcePackMerge.UnitTests.xml#ThreeFilesMergeTests")
+    END_TEST_METHOD();
+
 private:
     bool _BuildAndVerifyPri(_In_ TestHPri* pTestHPri, _In_ PCWSTR pVarPrefix, _In_ bool bAutoMerge, _In_ bool bResourcePackMerge);
 
@@ -48,6 +52,14 @@ private:
         _In_ bool bResourcePackMerge);
 
     bool _VerifyMergedFile(_In_ PCWSTR pszMergedFile, _In_ PCWSTR pszManifestClassName, _In_ TestHPri* pTestHPri);
+
+    void _IncrementalMerge(_In_ CoreProfile* pProfile, _In_reads_(nFiles) PCWSTR* ppszFiles, _In_ UINT nFiles, _In_ PCWSTR pszOutputFile);
+
+    FILETIME _GetLastWriteTime(_In_ PCWSTR pszFilePath);
+
+    void _FlipLastByteKeepingLastWriteTime(_In_ PCWSTR pszFilePath);
+
+    bool _IsMergeCurrent(_In_ CoreProfile* pProfile, _In_reads_(nFiles) PCWSTR* ppszFiles, _In_ UINT nFiles, _In_ PCWSTR pszOutputFile);
 };
 
 /*
@@ -240,6 +252,171 @@ void ResourcePackMergeTests::LoadUnloadWithResourcePackTest()
     fileBasedTestObj.CleanupClassFolders();
 }
 
+void ResourcePackMergeTests::IncrementalMergeTest()
+{
+    FileBasedTest fileBasedTestObj;
+    String strPri3FilePath;
+    String strPri4FilePath;
+    String strPri5FilePath;
+    TestHPri testHPri3;
+    TestHPri testHPri4;
+    TestHPri testHPri5;
+
+    VERIFY_IS_TRUE(fileBasedTestObj.SetupClassFolders(L"ResourcePackMergeTests"));
+
+    PCWSTR pszFolder = L"ResourcePackMergeTests_IncrementalMerge";
+    VERIFY_IS_TRUE(_CreatePriFile(L"Pri3_", pszFolder, L"ResourcePackMergeTests_Main.pri", testHPri3, strPri3FilePath, true, true));
+    VERIFY_IS_TRUE(_CreatePriFile(L"Pri4_", pszFolder, L"ResourcePackMergeTests_it-it.pri", testHPri4, strPri4FilePath, false, true));
+    VERIFY_IS_TRUE(_CreatePriFile(L"Pri5_", pszFolder, L"ResourcePackMergeTests_ko-KR.pri", testHPri5, strPri5FilePath, false, true));
+
+    AutoDeletePtr<CoreProfile> pProfile;
+    VERIFY_SUCCEEDED(CoreProfile::ChooseDefaultProfile(&pProfile));
+
+    PCWSTR files[] = {strPri3FilePath, strPri4FilePath, strPri5FilePath};
+
+    String strOutPath;
+    fileBasedTestObj.GetTestOutputDirectory(pszFolder, NULL, strOutPath);
+    strOutPath += L"\\";
+    strOutPath += L"MergedPriFile.pri";
+
+    // The first merge has no manifest to compare against, so it writes both the output and its manifest.
+    _IncrementalMerge(pProfile, files, ARRAYSIZE(files), strOutPath);
+    _VerifyMergedFile(strOutPath, L"PriMerged_3_4_5_", &testHPri3);
+
+    StringResult strManifestPath;
+    VERIFY_SUCCEEDED(PriMergeManifest::GetManifestPath(strOutPath, &strManifestPath));
+    VERIFY_ARE_NOT_EQUAL(GetFileAttributes(strManifestPath.GetRef()), INVALID_FILE_ATTRIBUTES);
+
+    // Nothing changed, so the second merge leaves the output alone.
+    FILETIME ftFirstMerge = _GetLastWriteTime(strOutPath);
+    _IncrementalMerge(pProfile, files, ARRAYSIZE(files), strOutPath);
+    FILETIME ftSecondMerge = _GetLastWriteTime(strOutPath);
+    VERIFY_ARE_EQUAL(CompareFileTime(&ftFirstMerge, &ftSecondMerge), 0L);
+
+    // Adding the same file twice still fails up front, even though the merge itself is deferred.
+    {
+        AutoDeletePtr<ResourcePackMerge> spResourcePackMerge;
+        VERIFY_SUCCEEDED(ResourcePackMerge::CreateInstance(pProfile, &spResourcePackMerge));
+        PriFileMerger::PriMergeFlags flags =
+            PriFileMerger::InPlaceMerge | PriFileMerger::IncrementalMerge | PriFileMerger::DefaultPriMergeFlags;
+        VERIFY_SUCCEEDED(spResourcePackMerge->AddPriFile(files[0], flags));
+        VERIFY_FAILED(spResourcePackMerge->AddPriFile(files[0], flags));
+        VERIFY_FAILED(spResourcePackMerge->AddPriFile(files[1], PriFileMerger::InPlaceMerge | PriFileMerger::DefaultPriMergeFlags));
+    }
+
+    // Touching one resource pack invalidates the manifest and the next merge rewrites the output.
+    FILETIME ftTouched = _GetLastWriteTime(strPri5FilePath);
+    ULARGE_INTEGER uliTouched;
+    uliTouched.LowPart = ftTouched.dwLowDateTime;
+    uliTouched.HighPart = ftTouched.dwHighDateTime;
+    uliTouched.QuadPart -= 10000000; // one second
+    ftTouched.dwLowDateTime = uliTouched.LowPart;
+    ftTouched.dwHighDateTime = uliTouched.HighPart;
+    {
+        wil::unique_hfile hFile(CreateFile(
+            strPri5FilePath, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+        VERIFY_IS_TRUE(static_cast<bool>(hFile));
+        VERIFY_WIN32_BOOL_SUCCEEDED(SetFileTime(hFile.get(), nullptr, nullptr, &ftTouched));
+    }
+
+    _IncrementalMerge(pProfile, files, ARRAYSIZE(files), strOutPath);
+    FILETIME ftThirdMerge = _GetLastWriteTime(strOutPath);
+    VERIFY_ARE_NOT_EQUAL(CompareFileTime(&ftSecondMerge, &ftThirdMerge), 0L);
+    _VerifyMergedFile(strOutPath, L"PriMerged_3_4_5_", &testHPri3);
+
+    // Same inputs, but a profile that builds differently: the manifest no longer matches and the output is
+    // rewritten.
+    MrmBuildConfiguration* pConfig = pProfile->GetBuildConfiguration();
+    UINT32 originalFlags = pConfig->GetFlags();
+    pConfig->SetFlags(originalFlags & ~MrmBuildConfiguration::UseDeduplicationFlag);
+    _IncrementalMerge(pProfile, files, ARRAYSIZE(files), strOutPath);
+    pConfig->SetFlags(originalFlags);
+    FILETIME ftFourthMerge = _GetLastWriteTime(strOutPath);
+    VERIFY_ARE_NOT_EQUAL(CompareFileTime(&ftThirdMerge, &ftFourthMerge), 0L);
+    _VerifyMergedFile(strOutPath, L"PriMerged_3_4_5_", &testHPri3);
+
+    // A resource pack rewritten in place with the same size and last write time no longer matches either,
+    // because the manifest checksums the file contents.
+    _IncrementalMerge(pProfile, files, ARRAYSIZE(files), strOutPath);
+    VERIFY_IS_TRUE(_IsMergeCurrent(pProfile, files, ARRAYSIZE(files), strOutPath));
+    _FlipLastByteKeepingLastWriteTime(strPri5FilePath);
+    VERIFY_IS_FALSE(_IsMergeCurrent(pProfile, files, ARRAYSIZE(files), strOutPath));
+    _FlipLastByteKeepingLastWriteTime(strPri5FilePath);
+    VERIFY_IS_TRUE(_IsMergeCurrent(pProfile, files, ARRAYSIZE(files), strOutPath));
+
+    fileBasedTestObj.CleanupClassFolders();
+}
+
+void ResourcePackMergeTests::_IncrementalMerge(
+    _In_ CoreProfile* pProfile,
+    _In_reads_(nFiles) PCWSTR* ppszFiles,
+    _In_ UINT nFiles,
+    _In_ PCWSTR pszOutputFile)
+{
+    AutoDeletePtr<ResourcePackMerge> spResourcePackMerge;
+    VERIFY_SUCCEEDED(ResourcePackMerge::CreateInstance(pProfile, &spResourcePackMerge));
+
+    for (UINT i = 0; i < nFiles; i++)
+    {
+        VERIFY_SUCCEEDED(spResourcePackMerge->AddPriFile(
+            ppszFiles[i], PriFileMerger::InPlaceMerge | PriFileMerger::IncrementalMerge | PriFileMerger::DefaultPriMergeFlags));
+    }
+
+    VERIFY_SUCCEEDED(spResourcePackMerge->WriteToFile(pszOutputFile));
+}
+
+FILETIME ResourcePackMergeTests::_GetLastWriteTime(_In_ PCWSTR pszFilePath)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+    VERIFY_WIN32_BOOL_SUCCEEDED(GetFileAttributesEx(pszFilePath, GetFileExInfoStandard, &data));
+    return data.ftLastWriteTime;
+}
+
+void ResourcePackMergeTests::_FlipLastByteKeepingLastWriteTime(_In_ PCWSTR pszFilePath)
+{
+    FILETIME ftLastWrite = _GetLastWriteTime(pszFilePath);
+
+    wil::unique_hfile hFile(
+        CreateFile(pszFilePath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+    VERIFY_IS_TRUE(static_cast<bool>(hFile));
+
+    LARGE_INTEGER liLastByte;
+    liLastByte.QuadPart = -1;
+    VERIFY_WIN32_BOOL_SUCCEEDED(SetFilePointerEx(hFile.get(), liLastByte, nullptr, FILE_END));
+
+    BYTE lastByte;
+    DWORD cbDone;
+    VERIFY_WIN32_BOOL_SUCCEEDED(ReadFile(hFile.get(), &lastByte, 1, &cbDone, nullptr));
+    VERIFY_ARE_EQUAL(cbDone, 1u);
+
+    lastByte ^= 0xff;
+    VERIFY_WIN32_BOOL_SUCCEEDED(SetFilePointerEx(hFile.get(), liLastByte, nullptr, FILE_END));
+    VERIFY_WIN32_BOOL_SUCCEEDED(WriteFile(hFile.get(), &lastByte, 1, &cbDone, nullptr));
+    VERIFY_ARE_EQUAL(cbDone, 1u);
+
+    VERIFY_WIN32_BOOL_SUCCEEDED(SetFileTime(hFile.get(), nullptr, nullptr, &ftLastWrite));
+}
+
+bool ResourcePackMergeTests::_IsMergeCurrent(
+    _In_ CoreProfile* pProfile,
+    _In_reads_(nFiles) PCWSTR* ppszFiles,
+    _In_ UINT nFiles,
+    _In_ PCWSTR pszOutputFile)
+{
+    AutoDeletePtr<PriMergeManifest> spManifest;
+    VERIFY_SUCCEEDED(PriMergeManifest::CreateInstance(pProfile, &spManifest));
+
+    for (UINT i = 0; i < nFiles; i++)
+    {
+        VERIFY_SUCCEEDED(spManifest->AddInput(
+            ppszFiles[i], PriFileMerger::InPlaceMerge | PriFileMerger::IncrementalMerge | PriFileMerger::DefaultPriMergeFlags));
+    }
+
+    bool bIsCurrent = false;
+    VERIFY_SUCCEEDED(spManifest->IsOutputCurrent(pszOutputFile, &bIsCurrent));
+    return bIsCurrent;
+}
+
 bool ResourcePackMergeTests::_VerifyMergedFile(_In_ PCWSTR pszMergedFile, _In_ PCWSTR pszManifestClassName, _In_ TestHPri* pTestHPri)
 {
     // Load the merged PRI file with official API
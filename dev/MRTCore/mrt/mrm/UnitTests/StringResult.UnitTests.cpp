@@ -716,4 +716,134 @@ void StringResult_Buffer::Copy(void)
     delete pCopy;
 }
 
+class StringResult_Inline : public WEX::TestClass<StringResult_Inline>, public StringResult_Struct
+{
+    TEST_CLASS(StringResult_Inline);
+
+    TEST_METHOD(ShortCopyStaysInline);
+    TEST_METHOD(LongCopyUsesHeap);
+    TEST_METHOD(RefIsNotCopied);
+    TEST_METHOD(AcquireAndReleaseBuf);
+    TEST_METHOD(Copy);
+
+    bool IsInline(_In_ const InlineStringResult* pResult, _In_opt_ PCWSTR pRef)
+    {
+        const BYTE* pStart = reinterpret_cast<const BYTE*>(pResult);
+        const BYTE* pEnd = pStart + sizeof(*pResult);
+        const BYTE* p = reinterpret_cast<const BYTE*>(pRef);
+        return (p >= pStart) && (p < pEnd);
+    }
+
+    void MakeLongString(_Out_writes_(cchBuf) PWSTR pBuf, _In_ size_t cchBuf)
+    {
+        for (size_t i = 0; i < cchBuf - 1; i++)
+        {
+            pBuf[i] = static_cast<WCHAR>(L'a' + (i % 26));
+        }
+        pBuf[cchBuf - 1] = L'\0';
+    }
+};
+
+void StringResult_Inline::ShortCopyStaysInline(void)
+{
+    InlineStringResult result;
+    CHECK_STRINGRESULT_EMPTY(&result);
+
+    VERIFY_SUCCEEDED(result.SetCopy(medStr));
+    VERIFY(result.GetType() == DefResultType_Buffer);
+    VERIFY_ARE_EQUAL(0, wcscmp(medStr, result.GetRef()));
+    VERIFY_IS_TRUE(IsInline(&result, result.GetRef()));
+
+    VERIFY_SUCCEEDED(result.Concat(concatStr));
+    VERIFY_ARE_EQUAL(0, wcscmp(endStr, result.GetRef()));
+    VERIFY_IS_TRUE(IsInline(&result, result.GetRef()));
+}
+
+void StringResult_Inline::LongCopyUsesHeap(void)
+{
+    WCHAR longBuf[InlineStringResult::InlineBufferSizeInChars * 2];
+    MakeLongString(longBuf, ARRAYSIZE(longBuf));
+
+    InlineStringResult result;
+    VERIFY_SUCCEEDED(result.SetCopy(longBuf));
+    VERIFY_ARE_EQUAL(0, wcscmp(longBuf, result.GetRef()));
+    VERIFY_IS_FALSE(IsInline(&result, result.GetRef()));
+
+    // Growing past the inline buffer keeps the existing contents.
+    InlineStringResult grown;
+    VERIFY_SUCCEEDED(grown.SetCopy(shortStr));
+    VERIFY_IS_TRUE(IsInline(&grown, grown.GetRef()));
+    VERIFY_SUCCEEDED(grown.Concat(longBuf));
+    VERIFY_IS_FALSE(IsInline(&grown, grown.GetRef()));
+    VERIFY_ARE_EQUAL(0, wcsncmp(shortStr, grown.GetRef(), shortLen));
+    VERIFY_ARE_EQUAL(0, wcscmp(longBuf, grown.GetRef() + shortLen));
+
+    // A short string after a long one reuses the heap buffer.
+    PCWSTR pHeapBuf = grown.GetRef();
+    VERIFY_SUCCEEDED(grown.SetCopy(medStr));
+    VERIFY_ARE_EQUAL(0, wcscmp(medStr, grown.GetRef()));
+    VERIFY_ARE_EQUAL(pHeapBuf, grown.GetRef());
+}
+
+void StringResult_Inline::RefIsNotCopied(void)
+{
+    InlineStringResult result;
+    VERIFY_SUCCEEDED(result.SetCopy(shortStr));
+    VERIFY_SUCCEEDED(result.SetRef(longStr));
+    CHECK_STRINGRESULT_REF(&result, longStr);
+
+    // Making the reference writable copies it into the inline buffer.
+    PWSTR pWritable;
+    size_t cchWritable;
+    VERIFY_SUCCEEDED(result.GetWritableRef(&pWritable, &cchWritable));
+    VERIFY_IS_TRUE(IsInline(&result, pWritable));
+    VERIFY_ARE_EQUAL(0, wcscmp(longStr, pWritable));
+    VERIFY_ARE_EQUAL(InlineStringResult::InlineBufferSizeInChars, cchWritable);
+}
+
+void StringResult_Inline::AcquireAndReleaseBuf(void)
+{
+    InlineStringResult result;
+    VERIFY_SUCCEEDED(result.SetCopy(medStr));
+
+    // Released contents are always a heap buffer the caller can free.
+    PWSTR pStrOut;
+    size_t cchStrOut;
+    VERIFY_SUCCEEDED(result.ReleaseContents(&pStrOut, &cchStrOut));
+    VERIFY_IS_FALSE(IsInline(&result, pStrOut));
+    VERIFY_ARE_EQUAL(0, wcscmp(medStr, pStrOut));
+    VERIFY_ARE_EQUAL(InlineStringResult::InlineBufferSizeInChars, cchStrOut);
+    CHECK_STRINGRESULT_COMPLETELY_EMPTY(&result);
+
+    // Adopting a heap buffer and releasing it again does not copy.
+    VERIFY_SUCCEEDED(result.SetContents(pStrOut, cchStrOut));
+    PWSTR pStrOut2;
+    VERIFY_SUCCEEDED(result.ReleaseContents(&pStrOut2, &cchStrOut));
+    VERIFY_ARE_EQUAL(pStrOut, pStrOut2);
+    Def_Free(pStrOut2);
+
+    // The inline buffer is still available afterwards.
+    VERIFY_SUCCEEDED(result.SetCopy(shortStr));
+    VERIFY_IS_TRUE(IsInline(&result, result.GetRef()));
+}
+
+void StringResult_Inline::Copy(void)
+{
+    StringResult source;
+    VERIFY_SUCCEEDED(source.Init(longStr, DefResultType_Buffer));
+
+    InlineStringResult copy;
+    VERIFY_SUCCEEDED(source.GetCopy(&copy));
+    VERIFY(copy.GetRef() != source.GetRef());
+    VERIFY_IS_TRUE(IsInline(&copy, copy.GetRef()));
+    VERIFY_ARE_EQUAL(0, wcscmp(longStr, copy.GetRef()));
+
+    // Taking over another result's contents moves its buffer rather than copying it.
+    PCWSTR pSourceBuf = source.GetRef();
+    VERIFY_SUCCEEDED(copy.SetContentsFromOther(&source));
+    CHECK_STRINGRESULT_BUF(&copy, longStr);
+    CHECK_STRINGRESULT_EMPTY(&source);
+    VERIFY_ARE_EQUAL(pSourceBuf, copy.GetRef());
+}
+
 } // namespace UnitTests
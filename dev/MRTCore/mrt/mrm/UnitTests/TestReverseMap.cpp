@@ -104,6 +104,19 @@ TestReverseFileMap::VerifyCandidate(
         VERIFY_SUCCEEDED(pReverseMap->GetCandidateInfo(candidateRevMapIndex, &gotQualifierSetIndex, &gotNamedResourceIndex));
         VERIFY(wantQualifierSetIndex == gotQualifierSetIndex);
         VERIFY(wantNamedResourceIndex == gotNamedResourceIndex);
+
+        // Lookups ignore case, either separator matches the other and a leading separator is ignored.
+        WCHAR variant[MAX_PATH];
+        PCWSTR pFormat = ((pWantCandidateValue[0] == L'/') || (pWantCandidateValue[0] == L'\\')) ? L"%s" : L"\\%s";
+        VERIFY(swprintf_s(variant, ARRAYSIZE(variant), pFormat, pWantCandidateValue) > 0);
+        for (WCHAR* pCh = variant; *pCh != L'\0'; pCh++)
+        {
+            *pCh = (*pCh == L'/') ? L'\\' : ((*pCh == L'\\') ? L'/' : static_cast<WCHAR>(towlower(*pCh)));
+        }
+
+        int variantRevMapIndex;
+        VERIFY(pReverseMap->TryGetReverseMapCandidateIndex(variant, &variantRevMapIndex));
+        VERIFY(variantRevMapIndex == candidateRevMapIndex);
     }
     else
     {
@@ -5,6 +5,7 @@
 #include "Helpers.h"
 #include "mrm/build/Base.h"
 #include "mrm/readers/MrmManagers.h"
+#include "mrm/common/MrmTraceLogging.h"
 
 #include "TestPri.h"
 #include "TestHSchema.h"
@@ -73,6 +74,8 @@ public:
     END_TEST_METHOD();
 
     TEST_METHOD(EnvironmentValidationTests);
+
+    TEST_METHOD(ResolvedResourceCacheTests);
 };
 
 bool UnifiedResourceViewUnitTests::ClassSetup()
@@ -1183,4 +1186,48 @@ void UnifiedResourceViewUnitTests::EnvironmentValidationTests()
     VERIFY_ARE_EQUAL(hr, HRESULT_FROM_WIN32(ERROR_MRM_UNKNOWN_QUALIFIER));
 }
 
+void UnifiedResourceViewUnitTests::ResolvedResourceCacheTests()
+{
+    AutoDeletePtr<CoreProfile> pProfile;
+    VERIFY_SUCCEEDED(CoreProfile::ChooseDefaultProfile(&pProfile));
+    AutoDeletePtr<UnifiedResourceView> pView;
+    VERIFY_SUCCEEDED(UnifiedResourceView::CreateInstance(pProfile, &pView));
+
+    AutoDeletePtr<OverrideResolver> pResolver;
+    VERIFY_SUCCEEDED(OverrideResolver::CreateInstance(pView->GetDefaultResolver(), &pResolver));
+
+    // The cache only uses the map as a key, so any address will do.
+    int mapKey = 0;
+    const IRawResourceMap* pRawMap = reinterpret_cast<const IRawResourceMap*>(&mapKey);
+    int candidateIndex;
+    LONG64 generation;
+
+    UINT64 processHitsBefore, processMissesBefore;
+    GetResolvedResourceCacheCounters(&processHitsBefore, &processMissesBefore);
+
+    VERIFY_IS_FALSE(pResolver->TryGetResolvedCandidate(pRawMap, 3, &candidateIndex, &generation));
+    pResolver->SetResolvedCandidate(pRawMap, 3, generation, 2);
+    VERIFY_IS_TRUE(pResolver->TryGetResolvedCandidate(pRawMap, 3, &candidateIndex, &generation));
+    VERIFY_ARE_EQUAL(candidateIndex, 2);
+
+    // Entries don't survive a qualifier change.
+    VERIFY_SUCCEEDED(pResolver->SetQualifier(L"Language", L"fr-FR"));
+    VERIFY_IS_FALSE(pResolver->TryGetResolvedCandidate(pRawMap, 3, &candidateIndex, &generation));
+
+    // Counts are kept per resolver.
+    UINT64 hits, misses;
+    pResolver->GetResolvedResourceCacheCounters(&hits, &misses);
+    VERIFY_ARE_EQUAL(hits, 1ull);
+    VERIFY_ARE_EQUAL(misses, 2ull);
+
+    pView->GetDefaultResolver()->GetResolvedResourceCacheCounters(&hits, &misses);
+    VERIFY_ARE_EQUAL(hits, 0ull);
+    VERIFY_ARE_EQUAL(misses, 0ull);
+
+    // And are reported to the process-wide counts as well.
+    GetResolvedResourceCacheCounters(&hits, &misses);
+    VERIFY_ARE_EQUAL(hits, processHitsBefore + 1);
+    VERIFY_ARE_EQUAL(misses, processMissesBefore + 2);
+}
+
 } // namespace UnitTests
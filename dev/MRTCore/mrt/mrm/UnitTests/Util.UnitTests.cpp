@@ -791,4 +791,38 @@ void StringConversionUnitTests::InvalidUtf8()
     VERIFY_ARE_EQUAL(cchUtf16IncludingNull, 0u);
 }
 
+class FoldedHashUnitTests : public WEX::TestClass<FoldedHashUnitTests>
+{
+public:
+    TEST_CLASS(FoldedHashUnitTests);
+
+    TEST_METHOD(FoldMatchesCaseInsensitiveCompare);
+};
+
+void FoldedHashUnitTests::FoldMatchesCaseInsensitiveCompare()
+{
+    // Pairs DefString_ICompare treats as equal, including letters towupper leaves alone in the C locale.
+    PCWSTR const equalPairs[][2] = {
+        {L"abc", L"ABC"},
+        {L"a\u00E9", L"a\u00C9"},
+        {L"Gr\u00F6\u00DFe", L"GR\u00D6\u00DFE"},
+        {L"\u0444\u0430\u0439\u043B", L"\u0424\u0410\u0419\u041B"},
+    };
+
+    for (int i = 0; i < ARRAYSIZE(equalPairs); i++)
+    {
+        VERIFY_IS_TRUE(DefString_IEqual(equalPairs[i][0], equalPairs[i][1]));
+
+        size_t cch0, cch1;
+        VERIFY_ARE_EQUAL(DefString_ComputeFoldedHash(equalPairs[i][0], &cch0), DefString_ComputeFoldedHash(equalPairs[i][1], &cch1));
+        VERIFY_ARE_EQUAL(cch0, wcslen(equalPairs[i][0]));
+        VERIFY_ARE_EQUAL(cch1, wcslen(equalPairs[i][1]));
+    }
+
+    // Only the path hash treats the two separators alike.
+    VERIFY_ARE_EQUAL(DefString_ComputeFoldedPathHash(L"a\\b", nullptr), DefString_ComputeFoldedPathHash(L"A/B", nullptr));
+    VERIFY_ARE_NOT_EQUAL(DefString_ComputeFoldedHash(L"a\\b", nullptr), DefString_ComputeFoldedHash(L"A/B", nullptr));
+    VERIFY_ARE_NOT_EQUAL(DefString_ComputeFoldedHash(L"a\u00E9", nullptr), DefString_ComputeFoldedHash(L"a\u00E8", nullptr));
+}
+
 } // namespace UnitTests
\ No newline at end of file
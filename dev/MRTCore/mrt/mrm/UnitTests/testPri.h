@@ -73,6 +73,9 @@ public:
     PriSectionBuilder* GetPriSectionBuilder() const { return m_priBuilder->GetDescriptor(); }
     StandalonePriFile* GetPriFile() const { return m_pri; }
 
+    const void* GetBuffer() const { return m_buffer; }
+    UINT32 GetBufferSize() const { return m_bufferSizeInBytes; }
+
     TestDecisionInfo* GetTestDI() { return &m_testDI; }
 
     int GetNumSchemas() const { return (m_schemas ? m_schemas->Count() : 0); }
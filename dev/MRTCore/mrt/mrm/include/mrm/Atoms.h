@@ -154,10 +154,12 @@ public:
     }
 
     typedef DEF_ATOM_HASH Hash;
+    typedef UINT64 Hash64;
     typedef DEF_ATOM_HASH_METHOD HashMethod;
 
     static const HashMethod HashMethodDefault = DEF_HASH_DEFAULT;
     static const HashMethod HashMethodCaseInsensitive = DEF_HASH_CASE_INSENSITIVE;
+    static const HashMethod HashMethodVersion2 = DEF_HASH_VERSION_2;
 
     static bool IsValidPoolIndex(Atom::Index index) { return (index > 0) && (index <= DEF_ATOM_MAX_INDEX); }
 
@@ -201,6 +203,9 @@ public:
     //! Generate hash with the default hash method
     static Hash HashString(PCWSTR str) { return HashString(str, HashMethodDefault); }
 
+    //! Generate the full 64-bit version 2 hash. Only the case-insensitive bit of hashType is used.
+    static Hash64 HashString64(_In_ PCWSTR str, _In_ HashMethod hashType);
+
     /*! 
          * \name Class-specific new/delete operators
          * @{
@@ -144,6 +144,26 @@ public:
     bool Contains(_In_ PCWSTR str) const;
 };
 
+/*!
+ * A StringResult with inline storage for short contents, meant for the transient names,
+ * qualifier values and paths produced while looking up a resource.  Contents that fit
+ * are copied into the object itself rather than a heap buffer; references are still
+ * never copied.
+ */
+class InlineStringResult : public StringResult
+{
+public:
+    static constexpr size_t InlineBufferSizeInChars = 64;
+
+    InlineStringResult();
+
+    InlineStringResult(const InlineStringResult&) = delete;
+    InlineStringResult& operator=(const InlineStringResult&) = delete;
+
+private:
+    WCHAR m_inlineBuffer[InlineBufferSizeInChars];
+};
+
 class BlobResult : public DefObject
 {
 private:
@@ -19,6 +19,7 @@ private:
         fDefault = 0x0000,
         fIsCaseInsensitive = 0x0001,
         fIsNotSorted = 0x0004,
+        fUsesHashV2 = 0x0010,
         fStringPoolIsOwned = 0x0100
     };
 
@@ -34,6 +35,8 @@ private:
     Atom::AtomCount m_sizeAtoms;
     DEFFILE_ATOMPOOL_HASHINDEX* m_hash;
     UINT32* m_offset;
+    FileAtomPool::HashTableEntry* m_buckets;
+    UINT32 m_numBuckets;
     WriteableStringPool* m_pStrings;
     WCHAR m_description[FileAtomPool::DescriptionLength];
     BaseFile::SectionIndex m_sectionIndex;
@@ -47,6 +50,8 @@ protected:
 
     HRESULT Extend(__in size_t newSize);
 
+    HRESULT RebuildHashTable(__in UINT32 numAtoms);
+
 public:
     static HRESULT CreateInstance(__in PCWSTR pDescription, bool isCaseInsensitive, _Outptr_ FileAtomPoolBuilder** result);
     static HRESULT CreateInstance(
@@ -72,6 +77,11 @@ public:
     }
 
     bool GetIsCaseInsensitive() const { return ((m_flags & fIsCaseInsensitive) != 0); }
+
+    // Pools store the legacy hash unless asked for version 2. Readers that predate the version 2 flag ignore it
+    // and look atoms up with the legacy hash, so only opt in when every reader of the file understands it.
+    bool GetUsesHashV2() const { return ((m_flags & fUsesHashV2) != 0); }
+    HRESULT SetUseHashV2(_In_ bool useHashV2);
     HRESULT GetString(Atom, _Out_ PCWSTR* result) const;
     HRESULT GetString(Atom::Index, _Out_ PCWSTR* result) const;
     bool TryGetString(Atom, __inout_opt StringResult*) const;
@@ -110,6 +110,9 @@ private:
     UINT32 m_cbSectionData;
     UINT32 m_nSectionDataUsed;
 
+    bool m_parallelBuild;
+    bool m_streamingGeneration;
+
 protected:
     FileBuilder(DEFFILE_MAGIC magic);
 
@@ -144,6 +147,20 @@ public:
 
     BuildPhase GetPhase() const { return m_phase; }
 
+    // When enabled, sections are built concurrently on the thread pool. Section layout and the resulting
+    // file are identical to a serial build.
+    void SetParallelBuild(bool parallel) { m_parallelBuild = parallel; }
+
+    bool GetParallelBuild() const { return m_parallelBuild; }
+
+    // When enabled, WriteToFile builds one section at a time and writes it straight to the file instead of
+    // generating the whole file in memory first, so peak memory follows the largest section rather than
+    // the file. Sections are built serially and the file is identical to a buffered build. The contents
+    // are not kept, so the file can only be generated once.
+    void SetStreamingGeneration(bool streaming) { m_streamingGeneration = streaming; }
+
+    bool GetStreamingGeneration() const { return m_streamingGeneration; }
+
     bool SetPhase(BuildPhase phase)
     {
         if (m_phase > phase)
@@ -188,6 +205,10 @@ private:
 
     virtual HRESULT BuildAllSections();
 
+    HRESULT BuildAllSectionsInParallel();
+
+    HRESULT GenerateToFile(_In_ HANDLE hFile);
+
     virtual HRESULT FinishGenerating();
 
     virtual HRESULT GenerateFileContentsInternal();
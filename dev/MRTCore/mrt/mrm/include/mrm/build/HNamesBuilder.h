@@ -494,9 +494,29 @@ public:
          */
     HRESULT GetOrAddItem(_In_ PCWSTR pName, _Out_ ItemInfo** result);
 
+    /*!
+         * Puts the immediate children of this scope into the order
+         * in which they are written to the generated section.
+         *
+         * Children are appended as they are added and looked up by
+         * name through a hash index, so they're only sorted when
+         * they are first accessed by position after a change.
+         */
+    void SortChildren() const;
+
 protected:
+    struct ChildSlot
+    {
+        UINT32 hash;
+        HNamesNode* pNode;
+    };
+
     DynamicArray<HNamesNode*>* m_pChildren;
 
+    ChildSlot* m_pChildSlots;
+    UINT32 m_numChildSlots;
+    mutable bool m_bChildrenSorted;
+
     int m_numChildScopes;
     int m_numChildItems;
 
@@ -556,9 +576,11 @@ protected:
          */
     HRESULT GetOrAddChildItem(_In_ const HierarchicalNameSegment* pName, _Out_ ItemInfo** result);
 
-    HRESULT FindSearchRange(_In_ PCWSTR nodeName, _Out_ int* startSearch, _Out_ int* endSearch, _Out_ int* insert) const;
+    HNamesNode* FindChild(_In_ PCWSTR pName, _In_ UINT32 hash) const;
+
+    HRESULT AddChild(_In_ HNamesNode* pNode, _In_ UINT32 hash);
 
-    UINT FindInsertionPoint(_In_ PCWSTR pName, _In_ UINT first, _In_ UINT last, _Out_ int* pDiffOut) const;
+    HRESULT RebuildChildIndex(_In_ UINT32 numSlots);
 
     HRESULT GetOrAddChildNode(_In_ HNamesNode* newNode, _Out_ HNamesNode** foundNode);
 };
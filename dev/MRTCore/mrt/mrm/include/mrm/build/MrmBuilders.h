@@ -1138,7 +1138,7 @@ public:
     ~OrchestratorDataReference() { delete m_metadata; }
 
     static HRESULT CreateInstance(
-        _In_ DEF_CHECKSUM valueHash,
+        _In_ UINT64 valueHash,
         _In_reads_bytes_(valueSizeInBytes) const void* actualValue,
         _In_ size_t valueSizeInBytes,
         _In_ DataItemsSectionBuilder* pBuilder,
@@ -1157,7 +1157,7 @@ public:
 
     UINT8 GetLocatorType() const { return MRMFILE_MAP_VALUE_LOCATOR_DATA_ITEM; }
 
-    DEF_CHECKSUM GetValueHash() const { return m_valueHash; }
+    UINT64 GetValueHash() const { return m_valueHash; }
 
     const void* GetActualValue() const;
 
@@ -1167,7 +1167,7 @@ public:
 
 private:
     OrchestratorDataReference(
-        _In_ DEF_CHECKSUM valueHash,
+        _In_ UINT64 valueHash,
         _In_ DataItemsSectionBuilder* pBuilder,
         _In_ DataItemsSectionBuilder::PrebuildItemReference* pPreBuildItemReference);
 
@@ -1176,68 +1176,64 @@ private:
     DataItemsSectionBuilder* m_disBuilder;
     DataItemsSectionBuilder::PrebuildItemReference m_innerReference;
 
-    DEF_CHECKSUM m_valueHash;
+    UINT64 m_valueHash;
     BlobResult m_actualDataBlob;
     DynamicArray<UINT>* m_metadata;
 };
 
-class OrchestratorHashNode : public DefObject
-{
-public:
-    static HRESULT CreateInstance(
-        _In_ DEF_CHECKSUM valueHash,
-        _In_ OrchestratorDataReference* dataReference,
-        _Outptr_ OrchestratorHashNode** result);
-
-    bool SetNext(_In_ OrchestratorHashNode* inputNode);
-
-    ~OrchestratorHashNode() {}
-
-    OrchestratorDataReference* GetDataReference() const { return m_dataReference; }
-    DEF_CHECKSUM GetHash() const { return m_valueHash; }
-    OrchestratorHashNode* GetNext() const { return m_nextOrchHashNode; }
-
-private:
-    OrchestratorHashNode(_In_ DEF_CHECKSUM valueHash, _In_ OrchestratorDataReference* dataReference);
-
-    OrchestratorHashNode* m_nextOrchHashNode;
-    DEF_CHECKSUM m_valueHash;
-    OrchestratorDataReference* m_dataReference;
-};
-
+// Open-addressed map from data item contents to the reference that first added them. Each slot keeps
+// the 64-bit content hash, the value size and its leading bytes inline, so probing rarely has to touch
+// the stored value itself. The map does not own the references.
 class OrchestratorHashMap : public DefObject
 {
 public:
     virtual ~OrchestratorHashMap();
 
-    static HRESULT CreateInstance(_In_ int initCapacity, _In_ float loadFactor, _Outptr_ OrchestratorHashMap** result);
+    static HRESULT CreateInstance(_In_ UINT32 expectedItems, _Outptr_ OrchestratorHashMap** result);
 
-    int Count() const { return m_nodeCount; }
+    static UINT64 ComputeHash(_In_reads_bytes_(valueSizeInBytes) const void* value, _In_ size_t valueSizeInBytes);
 
-    HRESULT AddtoMap(_In_ DEF_CHECKSUM key, _In_ OrchestratorDataReference* value);
+    int Count() const { return static_cast<int>(m_numEntries); }
 
-    int HashCode(_In_ DEF_CHECKSUM key);
+    HRESULT Reserve(_In_ UINT32 expectedItems);
 
-    int HashCode(_In_ size_t newSize, _In_ DEF_CHECKSUM key);
+    HRESULT AddtoMap(_In_ OrchestratorDataReference* value);
 
-    OrchestratorDataReference* TryGetFromMap(_In_ DEF_CHECKSUM key, _In_opt_ const void* value, _In_opt_ size_t valueSizeInBytes);
+    OrchestratorDataReference*
+    TryGetFromMap(_In_ UINT64 valueHash, _In_opt_ const void* value, _In_opt_ size_t valueSizeInBytes) const;
 
 private:
-    HRESULT ResizeMap();
+    struct Entry
+    {
+        UINT64 valueHash;
+        UINT32 valueSize; // clamped to UINT32_MAX
+        UINT32 valuePrefix;
+        OrchestratorDataReference* dataReference; // nullptr for an empty slot
+    };
 
-    OrchestratorHashMap(_In_ int initCapacity, _In_ float loadFactor);
+    OrchestratorHashMap();
 
-    HRESULT Init(int initCapacity);
+    HRESULT Rehash(_In_ UINT32 numSlots);
 
-    int m_nodeCount;
-    int m_currentSize;
-    float m_loadFactor;
-    DynamicArray<OrchestratorHashNode*>* m_entries;
+    Entry* m_pEntries;
+    UINT32 m_numSlots;
+    UINT32 m_numEntries;
 };
 
 class DataItemOrchestrator : public DefObject
 {
 public:
+    // One string passed to AddOptimizedStringsAndCreateInstanceReferences. The caller fills in the
+    // first three fields; result and optimalType are set the same way the single string overload sets them.
+    struct OptimizedString
+    {
+        MrmEnvironment::ResourceValueType originalType;
+        PCWSTR value;
+        int qualifierSetIndex;
+        IBuildInstanceReference* result;
+        MrmEnvironment::ResourceValueType optimalType;
+    };
+
     static HRESULT CreateInstance(
         _In_ FileBuilder* fileBuilder,
         _In_ CoreProfile* profile,
@@ -1251,6 +1247,15 @@ public:
 
     void DisableDeduplication();
 
+    bool UseDeduplication() const;
+
+    // Sizes the deduplication map for the expected number of data items, so that large projects
+    // don't rehash it repeatedly as items are added.
+    HRESULT ReserveDeduplicationCapacity(_In_ UINT32 expectedItems);
+
+    // Number of distinct data items tracked for deduplication so far.
+    UINT32 GetNumDeduplicatedItems() const;
+
     HRESULT GetValueSize(_In_ PCWSTR value, _Out_ size_t* size);
 
     virtual HRESULT AddDataAndCreateInstanceReference(
@@ -1299,7 +1304,21 @@ public:
         _Out_ int* qualifierIndex,
         _Out_ MrmEnvironment::ResourceValueType* optimalType);
 
+    // Adds a batch of strings as if each had been passed to AddOptimizedStringAndCreateInstanceReference
+    // in order. Large batches are encoded and hashed on the thread pool, but strings are added and deduplicated
+    // in input order, so the data items are identical to those the single string overload produces.
+    // On failure, strings before the failing one keep their references.
+    HRESULT AddOptimizedStringsAndCreateInstanceReferences(_In_ UINT32 numStrings, _Inout_updates_(numStrings) OptimizedString* strings);
+
 protected:
+    HRESULT AddEncodedStringAndCreateInstanceReference(
+        _In_ PCWSTR value,
+        _In_reads_bytes_opt_(encodedValueSize) const char* encodedValue,
+        _In_ size_t encodedValueSize,
+        _In_ UINT64 valueHash,
+        _In_ int qualifierSetIndex,
+        _Outptr_ IBuildInstanceReference** result);
+
     HRESULT GetOrAddDataItemSectionBuilder(_In_ int qualifierSetIndex, _Out_ DataItemsSectionBuilder** result);
 
     DataItemOrchestrator(_In_ FileBuilder* fileBuilder, _In_ CoreProfile* profile, _In_ DecisionInfoSectionBuilder* decisionInfo);
@@ -1370,7 +1389,8 @@ public:
         _In_ CoreProfile* pProfile,
         _Outptr_ PriSectionBuilder** result);
 
-    // build configuration determines how the string is ultimately stored
+    // build configuration determines how the string is ultimately stored. When strings are stored as
+    // optimized data items they are queued, and errors adding the candidate surface from FlushQueuedStrings.
     HRESULT AddCandidateWithString(
         _In_opt_ PCWSTR schemaName,
         _In_ PCWSTR resourceName,
@@ -1378,6 +1398,22 @@ public:
         _In_opt_ PCWSTR value,
         _In_opt_ IQualifierSet* qualifiers);
 
+    // Queues a UTF-16 string candidate to be stored as an optimized data item. The resource name is added to
+    // the schema immediately; the string is encoded and added with the rest of the queue. Requires the data
+    // item locator and optimal payload encoding. If ignoreDuplicates is set, a duplicate candidate is dropped.
+    HRESULT QueueCandidateWithString(
+        _In_ ResourceMapSectionBuilder* mapBuilder,
+        _In_ PCWSTR resourceName,
+        _In_ MrmEnvironment::ResourceValueType valueType,
+        _In_ PCWSTR value,
+        _In_ int qualifierSetIndex,
+        _In_ bool ignoreDuplicates);
+
+    // Encodes every queued string as one batch and adds the candidates in the order they were queued, so the
+    // result is the same as adding each string on its own. Other candidates are added after a flush, and
+    // callers that add directly to a map builder or the data item orchestrator must flush first.
+    HRESULT FlushQueuedStrings();
+
     // add embedded data candidate (qualifier set)
     HRESULT AddCandidateWithEmbeddedData(
         _In_opt_ PCWSTR schemaName,
@@ -1523,6 +1559,16 @@ private:
 
     HRESULT GetMapBuilderForAddCandidate(_In_opt_ PCWSTR schemaName, _Out_ ResourceMapSectionBuilder** result);
 
+    void ClearQueuedStrings();
+
+    // Where a queued string goes once it is encoded; m_queuedCandidates parallels m_queuedStrings.
+    struct QueuedCandidate
+    {
+        ResourceMapSectionBuilder* mapBuilder;
+        Atom::Index itemIndex;
+        bool ignoreDuplicates;
+    };
+
 private:
     FileBuilder* m_pFileBuilder;
     AtomPoolGroup* m_pAtoms;
@@ -1553,6 +1599,10 @@ private:
     DataItemOrchestrator* m_dataItems;
     FileListBuilder* m_pFileListBuilder;
 
+    DynamicArray<DataItemOrchestrator::OptimizedString>* m_queuedStrings; // values are copies owned by the queue
+    DynamicArray<QueuedCandidate>* m_queuedCandidates;
+    DynamicArray<IBuildInstanceReference*>* m_droppedReferences; // references for ignored duplicate candidates
+
     DynamicArray<ResourceLinkSectionBuilder*>* m_linkBuilders;
 
     MrmBuildConfiguration* m_pBuilderConfiguration; // do not delete this here
@@ -1643,6 +1693,10 @@ public:
         // With the following flag set, if callers try to add dupe candiates to the merger,
         // we will drop the dupe and continue, instead of erroring out.
         DropDuplicateCandidates = 0x0400,
+        // Defers the merge until the output is written and skips it entirely when the output's merge
+        // manifest shows that neither the output, the profile nor any of the inputs changed since the
+        // last merge.  Otherwise every input is merged again.
+        IncrementalMerge = 0x0800,
 
     } PriMergeFlags;
 
@@ -1793,6 +1847,74 @@ public:
         _In_ PriFileMerger::PriMergeFlags mergeFlags);
 };
 
+/*!
+ * Records the checksums of the files that went into a merged PRI file, along with a fingerprint of the
+ * profile that merged them, in a sidecar manifest stored next to the merged output.  The checksums cover the
+ * contents of each file, not just its name, size and last write time.  A merge whose inputs,
+ * profile and output all still match the manifest would produce the same file again, so incremental merges
+ * use it to skip no-op merges.  Any difference at all means the whole merge runs again; the manifest doesn't
+ * track what each input contributed, so a changed input can't be merged on its own.
+ */
+class PriMergeManifest : public DefObject
+{
+public:
+    static HRESULT CreateInstance(_In_ CoreProfile* pProfile, _Outptr_ PriMergeManifest** result);
+
+    ~PriMergeManifest();
+
+    HRESULT AddInput(_In_ PCWSTR pPriFilePath, _In_ PriFileMerger::PriMergeFlags mergeFlags);
+
+    int GetNumInputs() const;
+
+    HRESULT GetInput(_In_ int index, _Out_ PCWSTR* ppPriFilePath, _Out_ PriFileMerger::PriMergeFlags* pMergeFlags) const;
+
+    HRESULT IsOutputCurrent(_In_ PCWSTR pOutputFilePath, _Out_ bool* pbIsCurrent) const;
+
+    HRESULT WriteForOutput(_In_ PCWSTR pOutputFilePath) const;
+
+    static HRESULT DeleteForOutput(_In_ PCWSTR pOutputFilePath);
+
+    static HRESULT GetManifestPath(_In_ PCWSTR pOutputFilePath, _Inout_ StringResult* pStrManifestPath);
+
+    static const UINT32 ManifestMagic;
+    static const UINT16 ManifestVersion;
+
+private:
+    struct Input
+    {
+        StringResult* pStrFilePath;
+        DEF_CHECKSUM checksum;
+        PriFileMerger::PriMergeFlags mergeFlags;
+    };
+
+    typedef struct _MANIFEST_HEADER
+    {
+        UINT32 magic;
+        UINT16 version;
+        UINT16 pad;
+        UINT32 numInputs;
+        DEF_CHECKSUM outputChecksum;
+        DEF_CHECKSUM profileChecksum;
+    } MANIFEST_HEADER;
+
+    typedef struct _MANIFEST_INPUT
+    {
+        DEF_CHECKSUM checksum;
+        UINT32 mergeFlags;
+    } MANIFEST_INPUT;
+
+    PriMergeManifest(_In_ CoreProfile* pProfile);
+
+    HRESULT Init();
+
+    HRESULT ComputeProfileChecksum(_Out_ DEF_CHECKSUM* pChecksum) const;
+
+    static HRESULT ComputeFileChecksum(_In_ PCWSTR pFilePath, _Out_ DEF_CHECKSUM* pChecksum);
+
+    CoreProfile* m_pProfile;
+    DynamicArray<Input*>* m_pInputs;
+};
+
 #define DefBuilder_PhaseMismatch(GOT, WANT, STATUS) Def_Check0(((GOT) != (WANT)), E_DEFFILE_BUILD_BAD_PHASE, STATUS)
 #define DefBuilder_PhaseIsBefore(GOT, WANT, STATUS) Def_Check0(((GOT) < (WANT)), E_DEFFILE_BUILD_BAD_PHASE, STATUS)
 #define DefBuilder_PhaseIsAfter(GOT, WANT, STATUS) Def_Check0(((GOT) > (WANT)), E_DEFFILE_BUILD_BAD_PHASE, STATUS)
@@ -50,6 +50,8 @@ private:
 
     HRESULT Init();
 
+    HRESULT MergePriFile(_In_ PCWSTR pszPriFileName, _In_ PriFileMerger::PriMergeFlags priMergeFlags);
+
     HRESULT AddFileToFileList(_In_ PCWSTR pszFilePath, _In_ PriFileMerger::PriMergeFlags priMergeFlags, _Out_ FileInfo** ppFileInfo);
 
     HRESULT AddRootFolder(_In_ PWSTR pszLocalFilePath, _Out_ PWSTR* ppszFilePathNext, _Out_ FolderInfo** ppFolderInfo);
@@ -89,6 +91,7 @@ private:
     mutable const IHierarchicalSchema* m_pFirstEntrySchema;
     FileListBuilder* m_pFileListBuilder;
     DynamicArray<PriFile*>* m_pPriFileList;
+    PriMergeManifest* m_pMergeManifest;
 };
 
 } // namespace Microsoft::Resources
\ No newline at end of file
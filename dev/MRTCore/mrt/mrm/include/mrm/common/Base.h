@@ -117,7 +117,8 @@ extern "C"
     typedef enum
     {
         DEF_HASH_DEFAULT = 0, //!< Use the default hash function
-        DEF_HASH_CASE_INSENSITIVE = 1 //!< Use a case-insensitive hash function
+        DEF_HASH_CASE_INSENSITIVE = 1, //!< Use a case-insensitive hash function
+        DEF_HASH_VERSION_2 = 0x10 //!< Use the 64-bit version 2 hash, folded to 32 bits
     } DEF_ATOM_HASH_METHOD;
 
     /*! \enum DEF_ATOM_COMPARISON
@@ -307,6 +308,10 @@ extern "C"
      *
      * _DEFSTRINGRESULT::cchBuf must be >= the length of _DEFSTRINGRESULT::pBuf + 1
      * and < STRSAFE_MAX_CCH at all times
+     *
+     * _DEFSTRINGRESULT::pInlineBuf optionally supplies small-string storage owned
+     * by whoever embeds the ::DEFSTRINGRESULT.  Strings that fit are stored there
+     * instead of in a heap buffer, and it is never freed.
      */
     typedef struct _DEFSTRINGRESULT
     {
@@ -314,6 +319,8 @@ extern "C"
         UINT32 cchBuf; //!< The allocated size of the buffer
         PCWSTR pRef; /*!< The current pStr value of the string, which might
                                or might no be resident in buf. */
+        __ecount_opt(cchInlineBuf) PWSTR pInlineBuf; //!< Optional small-string storage, not owned by ::DEFSTRINGRESULT
+        UINT32 cchInlineBuf; //!< The size of the small-string storage
     } DEFSTRINGRESULT;
 
     typedef DEFSTRINGRESULT* PDEFSTRINGRESULT;
@@ -121,6 +121,35 @@ extern "C"
         _Out_ size_t* resultStringSizeInUtf16CharsIncludingNull,
         _Outptr_ PWSTR* result);
 
+    // Case-folded FNV-1a, used by the in-memory indexes over names and paths.  Characters are
+    // upper-cased with the same table CompareStringOrdinal uses when it ignores case, so strings that
+    // DefString_ICompare reports equal always hash alike.  towupper can't be used here: in the C
+    // locale it only maps ASCII.
+    static const UINT32 DEFSTRING_FOLDED_HASH_SEED = 2166136261;
+
+    WCHAR DefString_FoldNonAsciiChar(_In_ WCHAR ch);
+
+    static __inline WCHAR DefString_FoldChar(_In_ WCHAR ch)
+    {
+        if (ch < 0x80)
+        {
+            return ((ch >= L'a') && (ch <= L'z')) ? _DEF_STATIC_CAST(WCHAR)(ch - (L'a' - L'A')) : ch;
+        }
+        return DefString_FoldNonAsciiChar(ch);
+    }
+
+    // Also folds '\\' to '/', for indexes in which either path separator matches the other.
+    static __inline WCHAR DefString_FoldPathChar(_In_ WCHAR ch) { return (ch == L'\\') ? L'/' : DefString_FoldChar(ch); }
+
+    static __inline UINT32 DefString_HashFoldedChar(_In_ UINT32 hash, _In_ WCHAR ch)
+    {
+        return (hash ^ DefString_FoldChar(ch)) * 16777619;
+    }
+
+    // Hash a whole string, optionally returning its length in characters.
+    UINT32 DefString_ComputeFoldedHash(_In_ PCWSTR pString, _Out_opt_ size_t* pcchString);
+    UINT32 DefString_ComputeFoldedPathHash(_In_ PCWSTR pString, _Out_opt_ size_t* pcchString);
+
 #define DefString_Compare(S1, S2) DefString_CompareWithOptions((S1), (S2), DefCompare_Default)
 #define DefString_ICompare(S1, S2) DefString_CompareWithOptions((S1), (S2), DefCompare_CaseInsensitive)
 #define DefString_CchCompare(S1, S2, N) DefString_CchCompareWithOptions((S1), (S2), DefCompare_Default)
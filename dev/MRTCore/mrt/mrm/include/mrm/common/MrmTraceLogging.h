@@ -17,6 +17,10 @@ void LogErrorInMemory(HRESULT hr, ULONG line, _In_ PCSTR filename, _In_ PCWSTR m
 #define LOG_ERROR_IN_MEMORY(hr, line, filename, message) __noop
 #endif
 
+// Process-wide hit and miss counts for the resolvers' resolved resource caches.
+void LogResolvedResourceCacheLookup(bool bHit);
+void GetResolvedResourceCacheCounters(_Out_ UINT64* pHits, _Out_ UINT64* pMisses);
+
 class MrtRuntimeTraceLoggingProvider : public wil::TraceLoggingProvider
 {
     IMPLEMENT_TRACELOGGING_CLASS(MrtRuntimeTraceLoggingProvider, "Microsoft.WindowsAppSdk.MrtCore.Runtime",
@@ -46,6 +46,18 @@ extern "C"
 
     HRESULT _DefGetFileSizeEx(__in HANDLE hFile, __out PLARGE_INTEGER pFileSize);
 
+    // Identifies the contents of an open file: two handles with equal identities refer to the same
+    // file, at the same size, last written at the same time.
+    typedef struct _DEF_FILE_IDENTITY
+    {
+        ULONGLONG volumeSerialNumber;
+        ULONGLONG fileIndex;
+        LONGLONG cbFile;
+        LONGLONG lastWriteTime;
+    } DEF_FILE_IDENTITY;
+
+    HRESULT _DefGetFileIdentity(__in HANDLE hFile, __out DEF_FILE_IDENTITY* pIdentity);
+
     DEFRESULT _DefGetLastError();
 
     HRESULT _DefMapViewOfFile(
@@ -64,6 +76,23 @@ extern "C"
 
     UINT32 _DefComputeCrc32(__in UINT32 partialCrc, __in_bcount(cbBuf) const BYTE* pBuf, __in UINT32 cbBuf);
 
+    // _DefComputeCrc32 uses the fastest implementation the processor supports. All of them produce identical
+    // results; the others are exposed so they can be tested against each other.
+    typedef enum _DEF_CRC32_IMPLEMENTATION
+    {
+        DefCrc32Implementation_Bytewise = 0,
+        DefCrc32Implementation_SliceBy8 = 1,
+        DefCrc32Implementation_Hardware = 2
+    } DEF_CRC32_IMPLEMENTATION;
+
+    BOOLEAN _DefIsCrc32ImplementationSupported(__in DEF_CRC32_IMPLEMENTATION implementation);
+
+    UINT32 _DefComputeCrc32WithImplementation(
+        __in DEF_CRC32_IMPLEMENTATION implementation,
+        __in UINT32 partialCrc,
+        __in_bcount(cbBuf) const BYTE* pBuf,
+        __in UINT32 cbBuf);
+
     UINT32
     _DefComputeStringCrc32(__in UINT32 partialCrc, __in BOOLEAN isCaseInsensitive, __in_ecount(cchStr) PCWSTR pStr, __in UINT32 cchStr);
 
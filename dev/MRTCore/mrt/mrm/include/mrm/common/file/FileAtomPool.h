@@ -61,7 +61,9 @@ extern "C"
         DEFFILE_ATOMPOOL_HASH_CASE_INSENSITIVE = 0x0001, //!< Uses case-insensitive hash method
         DEFFILE_ATOMPOOL_HASH_NONE = 0x0002, //!< No hash table present
         DEFFILE_ATOMPOOL_HASH_UNSORTED = 0x0004, //!< Hash table is unsorted
-        DEFFILE_ATOMPOOL_HASH_SMALL = 0x0008 //!< Hash table uses small atom index for hash table
+        DEFFILE_ATOMPOOL_HASH_SMALL = 0x0008, //!< Hash table uses small atom index for hash table
+        DEFFILE_ATOMPOOL_HASH_V2 = 0x0010, //!< Hash values use the version 2 hash (matches DEF_HASH_VERSION_2)
+        DEFFILE_ATOMPOOL_HASH_TABLE = 0x0020 //!< An open-addressed lookup table follows the string pool
     } DefFileAtomPoolHashFlags;
 
 #define DEFFILE_ATOMPOOL_DESC_LENGTH 32
@@ -99,6 +101,26 @@ extern "C"
         DEF_ATOM_INDEX_SMALL index; //!< Index of the corresponding string in the hash table
     } DEFFILE_ATOMPOOL_HASHINDEX_SMALL, *PDEFFILE_ATOMPOOL_HASHINDEX_SMALL;
 
+    /*!
+     * Header for the lookup table that follows the string pool, aligned to 32 bits, when
+     * DEFFILE_ATOMPOOL_HASH_TABLE is set.  It is followed by nBuckets entries.  nBuckets is a
+     * power of two larger than the number of atoms, so every probe sequence ends at an empty bucket.
+     */
+    typedef struct _DEFFILE_ATOMPOOL_HASHTABLE
+    {
+        UINT32 nBuckets; //!< Number of buckets in the table
+    } DEFFILE_ATOMPOOL_HASHTABLE, *PDEFFILE_ATOMPOOL_HASHTABLE;
+
+    /*!
+     * One bucket of an atom pool lookup table.  Atoms are placed by linear probing from
+     * (hash & (nBuckets - 1)).  An indexPlusOne of 0 marks an empty bucket.
+     */
+    typedef struct _DEFFILE_ATOMPOOL_HASHTABLE_ENTRY
+    {
+        DEF_ATOM_HASH hash; //!< Hash value for the corresponding string
+        DEF_ATOM_INDEX indexPlusOne; //!< Index of the corresponding atom plus one, or 0 if the bucket is empty
+    } DEFFILE_ATOMPOOL_HASHTABLE_ENTRY, *PDEFFILE_ATOMPOOL_HASHTABLE_ENTRY;
+
     /*!
       * Describes the mapping from a range of one or more pools in another file to
       * a different range in this file.
@@ -15,7 +15,21 @@ public:
 
     HRESULT Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pValue, _Out_ double* score) const;
 
+    bool TryCompileValue(_In_ PCWSTR pValue, _Out_ CompiledValue* pCompiledOut) const;
+
+    double EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const;
+
 protected:
+    enum ContrastLevel
+    {
+        ContrastStandard = 0,
+        ContrastHigh = 1,
+        ContrastBlack = 2,
+        ContrastWhite = 3
+    };
+
+    static double ScoreContrastLevels(_In_ int providerLevel, _In_ int assetLevel);
+
     ContrastQualifierType() :
         EnumerationQualifierType(CoreEnvironment::Qualifier_Contrast_AllowedValues, CoreEnvironment::Qualifier_Contrast_NumAllowedValues)
     {}
@@ -43,9 +57,13 @@ public:
 
     virtual HRESULT Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pValue, _Out_ double* score) const;
 
+    virtual double EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const;
+
     static double CalculateScaleFactorScore(_In_ int assetValue, _In_ int contextValue);
 
 protected:
+    double ScoreScaleValues(_In_ int assetValue, _In_ int contextValue) const;
+
     static double ComputeScoreWithinBucket(_In_ int value, _In_ int bucketMinValue, _In_ int bucketMaxValue, _In_ double bucketSize);
 
     ScaleQualifierType() :
@@ -62,12 +80,21 @@ public:
 
     HRESULT Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pValue, _Outptr_ double* score) const;
 
+    // Compiles any value to its feature level, or -1 if it isn't a known level.
+    bool TryCompileValue(_In_ PCWSTR pValue, _Out_ CompiledValue* pCompiledOut) const;
+
+    double EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const;
+
     inline IBuildQualifierType::PackagingFlags GetDefaultPackagingFlags() const
     {
         return IBuildQualifierType::PackagingAllowResourcePackage | IBuildQualifierType::PackagingReportQualifier;
     }
 
 protected:
+    static int GetFeatureLevel(_In_ PCWSTR pValue);
+
+    static double ScoreFeatureLevels(_In_ int providerLevel, _In_ int qualifierLevel);
+
     DXFeatureLevelQualifierType() :
         EnumerationQualifierType(
             CoreEnvironment::Qualifier_DXFeatureLevel_AllowedValues,
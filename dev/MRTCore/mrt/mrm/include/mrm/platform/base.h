@@ -685,6 +685,27 @@ private:
 class IQualifierType : public DefObject
 {
 public:
+    // Pre-parsed form of a single qualifier value (a number or an ordinal) for types that can
+    // reduce their values to integers.
+    struct CompiledValue
+    {
+        INT32 value;
+        bool isEmpty;
+    };
+
+    // Pre-split form of a list of qualifier values (such as a language list) for types that take lists.
+    // pList is a copy of the whole list and each of ppValues points into a second copy in which the
+    // separators are replaced by terminators.  Release with FreeCompiledList.
+    struct CompiledList
+    {
+        PWSTR pBuffer;
+        PCWSTR pList;
+        PCWSTR* ppValues;
+        UINT32 numValues;
+    };
+
+    static void FreeCompiledList(_Inout_ CompiledList* pList);
+
     virtual ~IQualifierType() {}
     // All "Validate" methods report details is pStatus if the return value is false,
     // typically one of DEF_INVALID_ATTRIBUTE_VALUE or DEF_INVALID_COMPARISON_OPERATOR.
@@ -700,6 +721,44 @@ public:
 
     virtual HRESULT Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pAttributeValue, _Out_ double* score) const = 0;
 
+    // Lets callers parse qualifier and context values once and score them with integer comparisons.
+    // TryCompileValue returns false if the type or the value has no compiled form, in which case callers
+    // use Evaluate instead.  Values must be validated exactly as Evaluate would validate them, and
+    // EvaluateCompiled must yield the score Evaluate would for the original strings.
+    virtual bool TryCompileValue(_In_ PCWSTR /* pValue */, _Out_ CompiledValue* pCompiledOut) const
+    {
+        pCompiledOut->value = 0;
+        pCompiledOut->isEmpty = true;
+        return false;
+    }
+
+    virtual double EvaluateCompiled(_In_ const CompiledValue& /* assetValue */, _In_ const CompiledValue& /* contextValue */) const
+    {
+        return 0.0;
+    }
+
+    // Lets callers split a list-valued context value once and score every qualifier against the parts.
+    // TryCompileValueList returns false if the type doesn't take lists or can't split the value exactly
+    // as Evaluate would, in which case callers use Evaluate instead.  EvaluateCompiledList must yield
+    // the score Evaluate would for the original list.
+    virtual bool TryCompileValueList(_In_ PCWSTR /* pValue */, _Out_ CompiledList* pCompiledOut) const
+    {
+        pCompiledOut->pBuffer = nullptr;
+        pCompiledOut->pList = nullptr;
+        pCompiledOut->ppValues = nullptr;
+        pCompiledOut->numValues = 0;
+        return false;
+    }
+
+    virtual HRESULT EvaluateCompiledList(
+        _In_ const IQualifier* /* pQualifier */,
+        _In_ const CompiledList& /* contextList */,
+        _Out_ double* score) const
+    {
+        *score = 0.0;
+        return E_NOTIMPL;
+    }
+
     virtual HRESULT Compare(_In_ const IQualifier* pQualifier1, _In_ const IQualifier* pQualifier2, _Out_ DEFCOMPARISON* result) const = 0;
 
     virtual HRESULT CompareForValue(
@@ -786,6 +845,11 @@ public:
 
     virtual HRESULT Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pValue, _Out_ double* score) const;
 
+    virtual bool TryCompileValueList(_In_ PCWSTR pValue, _Out_ CompiledList* pCompiledOut) const;
+
+    virtual HRESULT
+    EvaluateCompiledList(_In_ const IQualifier* pQualifier, _In_ const CompiledList& contextList, _Out_ double* score) const;
+
     virtual HRESULT Compare(_In_ const IQualifier* pQualifier1, _In_ const IQualifier* pQualifier2, _Out_ DEFCOMPARISON* result) const;
 
     virtual HRESULT CompareForValue(
@@ -881,6 +945,11 @@ public:
 
     virtual HRESULT Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pszProviderValue, _Out_ double* score) const;
 
+    // Compiles a value to its ordinal in the list of allowed values.
+    virtual bool TryCompileValue(_In_ PCWSTR pValue, _Out_ CompiledValue* pCompiledOut) const;
+
+    virtual double EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const;
+
 protected:
     EnumerationQualifierType(_In_reads_(numAllowedValues) const PCWSTR* pAllowedValues, _In_ size_t numAllowedValues) :
         QualifierTypeBase(ListValuesNotAllowed | EmptyValuesNotAllowed),
@@ -890,6 +959,8 @@ protected:
 
     HRESULT ValidateSingleQualifierValue(_In_ PCWSTR pValue) const;
 
+    int GetOrdinal(_In_ PCWSTR pValue) const;
+
     _Field_size_(m_numAllowedValues) const PCWSTR* m_pAllowedValues;
     size_t m_numAllowedValues;
 };
@@ -907,6 +978,10 @@ public:
 
     virtual HRESULT Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pszProviderValue, _Out_ double* score) const;
 
+    virtual bool TryCompileValue(_In_ PCWSTR pValue, _Out_ CompiledValue* pCompiledOut) const;
+
+    virtual double EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const;
+
     HRESULT
     CompareForValue(_In_ const IQualifier* pQualifier1, _In_ const IQualifier* pQualifier2, _In_ PCWSTR pValue, _Out_ DEFCOMPARISON* result)
         const;
@@ -926,6 +1001,8 @@ protected:
     HRESULT ValidateSingleQualifierValue(_In_ PCWSTR pValue) const;
 
     HRESULT InnerCompare(_In_ const IQualifier* pQualifier1, _In_ const IQualifier* pQualifier2, _Out_ DEFCOMPARISON* result) const;
+
+    static double ScoreValues(_In_ int providerValue, _In_ int qualifierValue);
 };
 
 class IProviderDataSources;
@@ -15,9 +15,14 @@ class FileAtomPool : public IAtomPool, public FileSectionBase
 {
 public:
     typedef DEFFILE_ATOMPOOL_HASHINDEX HashIndex;
+    typedef DEFFILE_ATOMPOOL_HASHTABLE_ENTRY HashTableEntry;
 
     static const int DescriptionLength = DEFFILE_ATOMPOOL_DESC_LENGTH;
 
+    // Pools without a stored lookup table and with fewer atoms than this are searched linearly
+    // rather than building a table on first lookup.
+    static const int HashTableMinAtoms = 8;
+
 protected:
     UINT32 m_flags;
     Atom::PoolIndex m_poolIndex;
@@ -31,6 +36,10 @@ protected:
     const WCHAR* m_pPool;
     const WCHAR* m_pPoolGroup;
 
+    UINT32 m_numBuckets;
+    const HashTableEntry* m_pBuckets;
+    mutable HashTableEntry* volatile m_pLazyBuckets;
+
     static const DEFFILE_SECTION_TYPEID gAtomPoolSectionType;
 
     FileAtomPool();
@@ -141,6 +150,29 @@ public:
 
     static UINT32 GetSizeInBytes(__in const DEFFILE_ATOMPOOL_HEADER* header);
 
+    /*!
+         * Reports the number of buckets in the lookup table for a pool
+         * with the specified number of atoms.  The table is kept at most
+         * half full.
+         */
+    static UINT32 GetHashTableNumBuckets(__in UINT32 nAtoms);
+
+    /*!
+         * Reports the size needed to hold the lookup table, including
+         * its header, for a pool with the specified number of atoms.
+         */
+    static UINT32 GetHashTableSizeInBytes(__in UINT32 nAtoms);
+
+    /*!
+         * Adds an atom to a lookup table.  The table must have at least
+         * one empty bucket.
+         */
+    static void HashTable_Insert(
+        __inout_ecount(nBuckets) HashTableEntry* pBuckets,
+        __in UINT32 nBuckets,
+        __in Atom::Hash hash,
+        __in Atom::Index index);
+
     UINT32 GetMaxSizeInBytesForStrings(__in_ecount(nStrings) PCWSTR* ppStrings, __in UINT32 nStrings) const;
 
     static HRESULT ValidateHeader(__in_bcount(cbData) const void* pData, __in UINT32 cbData, __out_opt UINT32* pcbTotalRtrn);
@@ -152,6 +184,9 @@ protected:
     DEFCOMPARISON CompareAtIndex(__in Atom::Index index, __in PCWSTR pString) const;
 
     DEFCOMPARISON CompareAtHashIndex(__in Atom::Index hashIndex, __in PCWSTR pString) const;
+
+    const HashTableEntry* GetHashTable() const;
+    HRESULT BuildHashTable(_Outptr_ HashTableEntry** result) const;
 };
 
 class FileAtoms : public DefObject
@@ -72,7 +72,9 @@ public:
     static const SectionCount MaxSectionCount = DEFFILE_MAX_SECTION_COUNT;
     static const DEFFILE_SECTION_TYPEID SectionTypeNone;
 
-    // Public values for "flags" parameter to constructors
+    // Public values for "flags" parameter to constructors.
+    // Files are memory-mapped by default; LoadFileFlag reads a private copy instead. Files that
+    // can't be mapped, or that live on removable drives, are always read.
     static const UINT32 DefaultFlags = 0x0000;
     static const UINT32 MapFileFlag = 0x0001;
     static const UINT32 LoadFileFlag = 0x0002;
@@ -94,12 +96,28 @@ public:
         __in size_t cbData,
         _Outptr_ BaseFile** newFile);
 
+    /*!
+     * Opens a file that is shared with every other user of the same file in the process, so that
+     * it is mapped and validated only once.  Files are matched by identity (volume, file index,
+     * size and last write time) rather than by name, so any path to the file finds it, and a file
+     * that has been rewritten is opened afresh.  A file whose file system reports no volume serial
+     * number or file index can't be identified that way and gets an instance of its own.  Release
+     * with ReleaseSharedInstance.
+     */
+    static HRESULT GetSharedInstance(__in UINT32 flags, __in PCWSTR pFileName, _Outptr_ const BaseFile** newFile);
+
+    static void ReleaseSharedInstance(__in const BaseFile* pFile);
+
+    static int GetNumSharedInstances();
+
     virtual ~BaseFile();
 
     const DEFFILE_HEADER* GetFileHeader() const { return m_pHeader; }
 
     size_t GetFileSizeInBytes() const { return m_pHeader->cbTotal; }
 
+    bool IsFileDataMapped() const { return ((m_flags & (BaseFileOwnsDataFlag | MapFileFlag)) == (BaseFileOwnsDataFlag | MapFileFlag)); }
+
     bool SectionIsPresent(__inout SectionIndex index) { return (index >= 0) && (index < m_pHeader->sizeToc); }
 
     SectionCount GetNumSections() const { return m_pHeader->sizeToc; }
@@ -255,6 +273,8 @@ protected:
 
     HRESULT Init(__in UINT32 flags, __in PCWSTR pFileName);
 
+    HRESULT Init(__in UINT32 flags, __in PCWSTR pFileName, __in HANDLE hFile, __in size_t cbData);
+
     HRESULT Init(__in UINT32 flags, __in_bcount(cbData) const BYTE* pData, __in size_t cbData);
 
     HRESULT InitFromData(__in_bcount(cbData) const void* pData, __in size_t cbData);
@@ -348,6 +348,31 @@ private:
     // root folder.
     DEFFILE_FILELIST_FOLDER_ENTRY m_root;
 
+    // Full paths of every file and folder, materialized on first use into one buffer, plus a
+    // case-insensitive hash index from full path to file or folder index.
+    struct PathIndexEntry
+    {
+        UINT32 hash;
+        int index;         // -1 for an empty slot
+        UINT32 pathOffset; // into m_pPaths
+        bool isFolder;
+    };
+
+    enum PathCacheState
+    {
+        PathCacheNotBuilt = 0,
+        PathCacheBuilt = 1,
+        PathCacheUnavailable = 2
+    };
+
+    mutable _DEF_SRWLOCK m_srwLock;
+    mutable PathCacheState m_pathCacheState;
+    mutable PWSTR m_pPaths;
+    mutable UINT32* m_pFilePathOffsets;
+    mutable UINT32* m_pFolderPathOffsets;
+    mutable PathIndexEntry* m_pPathIndex;
+    mutable UINT32 m_numPathIndexSlots;
+
 public:
     /*!
          * Creates and initializes a \ref FileFileList from a supplied read-only data blob.
@@ -386,7 +411,7 @@ public:
     /*! 
          * Delete a \ref FileFileList.
          */
-    virtual ~FileFileList() {}
+    virtual ~FileFileList();
 
     /*!
          * \name IFileList Implementation
@@ -432,6 +457,12 @@ public:
     //! \see IFileList::GetFolderPath
     HRESULT GetFolderPath(__in int folderIndex, __inout StringResult* pPathOut) const;
 
+    //! \see IFileList::TryGetFileIndex
+    bool TryGetFileIndex(__in PCWSTR pPath, __out int* pIndexOut) const;
+
+    //! \see IFileList::TryGetFolderIndex
+    bool TryGetFolderIndex(__in PCWSTR pPath, __out int* pIndexOut) const;
+
     /*!@}*/
 
     //! Gets the typeid for a file list section.
@@ -444,6 +475,16 @@ protected:
 
     static HRESULT Validate(__in_bcount(cbData) const void* pData, __in size_t cbData);
 
+    HRESULT WriteFilePath(_In_ int fileBasedFileIndex, _Out_writes_(cchPath) PWSTR pPath, _In_ int cchPath) const;
+
+    HRESULT WriteFolderPath(_In_ int folderIndex, _Out_writes_(cchPath) PWSTR pPath, _In_ int cchPath) const;
+
+    bool EnsurePathCache() const;
+
+    HRESULT BuildPathCache() const;
+
+    bool TryFindPath(_In_ PCWSTR pPath, _In_ bool isFolder, _Out_ int* pIndexOut) const;
+
     HRESULT CopyNameSegment(_In_ UINT32 flags, _In_ int firstCharOffset, _In_ int cchName, _Out_writes_(cchName) WCHAR* pNameOut) const
     {
         if ((flags & DEFFILE_HNAMES_FLAGS_NAME_IS_ASCII) != 0)
@@ -207,6 +207,25 @@ private:
     IAtomPool* m_pScopeNames;
     IAtomPool* m_pItemNames;
 
+    // Scopes with fewer children than this are searched linearly. Wider scopes get
+    // a case-folded hash index of their children, built the first time the scope is searched.
+    static const UINT32 ChildIndexMinChildren = 16;
+
+    struct ChildIndexEntry
+    {
+        UINT32 hash;
+        UINT32 childIndexPlusOne; // 0 marks an empty slot
+    };
+
+    struct ChildIndex
+    {
+        UINT32 mask;
+        ChildIndexEntry entries[ANYSIZE_ARRAY];
+    };
+
+    // One lazily published index per scope, or nullptr if not built yet.
+    mutable ChildIndex* volatile* m_ppChildIndexes;
+
     HierarchicalNames();
 
     HRESULT Init(
@@ -284,6 +303,21 @@ private:
     template<typename T>
     HRESULT CompareNameSegment(_In_ const T* pNode, _In_ PCWSTR pRequestedSegment, _Out_ int* result) const;
 
+    HRESULT HashNodeName(_In_ const DEFFILE_HNAMES_NODE_LARGE* pNode, _Out_ UINT32* pHashOut) const;
+
+    HRESULT BuildChildIndex(_In_ const DEFFILE_HNAMES_SCOPE_LARGE* pScope, _Outptr_ ChildIndex** result) const;
+
+    HRESULT GetChildIndex(
+        _In_ int scopeIndex,
+        _In_ const DEFFILE_HNAMES_SCOPE_LARGE* pScope,
+        _Outptr_result_maybenull_ const ChildIndex** result) const;
+
+    HRESULT FindChild(
+        _In_ int scopeIndex,
+        _In_ const DEFFILE_HNAMES_SCOPE_LARGE* pScope,
+        _In_ PCWSTR pRequestedSegment,
+        _Out_ int* pChildOut) const;
+
     HRESULT CopyNameSegment(_In_ UINT32 flags, _In_ int firstCharOffset, _In_ int cchName, _Out_writes_(cchName) WCHAR* pNameOut) const
     {
         if ((flags & DEFFILE_HNAMES_FLAGS_NAME_IS_ASCII) != 0)
@@ -463,6 +463,12 @@ public:
 
     HRESULT SetDefaultFileFlags(_In_ UINT32 flags);
 
+    // In lazy section load mode only the file header, table of contents and PRI descriptor are read when a
+    // file is added. Referenced file lists are resolved on first access instead of at load time.
+    bool IsLazySectionLoadEnabled() const { return m_bLazySectionLoad; }
+
+    void SetLazySectionLoad(_In_ bool enable) { m_bLazySectionLoad = enable; }
+
     /*
          * IFileSectionResolver methods
          */
@@ -537,14 +543,26 @@ private:
     } FileManagerFileInfo;
 
     UINT32 m_defaultFileFlags;
+    bool m_bLazySectionLoad;
     mutable DynamicArray<FileManagerFileInfo>* m_pFiles;
     mutable MrmFileResolver* m_pFileResolver;
 
+    // Guards m_pFiles. In lazy section load mode referenced files are added by lookups on any thread.
+    // Never held while a file is created or loaded, because loading a file can add more files.
+    mutable _DEF_SRWLOCK m_filesLock;
+
     UnifiedEnvironment* m_pEnvironment;
 
-    PriFileManager() : m_pFiles(nullptr), m_pFileResolver(nullptr), m_pEnvironment(nullptr) {}
+    PriFileManager() : m_bLazySectionLoad(false), m_pFiles(nullptr), m_pFileResolver(nullptr), m_pEnvironment(nullptr)
+    {
+        _DefInitializeSRWLock(&m_filesLock);
+    }
 
     HRESULT Init(_In_ UnifiedEnvironment* pEnvironment);
+
+    bool TryGetFileInfo(_In_ int index, _Out_ FileManagerFileInfo* finfo) const;
+
+    ManagedFile* FindFileLocked(_In_ const NormalizedFilePath* pNormalizedPath) const;
 };
 
 class ManagedSchema : public IHierarchicalSchema
@@ -873,6 +891,10 @@ public:
 
     HRESULT SetDefaultFileFlags(_In_ UINT32 flags) { return m_pFileManager->SetDefaultFileFlags(flags); }
 
+    bool IsLazySectionLoadEnabled() const { return m_pFileManager->IsLazySectionLoadEnabled(); }
+
+    void SetLazySectionLoad(_In_ bool enable) { m_pFileManager->SetLazySectionLoad(enable); }
+
     // UnifiedResourceView
     AtomPoolGroup* GetAtoms() const { return m_pAtoms; }
     UnifiedDecisionInfo* GetDefaultDecisionInfo() const { return m_pDecisions; }
@@ -1031,6 +1053,21 @@ public:
         _Out_writes_(numResults) int* pResultIndexesOut,
         _Out_writes_(numResults) int* pResultSetIndexesOut) const;
 
+    // Remembers the candidate selected for a named resource so repeated lookups in the same context
+    // skip decision evaluation.  A lookup reports the generation it was checked against, which must be
+    // passed back to SetResolvedCandidate; entries stop matching as soon as the qualifiers change.
+    bool TryGetResolvedCandidate(
+        _In_ const IRawResourceMap* pRawMap,
+        _In_ int resourceIndex,
+        _Out_ int* pCandidateIndexOut,
+        _Out_ LONG64* pGenerationOut) const;
+
+    void SetResolvedCandidate(_In_ const IRawResourceMap* pRawMap, _In_ int resourceIndex, _In_ LONG64 generation, _In_ int candidateIndex)
+        const;
+
+    // Hit and miss counts for this resolver's resolved candidates.
+    void GetResolvedResourceCacheCounters(_Out_ UINT64* pHitsOut, _Out_ UINT64* pMissesOut) const;
+
     virtual HRESULT GetQualifierProvider(_In_ PCWSTR qualifierName, _Out_ const IQualifierValueProvider** provider) const override = 0;
 
 protected:
@@ -1041,12 +1078,16 @@ protected:
     HRESULT EvaluateQualifier(_In_ const IQualifier* pQualifier, _Out_ UINT16* pScoreOut, _Out_ UINT16* pFallbackScoreOut) const;
 
     class DecisionInfoCache;
+    class CompiledQualifierCache;
+    class ResolvedResourceCache;
 
     const UnifiedEnvironment* m_pEnvironment;
     const IDecisionInfo* m_pDecisions;
     UINT64 m_generation;
 
     mutable DecisionInfoCache* m_pCache;
+    mutable CompiledQualifierCache* m_pCompiledQualifiers;
+    mutable ResolvedResourceCache* m_pResolvedResources;
     mutable SRWLOCK m_srwLock;
     mutable SRWLOCK m_srwQualifierSetLock;
     mutable SRWLOCK m_srwQualifierLock;
@@ -512,14 +512,39 @@ public:
     static const DEFFILE_SECTION_TYPEID GetSectionTypeId();
 
 private:
+    // Hashed index from folded candidate path to reverse map index, built on first lookup.
+    struct PathIndexEntry
+    {
+        UINT32 hash;
+        int reverseMapIndex; // -1 for an empty slot
+        UINT32 pathOffset;   // into m_pPathIndexPaths
+    };
+
+    enum PathIndexState
+    {
+        PathIndexNotBuilt = 0,
+        PathIndexBuilt = 1,
+        PathIndexUnavailable = 2
+    };
+
     const MRMFILE_REVERSEFILEMAP_HEADER* m_pHeader;
     const MRMFILE_REVERSEFILEMAP_ENTRY* m_pEntries;
     const HierarchicalNames* m_pNames;
     int m_cbSection;
 
+    mutable _DEF_SRWLOCK m_srwLock;
+    mutable PathIndexState m_pathIndexState;
+    mutable PathIndexEntry* m_pPathIndex;
+    mutable UINT32 m_numPathIndexSlots;
+    mutable PWSTR m_pPathIndexPaths;
+
     ReverseFileMap();
 
     HRESULT Init(_In_opt_ const IFileSection* pSection, _In_reads_bytes_(cbData) const void* pData, _In_ int cbData);
+
+    bool EnsurePathIndex() const;
+
+    HRESULT BuildPathIndex() const;
 };
 
 class IRawResourceMap;
@@ -540,6 +565,7 @@ public:
     HRESULT GetResourceValueType(_Out_ MrmEnvironment::ResourceValueType* pTypeOut) const;
 
     int GetCandidateIndex() const { return m_candidateIndexInDecision; }
+    int GetValueIndex() const { return m_valueGlobalIndex; }
     const IRawResourceMap* GetRawResourceMap() const { return m_pRawMap; }
 
     HRESULT GetValueLocation(
@@ -563,6 +589,37 @@ protected:
     int m_candidateIndexInDecision;
 };
 
+/*!
+ * Hands out borrowed views of candidate string values.  Values stored as UTF-16 are
+ * returned in place in the mapped file.  Values that have to be built, such as ASCII or
+ * UTF-8 strings and paths under a package root, are decoded on first use and kept
+ * until the cache is destroyed.
+ */
+class CandidateStringCache : public DefObject
+{
+public:
+    static HRESULT CreateInstance(_Outptr_ CandidateStringCache** result);
+
+    ~CandidateStringCache();
+
+    HRESULT GetStringValue(_In_ const ResourceCandidateResult* pCandidate, _Outptr_ PCWSTR* ppValueOut, _Out_ size_t* pLengthOut);
+
+protected:
+    struct DecodedValues
+    {
+        const IRawResourceMap* pRawMap;
+        int numValues;
+        PWSTR* pValues;
+    };
+
+    CandidateStringCache();
+
+    HRESULT GetDecodedValues(_In_ const IRawResourceMap* pRawMap, _Out_ DecodedValues* pValuesOut);
+
+    DynamicArray<DecodedValues>* m_pMaps;
+    _DEF_SRWLOCK m_srwLock;
+};
+
 class NamedResourceResult : public DefObject
 {
 public:
@@ -588,6 +645,8 @@ public:
 
     int GetResourceIndexInSchema() const { return m_resourceIndexInSchema; }
 
+    const IRawResourceMap* GetRawResourceMap() const { return m_pRawMap; }
+
     HRESULT GetDecision(_Inout_ DecisionResult* pDecisionOut) const;
 
     int GetNumCandidates() const;
@@ -795,6 +854,50 @@ protected:
     mutable UINT16 m_currentMinorVersion;
 };
 
+/*!
+ * Remembers which resource each name resolved to, per resource map and scope, so that
+ * repeated lookups by name skip the walk through the hierarchical names.  Names are
+ * matched without regard to case or to which path separator is used.  Only names that
+ * were found are remembered.
+ */
+class ResourceNameCache : public DefObject
+{
+public:
+    static HRESULT CreateInstance(_Outptr_ ResourceNameCache** result);
+
+    ~ResourceNameCache();
+
+    HRESULT GetResource(_In_ const ResourceMapSubtree* pSubtree, _In_ PCWSTR pName, _Inout_ NamedResourceResult* pResourceOut);
+
+protected:
+    struct Entry
+    {
+        const IResourceMapBase* pMap;
+        PWSTR pName;
+        UINT32 hash;
+        int scopeIndex;
+        int resourceIndex;
+    };
+
+    ResourceNameCache();
+
+    bool TryFind(_In_ const IResourceMapBase* pMap, _In_ int scopeIndex, _In_ PCWSTR pName, _In_ UINT32 hash, _Out_ int* pResourceIndexOut)
+        const;
+
+    HRESULT Add(
+        _In_ const IResourceMapBase* pMap,
+        _In_ int scopeIndex,
+        _In_reads_(cchName) PCWSTR pName,
+        _In_ size_t cchName,
+        _In_ UINT32 hash,
+        _In_ int resourceIndex);
+
+    Entry* m_pEntries;
+    UINT32 m_numSlots;
+    int m_numEntries;
+    mutable _DEF_SRWLOCK m_srwLock;
+};
+
 class IFileSectionResolver;
 class ResourceMapFileData;
 
@@ -1469,19 +1572,26 @@ public:
 protected:
     mutable const BaseFile* m_pBaseFile;
     mutable const BaseFile* m_pMyBaseFile;
+    mutable const BaseFile* m_pSharedBaseFile;
     mutable MrmFileSection* m_pSections;
     mutable PriFileManager* m_pPriFileManager;
     mutable MrmFileResolver* m_pFileResolver;
     UnifiedEnvironment* m_pEnvironment;
+    mutable _DEF_SRWLOCK m_fileListLock;
+    mutable bool m_bFileListResolved;
 
     MrmFile() :
         m_pBaseFile(nullptr),
         m_pMyBaseFile(nullptr),
+        m_pSharedBaseFile(nullptr),
         m_pSections(nullptr),
         m_pPriFileManager(nullptr),
         m_pFileResolver(nullptr),
-        m_pEnvironment(nullptr)
-    {}
+        m_pEnvironment(nullptr),
+        m_bFileListResolved(false)
+    {
+        _DefInitializeSRWLock(&m_fileListLock);
+    }
 
     HRESULT Init(_In_ UnifiedEnvironment* pEnvironment, _In_ UINT32 flags, _In_ PCWSTR pPath);
 
@@ -1497,6 +1607,10 @@ protected:
 
     HRESULT InitializeAndGetSection(_In_ BaseFile::SectionIndex sectionIndex, _Out_ MrmFileSection** result) const;
 
+    HRESULT GetGlobalFileIndex(_In_ int fileIndex, _Out_ int* pGlobalIndex) const;
+
+    HRESULT EnsureFileListResolved() const;
+
 private:
     StringResult m_strRootFolder;
     StringResult m_strFilePath;
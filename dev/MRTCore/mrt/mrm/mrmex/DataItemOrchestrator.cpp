@@ -3,9 +3,45 @@
 
 #include "stdafx.h"
 
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#elif defined(_M_ARM64)
+#include <arm64_neon.h>
+#endif
+
 namespace Microsoft::Resources::Build
 {
 
+namespace
+{
+
+// The map starts with about as many slots as the old chained map had buckets.
+const UINT32 OrchestratorHashMapMinSlots = 1024;
+
+// Constants from xxHash64.
+const UINT64 OrchestratorPrime64_1 = 0x9E3779B185EBCA87ULL;
+const UINT64 OrchestratorPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+const UINT64 OrchestratorPrime64_3 = 0x165667B19E3779F9ULL;
+const UINT64 OrchestratorPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+const UINT64 OrchestratorPrime64_5 = 0x27D4EB2F165667C5ULL;
+
+UINT32 ClampValueSize(_In_ size_t valueSizeInBytes)
+{
+    return (valueSizeInBytes > UINT32_MAX) ? UINT32_MAX : static_cast<UINT32>(valueSizeInBytes);
+}
+
+UINT32 ReadValuePrefix(_In_reads_bytes_opt_(valueSizeInBytes) const void* value, _In_ size_t valueSizeInBytes)
+{
+    UINT32 prefix = 0;
+    if ((value != nullptr) && (valueSizeInBytes > 0))
+    {
+        memcpy(&prefix, value, (valueSizeInBytes < sizeof(prefix)) ? valueSizeInBytes : sizeof(prefix));
+    }
+    return prefix;
+}
+
+} // namespace
+
 HRESULT DataItemOrchestrator::CreateInstance(
     _In_ FileBuilder* fileBuilder,
     _In_ CoreProfile* profile,
@@ -40,7 +76,7 @@ HRESULT DataItemOrchestrator::Init()
 {
     RETURN_IF_FAILED(DynamicArray<DataItemsSectionBuilder*>::CreateInstance(10, &m_allBuilders));
     RETURN_IF_FAILED(DynamicArray<DataItemsSectionBuilder*>::CreateInstance(10, &m_buildersByQualifierSet));
-    RETURN_IF_FAILED(OrchestratorHashMap::CreateInstance(1019, 0.75, &m_OrchestratorHashMap));
+    RETURN_IF_FAILED(OrchestratorHashMap::CreateInstance(0, &m_OrchestratorHashMap));
 
     return S_OK;
 }
@@ -136,9 +172,9 @@ HRESULT DataItemOrchestrator::AddDataAndCreateInstanceReference(
 
     if (m_buildConfiguration->UseDeduplication())
     {
-        DEF_CHECKSUM defCheckSum = DefChecksum::ComputeChecksum(0, (const BYTE*)value, valueSizeInBytes);
+        UINT64 valueHash = OrchestratorHashMap::ComputeHash(value, valueSizeInBytes);
 
-        OrchestratorDataReference* dataRefereceFromMap = m_OrchestratorHashMap->TryGetFromMap(defCheckSum, value, valueSizeInBytes);
+        OrchestratorDataReference* dataRefereceFromMap = m_OrchestratorHashMap->TryGetFromMap(valueHash, value, valueSizeInBytes);
 
         if (dataRefereceFromMap == nullptr)
         {
@@ -149,9 +185,9 @@ HRESULT DataItemOrchestrator::AddDataAndCreateInstanceReference(
 
             AutoDeletePtr<OrchestratorDataReference> autoBuildInstanceReference;
             RETURN_IF_FAILED(OrchestratorDataReference::CreateInstance(
-                defCheckSum, value, valueSizeInBytes, dataItemSectionBuilder, &preBuildReference, &autoBuildInstanceReference));
+                valueHash, value, valueSizeInBytes, dataItemSectionBuilder, &preBuildReference, &autoBuildInstanceReference));
 
-            RETURN_IF_FAILED(m_OrchestratorHashMap->AddtoMap(defCheckSum, autoBuildInstanceReference));
+            RETURN_IF_FAILED(m_OrchestratorHashMap->AddtoMap(autoBuildInstanceReference));
 
             buildInstanceReference = autoBuildInstanceReference.Detach();
         }
@@ -208,9 +244,8 @@ HRESULT DataItemOrchestrator::AddStringAndCreateInstanceReference(
 
     if (m_buildConfiguration->UseDeduplication())
     {
-        DEF_CHECKSUM defCheckSum;
-        RETURN_IF_FAILED(DefChecksum::ComputeStringChecksum(0, true, value, &defCheckSum));
-        OrchestratorDataReference* dataRefereceFromMap = m_OrchestratorHashMap->TryGetFromMap(defCheckSum, value, valueLength);
+        UINT64 valueHash = OrchestratorHashMap::ComputeHash(value, valueLength);
+        OrchestratorDataReference* dataRefereceFromMap = m_OrchestratorHashMap->TryGetFromMap(valueHash, value, valueLength);
 
         if (dataRefereceFromMap == nullptr)
         {
@@ -221,9 +256,9 @@ HRESULT DataItemOrchestrator::AddStringAndCreateInstanceReference(
 
             AutoDeletePtr<OrchestratorDataReference> autoBuildInstanceReference;
             RETURN_IF_FAILED(OrchestratorDataReference::CreateInstance(
-                defCheckSum, value, valueLength, dataItemSectionBuilder, &preBuildReference, &autoBuildInstanceReference));
+                valueHash, value, valueLength, dataItemSectionBuilder, &preBuildReference, &autoBuildInstanceReference));
 
-            RETURN_IF_FAILED(m_OrchestratorHashMap->AddtoMap(defCheckSum, autoBuildInstanceReference));
+            RETURN_IF_FAILED(m_OrchestratorHashMap->AddtoMap(autoBuildInstanceReference));
 
             buildInstanceReference = autoBuildInstanceReference.Detach();
         }
@@ -305,139 +340,322 @@ HRESULT DataItemOrchestrator::OptimizeString(
     return S_OK;
 }
 
-HRESULT DataItemOrchestrator::AddOptimizedStringAndCreateInstanceReference(
+namespace
+{
+
+// Batches are encoded in chunks of this many strings, and only batches of at least two chunks are worth
+// handing to the thread pool.
+const UINT32 EncodeStringsChunkSize = 256;
+const UINT32 EncodeStringsMinParallelBatch = 2 * EncodeStringsChunkSize;
+
+// Tests eight UTF-16 code units at a time with SSE2 or NEON, then four at a time with plain 64-bit words;
+// any code unit above 0x7F has a bit set under the mask.
+bool IsAsciiString(_In_reads_(length) PCWSTR value, _In_ size_t length)
+{
+    const UINT64 nonAsciiMask = 0xFF80FF80FF80FF80ULL;
+
+    size_t i = 0;
+#if defined(_M_IX86) || defined(_M_X64)
+    const __m128i nonAsciiMask128 = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= length; i += 8)
+    {
+        __m128i codeUnits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&value[i]));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(codeUnits, nonAsciiMask128), zero)) != 0xFFFF)
+        {
+            return false;
+        }
+    }
+#elif defined(_M_ARM64)
+    for (; i + 8 <= length; i += 8)
+    {
+        if (vmaxvq_u16(vld1q_u16(reinterpret_cast<const uint16_t*>(&value[i]))) > 0x7F)
+        {
+            return false;
+        }
+    }
+#endif
+
+    for (; i + 4 <= length; i += 4)
+    {
+        UINT64 codeUnits;
+        memcpy(&codeUnits, &value[i], sizeof(codeUnits));
+        if ((codeUnits & nonAsciiMask) != 0)
+        {
+            return false;
+        }
+    }
+
+    for (; i < length; i++)
+    {
+        if (value[i] > 0x7F)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct EncodedString
+{
+    MrmEnvironment::ResourceValueType optimalType;
+    char* encodedValue; // nullptr if the string is stored as UTF-16
+    size_t encodedValueSize;
+    UINT64 valueHash; // hash of the stored form, only computed when deduplicating
+    HRESULT hr;
+};
+
+// Chooses the best encoding for a string and converts it if that isn't UTF-16, then hashes whichever form
+// will be stored if the orchestrator deduplicates. Any buffer allocated is left in encoded->encodedValue for
+// the caller to free, even on failure.
+HRESULT EncodeString(
+    _In_ DataItemOrchestrator* orchestrator,
     _In_ MrmEnvironment::ResourceValueType originalType,
     _In_ PCWSTR value,
+    _Inout_ EncodedString* encoded)
+{
+    size_t length = wcslen(value);
+
+    // Pure ASCII strings are by far the most common and always encode best as ASCII, so only strings with
+    // wider code units need the full size comparison.
+    DEFSTRING_ENCODING encoding = IsAsciiString(value, length) ? DEFSTRING_ENCODING_ASCII : DefString_ChooseBestEncoding(value);
+    encoded->optimalType = MrmEnvironment::ConvertToBestValueType(originalType, encoding);
+
+    if (MrmEnvironment::IsUtf16ResourceValueType(encoded->optimalType))
+    {
+        if (orchestrator->UseDeduplication())
+        {
+            size_t valueSize;
+            RETURN_IF_FAILED(orchestrator->GetValueSize(value, &valueSize));
+            encoded->valueHash = OrchestratorHashMap::ComputeHash(value, valueSize);
+        }
+        return S_OK;
+    }
+
+    // We know that the new string is less than the size of the existing one, else we wouldn't bother converting it.
+    size_t bufferSize = (length + 1) * sizeof(wchar_t);
+    encoded->encodedValue = _DefArray_Alloc(char, bufferSize);
+    RETURN_IF_NULL_ALLOC(encoded->encodedValue);
+
+    encoded->encodedValueSize = length;
+    RETURN_IF_FAILED(
+        orchestrator->OptimizeString(encoded->encodedValue, value, &encoded->encodedValueSize, bufferSize, &encoded->optimalType));
+
+    if (orchestrator->UseDeduplication())
+    {
+        encoded->valueHash = OrchestratorHashMap::ComputeHash(encoded->encodedValue, encoded->encodedValueSize);
+    }
+    return S_OK;
+}
+
+struct EncodeStringsContext
+{
+    DataItemOrchestrator* orchestrator;
+    const DataItemOrchestrator::OptimizedString* strings;
+    EncodedString* encoded;
+    UINT32 numStrings;
+    LONG numChunks;
+    volatile LONG nextChunk;
+};
+
+// Each callback encodes and hashes one chunk of strings. Encoding only reads the input string and writes its
+// own EncodedString, so chunks can be encoded in any order.
+VOID CALLBACK EncodeStringsCallback(_Inout_ PTP_CALLBACK_INSTANCE, _Inout_opt_ PVOID pContext, _Inout_ PTP_WORK)
+{
+    EncodeStringsContext* pEncodeContext = static_cast<EncodeStringsContext*>(pContext);
+    LONG chunk = InterlockedIncrement(&pEncodeContext->nextChunk) - 1;
+
+    if (chunk < pEncodeContext->numChunks)
+    {
+        UINT32 first = static_cast<UINT32>(chunk) * EncodeStringsChunkSize;
+        UINT32 last = first + EncodeStringsChunkSize;
+        if (last > pEncodeContext->numStrings)
+        {
+            last = pEncodeContext->numStrings;
+        }
+
+        for (UINT32 i = first; i < last; i++)
+        {
+            pEncodeContext->encoded[i].hr = EncodeString(
+                pEncodeContext->orchestrator,
+                pEncodeContext->strings[i].originalType,
+                pEncodeContext->strings[i].value,
+                &pEncodeContext->encoded[i]);
+        }
+    }
+}
+
+} // namespace
+
+HRESULT DataItemOrchestrator::AddEncodedStringAndCreateInstanceReference(
+    _In_ PCWSTR value,
+    _In_reads_bytes_opt_(encodedValueSize) const char* encodedValue,
+    _In_ size_t encodedValueSize,
+    _In_ UINT64 valueHash,
     _In_ int qualifierSetIndex,
-    _Outptr_ IBuildInstanceReference** result,
-    _Out_ MrmEnvironment::ResourceValueType* optimalType)
+    _Outptr_ IBuildInstanceReference** result)
 {
     *result = nullptr;
-    RETURN_HR_IF(E_DEF_ALREADY_INITIALIZED, m_finalized);
-    RETURN_HR_IF(E_DEF_INCOMPATIBLE_VALUE_TYPE, !MrmEnvironment::IsUtf16ResourceValueType(originalType));
 
     DataItemsSectionBuilder::PrebuildItemReference preBuildReference = {};
+    DataItemsSectionBuilder* dataItemSectionBuilder;
 
-    if (m_buildConfiguration->UseDeduplication())
+    if (!m_buildConfiguration->UseDeduplication())
     {
-        DEF_CHECKSUM defCheckSum = 0;
-        OrchestratorDataReference* buildInstanceReference = nullptr;
-
-        // Override the provided resource value type with the optimal one.
-        *optimalType = MrmEnvironment::ConvertToBestValueType(originalType, DefString_ChooseBestEncoding(value));
+        RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, &dataItemSectionBuilder));
 
-        if (!MrmEnvironment::IsUtf16ResourceValueType(*optimalType))
+        if (encodedValue != nullptr)
         {
-            // The input can be optimized.
-            // The actual value stored in OrchestratorDataReference needs to be consistent with the converted value added to dataItemSectionBuilder.
-            // Therefore we convert the stirng at first so we can check its check sum and serach for a duplicaiton,
-            // then create OrchestratorDataReference instance to store the converted string.
-
-            // We know that the new string is less than the size of the existing one, else we wouldn't bother converting it.
-            size_t writtenBytesIncludingNull = wcslen(value);
-            size_t convertedStringSize = (writtenBytesIncludingNull + 1) * sizeof(wchar_t);
-            BlobResult convertedStringResult;
-            char* convertedString;
-            RETURN_IF_FAILED(convertedStringResult.SetEmptyContents(convertedStringSize, (void**)&convertedString));
-
-            RETURN_IF_FAILED(OptimizeString(convertedString, value, &writtenBytesIncludingNull, convertedStringSize, optimalType));
-
-            // Converting finished. Check duplication.
-            defCheckSum = DefChecksum::ComputeChecksum(
-                0, reinterpret_cast<const BYTE*>(convertedString), static_cast<UINT32>(writtenBytesIncludingNull));
-            buildInstanceReference =
-                m_OrchestratorHashMap->TryGetFromMap(defCheckSum, convertedString, static_cast<UINT32>(writtenBytesIncludingNull));
-
-            if (buildInstanceReference == nullptr) // The input value is an unique one.
-            {
-                DataItemsSectionBuilder* dataItemSectionBuilder;
-                RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, &dataItemSectionBuilder));
-
-                RETURN_IF_FAILED(dataItemSectionBuilder->AddDataItem(
-                    convertedString, static_cast<UINT32>(writtenBytesIncludingNull), &preBuildReference));
-
-                AutoDeletePtr<OrchestratorDataReference> autoBuildInstanceReference;
-                RETURN_IF_FAILED(OrchestratorDataReference::CreateInstance(
-                    defCheckSum,
-                    convertedString,
-                    static_cast<size_t>(writtenBytesIncludingNull),
-                    dataItemSectionBuilder,
-                    &preBuildReference,
-                    &autoBuildInstanceReference));
-
-                RETURN_IF_FAILED(m_OrchestratorHashMap->AddtoMap(defCheckSum, autoBuildInstanceReference));
-
-                *result = autoBuildInstanceReference.Detach();
-                return S_OK;
-            } // End of if (buildInstanceReference == nullptr)
-            else // A duplication found.
-            {
-                return OrchestratorDataReference::CloneDataReference(buildInstanceReference, (OrchestratorDataReference**)result);
-            }
-        } // End of if(!MrmEnvironment::IsUtf16ResourceValueType(*optimalType))
-        else // The input value do not need to be optimized.
+            RETURN_IF_FAILED(dataItemSectionBuilder->AddDataItem(encodedValue, static_cast<UINT32>(encodedValueSize), &preBuildReference));
+        }
+        else
         {
-            RETURN_IF_FAILED(DefChecksum::DefChecksum::ComputeStringChecksum(0, true, value, &defCheckSum));
+            RETURN_IF_FAILED(dataItemSectionBuilder->AddDataString(value, &preBuildReference));
+        }
 
-            size_t valueLength;
-            RETURN_IF_FAILED(GetValueSize(value, &valueLength)); // Use safe calculations to get the value length.
+        return DataItemsBuildInstanceReference::CreateInstance(
+            dataItemSectionBuilder, &preBuildReference, (DataItemsBuildInstanceReference**)result);
+    }
 
-            buildInstanceReference = m_OrchestratorHashMap->TryGetFromMap(defCheckSum, value, valueLength);
-            if (buildInstanceReference == nullptr) // The input value is an unique one.
-            {
-                DataItemsSectionBuilder* dataItemSectionBuilder;
-                RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, &dataItemSectionBuilder));
+    // The actual value stored in OrchestratorDataReference needs to be consistent with the value added to dataItemSectionBuilder,
+    // so an optimized string is compared in its converted form. EncodeString has already hashed that form.
+    const void* dataValue = encodedValue;
+    size_t dataValueSize = encodedValueSize;
+    if (encodedValue == nullptr)
+    {
+        dataValue = value;
+        RETURN_IF_FAILED(GetValueSize(value, &dataValueSize)); // Use safe calculations to get the value length.
+    }
+
+    OrchestratorDataReference* dataReferenceFromMap = m_OrchestratorHashMap->TryGetFromMap(valueHash, dataValue, dataValueSize);
+    if (dataReferenceFromMap != nullptr) // A duplication found.
+    {
+        return OrchestratorDataReference::CloneDataReference(dataReferenceFromMap, (OrchestratorDataReference**)result);
+    }
+
+    RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, &dataItemSectionBuilder));
+
+    if (encodedValue != nullptr)
+    {
+        RETURN_IF_FAILED(dataItemSectionBuilder->AddDataItem(encodedValue, static_cast<UINT32>(encodedValueSize), &preBuildReference));
+    }
+    else
+    {
+        RETURN_IF_FAILED(dataItemSectionBuilder->AddDataString(value, &preBuildReference));
+    }
 
-                RETURN_IF_FAILED(dataItemSectionBuilder->AddDataString(value, &preBuildReference));
+    AutoDeletePtr<OrchestratorDataReference> autoBuildInstanceReference;
+    RETURN_IF_FAILED(OrchestratorDataReference::CreateInstance(
+        valueHash, dataValue, dataValueSize, dataItemSectionBuilder, &preBuildReference, &autoBuildInstanceReference));
 
-                AutoDeletePtr<OrchestratorDataReference> autoBuildInstanceReference;
-                RETURN_IF_FAILED(OrchestratorDataReference::CreateInstance(
-                    defCheckSum, value, valueLength, dataItemSectionBuilder, &preBuildReference, &autoBuildInstanceReference));
+    RETURN_IF_FAILED(m_OrchestratorHashMap->AddtoMap(autoBuildInstanceReference));
 
-                RETURN_IF_FAILED(m_OrchestratorHashMap->AddtoMap(defCheckSum, autoBuildInstanceReference));
+    *result = autoBuildInstanceReference.Detach();
+    return S_OK;
+}
 
-                *result = autoBuildInstanceReference.Detach();
-                return S_OK;
-            }
-            else // Duplication found
-            {
-                return OrchestratorDataReference::CloneDataReference(buildInstanceReference, (OrchestratorDataReference**)result);
-            }
-        } // End of else. End of non-optimized string deduplication process.
-    } // End of deduplication process
-    else // Deduplication disabled.
+HRESULT DataItemOrchestrator::AddOptimizedStringAndCreateInstanceReference(
+    _In_ MrmEnvironment::ResourceValueType originalType,
+    _In_ PCWSTR value,
+    _In_ int qualifierSetIndex,
+    _Outptr_ IBuildInstanceReference** result,
+    _Out_ MrmEnvironment::ResourceValueType* optimalType)
+{
+    *result = nullptr;
+    RETURN_HR_IF(E_DEF_ALREADY_INITIALIZED, m_finalized);
+    RETURN_HR_IF(E_DEF_INCOMPATIBLE_VALUE_TYPE, !MrmEnvironment::IsUtf16ResourceValueType(originalType));
+
+    EncodedString encoded = {};
+    HRESULT hr = EncodeString(this, originalType, value, &encoded);
+    unique_deffree_ptr<char> encodedValue(encoded.encodedValue);
+    RETURN_IF_FAILED(hr);
+
+    // Override the provided resource value type with the optimal one.
+    *optimalType = encoded.optimalType;
+    return AddEncodedStringAndCreateInstanceReference(
+        value, encodedValue.get(), encoded.encodedValueSize, encoded.valueHash, qualifierSetIndex, result);
+}
+
+// Choosing an encoding, converting and hashing a string don't depend on any other string, so a large batch
+// is encoded concurrently first. The encoded strings are then looked up and added one at a time in input
+// order, which keeps deduplication and data item placement the same as adding each string on its own.
+HRESULT DataItemOrchestrator::AddOptimizedStringsAndCreateInstanceReferences(
+    _In_ UINT32 numStrings,
+    _Inout_updates_(numStrings) OptimizedString* strings)
+{
+    RETURN_HR_IF(E_DEF_ALREADY_INITIALIZED, m_finalized);
+    RETURN_HR_IF_NULL(E_INVALIDARG, strings);
+
+    for (UINT32 i = 0; i < numStrings; i++)
     {
-        DataItemsSectionBuilder* dataItemSectionBuilder;
-        RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, &dataItemSectionBuilder));
+        strings[i].result = nullptr;
+        strings[i].optimalType = strings[i].originalType;
+        RETURN_HR_IF_NULL(E_INVALIDARG, strings[i].value);
+        RETURN_HR_IF(E_DEF_INCOMPATIBLE_VALUE_TYPE, !MrmEnvironment::IsUtf16ResourceValueType(strings[i].originalType));
+    }
 
-        // Override the provided resource value type with the optimal one.
-        *optimalType = MrmEnvironment::ConvertToBestValueType(originalType, DefString_ChooseBestEncoding(value));
+    if (numStrings == 0)
+    {
+        return S_OK;
+    }
 
-        if (!MrmEnvironment::IsUtf16ResourceValueType(*optimalType))
+    // Grow the deduplication map once up front rather than rehashing part way through the batch.
+    if (UseDeduplication())
+    {
+        UINT32 expectedItems;
+        RETURN_IF_FAILED(UInt32Add(GetNumDeduplicatedItems(), numStrings, &expectedItems));
+        RETURN_IF_FAILED(ReserveDeduplicationCapacity(expectedItems));
+    }
+
+    unique_deffree_ptr<EncodedString> encoded(_DefArray_AllocZeroed(EncodedString, numStrings));
+    RETURN_IF_NULL_ALLOC(encoded.get());
+    auto freeEncodedValues = wil::scope_exit([&] {
+        for (UINT32 i = 0; i < numStrings; i++)
         {
-            // We know that the new string is less than the size of the existing one, else we wouldn't bother converting it.
-            size_t writtenBytesIncludingNull = wcslen(value);
-            size_t convertedStringSize = (writtenBytesIncludingNull + 1) * sizeof(wchar_t);
-            BlobResult convertedStringResult;
-            char* convertedString;
-            RETURN_IF_FAILED(convertedStringResult.SetEmptyContents(convertedStringSize, (void**)&convertedString));
+            if (encoded.get()[i].encodedValue != nullptr)
+            {
+                _DefFree(encoded.get()[i].encodedValue);
+            }
+        }
+    });
 
-            RETURN_IF_FAILED(OptimizeString(convertedString, value, &writtenBytesIncludingNull, convertedStringSize, optimalType));
+    if (numStrings >= EncodeStringsMinParallelBatch)
+    {
+        LONG numChunks = static_cast<LONG>((numStrings + EncodeStringsChunkSize - 1) / EncodeStringsChunkSize);
+        EncodeStringsContext context = {this, strings, encoded.get(), numStrings, numChunks, 0};
+        PTP_WORK work = CreateThreadpoolWork(EncodeStringsCallback, &context, nullptr);
+        RETURN_LAST_ERROR_IF_NULL(work);
 
-            RETURN_IF_FAILED(
-                dataItemSectionBuilder->AddDataItem(convertedString, static_cast<UINT32>(writtenBytesIncludingNull), &preBuildReference));
+        for (LONG i = 0; i < numChunks; i++)
+        {
+            SubmitThreadpoolWork(work);
         }
-        else
+        WaitForThreadpoolWorkCallbacks(work, FALSE);
+        CloseThreadpoolWork(work);
+    }
+    else
+    {
+        for (UINT32 i = 0; i < numStrings; i++)
         {
-            RETURN_IF_FAILED(dataItemSectionBuilder->AddDataString(value, &preBuildReference));
+            encoded.get()[i].hr = EncodeString(this, strings[i].originalType, strings[i].value, &encoded.get()[i]);
         }
+    }
 
-        IBuildInstanceReference* buildInstanceReference;
-        RETURN_IF_FAILED(DataItemsBuildInstanceReference::CreateInstance(
-            dataItemSectionBuilder, &preBuildReference, (DataItemsBuildInstanceReference**)&buildInstanceReference));
+    for (UINT32 i = 0; i < numStrings; i++)
+    {
+        EncodedString* pEncoded = &encoded.get()[i];
+        RETURN_IF_FAILED(pEncoded->hr);
+
+        RETURN_IF_FAILED(AddEncodedStringAndCreateInstanceReference(
+            strings[i].value,
+            pEncoded->encodedValue,
+            pEncoded->encodedValueSize,
+            pEncoded->valueHash,
+            strings[i].qualifierSetIndex,
+            &strings[i].result));
+        strings[i].optimalType = pEncoded->optimalType;
+    }
 
-        *result = buildInstanceReference;
-    } // End of non-deduplication process
     return S_OK;
 }
 
@@ -478,8 +696,17 @@ void DataItemOrchestrator::DisableDeduplication()
     m_buildConfiguration->SetFlags(newFlags);
 }
 
+bool DataItemOrchestrator::UseDeduplication() const { return m_buildConfiguration->UseDeduplication(); }
+
+HRESULT DataItemOrchestrator::ReserveDeduplicationCapacity(_In_ UINT32 expectedItems)
+{
+    return m_OrchestratorHashMap->Reserve(expectedItems);
+}
+
+UINT32 DataItemOrchestrator::GetNumDeduplicatedItems() const { return static_cast<UINT32>(m_OrchestratorHashMap->Count()); }
+
 HRESULT OrchestratorDataReference::CreateInstance(
-    _In_ DEF_CHECKSUM valueHash,
+    _In_ UINT64 valueHash,
     _In_reads_bytes_(valueSizeInBytes) const void* actualValue,
     _In_ size_t valueSizeInBytes,
     _In_ DataItemsSectionBuilder* builder,
@@ -500,7 +727,7 @@ HRESULT OrchestratorDataReference::CreateInstance(
 }
 
 OrchestratorDataReference::OrchestratorDataReference(
-    _In_ DEF_CHECKSUM valueHash,
+    _In_ UINT64 valueHash,
     _In_ DataItemsSectionBuilder* builder,
     _In_ DataItemsSectionBuilder::PrebuildItemReference* preBuildItemReference) :
     m_valueHash(valueHash), m_disBuilder(builder)
@@ -593,230 +820,150 @@ const void* OrchestratorDataReference::GetActualValue() const
 
 size_t OrchestratorDataReference::GetActualValueSize() const { return m_actualDataBlob.GetSize(); }
 
-HRESULT OrchestratorHashNode::CreateInstance(
-    _In_ DEF_CHECKSUM valueHash,
-    _In_ OrchestratorDataReference* dataReference,
-    _Outptr_ OrchestratorHashNode** result)
-{
-    *result = nullptr;
-    RETURN_HR_IF_NULL(E_INVALIDARG, dataReference);
-
-    OrchestratorHashNode* hashNode = new OrchestratorHashNode(valueHash, dataReference);
-    RETURN_IF_NULL_ALLOC(hashNode);
-
-    *result = hashNode;
-    return S_OK;
-}
-
-OrchestratorHashNode::OrchestratorHashNode(_In_ DEF_CHECKSUM valueHash, _In_ OrchestratorDataReference* dataReference) :
-    m_valueHash(valueHash), m_dataReference(dataReference), m_nextOrchHashNode(nullptr)
-{}
+OrchestratorHashMap::OrchestratorHashMap() : m_pEntries(nullptr), m_numSlots(0), m_numEntries(0) {}
 
-bool OrchestratorHashNode::SetNext(_In_ OrchestratorHashNode* inputNode)
-{
-    m_nextOrchHashNode = inputNode;
-    return true;
-}
+OrchestratorHashMap::~OrchestratorHashMap() { Def_Free(m_pEntries); }
 
-OrchestratorHashMap::~OrchestratorHashMap()
-{
-    if (m_entries != nullptr)
-    {
-        for (int entryIndex = 0; entryIndex < m_currentSize; entryIndex++)
-        {
-            OrchestratorHashNode* node = nullptr;
-            m_entries->TryGet(entryIndex, &node);
-            while (node != nullptr)
-            {
-                OrchestratorHashNode* nodeToBeDeleted = node;
-                node = node->GetNext();
-                delete nodeToBeDeleted;
-                nodeToBeDeleted = nullptr;
-            }
-        }
-
-        delete m_entries;
-    }
-}
-
-OrchestratorHashMap::OrchestratorHashMap(_In_ int initCapacity, _In_ float loadFactor) :
-    m_currentSize(initCapacity), m_nodeCount(0), m_loadFactor(loadFactor)
-{}
-
-HRESULT OrchestratorHashMap::Init(int initCapacity)
-{
-    RETURN_IF_FAILED(DynamicArray<OrchestratorHashNode*>::CreateInstance(initCapacity, &m_entries));
-    return S_OK;
-}
-
-HRESULT OrchestratorHashMap::CreateInstance(_In_ int initCapacity, _In_ float loadFactor, _Outptr_ OrchestratorHashMap** result)
+HRESULT OrchestratorHashMap::CreateInstance(_In_ UINT32 expectedItems, _Outptr_ OrchestratorHashMap** result)
 {
     *result = nullptr;
 
-    AutoDeletePtr<OrchestratorHashMap> orchsHashMap = new OrchestratorHashMap(initCapacity, loadFactor);
+    AutoDeletePtr<OrchestratorHashMap> orchsHashMap = new OrchestratorHashMap();
     RETURN_IF_NULL_ALLOC(orchsHashMap);
-    RETURN_IF_FAILED(orchsHashMap->Init(initCapacity));
+    RETURN_IF_FAILED(orchsHashMap->Reserve(expectedItems));
 
     *result = orchsHashMap.Detach();
     return S_OK;
 }
 
-int OrchestratorHashMap::HashCode(_In_ DEF_CHECKSUM key)
-{
-    int index = key % m_currentSize;
-    return index;
-}
-
-int OrchestratorHashMap::HashCode(_In_ size_t newSize, _In_ DEF_CHECKSUM key)
-{
-    int index = key % newSize;
-    return index;
-}
-
-HRESULT OrchestratorHashMap::AddtoMap(_In_ DEF_CHECKSUM key, _In_ OrchestratorDataReference* dataReference)
+// An xxHash64-style hash over the value, taken eight bytes at a time.
+UINT64 OrchestratorHashMap::ComputeHash(_In_reads_bytes_(valueSizeInBytes) const void* value, _In_ size_t valueSizeInBytes)
 {
-    RETURN_HR_IF_NULL(E_INVALIDARG, dataReference);
-
-    int valueIndex = HashCode(key);
-    OrchestratorHashNode* existingNode = nullptr;
-    m_entries->TryGet(valueIndex, &existingNode);
-
-    AutoDeletePtr<OrchestratorHashNode> newHashNode;
-    RETURN_IF_FAILED(OrchestratorHashNode::CreateInstance(key, dataReference, &newHashNode));
+    const BYTE* pBytes = static_cast<const BYTE*>(value);
+    UINT64 hash = OrchestratorPrime64_5;
+    size_t offset = 0;
 
-    RETURN_IF_FAILED(m_entries->ExtendAndSet(valueIndex, newHashNode, &existingNode));
-    OrchestratorHashNode* newLocalHasNode = newHashNode.Detach();
+    for (; offset + sizeof(UINT64) <= valueSizeInBytes; offset += sizeof(UINT64))
+    {
+        UINT64 block;
+        memcpy(&block, &pBytes[offset], sizeof(block));
+        hash ^= _rotl64(block * OrchestratorPrime64_2, 31) * OrchestratorPrime64_1;
+        hash = (_rotl64(hash, 27) * OrchestratorPrime64_1) + OrchestratorPrime64_4;
+    }
 
-    if (existingNode != nullptr)
+    if (offset < valueSizeInBytes)
     {
-        newLocalHasNode->SetNext(existingNode);
+        UINT64 block = 0;
+        memcpy(&block, &pBytes[offset], valueSizeInBytes - offset);
+        hash ^= block * OrchestratorPrime64_5;
+        hash = _rotl64(hash, 11) * OrchestratorPrime64_1;
     }
 
-    m_nodeCount++;
+    hash += valueSizeInBytes;
+
+    hash ^= hash >> 33;
+    hash *= OrchestratorPrime64_2;
+    hash ^= hash >> 29;
+    hash *= OrchestratorPrime64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
 
-    if (m_nodeCount > m_currentSize * m_loadFactor)
+HRESULT OrchestratorHashMap::Reserve(_In_ UINT32 expectedItems)
+{
+    // Keep the table at most half full so probe sequences stay short.
+    UINT32 numSlots = OrchestratorHashMapMinSlots;
+    while ((numSlots / 2) < expectedItems)
     {
-        RETURN_IF_FAILED(ResizeMap());
+        RETURN_HR_IF(E_OUTOFMEMORY, numSlots > (UINT32_MAX / 2));
+        numSlots <<= 1;
     }
 
-    return S_OK;
+    return (numSlots > m_numSlots) ? Rehash(numSlots) : S_OK;
 }
 
-HRESULT OrchestratorHashMap::ResizeMap()
+HRESULT OrchestratorHashMap::Rehash(_In_ UINT32 numSlots)
 {
-    int oldindex = 0;
-    int newIndex = 0;
-    DEF_CHECKSUM key = 0;
-    OrchestratorHashNode* nodeToMove = nullptr;
-    OrchestratorHashNode* nestNodeInOldMap = nullptr;
-    OrchestratorHashNode* existingNodeInNewMap = nullptr;
-    OrchestratorDataReference* dataReference = nullptr;
-    DynamicArray<OrchestratorHashNode*>* oldMapEntry = m_entries;
-    AutoDeletePtr<DynamicArray<OrchestratorHashNode*>> newMapEntry;
-
-    RETURN_IF_FAILED(DynamicArray<OrchestratorHashNode*>::CreateInstance(m_currentSize * 2, &newMapEntry));
+    Entry* pEntries = _DefArray_AllocZeroed(Entry, numSlots);
+    RETURN_IF_NULL_ALLOC(pEntries);
 
-    for (oldindex = 0; oldindex < m_currentSize; oldindex++)
+    // Every entry keeps its full hash, so moving it never touches the value itself.
+    for (UINT32 i = 0; i < m_numSlots; i++)
     {
-        nestNodeInOldMap = nullptr;
-        if (!oldMapEntry->TryGet(oldindex, &nestNodeInOldMap))
+        if (m_pEntries[i].dataReference != nullptr)
         {
-            continue;
-        }
-
-        while (nestNodeInOldMap != nullptr)
-        {
-            //move the odeNode pointer
-            nodeToMove = nestNodeInOldMap;
-            nestNodeInOldMap = nestNodeInOldMap->GetNext();
-
-            //set this node's nextpoint to null
-            nodeToMove->SetNext(nullptr);
-
-            //Calculate new index by the hash from its reference
-            dataReference = nodeToMove->GetDataReference();
-            key = dataReference->GetValueHash();
-            size_t newsize = 0;
-            RETURN_IF_FAILED(SizeTAdd(m_currentSize, m_currentSize, &newsize));
-
-            newIndex = HashCode(newsize, key);
-
-            //put the new node(actually not a totally new one)
-            //check if the position is null
-            existingNodeInNewMap = nullptr;
-            newMapEntry->TryGet(newIndex, &existingNodeInNewMap);
-
-            if (existingNodeInNewMap == nullptr) //the new position is empty, put the node in there
-            {
-                RETURN_IF_FAILED(newMapEntry->ExtendAndSet(newIndex, nodeToMove));
-            }
-            else //the new position is not empty, put the new node in front of the existing node.
+            UINT32 slot = static_cast<UINT32>(m_pEntries[i].valueHash) & (numSlots - 1);
+            while (pEntries[slot].dataReference != nullptr)
             {
-                nodeToMove->SetNext(existingNodeInNewMap);
-                RETURN_IF_FAILED(newMapEntry->ExtendAndSet(newIndex, nodeToMove));
+                slot = (slot + 1) & (numSlots - 1);
             }
-            //Finish adding one node continue check.
+            pEntries[slot] = m_pEntries[i];
         }
     }
 
-    m_entries = newMapEntry.Detach();
-    delete oldMapEntry;
-    m_currentSize = m_currentSize * 2;
+    Def_Free(m_pEntries);
+    m_pEntries = pEntries;
+    m_numSlots = numSlots;
     return S_OK;
 }
 
-OrchestratorDataReference* OrchestratorHashMap::TryGetFromMap(
-    _In_ DEF_CHECKSUM key,
-    _In_opt_ const void* value,
-    _In_opt_ size_t valueSizeInBytes)
+HRESULT OrchestratorHashMap::AddtoMap(_In_ OrchestratorDataReference* dataReference)
 {
-    if ((value == nullptr) || (valueSizeInBytes > SIZE_T_MAX))
+    RETURN_HR_IF_NULL(E_INVALIDARG, dataReference);
+
+    if ((m_numEntries + 1) > (m_numSlots / 2))
     {
-        return nullptr;
+        RETURN_HR_IF(E_OUTOFMEMORY, m_numSlots > (UINT32_MAX / 2));
+        RETURN_IF_FAILED(Rehash(m_numSlots * 2));
     }
 
-    int valueIndex = HashCode(key);
-    int ifEqual = 1;
+    UINT64 valueHash = dataReference->GetValueHash();
+    UINT32 slot = static_cast<UINT32>(valueHash) & (m_numSlots - 1);
+    while (m_pEntries[slot].dataReference != nullptr)
+    {
+        slot = (slot + 1) & (m_numSlots - 1);
+    }
 
-    // get the entry of the value
-    OrchestratorHashNode* existingNodeInCurrentMap = nullptr;
+    size_t valueSize = dataReference->GetActualValueSize();
+    m_pEntries[slot].valueHash = valueHash;
+    m_pEntries[slot].valueSize = ClampValueSize(valueSize);
+    m_pEntries[slot].valuePrefix = ReadValuePrefix(dataReference->GetActualValue(), valueSize);
+    m_pEntries[slot].dataReference = dataReference;
+    m_numEntries++;
 
-    (void)m_entries->Get(valueIndex, &existingNodeInCurrentMap);
+    return S_OK;
+}
 
-    // if it is nullptr, there is no exsiting node in that position.
-    // Return nullptr means new node can be added to this position.
-    if (existingNodeInCurrentMap == nullptr)
+OrchestratorDataReference* OrchestratorHashMap::TryGetFromMap(
+    _In_ UINT64 valueHash,
+    _In_opt_ const void* value,
+    _In_opt_ size_t valueSizeInBytes) const
+{
+    if ((value == nullptr) || (m_numSlots == 0))
     {
         return nullptr;
     }
 
-    // If the entry is not nullptr, need to check the link on this entry.
-    while (existingNodeInCurrentMap != nullptr)
+    UINT32 valueSize = ClampValueSize(valueSizeInBytes);
+    UINT32 valuePrefix = ReadValuePrefix(value, valueSizeInBytes);
+
+    for (UINT32 slot = static_cast<UINT32>(valueHash) & (m_numSlots - 1); m_pEntries[slot].dataReference != nullptr;
+         slot = (slot + 1) & (m_numSlots - 1))
     {
-        // Firstly, check if there is any same hash code in the link.
-        if (existingNodeInCurrentMap->GetHash() == key)
-        {
-            // A node with the same hash code found
-            // Secondly, check if they have the same hash value.
-            // Only if so, they can be considered as duplicate values.
-            OrchestratorDataReference* dataReference = existingNodeInCurrentMap->GetDataReference();
-
-            // if the input value has the same size with the existing value, check the actual values.
-            // if they have different size, consider as different value.
-            if (valueSizeInBytes == dataReference->GetActualValueSize())
-            {
-                const void* existingValue = dataReference->GetActualValue();
-                ifEqual = memcmp(value, existingValue, valueSizeInBytes);
-            }
+        const Entry& entry = m_pEntries[slot];
 
-            if (ifEqual == 0)
+        // Only if the hash, size and leading bytes all match do we compare the stored value, and only
+        // then can the two be considered duplicates.
+        if ((entry.valueHash == valueHash) && (entry.valueSize == valueSize) && (entry.valuePrefix == valuePrefix))
+        {
+            OrchestratorDataReference* dataReference = entry.dataReference;
+            if ((dataReference->GetActualValueSize() == valueSizeInBytes) &&
+                ((valueSizeInBytes == 0) || (memcmp(value, dataReference->GetActualValue(), valueSizeInBytes) == 0)))
             {
                 // A true duplication found, return the existing dataReference.
                 return dataReference;
             }
         }
-
-        existingNodeInCurrentMap = existingNodeInCurrentMap->GetNext();
     }
 
     return nullptr;
@@ -8,7 +8,9 @@
 namespace Microsoft::Resources::Build
 {
 
-FileAtomPoolBuilder::FileAtomPoolBuilder() : m_pStrings(nullptr), m_offset(nullptr), m_hash(nullptr), m_flags(0) {}
+FileAtomPoolBuilder::FileAtomPoolBuilder() :
+    m_pStrings(nullptr), m_offset(nullptr), m_hash(nullptr), m_buckets(nullptr), m_numBuckets(0), m_flags(0)
+{}
 
 HRESULT FileAtomPoolBuilder::Init(_In_opt_ PCWSTR pDescription, _In_ WriteableStringPool* pStrings, UINT32 flags)
 {
@@ -16,7 +18,9 @@ HRESULT FileAtomPoolBuilder::Init(_In_opt_ PCWSTR pDescription, _In_ WriteableSt
 
     m_finalized = false;
     m_flags = flags;
-    m_hashMethod = ((flags & fIsCaseInsensitive) ? Atom::HashMethodCaseInsensitive : Atom::HashMethodDefault);
+    m_hashMethod = static_cast<Atom::HashMethod>(
+        ((flags & fIsCaseInsensitive) ? Atom::HashMethodCaseInsensitive : Atom::HashMethodDefault) |
+        ((flags & fUsesHashV2) ? Atom::HashMethodVersion2 : Atom::HashMethodDefault));
 
     m_group = NULL;
     m_poolIndex = Atom::NullPoolIndex;
@@ -31,6 +35,8 @@ HRESULT FileAtomPoolBuilder::Init(_In_opt_ PCWSTR pDescription, _In_ WriteableSt
     m_sizeAtoms = 0;
     m_hash = NULL;
     m_offset = NULL;
+    m_buckets = NULL;
+    m_numBuckets = 0;
     m_sectionIndex = 0;
     m_pStrings = pStrings;
 
@@ -118,6 +124,12 @@ FileAtomPoolBuilder::~FileAtomPoolBuilder()
         _DefFree(m_hash);
         m_hash = NULL;
     }
+    if (m_buckets != NULL)
+    {
+        _DefFree(m_buckets);
+        m_buckets = NULL;
+    }
+    m_numBuckets = 0;
 }
 
 HRESULT FileAtomPoolBuilder::Extend(__in size_t newSize)
@@ -143,6 +155,48 @@ HRESULT FileAtomPoolBuilder::Extend(__in size_t newSize)
     return S_OK;
 }
 
+// Sizes the lookup table for numAtoms atoms and re-adds the atoms already in the pool.
+HRESULT FileAtomPoolBuilder::RebuildHashTable(__in UINT32 numAtoms)
+{
+    UINT32 numBuckets = FileAtomPool::GetHashTableNumBuckets(numAtoms);
+    FileAtomPool::HashTableEntry* pBuckets = _DefArray_AllocZeroed(FileAtomPool::HashTableEntry, numBuckets);
+    RETURN_IF_NULL_ALLOC(pBuckets);
+
+    for (Atom::Index i = 0; i < m_numAtoms; i++)
+    {
+        FileAtomPool::HashTable_Insert(pBuckets, numBuckets, m_hash[i].hash, m_hash[i].index);
+    }
+
+    if (m_buckets != NULL)
+    {
+        _DefFree(m_buckets);
+    }
+    m_buckets = pBuckets;
+    m_numBuckets = numBuckets;
+    return S_OK;
+}
+
+HRESULT FileAtomPoolBuilder::SetUseHashV2(_In_ bool useHashV2)
+{
+    m_flags = (useHashV2 ? (m_flags | fUsesHashV2) : (m_flags & ~fUsesHashV2));
+    m_hashMethod = static_cast<Atom::HashMethod>(
+        (GetIsCaseInsensitive() ? Atom::HashMethodCaseInsensitive : Atom::HashMethodDefault) |
+        (useHashV2 ? Atom::HashMethodVersion2 : Atom::HashMethodDefault));
+
+    // Rehash anything that was already added.
+    for (Atom::Index i = 0; i < m_numAtoms; i++)
+    {
+        m_hash[i].hash = Atom::HashString(m_pStrings->GetString(m_offset[m_hash[i].index]), m_hashMethod);
+    }
+
+    if (m_numAtoms > 0)
+    {
+        RETURN_IF_FAILED(RebuildHashTable(m_numAtoms));
+    }
+
+    return S_OK;
+}
+
 HRESULT FileAtomPoolBuilder::GetOrAddAtom(__in PCWSTR pString, _Out_ Atom* result, __out_opt bool* pIsNewOut)
 {
     *result = Atom::NullAtom;
@@ -169,12 +223,19 @@ HRESULT FileAtomPoolBuilder::GetOrAddAtom(__in PCWSTR pString, _Out_ Atom* resul
         DEF_ASSERT(m_sizeAtoms > m_numAtoms);
     }
 
+    if (((m_numAtoms + 1) * 2) > static_cast<Atom::AtomCount>(m_numBuckets))
+    {
+        RETURN_IF_FAILED(RebuildHashTable(m_numAtoms + 1));
+    }
+
     m_hash[m_numAtoms].hash = Atom::HashString(pString, m_hashMethod);
     m_hash[m_numAtoms].index = m_numAtoms;
 
     m_offset[m_numAtoms] = m_pStrings->GetOrAddStringOffset(pString);
     RETURN_HR_IF(E_ABORT, m_offset[m_numAtoms] == -1);
 
+    FileAtomPool::HashTable_Insert(m_buckets, m_numBuckets, m_hash[m_numAtoms].hash, m_numAtoms);
+
     rtrn.Set(m_numAtoms, m_poolIndex);
     m_numAtoms++;
 
@@ -293,12 +354,14 @@ bool FileAtomPoolBuilder::TryGetIndex(__in PCWSTR pString, __out_opt Atom::Index
         return true;
     }
 
-    hash = Atom::HashString(pString, m_hashMethod);
-    for (i = 0; i < m_numAtoms; i++)
+    if (m_buckets != NULL)
     {
-        if (m_hash[i].hash == hash)
+        UINT32 mask = m_numBuckets - 1;
+        hash = Atom::HashString(pString, m_hashMethod);
+        for (UINT32 slot = hash & mask; m_buckets[slot].indexPlusOne != 0; slot = (slot + 1) & mask)
         {
-            if (m_pStrings->Equals(m_offset[m_hash[i].index], pString))
+            i = m_buckets[slot].indexPlusOne - 1;
+            if ((m_buckets[slot].hash == hash) && m_pStrings->Equals(m_offset[i], pString))
             {
                 if (pIndexOut)
                 {
@@ -372,7 +435,12 @@ FileAtomPoolBuilder::GetMaxSizeInBytes() const
     {
         return 0;
     }
-    return FileAtomPool::GetSizeInBytes(m_numAtoms, m_pStrings->GetNumCharsInPool());
+    UINT32 cbPool = FileAtomPool::GetSizeInBytes(m_numAtoms, m_pStrings->GetNumCharsInPool());
+    if (m_numAtoms == 0)
+    {
+        return cbPool;
+    }
+    return BaseFile::PadData(cbPool, BaseFile::Align32Bit) + FileAtomPool::GetHashTableSizeInBytes(m_numAtoms);
 }
 
 HRESULT FileAtomPoolBuilder::Build(__out_bcount(cbBuffer) VOID* pBuffer, UINT32 cbBuffer, __out_opt UINT32* pcbWritten) const
@@ -393,7 +461,8 @@ HRESULT FileAtomPoolBuilder::Build(__out_bcount(cbBuffer) VOID* pBuffer, UINT32
 
     RETURN_HR_IF(E_INVALIDARG, cbBuffer < cbAtomPoolSize);
 
-    header.flags = m_flags;
+    // Every non-empty pool gets a lookup table. Readers that predate the table ignore it and search the hashes.
+    header.flags = m_flags | ((m_numAtoms > 0) ? DEFFILE_ATOMPOOL_HASH_TABLE : 0);
 
     SecureZeroMemory(header.desc, DEFFILE_ATOMPOOL_DESC_LENGTH * sizeof(WCHAR));
     RETURN_IF_FAILED(DefString_CchCopy(header.desc, _countof(header.desc), m_description));
@@ -434,6 +503,24 @@ HRESULT FileAtomPoolBuilder::Build(__out_bcount(cbBuffer) VOID* pBuffer, UINT32
     err = memcpy_s(pChars, cbData, m_pStrings->GetBuffer(), cbData);
     RETURN_IF_FAILED(ErrnoToHResult(err));
 
+    if (m_numAtoms > 0)
+    {
+        _SECTION_BUILDER_PAD(&data, BaseFile::Align32Bit, &hr);
+        DEFFILE_ATOMPOOL_HASHTABLE* pTable = _SECTION_BUILDER_NEXT(data, DEFFILE_ATOMPOOL_HASHTABLE, &hr);
+        RETURN_IF_FAILED(hr);
+
+        pTable->nBuckets = FileAtomPool::GetHashTableNumBuckets(m_numAtoms);
+        FileAtomPool::HashTableEntry* pBuckets = _SECTION_BUILDER_NEXT_ARRAY(data, pTable->nBuckets, FileAtomPool::HashTableEntry, &hr);
+        RETURN_IF_FAILED(hr);
+
+        // Rebuild rather than copy the in-memory table so the file doesn't depend on how the pool grew.
+        ZeroMemory(pBuckets, pTable->nBuckets * sizeof(FileAtomPool::HashTableEntry));
+        for (Atom::Index i = 0; i < m_numAtoms; i++)
+        {
+            FileAtomPool::HashTable_Insert(pBuckets, pTable->nBuckets, m_hash[i].hash, m_hash[i].index);
+        }
+    }
+
     if (pcbWritten)
     {
         *pcbWritten = (UINT32)data.UsedBufferSizeInBytes();
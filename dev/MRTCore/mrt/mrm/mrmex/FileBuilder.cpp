@@ -20,7 +20,9 @@ FileBuilder::FileBuilder(__in DEFFILE_MAGIC magic) :
     m_pToc(NULL),
     m_pSectionData(NULL),
     m_cbSectionData(0),
-    m_nSectionDataUsed(0)
+    m_nSectionDataUsed(0),
+    m_parallelBuild(false),
+    m_streamingGeneration(false)
 {}
 
 FileBuilder::~FileBuilder()
@@ -339,6 +341,11 @@ HRESULT FileBuilder::BuildAllSections()
 {
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), m_phase != Generating);
 
+    if (m_parallelBuild && (m_nSections > 1))
+    {
+        return BuildAllSectionsInParallel();
+    }
+
     for (int i = 0; i < m_nSections; i++)
     {
         BaseFile::SectionIndex sectionIndex = m_pSections[i].m_pSectionBuilder->GetSectionIndex();
@@ -353,6 +360,259 @@ HRESULT FileBuilder::BuildAllSections()
     return S_OK;
 }
 
+namespace
+{
+
+struct ParallelSectionBuild
+{
+    FileBuilder::SectionInfo* pSectionInfo;
+    HRESULT hr;
+    UINT32 cbWritten;
+};
+
+struct ParallelBuildContext
+{
+    ParallelSectionBuild* pBuilds;
+    LONG numBuilds;
+    volatile LONG nextBuild;
+};
+
+// Each callback builds one section. Sections only read their own finalized state and write to their own
+// region of the output buffer, so they can be built in any order.
+VOID CALLBACK BuildSectionCallback(_Inout_ PTP_CALLBACK_INSTANCE, _Inout_opt_ PVOID pContext, _Inout_ PTP_WORK)
+{
+    ParallelBuildContext* pBuildContext = static_cast<ParallelBuildContext*>(pContext);
+    LONG index = InterlockedIncrement(&pBuildContext->nextBuild) - 1;
+
+    if (index < pBuildContext->numBuilds)
+    {
+        ParallelSectionBuild* pBuild = &pBuildContext->pBuilds[index];
+        FileBuilder::SectionInfo* pSectionInfo = pBuild->pSectionInfo;
+
+        pBuild->hr =
+            pSectionInfo->m_pSectionBuilder->Build(pSectionInfo->m_pSectionData, pSectionInfo->m_cbSectionData, &pBuild->cbWritten);
+    }
+}
+
+} // namespace
+
+// The layout of each section depends only on the maximum sizes of the sections before it, so every section
+// is placed first, then the sections are built concurrently, then finished in order. The output is byte for
+// byte the same as BuildAllSections produces serially.
+HRESULT FileBuilder::BuildAllSectionsInParallel()
+{
+    unique_deffree_ptr<ParallelSectionBuild> builds(_DefArray_AllocZeroed(ParallelSectionBuild, m_nSections));
+    RETURN_IF_NULL_ALLOC(builds.get());
+
+    for (int i = 0; i < m_nSections; i++)
+    {
+        BaseFile::SectionIndex sectionIndex = m_pSections[i].m_pSectionBuilder->GetSectionIndex();
+        RETURN_IF_FAILED(StartSection(sectionIndex, &builds.get()[i].pSectionInfo));
+        builds.get()[i].hr = E_PENDING;
+    }
+
+    ParallelBuildContext context = {builds.get(), m_nSections, 0};
+    PTP_WORK work = CreateThreadpoolWork(BuildSectionCallback, &context, nullptr);
+    RETURN_LAST_ERROR_IF_NULL(work);
+
+    for (int i = 0; i < m_nSections; i++)
+    {
+        SubmitThreadpoolWork(work);
+    }
+    WaitForThreadpoolWorkCallbacks(work, FALSE);
+    CloseThreadpoolWork(work);
+
+    for (int i = 0; i < m_nSections; i++)
+    {
+        RETURN_IF_FAILED(builds.get()[i].hr);
+        RETURN_IF_FAILED(FinishSection(m_pSections[i].m_pSectionBuilder->GetSectionIndex(), builds.get()[i].cbWritten));
+    }
+
+    return S_OK;
+}
+
+namespace
+{
+
+HRESULT WriteFileData(_In_ HANDLE hFile, _In_reads_bytes_(cbData) const void* pData, _In_ UINT32 cbData)
+{
+    DWORD cbWritten = 0;
+    RETURN_LAST_ERROR_IF(WriteFile(hFile, pData, cbData, &cbWritten, NULL) == 0);
+    RETURN_HR_IF(E_DEFFILE_UNABLE_TO_WRITE, cbWritten != cbData);
+    return S_OK;
+}
+
+// Copies the part of a structure placed at offset that falls inside the range of the file held in pRange.
+void CopyToFileRange(
+    _Inout_updates_bytes_(cbRange) BYTE* pRange,
+    _In_ UINT32 rangeOffset,
+    _In_ UINT32 cbRange,
+    _In_ UINT32 offset,
+    _In_reads_bytes_(cbData) const void* pData,
+    _In_ UINT32 cbData)
+{
+    const BYTE* pBytes = static_cast<const BYTE*>(pData);
+    for (UINT32 i = 0; i < cbData; i++)
+    {
+        if ((offset + i >= rangeOffset) && (offset + i < rangeOffset + cbRange))
+        {
+            pRange[offset + i - rangeOffset] = pBytes[i];
+        }
+    }
+}
+
+} // namespace
+
+// Produces exactly the bytes StartGenerating, BuildAllSections and FinishGenerating leave in the buffer
+// GenerateFileContentsInternal allocates, but holds only the header, the table of contents and one section
+// in memory at a time. Sections are written in order as they are built; the header and table of contents
+// are written last, once the final size of every section is known.
+HRESULT FileBuilder::GenerateToFile(_In_ HANDLE hFile)
+{
+    RETURN_IF_FAILED(FinalizeAllSections());
+
+    UINT32 cbMaxSize = 0;
+    RETURN_IF_FAILED(GetMaxSize(&cbMaxSize));
+
+    UINT32 cbFile = BaseFile::TruncData(cbMaxSize);
+    UINT32 cbSectionDataAvailable = cbMaxSize - BaseFile::GetStructureOverhead(m_nSections);
+    UINT32 cbPrefix = static_cast<UINT32>(sizeof(DEFFILE_HEADER) + (m_nSections * sizeof(DEFFILE_TOC_ENTRY)));
+    UINT32 cbSectionOverhead = BaseFile::GetSectionStructureOverhead();
+
+    unique_deffree_ptr<BYTE> prefix(_DefArray_AllocZeroed(BYTE, cbPrefix));
+    RETURN_IF_NULL_ALLOC(prefix.get());
+
+    DEFFILE_HEADER* pHeader = reinterpret_cast<DEFFILE_HEADER*>(prefix.get());
+    DEFFILE_TOC_ENTRY* pToc = reinterpret_cast<DEFFILE_TOC_ENTRY*>(&pHeader[1]);
+
+    pHeader->magic = m_magic;
+    pHeader->majorVersion = DEFFILE_VERSION_MAJOR;
+    pHeader->minorVersion = DEFFILE_VERSION_MINOR;
+    pHeader->descriptorIndex = m_descriptorIndex;
+    pHeader->tocOffset = BaseFile::PadSectionData(sizeof(DEFFILE_HEADER));
+    pHeader->sectionDataOffset = BaseFile::PadSectionData((pHeader->tocOffset + m_nSections * sizeof(DEFFILE_TOC_ENTRY)));
+
+    // Leave room for the header and table of contents.
+    LARGE_INTEGER sectionStart;
+    sectionStart.QuadPart = cbPrefix;
+    RETURN_IF_WIN32_BOOL_FALSE(SetFilePointerEx(hFile, sectionStart, nullptr, FILE_BEGIN));
+
+    m_phase = Generating;
+
+    unique_deffree_ptr<BYTE> sectionBuffer;
+    UINT32 cbSectionBuffer = 0;
+    UINT32 cbUsed = 0;
+
+    for (int i = 0; i < m_nSections; i++)
+    {
+        BaseFile::SectionIndex sectionIndex = m_pSections[i].m_pSectionBuilder->GetSectionIndex();
+        RETURN_HR_IF(E_INVALIDARG, sectionIndex >= m_nSections);
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (cbSectionDataAvailable - cbUsed) < cbSectionOverhead);
+
+        SectionInfo* pSection = &m_pSections[sectionIndex];
+        ISectionBuilder* pSectionBuilder = pSection->m_pSectionBuilder;
+        UINT32 sectionMaxSize = pSectionBuilder->GetMaxSizeInBytes();
+
+        // Same placement as StartSection.
+        UINT32 cbSectionData = BaseFile::PadData(sectionMaxSize);
+        UINT32 cbTotal = cbSectionData + cbSectionOverhead;
+        if (cbUsed + cbTotal > cbSectionDataAvailable)
+        {
+            cbTotal = cbSectionDataAvailable - cbUsed;
+            cbSectionData = cbTotal - cbSectionOverhead;
+        }
+
+        // The buffer only ever grows, so it ends up the size of the largest section.
+        if (cbTotal > cbSectionBuffer)
+        {
+            sectionBuffer.reset(_DefArray_Alloc(BYTE, cbTotal));
+            RETURN_IF_NULL_ALLOC(sectionBuffer.get());
+            cbSectionBuffer = cbTotal;
+        }
+        ZeroMemory(sectionBuffer.get(), cbTotal);
+
+        DEFFILE_SECTION_HEADER* pSectionHeader = reinterpret_cast<DEFFILE_SECTION_HEADER*>(sectionBuffer.get());
+        BYTE* pSectionData = reinterpret_cast<BYTE*>(&pSectionHeader[1]);
+        DEFFILE_SECTION_TRAILER* pSectionTrailer = reinterpret_cast<DEFFILE_SECTION_TRAILER*>(&pSectionData[cbSectionData]);
+
+        pSectionHeader->type = pSectionBuilder->GetSectionType();
+        pSectionHeader->cbSectionTotal = cbTotal;
+        pSectionTrailer->marker = DEFFILE_SECTION_END_MARKER;
+        pSectionTrailer->cbSectionTotal = cbTotal;
+
+        UINT32 cbGenerated = 0;
+        RETURN_IF_FAILED(pSectionBuilder->Build(pSectionData, cbSectionData, &cbGenerated));
+
+        // Same checks and trailer relocation as FinishSection.
+        RETURN_HR_IF(E_DEFFILE_BUILD_SECTION_DATA_TOO_LARGE, cbGenerated > sectionMaxSize);
+        RETURN_HR_IF(
+            E_DEFFILE_BUILD_SECTION_TRAILER_DAMAGED,
+            (pSectionTrailer->marker != DEFFILE_SECTION_END_MARKER) ||
+                (pSectionTrailer->cbSectionTotal != (UINT32)BaseFile::PadSectionData(sectionMaxSize + cbSectionOverhead)));
+
+        UINT32 cbGeneratedData = BaseFile::PadSectionData(cbGenerated);
+        if (cbGeneratedData != (UINT32)BaseFile::PadSectionData(sectionMaxSize))
+        {
+            pSectionHeader->cbSectionTotal = cbGeneratedData + cbSectionOverhead;
+            pSectionTrailer = BaseFile::GetSectionTrailer(pSectionHeader);
+            pSectionTrailer->marker = DEFFILE_SECTION_END_MARKER;
+            pSectionTrailer->cbSectionTotal = pSectionHeader->cbSectionTotal;
+        }
+
+        pSectionHeader->qualifier = pSectionBuilder->GetSectionQualifier();
+        pSectionHeader->flags = pSectionBuilder->GetFlags();
+        pSectionHeader->sectionFlags = pSectionBuilder->GetSectionFlags();
+
+        DEFFILE_TOC_ENTRY* pTocEntry = &pToc[sectionIndex];
+        pTocEntry->type = pSectionHeader->type;
+        pTocEntry->flags = pSectionHeader->flags;
+        pTocEntry->sectionFlags = pSectionHeader->sectionFlags;
+        pTocEntry->qualifier = pSectionHeader->qualifier;
+        pTocEntry->offset = cbUsed;
+        pTocEntry->cbSectionTotal = pSectionHeader->cbSectionTotal;
+
+        // Like the buffered layout, the section keeps all of the space it was given.
+        RETURN_IF_FAILED(WriteFileData(hFile, sectionBuffer.get(), cbTotal));
+        pSection->m_maxDataSize = sectionMaxSize;
+        cbUsed += cbTotal;
+    }
+
+    pHeader->sizeToc = (UINT16)m_nSections;
+    pHeader->cbTotal = BaseFile::GetStructureOverhead(m_nSections) + BaseFile::PadSectionData(cbUsed);
+
+    // Whatever follows the last section holds the file trailer. StartGenerating writes a provisional trailer
+    // at the end of the buffer and FinishGenerating the real one, usually in the same place.
+    UINT32 tailOffset = cbPrefix + cbUsed;
+    RETURN_HR_IF(E_DEFFILE_BUILD_SECTION_DATA_TOO_LARGE, tailOffset > cbFile);
+
+    UINT32 cbTail = cbFile - tailOffset;
+    if (cbTail > 0)
+    {
+        unique_deffree_ptr<BYTE> tail(_DefArray_AllocZeroed(BYTE, cbTail));
+        RETURN_IF_NULL_ALLOC(tail.get());
+
+        DEFFILE_TRAILER trailer = {};
+        trailer.marker = DEFFILE_FILE_END_MARKER;
+        trailer.magic = m_magic;
+        trailer.cbTotal = cbFile;
+        UINT32 trailerOffset = static_cast<UINT32>(BaseFile::PadSectionData(cbFile) - sizeof(DEFFILE_TRAILER));
+        CopyToFileRange(tail.get(), tailOffset, cbTail, trailerOffset, &trailer, sizeof(trailer));
+
+        trailer.cbTotal = pHeader->cbTotal;
+        trailerOffset = static_cast<UINT32>(BaseFile::PadSectionData(pHeader->cbTotal) - sizeof(DEFFILE_TRAILER));
+        CopyToFileRange(tail.get(), tailOffset, cbTail, trailerOffset, &trailer, sizeof(trailer));
+
+        RETURN_IF_FAILED(WriteFileData(hFile, tail.get(), cbTail));
+    }
+
+    LARGE_INTEGER fileStart = {};
+    RETURN_IF_WIN32_BOOL_FALSE(SetFilePointerEx(hFile, fileStart, nullptr, FILE_BEGIN));
+    RETURN_IF_FAILED(WriteFileData(hFile, prefix.get(), cbPrefix));
+
+    m_phase = Done;
+    return S_OK;
+}
+
 HRESULT FileBuilder::GenerateFileContentsInternal()
 {
     UINT32 cbBuffer = 0;
@@ -435,12 +695,16 @@ HRESULT FileBuilder::WriteToFile(__in PCWSTR pFileName)
 
     // if the identity is enabled, we need to add identity section here
 
-    if (!m_pData)
+    bool streaming = (m_streamingGeneration && (m_pData == nullptr));
+    if (!streaming)
     {
-        RETURN_IF_FAILED(GenerateFileContentsInternal());
-    }
+        if (!m_pData)
+        {
+            RETURN_IF_FAILED(GenerateFileContentsInternal());
+        }
 
-    RETURN_HR_IF(E_DEFFILE_FILE_DATA_EMPTY, !m_pData || !m_cbData);
+        RETURN_HR_IF(E_DEFFILE_FILE_DATA_EMPTY, !m_pData || !m_cbData);
+    }
 
     // TODO - consider a wrapper around file create/write operations, so we can safely be called
     // from any layer in the system.
@@ -452,9 +716,14 @@ HRESULT FileBuilder::WriteToFile(__in PCWSTR pFileName)
         DeleteFile(pFileName);
     });
 
-    DWORD cbWritten = 0;
-    RETURN_LAST_ERROR_IF(WriteFile(hfile.get(), m_pData, m_cbData, &cbWritten, NULL) == 0);
-    RETURN_HR_IF(E_DEFFILE_UNABLE_TO_WRITE, cbWritten != m_cbData);
+    if (streaming)
+    {
+        RETURN_IF_FAILED(GenerateToFile(hfile.get()));
+    }
+    else
+    {
+        RETURN_IF_FAILED(WriteFileData(hfile.get(), m_pData, m_cbData));
+    }
     RETURN_LAST_ERROR_IF(FlushFileBuffers(hfile.get()) == 0);
 
     cleanupOnFailure.release();
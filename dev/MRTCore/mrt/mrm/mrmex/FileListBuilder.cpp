@@ -1252,6 +1252,11 @@ HRESULT FileListBuilder::Finalize()
     }
     m_numFinalizedFolders = sizeFolders;
     m_numFinalizedFiles = sizeFiles;
+
+    // Create the finalized file list now rather than on first use, so that Build doesn't modify the
+    // builder and sections can be built concurrently.
+    IFileList* pFileList;
+    RETURN_IF_FAILED(GetFileList(&pFileList));
     return S_OK;
 }
 
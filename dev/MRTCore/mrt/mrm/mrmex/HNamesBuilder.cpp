@@ -138,9 +138,44 @@ HRESULT ItemInfo::AddToGlobal(_In_ ScopeInfo* parent)
 
 // ScopeInfo - Describes a single scope of interest and its contents
 
+namespace
+{
+
+// Scopes with fewer children than this are searched linearly.
+const UINT ChildIndexMinChildren = 8;
+const UINT32 ChildIndexMinSlots = 32;
+
+// Folds with the table DefString_ICompare uses, so names that ChildNameMatches treats as equal hash equal.
+UINT32 HashChildName(_In_ PCWSTR pName) { return DefString_ComputeFoldedHash(pName, nullptr); }
+
+bool ChildNameMatches(_In_ const HNamesNode* pNode, _In_ PCWSTR pName, _In_ WCHAR initialChar)
+{
+    return (pNode->GetInitialChar() == initialChar) && (DefString_ICompare(pName, pNode->GetName()) == Def_Equal);
+}
+
+// Children are ordered by initial char, then by case-insensitive name; this is the order in which
+// the reader expects to find them.
+int __cdecl CompareChildNodes(_In_ const void* pElem1, _In_ const void* pElem2)
+{
+    const HNamesNode* pNode1 = *reinterpret_cast<HNamesNode* const*>(pElem1);
+    const HNamesNode* pNode2 = *reinterpret_cast<HNamesNode* const*>(pElem2);
+
+    if (pNode1->GetInitialChar() != pNode2->GetInitialChar())
+    {
+        return (pNode1->GetInitialChar() > pNode2->GetInitialChar()) ? 1 : -1;
+    }
+
+    return static_cast<int>(DefString_ICompare(pNode1->GetName(), pNode2->GetName()));
+}
+
+} // namespace
+
 ScopeInfo::ScopeInfo(_In_ ScopeInfo* pParent) :
     HNamesNode(pParent),
     m_pChildren(nullptr),
+    m_pChildSlots(nullptr),
+    m_numChildSlots(0),
+    m_bChildrenSorted(true),
     m_numChildScopes(0),
     m_numChildItems(0),
     m_totalNumItems(0),
@@ -153,6 +188,9 @@ ScopeInfo::ScopeInfo(_In_ ScopeInfo* pParent) :
 ScopeInfo::ScopeInfo(__in IHNamesGlobalNodes* pGlobalNodes) :
     HNamesNode(pGlobalNodes->GetConfig()),
     m_pChildren(nullptr),
+    m_pChildSlots(nullptr),
+    m_numChildSlots(0),
+    m_bChildrenSorted(true),
     m_numChildScopes(0),
     m_numChildItems(0),
     m_totalNumItems(0),
@@ -180,6 +218,7 @@ HRESULT ScopeInfo::Init(_In_ const HierarchicalNameSegment* name)
 ScopeInfo::~ScopeInfo()
 {
     delete m_pChildren;
+    Def_Free(m_pChildSlots);
     // GlobalNodes owns the scopes and items and is responsible for deleting them
 }
 
@@ -226,6 +265,8 @@ HNamesNode* ScopeInfo::GetChild(UINT i) const
 {
     if (i < m_pChildren->Count())
     {
+        SortChildren();
+
         HNamesNode* node;
         if (SUCCEEDED(m_pChildren->Get(i, &node)))
         {
@@ -250,6 +291,7 @@ bool ScopeInfo::TryGetChild(_In_ int index, _Outptr_opt_result_maybenull_ HNames
         return false;
     }
 
+    SortChildren();
     return (SUCCEEDED(m_pChildren->Get(static_cast<UINT>(index), ppChildOut)));
 }
 
@@ -260,33 +302,23 @@ bool ScopeInfo::TryGetChild(_In_ const HierarchicalNameSegment* pName, _Outptr_o
         *ppChildOut = nullptr;
     }
 
-    int startSearch = -1;
-    int endSearch = -1;
-    int insert = -1;
-
-    if (FAILED(FindSearchRange(pName->GetName(), &startSearch, &endSearch, &insert)))
+    PCWSTR pNodeName = pName->GetName();
+    if (DefString_IsEmpty(pNodeName))
     {
         return false;
     }
 
-    if (insert != -1)
+    HNamesNode* pChild = FindChild(pNodeName, HashChildName(pNodeName));
+    if (pChild == nullptr)
     {
         return false;
     }
 
-    int diff = 0;
-    PCWSTR nodeName = pName->GetName();
-    UINT insertPoint = FindInsertionPoint(nodeName, startSearch, endSearch, &diff);
-
-    if (diff == 0)
+    if (ppChildOut != nullptr)
     {
-        if (SUCCEEDED(m_pChildren->Get(insertPoint, ppChildOut)))
-        {
-            return true;
-        }
+        *ppChildOut = pChild;
     }
-
-    return false;
+    return true;
 }
 
 bool ScopeInfo::TryGetDescendent(_In_ PCWSTR pFullName, _Outptr_opt_result_maybenull_ HNamesNode** ppChildOut) const
@@ -458,217 +490,132 @@ HRESULT ScopeInfo::GetOrAddChildItem(_In_ const HierarchicalNameSegment* pName,
     return S_OK;
 }
 
-// Find the range where the initial char matches.
-// startSearch, endSearch: start and end locations of the matching range. -1 if no match
-// insert: -1 if range found, otherwise the location to insert the new node.
-HRESULT ScopeInfo::FindSearchRange(_In_ PCWSTR nodeName, _Out_ int* startSearch, _Out_ int* endSearch, _Out_ int* insert) const
+HNamesNode* ScopeInfo::FindChild(_In_ PCWSTR pName, _In_ UINT32 hash) const
 {
-    *startSearch = -1;
-    *endSearch = -1;
-    *insert = -1;
-    WCHAR newInitial = GetConfig()->GetSegmentInitialChar(nodeName);
+    WCHAR initialChar = GetConfig()->GetSegmentInitialChar(pName);
 
-    int size = static_cast<int>(m_pChildren->Count());
-    if (size == 0)
+    if (m_pChildSlots == nullptr)
     {
-        *insert = 0;
-        return S_OK;
-    }
-
-    int low = 0;
-    int high = size - 1;
-    int mid;
-    // find the start location
-    while (low <= high)
-    {
-        mid = low + (high - low) / 2;
-        HNamesNode* currentNode;
-        RETURN_IF_FAILED(m_pChildren->Get(static_cast<UINT>(mid), &currentNode));
-        WCHAR nodeInitial = currentNode->GetInitialChar();
-        if (nodeInitial == newInitial)
-        {
-            *startSearch = mid;
-            high = mid - 1;
-        }
-        else if (nodeInitial > newInitial)
-        {
-            high = mid - 1;
-        }
-        else
+        // Small scopes don't have an index; a scan is cheaper than maintaining one.
+        for (UINT i = 0; i < m_pChildren->Count(); i++)
         {
-            low = mid + 1;
+            HNamesNode* pChild = m_pChildren->GetAll()[i];
+            if (ChildNameMatches(pChild, pName, initialChar))
+            {
+                return pChild;
+            }
         }
+        return nullptr;
     }
 
-    if (*startSearch == -1)
+    UINT32 mask = m_numChildSlots - 1;
+    for (UINT32 slot = hash & mask; m_pChildSlots[slot].pNode != nullptr; slot = (slot + 1) & mask)
     {
-        // no match
-        *insert = low;
-        return S_OK;
+        if ((m_pChildSlots[slot].hash == hash) && ChildNameMatches(m_pChildSlots[slot].pNode, pName, initialChar))
+        {
+            return m_pChildSlots[slot].pNode;
+        }
     }
+    return nullptr;
+}
 
-    low = 0;
-    high = size - 1;
+HRESULT ScopeInfo::RebuildChildIndex(_In_ UINT32 numSlots)
+{
+    ChildSlot* pSlots = _DefArray_AllocZeroed(ChildSlot, numSlots);
+    RETURN_IF_NULL_ALLOC(pSlots);
 
-    // find the end location
-    while (low <= high)
+    UINT32 mask = numSlots - 1;
+    for (UINT i = 0; i < m_pChildren->Count(); i++)
     {
-        mid = low + (high - low) / 2;
-        HNamesNode* currentNode;
-        RETURN_IF_FAILED(m_pChildren->Get(static_cast<UINT>(mid), &currentNode));
-        WCHAR nodeInitial = currentNode->GetInitialChar();
-        if (nodeInitial == newInitial)
-        {
-            *endSearch = mid;
-            low = mid + 1;
-        }
-        else if (nodeInitial > newInitial)
+        HNamesNode* pChild = m_pChildren->GetAll()[i];
+        UINT32 hash = HashChildName(pChild->GetName());
+        UINT32 slot = hash & mask;
+        while (pSlots[slot].pNode != nullptr)
         {
-            high = mid - 1;
-        }
-        else
-        {
-            low = mid + 1;
+            slot = (slot + 1) & mask;
         }
+        pSlots[slot].hash = hash;
+        pSlots[slot].pNode = pChild;
     }
 
+    Def_Free(m_pChildSlots);
+    m_pChildSlots = pSlots;
+    m_numChildSlots = numSlots;
     return S_OK;
 }
 
-UINT ScopeInfo::FindInsertionPoint(_In_ PCWSTR pName, _In_ UINT first, _In_ UINT last, _Out_ int* pDiffOut) const
+HRESULT ScopeInfo::AddChild(_In_ HNamesNode* pNode, _In_ UINT32 hash)
 {
-    UINT mid = (first + last) / 2;
+    UINT numChildren = m_pChildren->Count();
 
-    DEFCOMPARISON firstDiff = Def_CompareError;
-    DEFCOMPARISON midDiff = Def_CompareError;
-    DEFCOMPARISON lastDiff = Def_CompareError;
-    HNamesNode* pFirst = nullptr;
-    HNamesNode* pMid = nullptr;
-    HNamesNode* pLast = nullptr;
-
-    int nNodes = (last - first + 1);
-
-    while (true)
+    // Names usually arrive in no particular order, but a new child that sorts after the current
+    // last child keeps the list sorted.
+    if (m_bChildrenSorted && (numChildren > 0) && (CompareChildNodes(&m_pChildren->GetAll()[numChildren - 1], &pNode) > 0))
     {
-        // index should always be in range. Don't check the error
-        m_pChildren->Get(first, &pFirst);
-        m_pChildren->Get(last, &pLast);
+        m_bChildrenSorted = false;
+    }
 
-        if (firstDiff == Def_CompareError)
-        {
-            firstDiff = DefString_ICompare(pName, pFirst->GetName());
-        }
+    RETURN_IF_FAILED(m_pChildren->Add(pNode));
+    numChildren++;
 
-        if ((firstDiff == Def_Less) || (firstDiff == Def_Equal))
-        {
-            // less than or equal to the first
-            *pDiffOut = firstDiff;
-            return first;
-        }
+    if ((m_pChildSlots == nullptr) && (numChildren < ChildIndexMinChildren))
+    {
+        return S_OK;
+    }
 
-        if (lastDiff == Def_CompareError)
+    // Keep the index at most half full so probe sequences stay short.
+    if ((m_pChildSlots == nullptr) || ((numChildren * 2) > m_numChildSlots))
+    {
+        UINT32 numSlots = ((m_numChildSlots > 0) ? m_numChildSlots : ChildIndexMinSlots);
+        while ((numChildren * 2) > numSlots)
         {
-            lastDiff = DefString_ICompare(pName, pLast->GetName());
+            numSlots *= 2;
         }
 
-        if ((lastDiff == Def_Greater) || (lastDiff == Def_Equal))
+        HRESULT hr = RebuildChildIndex(numSlots);
+        if (FAILED(hr))
         {
-            // greater than or equal to the last
-            *pDiffOut = lastDiff;
-            return last;
+            // Leave the scope as it was so a failed add doesn't leave an unindexed child behind.
+            (void)m_pChildren->Delete(numChildren - 1);
+            return hr;
         }
+        return S_OK;
+    }
 
-        // somewhere in the middle.
-        if (nNodes > 3)
-        {
-            // if we still have a bunch of nodes, continue to divide and conquer
-            m_pChildren->Get(mid, &pMid);
-            midDiff = DefString_ICompare(pName, pMid->GetName());
-            if (midDiff == Def_Equal)
-            {
-                *pDiffOut = midDiff;
-                return mid;
-            }
-            else if (midDiff == Def_Less)
-            {
-                last = mid;
-                mid = (first + last) / 2;
-                nNodes = (last - first + 1);
-
-                lastDiff = midDiff;
-                midDiff = Def_CompareError;
-            }
-            else if (midDiff == Def_Greater)
-            {
-                first = mid;
-                mid = (first + last) / 2;
-                nNodes = (last - first + 1);
-
-                firstDiff = midDiff;
-                midDiff = Def_CompareError;
-            }
-        }
-        else
-        {
-            // Down to (approximately) three. Go linear.
-            while (pFirst != nullptr)
-            {
-                if (firstDiff == Def_CompareError)
-                {
-                    firstDiff = DefString_ICompare(pName, pFirst->GetName());
-                }
-
-                if ((firstDiff == Def_Greater) && (pFirst != pLast))
-                {
-                    // keep looking
-                    first++;
-                    m_pChildren->Get(first, &pFirst);
-                    firstDiff = Def_CompareError;
-                }
-                else
-                {
-                    // Hit one of:
-                    // 1) A match
-                    // 2) The next largest entry
-                    // 3) The end of our range
-                    *pDiffOut = firstDiff;
-                    return first;
-                }
-            }
-        }
+    UINT32 mask = m_numChildSlots - 1;
+    UINT32 slot = hash & mask;
+    while (m_pChildSlots[slot].pNode != nullptr)
+    {
+        slot = (slot + 1) & mask;
     }
+    m_pChildSlots[slot].hash = hash;
+    m_pChildSlots[slot].pNode = pNode;
+    return S_OK;
+}
 
-    // should never get here
-    return -1;
+void ScopeInfo::SortChildren() const
+{
+    if (!m_bChildrenSorted)
+    {
+        qsort(m_pChildren->GetAll(), m_pChildren->Count(), sizeof(HNamesNode*), CompareChildNodes);
+        m_bChildrenSorted = true;
+    }
 }
 
 HRESULT ScopeInfo::GetOrAddChildNode(_In_ HNamesNode* newNode, _Out_ HNamesNode** foundNode)
 {
     *foundNode = nullptr;
 
-    int startSearch = -1;
-    int endSearch = -1;
-    int insert = -1;
     PCWSTR nodeName = newNode->GetName();
+    UINT32 hash = HashChildName(nodeName);
 
-    RETURN_IF_FAILED(FindSearchRange(nodeName, &startSearch, &endSearch, &insert));
-    if (insert != -1)
+    *foundNode = FindChild(nodeName, hash);
+    if (*foundNode != nullptr)
     {
-        RETURN_IF_FAILED(m_pChildren->Insert(newNode, (UINT)insert));
         return S_OK;
     }
 
-    int diff = 0;
-    UINT insertPoint = FindInsertionPoint(nodeName, startSearch, endSearch, &diff);
-
-    if (diff == 0)
-    {
-        RETURN_IF_FAILED(m_pChildren->Get(insertPoint, foundNode));
-        return S_OK;
-    }
-
-    // Not found. Insert at insertPoint if diff < 0, or insert after insertPoint if diff > 0.
-    RETURN_IF_FAILED(m_pChildren->Insert(newNode, diff > 0 ? insertPoint + 1 : insertPoint));
+    RETURN_IF_FAILED(AddChild(newNode, hash));
     return S_OK;
 }
 
@@ -1224,6 +1171,13 @@ bool HierarchicalNamesBuilder::AssignChildNameIndices(__in ScopeInfo* pScope, __
 
 HRESULT HierarchicalNamesBuilder::Finalize()
 {
+    // Children are kept in insertion order while names are added; put every scope in generated order
+    // in a single pass before any indices are assigned.
+    for (UINT i = 0; i < m_pAllScopes->Count(); i++)
+    {
+        m_pAllScopes->GetAll()[i]->SortChildren();
+    }
+
     m_pRootScope->SetNameIndex(0);
 
     int nextIndex = 1;
@@ -673,6 +673,10 @@ HRESULT HierarchicalSchemaSectionBuilder::Finalize()
         }
     }
 
+    // Create the version info now rather than on first use, so that Build doesn't modify the builder
+    // and sections can be built concurrently.
+    RETURN_IF_FAILED(HierarchicalSchemaVersionInfoBuilder::CreateInstance(this, m_majorVersion, m_minorVersion, &m_pVersionInfo));
+
     m_finalized = true;
     return S_OK;
 }
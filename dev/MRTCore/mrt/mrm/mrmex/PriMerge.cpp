@@ -139,6 +139,10 @@ HRESULT PriFileMerger::SetPriFileFlags(_In_ UINT32 nFlags)
 HRESULT PriFileMerger::WriteToFile(_In_ PCWSTR pFilePath)
 {
     m_priBuilderPhase = PriBuilderPhase::PriFinalizedAll;
+
+    // Merged files are written once and never read back from the builder, so there's no need to hold
+    // the whole file in memory.
+    m_pPriFileBuilder->SetStreamingGeneration(true);
     RETURN_IF_FAILED(m_pPriFileBuilder->WriteToFile(pFilePath));
 
     // Set GENERIC_READ for ALL APPLICATION PACKAGES for the output merged files
@@ -459,6 +463,19 @@ HRESULT PriMapMerger::MergeMap(
     pDecisionInfo = pResMap->GetDecisionInfo();
     RETURN_IF_FAILED(pMergedDecisions->Merge(pDecisionInfo, &qualifierMap, &qualifierSetMap, &decisionMap));
 
+    // Every candidate in this map may become a new data item, so size the deduplication map for all of them
+    // up front instead of letting it rehash repeatedly while large maps are merged.
+    DataItemOrchestrator* dataItems = pMergedPriSectionBuilder->GetDataItemOrchestrator();
+    if (dataItems->UseDeduplication())
+    {
+        RETURN_IF_FAILED(dataItems->ReserveDeduplicationCapacity(
+            dataItems->GetNumDeduplicatedItems() + static_cast<UINT32>(pResMap->GetTotalNumResourceValues())));
+    }
+
+    // When strings are stored as optimized data items, the map's strings are queued and encoded as one batch.
+    MrmBuildConfiguration* pConfiguration = pMergedPriSectionBuilder->GetBuildConfiguration();
+    bool queueStrings = pConfiguration->UseDataItemLocator() && pConfiguration->UseOptimalPayloadEncoding();
+
     for (int nResItr = 0; nResItr < pResMap->GetNumResources(); nResItr++)
     {
         RETURN_IF_FAILED(pResMap->GetResourceByIndex(nResItr, &namedResource));
@@ -480,7 +497,9 @@ HRESULT PriMapMerger::MergeMap(
                         size_t cbBlobSize;
                         const BYTE* blob = static_cast<const BYTE*>(brCandidateValue.GetRef(&cbBlobSize));
 
-                        DataItemOrchestrator* dataItems = pMergedPriSectionBuilder->GetDataItemOrchestrator();
+                        // Keep candidates and data items in the order they appear in the map.
+                        RETURN_IF_FAILED(pMergedPriSectionBuilder->FlushQueuedStrings());
+
                         IBuildInstanceReference* pBuildInstanceReference;
                         RETURN_IF_FAILED(dataItems->AddDataAndCreateInstanceReference(
                             blob, static_cast<UINT>(cbBlobSize), static_cast<int>(nRemappedQualifierSetIndex), &pBuildInstanceReference));
@@ -521,6 +540,19 @@ HRESULT PriMapMerger::MergeMap(
                             valueType = MrmEnvironment::ResourceValueType_Utf16String;
                         }
 
+                        if (queueStrings)
+                        {
+                            // Duplicates are dropped when the queue is flushed.
+                            RETURN_IF_FAILED(pMergedPriSectionBuilder->QueueCandidateWithString(
+                                pMergedMapBuilder,
+                                strResourceName.GetRef(),
+                                valueType,
+                                strNewCandidateValue.GetRef(),
+                                static_cast<int>(nRemappedQualifierSetIndex),
+                                true));
+                            continue;
+                        }
+
                         HRESULT hr = pMergedMapBuilder->AddCandidateWithInternalString(
                             strResourceName.GetRef(),
                             valueType,
@@ -538,7 +570,7 @@ HRESULT PriMapMerger::MergeMap(
         }
     }
 
-    return S_OK;
+    return pMergedPriSectionBuilder->FlushQueuedStrings();
 }
 
 // Method to check whether the two given schemas are compatible.
@@ -626,6 +658,296 @@ HRESULT PriFileMerger::ReleasePriBuilder(_Out_ PriFileBuilder** ppPriBuilder)
     return S_OK;
 }
 
+//
+// PriMergeManifest Implementation
+//
+const UINT32 PriMergeManifest::ManifestMagic = 0x4d524d50; // "PMRM"
+const UINT16 PriMergeManifest::ManifestVersion = 3;
+
+HRESULT PriMergeManifest::CreateInstance(_In_ CoreProfile* pProfile, _Outptr_ PriMergeManifest** result)
+{
+    *result = nullptr;
+    RETURN_HR_IF(E_INVALIDARG, pProfile == nullptr);
+
+    AutoDeletePtr<PriMergeManifest> pManifest = new PriMergeManifest(pProfile);
+    RETURN_IF_NULL_ALLOC(pManifest);
+
+    RETURN_IF_FAILED(pManifest->Init());
+
+    *result = pManifest.Detach();
+
+    return S_OK;
+}
+
+PriMergeManifest::PriMergeManifest(_In_ CoreProfile* pProfile) : m_pProfile(pProfile), m_pInputs(nullptr) {}
+
+HRESULT PriMergeManifest::Init()
+{
+    RETURN_IF_FAILED(DynamicArray<Input*>::CreateInstance(5, &m_pInputs));
+    return S_OK;
+}
+
+PriMergeManifest::~PriMergeManifest()
+{
+    if (m_pInputs != nullptr)
+    {
+        for (int i = 0; i < m_pInputs->Count(); i++)
+        {
+            Input* pInput;
+            if (m_pInputs->TryGet(i, &pInput))
+            {
+                delete pInput->pStrFilePath;
+                Def_Free(pInput);
+            }
+        }
+        delete m_pInputs;
+    }
+}
+
+HRESULT PriMergeManifest::AddInput(_In_ PCWSTR pPriFilePath, _In_ PriFileMerger::PriMergeFlags mergeFlags)
+{
+    RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pPriFilePath));
+
+    for (int i = 0; i < m_pInputs->Count(); i++)
+    {
+        Input* pExisting;
+        RETURN_IF_FAILED(m_pInputs->Get(i, &pExisting));
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY), DefString_IEqual(pExisting->pStrFilePath->GetRef(), pPriFilePath));
+    }
+
+    DEF_CHECKSUM checksum;
+    RETURN_IF_FAILED(ComputeFileChecksum(pPriFilePath, &checksum));
+
+    AutoDeletePtr<StringResult> pStrFilePath = new StringResult();
+    RETURN_IF_NULL_ALLOC(pStrFilePath);
+    RETURN_IF_FAILED(pStrFilePath->SetCopy(pPriFilePath));
+
+    Input* pInput = _DefArray_AllocZeroed(Input, 1);
+    RETURN_IF_NULL_ALLOC(pInput);
+
+    pInput->pStrFilePath = pStrFilePath;
+    pInput->checksum = checksum;
+    pInput->mergeFlags = mergeFlags;
+
+    HRESULT hr = m_pInputs->Add(pInput);
+    if (FAILED(hr))
+    {
+        Def_Free(pInput);
+        return hr;
+    }
+
+    pStrFilePath.Detach();
+    return S_OK;
+}
+
+int PriMergeManifest::GetNumInputs() const { return m_pInputs->Count(); }
+
+HRESULT PriMergeManifest::ComputeFileChecksum(_In_ PCWSTR pFilePath, _Out_ DEF_CHECKSUM* pChecksum)
+{
+    *pChecksum = 0;
+
+    // Name, size and last write time alone miss a file that was rewritten in place and had its timestamp
+    // preserved, so the contents are checksummed as well. That reads every input once, which is still far
+    // cheaper than merging them.
+    DEF_CHECKSUM checksum = 0;
+    RETURN_IF_FAILED(PriFileMerger::PriFileInfo::ComputeChecksum(pFilePath, &checksum));
+
+    wil::unique_hfile hFile(
+        CreateFile(pFilePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+    RETURN_LAST_ERROR_IF(!hFile);
+
+    static const DWORD cbChunk = 64 * 1024;
+    unique_deffree_ptr<BYTE> pChunk(_DefArray_AllocZeroed(BYTE, cbChunk));
+    RETURN_IF_NULL_ALLOC(pChunk.get());
+
+    DWORD cbRead;
+    do
+    {
+        RETURN_IF_WIN32_BOOL_FALSE(ReadFile(hFile.get(), pChunk.get(), cbChunk, &cbRead, nullptr));
+        checksum = DefChecksum::ComputeChecksum(checksum, pChunk.get(), cbRead);
+    } while (cbRead == cbChunk);
+
+    *pChecksum = checksum;
+    return S_OK;
+}
+
+HRESULT PriMergeManifest::ComputeProfileChecksum(_Out_ DEF_CHECKSUM* pChecksum) const
+{
+    *pChecksum = 0;
+
+    // Covers everything the profile feeds into the merged file besides the inputs themselves: the build
+    // configuration decides the file format and encodings, and the platform and environments decide the
+    // qualifiers and environment the merged maps are built against.
+    DefChecksum checksum;
+    DEF_CHECKSUM ignored;
+
+    const MrmBuildConfiguration* pConfig = m_pProfile->GetBuildConfiguration();
+    RETURN_IF_NULL_ALLOC(pConfig);
+    DEFFILE_MAGIC magic = pConfig->GetFileMagicNumber();
+    checksum.ComputeChecksum(reinterpret_cast<const BYTE*>(&magic), sizeof(magic));
+    checksum.ComputeUInt32Checksum(pConfig->GetFlags());
+
+    StringResult strPlatformName;
+    StringResult strPlatformVersion;
+    RETURN_IF_FAILED(m_pProfile->GetTargetPlatformAndVersion(&strPlatformName, &strPlatformVersion));
+    RETURN_IF_FAILED(checksum.ComputeStringChecksum(true, strPlatformName.GetRef(), &ignored));
+    RETURN_IF_FAILED(checksum.ComputeStringChecksum(true, strPlatformVersion.GetRef(), &ignored));
+
+    int numEnvironments = m_pProfile->GetNumEnvironments();
+    checksum.ComputeUInt32Checksum(static_cast<UINT32>(numEnvironments));
+    for (int i = 0; i < numEnvironments; i++)
+    {
+        StringResult strEnvironmentName;
+        AutoDeletePtr<IEnvironmentVersionInfo> pVersionInfo;
+        RETURN_IF_FAILED(m_pProfile->GetEnvironmentVersionInfo(i, &strEnvironmentName, &pVersionInfo));
+        RETURN_IF_FAILED(checksum.ComputeStringChecksum(true, strEnvironmentName.GetRef(), &ignored));
+        checksum.ComputeUInt32Checksum(pVersionInfo->GetVersionChecksum());
+    }
+
+    *pChecksum = checksum.GetChecksum();
+    return S_OK;
+}
+
+HRESULT PriMergeManifest::GetInput(_In_ int index, _Out_ PCWSTR* ppPriFilePath, _Out_ PriFileMerger::PriMergeFlags* pMergeFlags) const
+{
+    *ppPriFilePath = nullptr;
+    *pMergeFlags = static_cast<PriFileMerger::PriMergeFlags>(0);
+
+    Input* pInput;
+    RETURN_IF_FAILED(m_pInputs->Get(index, &pInput));
+
+    *ppPriFilePath = pInput->pStrFilePath->GetRef();
+    *pMergeFlags = pInput->mergeFlags;
+    return S_OK;
+}
+
+HRESULT PriMergeManifest::GetManifestPath(_In_ PCWSTR pOutputFilePath, _Inout_ StringResult* pStrManifestPath)
+{
+    RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pOutputFilePath) || (pStrManifestPath == nullptr));
+
+    RETURN_IF_FAILED(pStrManifestPath->SetCopy(pOutputFilePath));
+    RETURN_IF_FAILED(pStrManifestPath->Concat(L".mergeinfo"));
+    return S_OK;
+}
+
+HRESULT PriMergeManifest::IsOutputCurrent(_In_ PCWSTR pOutputFilePath, _Out_ bool* pbIsCurrent) const
+{
+    *pbIsCurrent = false;
+    RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pOutputFilePath));
+
+    // A missing or unreadable output or manifest just means the merge has to run; it isn't an error.
+    DEF_CHECKSUM outputChecksum = 0;
+    if (FAILED(ComputeFileChecksum(pOutputFilePath, &outputChecksum)))
+    {
+        return S_OK;
+    }
+
+    StringResult strManifestPath;
+    RETURN_IF_FAILED(GetManifestPath(pOutputFilePath, &strManifestPath));
+
+    wil::unique_hfile hManifest(
+        CreateFile(strManifestPath.GetRef(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+    if (!hManifest)
+    {
+        return S_OK;
+    }
+
+    LARGE_INTEGER cbManifest;
+    RETURN_IF_WIN32_BOOL_FALSE(GetFileSizeEx(hManifest.get(), &cbManifest));
+
+    UINT32 numInputs = static_cast<UINT32>(m_pInputs->Count());
+    UINT64 cbExpected = sizeof(MANIFEST_HEADER) + (static_cast<UINT64>(numInputs) * sizeof(MANIFEST_INPUT));
+    if (static_cast<UINT64>(cbManifest.QuadPart) != cbExpected)
+    {
+        return S_OK;
+    }
+
+    DEF_CHECKSUM profileChecksum;
+    RETURN_IF_FAILED(ComputeProfileChecksum(&profileChecksum));
+
+    MANIFEST_HEADER header;
+    DWORD cbRead = 0;
+    RETURN_IF_WIN32_BOOL_FALSE(ReadFile(hManifest.get(), &header, sizeof(header), &cbRead, nullptr));
+    if ((cbRead != sizeof(header)) || (header.magic != ManifestMagic) || (header.version != ManifestVersion) ||
+        (header.numInputs != numInputs) || (header.outputChecksum != outputChecksum) || (header.profileChecksum != profileChecksum))
+    {
+        return S_OK;
+    }
+
+    // Inputs are compared in order: the first input supplies the primary schema, so the same set of
+    // files added in a different order doesn't necessarily produce the same output.
+    for (UINT32 i = 0; i < numInputs; i++)
+    {
+        MANIFEST_INPUT entry;
+        RETURN_IF_WIN32_BOOL_FALSE(ReadFile(hManifest.get(), &entry, sizeof(entry), &cbRead, nullptr));
+
+        Input* pInput;
+        RETURN_IF_FAILED(m_pInputs->Get(i, &pInput));
+        if ((cbRead != sizeof(entry)) || (entry.checksum != pInput->checksum) ||
+            (entry.mergeFlags != static_cast<UINT32>(pInput->mergeFlags)))
+        {
+            return S_OK;
+        }
+    }
+
+    *pbIsCurrent = true;
+    return S_OK;
+}
+
+HRESULT PriMergeManifest::WriteForOutput(_In_ PCWSTR pOutputFilePath) const
+{
+    RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pOutputFilePath));
+
+    UINT32 numInputs = static_cast<UINT32>(m_pInputs->Count());
+    size_t cbManifest = sizeof(MANIFEST_HEADER) + (numInputs * sizeof(MANIFEST_INPUT));
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW), cbManifest > MAXDWORD);
+
+    unique_deffree_ptr<BYTE> pData(_DefArray_AllocZeroed(BYTE, cbManifest));
+    RETURN_IF_NULL_ALLOC(pData.get());
+
+    MANIFEST_HEADER* pHeader = reinterpret_cast<MANIFEST_HEADER*>(pData.get());
+    pHeader->magic = ManifestMagic;
+    pHeader->version = ManifestVersion;
+    pHeader->numInputs = numInputs;
+    RETURN_IF_FAILED(ComputeFileChecksum(pOutputFilePath, &pHeader->outputChecksum));
+    RETURN_IF_FAILED(ComputeProfileChecksum(&pHeader->profileChecksum));
+
+    MANIFEST_INPUT* pEntries = reinterpret_cast<MANIFEST_INPUT*>(pHeader + 1);
+    for (UINT32 i = 0; i < numInputs; i++)
+    {
+        Input* pInput;
+        RETURN_IF_FAILED(m_pInputs->Get(i, &pInput));
+        pEntries[i].checksum = pInput->checksum;
+        pEntries[i].mergeFlags = static_cast<UINT32>(pInput->mergeFlags);
+    }
+
+    StringResult strManifestPath;
+    RETURN_IF_FAILED(GetManifestPath(pOutputFilePath, &strManifestPath));
+
+    wil::unique_hfile hManifest(
+        CreateFile(strManifestPath.GetRef(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+    RETURN_LAST_ERROR_IF(!hManifest);
+
+    DWORD cbWritten = 0;
+    RETURN_IF_WIN32_BOOL_FALSE(WriteFile(hManifest.get(), pData.get(), static_cast<DWORD>(cbManifest), &cbWritten, nullptr));
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_WRITE_FAULT), cbWritten != cbManifest);
+
+    return S_OK;
+}
+
+HRESULT PriMergeManifest::DeleteForOutput(_In_ PCWSTR pOutputFilePath)
+{
+    StringResult strManifestPath;
+    RETURN_IF_FAILED(GetManifestPath(pOutputFilePath, &strManifestPath));
+
+    if (!DeleteFile(strManifestPath.GetRef()) && (GetLastError() != ERROR_FILE_NOT_FOUND))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    return S_OK;
+}
+
 //
 // PriFileInfo Implementation
 //
@@ -28,6 +28,9 @@ PriSectionBuilder::PriSectionBuilder(_In_opt_ FileBuilder* pFileBuilder) :
     m_bAllocFileBuilder(false),
     m_dataItems(nullptr),
     m_pFileListBuilder(nullptr),
+    m_queuedStrings(nullptr),
+    m_queuedCandidates(nullptr),
+    m_droppedReferences(nullptr),
     m_linkBuilders(nullptr),
     m_pBuilderConfiguration(nullptr)
 {}
@@ -69,6 +72,31 @@ PriSectionBuilder::~PriSectionBuilder()
         m_pMaps = nullptr;
     }
 
+    if ((m_queuedStrings != nullptr) && (m_queuedCandidates != nullptr))
+    {
+        ClearQueuedStrings();
+    }
+
+    delete m_queuedStrings;
+    m_queuedStrings = nullptr;
+    delete m_queuedCandidates;
+    m_queuedCandidates = nullptr;
+
+    if (m_droppedReferences != nullptr)
+    {
+        for (UINT i = 0; i < m_droppedReferences->Count(); i++)
+        {
+            IBuildInstanceReference* reference;
+            if (m_droppedReferences->TryGet(i, &reference))
+            {
+                delete reference;
+            }
+        }
+
+        delete m_droppedReferences;
+        m_droppedReferences = nullptr;
+    }
+
     delete m_dataItems;
 
     if (m_linkBuilders != nullptr)
@@ -152,6 +180,10 @@ HRESULT PriSectionBuilder::Init(_In_ CoreProfile* pProfile)
 
     RETURN_IF_FAILED(DataItemOrchestrator::CreateInstance(m_pFileBuilder, pProfile, m_pDecisionInfo, &m_dataItems));
 
+    RETURN_IF_FAILED(DynamicArray<DataItemOrchestrator::OptimizedString>::CreateInstance(0, &m_queuedStrings));
+    RETURN_IF_FAILED(DynamicArray<QueuedCandidate>::CreateInstance(0, &m_queuedCandidates));
+    RETURN_IF_FAILED(DynamicArray<IBuildInstanceReference*>::CreateInstance(0, &m_droppedReferences));
+
     return S_OK;
 }
 
@@ -581,24 +613,23 @@ HRESULT PriSectionBuilder::AddCandidateWithString(
 
     value = (value ? value : L"");
 
-    if (m_pBuilderConfiguration->UseDataItemLocator())
+    if (m_pBuilderConfiguration->UseDataItemLocator() && m_pBuilderConfiguration->UseOptimalPayloadEncoding())
+    {
+        // Choosing the best encoding is the expensive part of adding a string, so strings are queued and
+        // encoded together when the queue is flushed.
+        int qualifierSetIndex;
+        RETURN_IF_FAILED(m_pDecisionInfo->GetOrAddQualifierSet(qualifiers, &qualifierSetIndex));
+
+        return QueueCandidateWithString(mapBuilder, resourceName, valueType, value, qualifierSetIndex, false);
+    }
+    else if (m_pBuilderConfiguration->UseDataItemLocator())
     {
         AutoDeletePtr<IBuildInstanceReference> buildInstanceReference;
-        MrmEnvironment::ResourceValueType optimalValueType = valueType;
         int qualifierSetIndex;
 
-        if (m_pBuilderConfiguration->UseOptimalPayloadEncoding())
-        {
-            RETURN_IF_FAILED(m_dataItems->AddOptimizedStringAndCreateInstanceReference(
-                valueType, value, qualifiers, &buildInstanceReference, &qualifierSetIndex, &optimalValueType));
-        }
-        else
-        {
-            RETURN_IF_FAILED(
-                m_dataItems->AddStringAndCreateInstanceReference(value, qualifiers, &buildInstanceReference, &qualifierSetIndex));
-        }
+        RETURN_IF_FAILED(m_dataItems->AddStringAndCreateInstanceReference(value, qualifiers, &buildInstanceReference, &qualifierSetIndex));
 
-        RETURN_IF_FAILED(mapBuilder->AddCandidate(resourceName, optimalValueType, buildInstanceReference, qualifierSetIndex));
+        RETURN_IF_FAILED(mapBuilder->AddCandidate(resourceName, valueType, buildInstanceReference, qualifierSetIndex));
 
         // else buildInstanceReference will be deleted when ResourceMapSectionBuilder::Build resolves
         // the DataItemSectionBuilder's section index, which is not available until all sections are finalized
@@ -616,6 +647,97 @@ HRESULT PriSectionBuilder::AddCandidateWithString(
     return S_OK;
 }
 
+HRESULT PriSectionBuilder::QueueCandidateWithString(
+    _In_ ResourceMapSectionBuilder* mapBuilder,
+    _In_ PCWSTR resourceName,
+    _In_ MrmEnvironment::ResourceValueType valueType,
+    _In_ PCWSTR value,
+    _In_ int qualifierSetIndex,
+    _In_ bool ignoreDuplicates)
+{
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), m_priBuilderPhase != PriBuilderPhase::PriInitialized);
+    RETURN_HR_IF(
+        E_DEF_INCOMPATIBLE_LOCATOR_TYPE,
+        !m_pBuilderConfiguration->UseDataItemLocator() || !m_pBuilderConfiguration->UseOptimalPayloadEncoding());
+    RETURN_HR_IF(E_INVALIDARG, (mapBuilder == nullptr) || DefString_IsEmpty(resourceName) || (value == nullptr));
+    RETURN_HR_IF(E_DEF_INCOMPATIBLE_VALUE_TYPE, !MrmEnvironment::IsUtf16ResourceValueType(valueType));
+
+    // Add the name now so the schema sees names in the same order as if each string were added on its own.
+    QueuedCandidate candidate = {mapBuilder, 0, ignoreDuplicates};
+    RETURN_IF_FAILED(mapBuilder->GetSchema()->GetOrAddItem(resourceName, &candidate.itemIndex));
+
+    DataItemOrchestrator::OptimizedString queuedString = {valueType, nullptr, qualifierSetIndex, nullptr, valueType};
+    PWSTR valueCopy;
+    RETURN_IF_FAILED(DefString_Dup(value, &valueCopy));
+    queuedString.value = valueCopy;
+
+    HRESULT hr = m_queuedStrings->Add(queuedString);
+    if (SUCCEEDED(hr))
+    {
+        hr = m_queuedCandidates->Add(candidate);
+        if (FAILED(hr))
+        {
+            m_queuedStrings->SetExtent(m_queuedStrings->Count() - 1);
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        Def_Free(valueCopy);
+    }
+    return hr;
+}
+
+HRESULT PriSectionBuilder::FlushQueuedStrings()
+{
+    UINT32 numStrings = (m_queuedStrings != nullptr) ? m_queuedStrings->Count() : 0;
+    if (numStrings == 0)
+    {
+        return S_OK;
+    }
+
+    // The queue is emptied even if the flush fails, so the same strings are never added twice.
+    auto clearQueue = wil::scope_exit([&] { ClearQueuedStrings(); });
+
+    DataItemOrchestrator::OptimizedString* strings = m_queuedStrings->GetAll();
+    RETURN_IF_FAILED(m_dataItems->AddOptimizedStringsAndCreateInstanceReferences(numStrings, strings));
+
+    for (UINT32 i = 0; i < numStrings; i++)
+    {
+        QueuedCandidate candidate;
+        RETURN_HR_IF(E_UNEXPECTED, !m_queuedCandidates->TryGet(i, &candidate));
+
+        HRESULT hr = candidate.mapBuilder->AddCandidate(
+            candidate.itemIndex, strings[i].optimalType, strings[i].result, strings[i].qualifierSetIndex);
+        if (candidate.ignoreDuplicates && ((hr == E_DEF_ALREADY_INITIALIZED) || (hr == HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY))))
+        {
+            // The deduplication map may still hand out clones of this reference, so it has to live as long as
+            // the orchestrator does.
+            hr = m_droppedReferences->Add(strings[i].result);
+        }
+        RETURN_IF_FAILED(hr);
+
+        // else the reference will be deleted when ResourceMapSectionBuilder::Build resolves
+        // the DataItemSectionBuilder's section index, which is not available until all sections are finalized
+        strings[i].result = nullptr;
+    }
+
+    return S_OK;
+}
+
+void PriSectionBuilder::ClearQueuedStrings()
+{
+    DataItemOrchestrator::OptimizedString* strings = m_queuedStrings->GetAll();
+    for (UINT32 i = 0; i < m_queuedStrings->Count(); i++)
+    {
+        delete strings[i].result;
+        Def_Free(const_cast<PWSTR>(strings[i].value));
+    }
+
+    m_queuedStrings->Reset();
+    m_queuedCandidates->Reset();
+}
+
 HRESULT PriSectionBuilder::AddCandidateWithEmbeddedData(
     _In_opt_ PCWSTR schemaName,
     _In_ PCWSTR resourceName,
@@ -630,6 +752,8 @@ HRESULT PriSectionBuilder::AddCandidateWithEmbeddedData(
     RETURN_HR_IF_NULL(E_INVALIDARG, value);
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_FILE_TYPE), !MrmEnvironment::IsBinaryResourceValueType(valueType));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     ResourceMapSectionBuilder* mapBuilder;
     RETURN_IF_FAILED(GetMapBuilderForAddCandidate(schemaName, &mapBuilder));
 
@@ -686,6 +810,8 @@ HRESULT PriSectionBuilder::AddCandidateByReference(
     // resource packs that gives can file and data item index
     RETURN_IF_FAILED(GetCanAddCandidate(schemaName, resourceName));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     ResourceMapSectionBuilder* mapBuilder;
     RETURN_IF_FAILED(GetMapBuilderForAddCandidate(schemaName, &mapBuilder));
 
@@ -708,6 +834,8 @@ HRESULT PriSectionBuilder::AddCandidateByReference(
     // resource packs that gives can file and data item index
     RETURN_IF_FAILED(GetCanAddCandidate(schemaName, resourceName));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     ResourceMapSectionBuilder* mapBuilder;
     RETURN_IF_FAILED(GetMapBuilderForAddCandidate(schemaName, &mapBuilder));
     return mapBuilder->AddCandidate(resourceName, valueType, buildInstanceReference, newQualifierSetIndex);
@@ -725,6 +853,8 @@ HRESULT PriSectionBuilder::AddCandidateByReference(
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), m_priBuilderPhase != PriBuilderPhase::PriInitialized);
     RETURN_HR_IF(E_INVALIDARG, (schemaName != nullptr) && DefString_IsEmpty(schemaName));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     ResourceMapSectionBuilder* mapBuilder;
     RETURN_IF_FAILED(GetMapBuilderForAddCandidate(schemaName, &mapBuilder));
     return mapBuilder->AddCandidate(resourceIndex, valueType, buildInstanceReference, newQualifierSetIndex);
@@ -735,6 +865,8 @@ HRESULT PriSectionBuilder::AddResourceLink(_In_ PCWSTR linkFromResourceName, _In
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), m_priBuilderPhase != PriBuilderPhase::PriInitialized);
     RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(linkFromResourceName) || DefString_IsEmpty(linkToResourceName));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     ResourceMapSectionBuilder* mapBuilder;
     RETURN_IF_FAILED(GetOrAddPrimaryResourceMapBuilder(&mapBuilder));
 
@@ -746,6 +878,8 @@ HRESULT PriSectionBuilder::AddResourceLink(_In_ int linkFromResourceIndex, _In_
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), m_priBuilderPhase != PriBuilderPhase::PriInitialized);
     RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(linkToResourceName));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     ResourceMapSectionBuilder* mapBuilder;
     RETURN_IF_FAILED(GetOrAddPrimaryResourceMapBuilder(&mapBuilder));
 
@@ -761,6 +895,8 @@ PriSectionBuilder::AddResourceLink(
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), m_priBuilderPhase != PriBuilderPhase::PriInitialized);
     RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(linkFromResourceName) || DefString_IsEmpty(linkToResourceName));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     ResourceMapSectionBuilder* mapBuilder;
     RETURN_IF_FAILED(GetOrAddPrimaryResourceMapBuilder(&mapBuilder));
 
@@ -776,6 +912,8 @@ PriSectionBuilder::AddResourceLink(
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), m_priBuilderPhase != PriBuilderPhase::PriInitialized);
     RETURN_HR_IF(E_INVALIDARG, (linkToSchema == nullptr) || DefString_IsEmpty(linkToResourceName));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     ResourceMapSectionBuilder* mapBuilder;
     RETURN_IF_FAILED(GetOrAddPrimaryResourceMapBuilder(&mapBuilder));
 
@@ -841,6 +979,9 @@ HRESULT PriSectionBuilder::AddSchemaBuilder(_In_ HierarchicalSchemaSectionBuilde
     *index = -1;
     RETURN_HR_IF_NULL(E_INVALIDARG, pSchema);
 
+    // Data item sections for queued strings go before any section added after them.
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     int indexRtrn = -1;
     RETURN_IF_FAILED(m_pSchemas->Add(pSchema, &indexRtrn));
     RETURN_IF_FAILED(m_pFileBuilder->AddSection(pSchema));
@@ -970,6 +1111,9 @@ HRESULT PriSectionBuilder::AddResourceMapBuilder(_In_ ResourceMapSectionBuilder*
     *index = -1;
     RETURN_HR_IF_NULL(E_INVALIDARG, pMap);
 
+    // Data item sections for queued strings go before any section added after them.
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     int indexRtrn = -1;
     RETURN_IF_FAILED(m_pMaps->Add(pMap, &indexRtrn));
     RETURN_IF_FAILED(m_pFileBuilder->AddSection(pMap));
@@ -1079,6 +1223,9 @@ HRESULT PriSectionBuilder::AddFileListSectionBuilder(_In_ FileListBuilder* pFile
         return HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY);
     }
 
+    // Data item sections for queued strings go before any section added after them.
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     RETURN_IF_FAILED(m_pFileBuilder->AddSection(pFileListSectionBuilder));
 
     m_pFileListBuilder = pFileListSectionBuilder;
@@ -1094,6 +1241,8 @@ HRESULT PriSectionBuilder::Finalize()
 {
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), !IsValid() || (m_priBuilderPhase < PriBuilderPhase::PriInitialized));
 
+    RETURN_IF_FAILED(FlushQueuedStrings());
+
     m_priBuilderPhase = PriBuilderPhase::PriFinalizedSection;
 
     // FileList and DataItem Section Finalize should come before ResourceMap Finalize
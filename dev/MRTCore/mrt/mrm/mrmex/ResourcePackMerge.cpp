@@ -31,7 +31,8 @@ ResourcePackMerge::ResourcePackMerge(_In_ CoreProfile* pProfile) :
     bFinalized(false),
     m_pFirstEntrySchema(nullptr),
     m_pPriFileList(nullptr),
-    m_pAtoms(nullptr)
+    m_pAtoms(nullptr),
+    m_pMergeManifest(nullptr)
 {
     // Constructor will receive the CoreProfile interface that is implemented by DEHClientProfile, which can give merged file path and additional information such as perf optimization.
 }
@@ -51,6 +52,7 @@ ResourcePackMerge::~ResourcePackMerge()
     delete m_pEnvironment;
     delete m_pAtoms;
     delete m_pFileBuilder;
+    delete m_pMergeManifest;
 
     if (m_pPriFileList != nullptr)
     {
@@ -79,6 +81,31 @@ HRESULT ResourcePackMerge::AddPriFile(_In_ PCWSTR pszPriFileName, _In_ PriFileMe
         return E_INVALIDARG;
     }
 
+    // All files in one merge are either merged as they're added or deferred to WriteToFile; mixing the
+    // two would reorder the inputs.
+    bool bIncremental = ((priMergeFlags & PriFileMerger::IncrementalMerge) != 0);
+    if (bIncremental)
+    {
+        RETURN_HR_IF(E_INVALIDARG, m_pPriFileList->Count() > 0);
+
+        if (m_pMergeManifest == nullptr)
+        {
+            RETURN_IF_FAILED(PriMergeManifest::CreateInstance(m_pProfile, &m_pMergeManifest));
+        }
+
+        // The manifest detects duplicate files; the merge itself happens in WriteToFile, and only if the
+        // previous output is stale.
+        RETURN_IF_FAILED(m_pMergeManifest->AddInput(pszPriFileName, priMergeFlags));
+        return S_OK;
+    }
+
+    RETURN_HR_IF(E_INVALIDARG, m_pMergeManifest != nullptr);
+
+    return MergePriFile(pszPriFileName, priMergeFlags);
+}
+
+HRESULT ResourcePackMerge::MergePriFile(_In_ PCWSTR pszPriFileName, _In_ PriFileMerger::PriMergeFlags priMergeFlags)
+{
     // AddFile will detect if the same file is added
     ManagedFile* pManagedFile;
     RETURN_IF_FAILED(m_pPriFileManager->AddFile(pszPriFileName, nullptr, true, &pManagedFile));
@@ -179,6 +206,32 @@ bool ResourcePackMerge::IsFinalized() const { return bFinalized; }
 
 HRESULT ResourcePackMerge::WriteToFile(_In_ PCWSTR pszOutputFile)
 {
+    if (m_pMergeManifest != nullptr)
+    {
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_OPERATION), IsFinalized());
+
+        bool bIsCurrent;
+        RETURN_IF_FAILED(m_pMergeManifest->IsOutputCurrent(pszOutputFile, &bIsCurrent));
+        if (bIsCurrent)
+        {
+            // The existing output was merged from exactly these inputs with the same profile, so merging
+            // again would reproduce it.
+            bFinalized = true;
+            return S_OK;
+        }
+
+        for (int i = 0; i < m_pMergeManifest->GetNumInputs(); i++)
+        {
+            PCWSTR pszPriFileName;
+            PriFileMerger::PriMergeFlags priMergeFlags;
+            RETURN_IF_FAILED(m_pMergeManifest->GetInput(i, &pszPriFileName, &priMergeFlags));
+            RETURN_IF_FAILED(MergePriFile(pszPriFileName, priMergeFlags));
+        }
+
+        // Don't leave a manifest vouching for the old output if the write below fails part way.
+        RETURN_IF_FAILED(PriMergeManifest::DeleteForOutput(pszOutputFile));
+    }
+
     // It is possible that there are no eligible files to merge. This should only happen
     // when the machine is corrupted, but when it does we want to make sure we fail gracefully.
     // Otherwise, if the missing file is loaded by explorer it will just chain crash.
@@ -189,9 +242,21 @@ HRESULT ResourcePackMerge::WriteToFile(_In_ PCWSTR pszOutputFile)
 
     bFinalized = true;
 
-    // Write to the file of the merged opearation.
+    // Write to the file of the merged opearation. Resource packs can be large, so sections are streamed
+    // to the file rather than generated in memory first.
+    m_pFileBuilder->SetStreamingGeneration(true);
     RETURN_IF_FAILED(m_pFileBuilder->WriteToFile(pszOutputFile));
 
+    if (m_pMergeManifest != nullptr)
+    {
+        // The manifest only saves work on the next merge, so failing to write it doesn't fail this one.
+        HRESULT hr = m_pMergeManifest->WriteForOutput(pszOutputFile);
+        if (FAILED(hr))
+        {
+            WRITE_MRMMIN_INIT_TRACE_ERROR_CHECK(pszOutputFile, hr);
+        }
+    }
+
     return S_OK;
 }
 
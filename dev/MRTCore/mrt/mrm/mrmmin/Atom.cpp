@@ -19,17 +19,82 @@ const Atom Atom::NullAtom(0, 0);
     (((A1).s.poolIndex == (A2).s.poolIndex) ? (((A1).s.index == (A2).s.index) ? DEF_ATOMS_EQUAL : DEF_ATOMS_UNEQUAL) : \
                                               DEF_ATOMS_INDETERMINATE)
 
+// Constants from xxHash64.
+static const UINT64 DefAtom_Prime64_1 = 0x9E3779B185EBCA87ULL;
+static const UINT64 DefAtom_Prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const UINT64 DefAtom_Prime64_3 = 0x165667B19E3779F9ULL;
+static const UINT64 DefAtom_Prime64_4 = 0x85EBCA77C2B2AE63ULL;
+static const UINT64 DefAtom_Prime64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline WCHAR DefAtom_FoldCase(WCHAR ch)
+{
+    // Resource names are almost entirely ASCII, so avoid the locale lookup for those.
+    if (ch < 0x80)
+    {
+        return (((ch >= L'A') && (ch <= L'Z')) ? static_cast<WCHAR>(ch + (L'a' - L'A')) : ch);
+    }
+    return towlower(ch);
+}
+
+static inline UINT64 DefAtom_HashRound(UINT64 acc, UINT64 input)
+{
+    acc ^= _rotl64(input * DefAtom_Prime64_2, 31) * DefAtom_Prime64_1;
+    return (_rotl64(acc, 27) * DefAtom_Prime64_1) + DefAtom_Prime64_4;
+}
+
+// Version 2 hash: an xxHash64-style hash over the (optionally case-folded) UTF-16 code units, taken
+// four at a time. Unlike the legacy hash every character affects every bit of the result, so long names
+// that share a suffix don't collide.
+static UINT64 DefAtom_HashString64(__in PCWSTR pString, bool isCaseInsensitive)
+{
+    UINT64 hash = DefAtom_Prime64_5;
+    UINT64 block = 0;
+    UINT32 cch = 0;
+
+    for (; *pString; pString++, cch++)
+    {
+        WCHAR ch = (isCaseInsensitive ? DefAtom_FoldCase(*pString) : *pString);
+        block |= (static_cast<UINT64>(ch) << ((cch & 3) * 16));
+        if ((cch & 3) == 3)
+        {
+            hash = DefAtom_HashRound(hash, block);
+            block = 0;
+        }
+    }
+
+    if ((cch & 3) != 0)
+    {
+        hash ^= block * DefAtom_Prime64_5;
+        hash = _rotl64(hash, 11) * DefAtom_Prime64_1;
+    }
+
+    hash += static_cast<UINT64>(cch) * sizeof(WCHAR);
+
+    hash ^= hash >> 33;
+    hash *= DefAtom_Prime64_2;
+    hash ^= hash >> 29;
+    hash *= DefAtom_Prime64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
 DEF_ATOM_HASH
 DefAtom_HashString(__in PCWSTR pString, DEF_ATOM_HASH_METHOD hashMethod)
 {
-    DEF_ATOM_HASH rtrn = 0x3482;
+    bool isCaseInsensitive = ((hashMethod & DEF_HASH_CASE_INSENSITIVE) != 0);
+
+    if ((hashMethod & DEF_HASH_VERSION_2) != 0)
+    {
+        UINT64 hash = DefAtom_HashString64(pString, isCaseInsensitive);
+        return static_cast<DEF_ATOM_HASH>(hash ^ (hash >> 32));
+    }
 
-    //! \todo really basic hash function.  Do something better someday.
-    //! \todo Repeated hashMethod tests should be factored out if they
-    //!       aren't optimized away (which they almost certainly are).
+    // Legacy hash. Files that don't set DEFFILE_ATOMPOOL_HASH_V2 were written with this, so it has to
+    // stay exactly as it is.
+    DEF_ATOM_HASH rtrn = 0x3482;
     for (; *pString; pString++)
     {
-        rtrn = (rtrn << 1) ^ ((hashMethod & DEF_HASH_CASE_INSENSITIVE) ? towlower(*pString) : *pString);
+        rtrn = (rtrn << 1) ^ (isCaseInsensitive ? towlower(*pString) : *pString);
     }
 
     return rtrn;
@@ -60,4 +125,21 @@ Atom::Comparison Atom::Compare(__in Atom atom) const { return DefAtom_Compare(m_
 /// </returns>
 Atom::Hash Atom::HashString(__in PCWSTR pString, __in Atom::HashMethod hashType) { return DefAtom_HashString(pString, hashType); }
 
+/// <summary>
+///        returns the full 64-bit version 2 hash value for a string.
+/// </summary>
+/// <param name="pString">
+///        String whose hash needs to be retreived.
+/// </param>
+/// <param name="hashType">
+///        Specifies whether the hash is case-insensitive.
+/// </param>
+/// <returns>
+///        The 64-bit hash.
+/// </returns>
+Atom::Hash64 Atom::HashString64(__in PCWSTR pString, __in Atom::HashMethod hashType)
+{
+    return DefAtom_HashString64(pString, ((hashType & HashMethodCaseInsensitive) != 0));
+}
+
 } // namespace Microsoft::Resources
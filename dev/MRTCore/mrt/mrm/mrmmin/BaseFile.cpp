@@ -94,58 +94,98 @@ HRESULT BaseFile::InitFromData(__in_bcount(cbData) const void* pData, __in size_
     return S_OK;
 }
 
-HRESULT
-BaseFile::LoadFileData(_In_ PCWSTR pFileName, _Out_ size_t* pcbDataOut, _Outptr_result_buffer_maybenull_(*pcbDataOut) VOID** ppDataOut)
+static HRESULT OpenPriFile(_In_ PCWSTR pFileName, _Out_ unique_DefHandle* phFile, _Out_ size_t* pcbFileOut)
 {
-    unique_DefHandle hFile;
-    DWORD cbData = 0;
-    DWORD cbRead = 0;
     LARGE_INTEGER fileLen = {0};
 
-    DEF_ASSERT((pcbDataOut != NULL) && (ppDataOut != NULL));
+    *pcbFileOut = 0;
 
-    *pcbDataOut = 0;
-    *ppDataOut = nullptr;
+    RETURN_IF_FAILED(_DefCreateFile(pFileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, phFile->put()));
+    RETURN_IF_FAILED(_DefGetFileSizeEx(phFile->get(), &fileLen));
 
-    RETURN_IF_FAILED((_DefCreateFile(pFileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, &hFile)));
+    // The file header describes its size in 32 bits, so anything bigger can't be a PRI file. Check the whole
+    // 64-bit size rather than truncating it to the low part.
+    RETURN_HR_IF(
+        HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+        fileLen.QuadPart < static_cast<LONGLONG>(sizeof(DEFFILE_HEADER) + sizeof(DEFFILE_TRAILER)));
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE), static_cast<ULONGLONG>(fileLen.QuadPart) > MAXUINT32);
 
-    RETURN_IF_FAILED(_DefGetFileSizeEx(hFile.get(), &fileLen));
+    *pcbFileOut = static_cast<size_t>(fileLen.QuadPart);
+    return S_OK;
+}
 
-    cbData = (UINT32)fileLen.LowPart;
-    unique_deffree_ptr<VOID> pBaseFileData(_DefBlob_AllocZeroed(cbData));
+static HRESULT ReadPriFile(_In_ HANDLE hFile, _In_ size_t cbData, _Outptr_result_bytebuffer_(cbData) VOID** ppDataOut)
+{
+    *ppDataOut = nullptr;
+
+    // Every byte is overwritten below, so there's no need to zero the buffer first.
+    unique_deffree_ptr<VOID> pBaseFileData(_DefBlob_Alloc(cbData));
     RETURN_IF_NULL_ALLOC(pBaseFileData.get());
 
-    RETURN_IF_FAILED(_DefReadFile(hFile.get(), pBaseFileData.get(), cbData, &cbRead));
+    // Some sources return less than was asked for, so keep reading until we have the whole file.
+    BYTE* pNext = static_cast<BYTE*>(pBaseFileData.get());
+    size_t cbRemaining = cbData;
+    while (cbRemaining > 0)
+    {
+        ULONG cbRead = 0;
+        RETURN_IF_FAILED(_DefReadFile(hFile, pNext, static_cast<ULONG>(cbRemaining), &cbRead));
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (cbRead == 0) || (cbRead > cbRemaining));
 
-    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), cbRead != cbData);
+        pNext += cbRead;
+        cbRemaining -= cbRead;
+    }
 
-    *pcbDataOut = cbData;
     *ppDataOut = pBaseFileData.release();
+    return S_OK;
+}
+
+static HRESULT MapPriFile(_In_ HANDLE hFile, _Outptr_ const VOID** ppDataOut)
+{
+    unique_DefHandle hMapping;
+    PVOID pBaseFileData = NULL;
 
+    *ppDataOut = nullptr;
+
+    RETURN_IF_FAILED(_DefCreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL, &hMapping));
+    RETURN_IF_FAILED(_DefMapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, 0, 0, &pBaseFileData));
+
+    *ppDataOut = pBaseFileData;
     return S_OK;
 }
 
 HRESULT
-BaseFile::MapFileData(_In_ PCWSTR pFileName, _Out_ size_t* pcbDataOut, _Outptr_result_buffer_maybenull_(*pcbDataOut) const VOID** ppDataOut)
+BaseFile::LoadFileData(_In_ PCWSTR pFileName, _Out_ size_t* pcbDataOut, _Outptr_result_buffer_maybenull_(*pcbDataOut) VOID** ppDataOut)
 {
     unique_DefHandle hFile;
-    unique_DefHandle hMapping;
-    PVOID pBaseFileData = NULL;
-    LARGE_INTEGER fileLen = {0};
+    size_t cbData = 0;
 
     DEF_ASSERT((pcbDataOut != NULL) && (ppDataOut != NULL));
 
     *pcbDataOut = 0;
     *ppDataOut = nullptr;
 
-    RETURN_IF_FAILED(_DefCreateFile(pFileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, &hFile));
-    RETURN_IF_FAILED(_DefGetFileSizeEx(hFile.get(), &fileLen));
-    RETURN_IF_FAILED(_DefCreateFileMapping(hFile.get(), NULL, PAGE_READONLY, 0, 0, NULL, &hMapping));
-    RETURN_IF_FAILED(_DefMapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, 0, 0, &pBaseFileData));
+    RETURN_IF_FAILED(OpenPriFile(pFileName, &hFile, &cbData));
+    RETURN_IF_FAILED(ReadPriFile(hFile.get(), cbData, ppDataOut));
 
-    *pcbDataOut = fileLen.QuadPart;
-    *ppDataOut = pBaseFileData;
+    *pcbDataOut = cbData;
+    return S_OK;
+}
+
+HRESULT
+BaseFile::MapFileData(_In_ PCWSTR pFileName, _Out_ size_t* pcbDataOut, _Outptr_result_buffer_maybenull_(*pcbDataOut) const VOID** ppDataOut)
+{
+    unique_DefHandle hFile;
+    size_t cbData = 0;
+
+    DEF_ASSERT((pcbDataOut != NULL) && (ppDataOut != NULL));
+
+    *pcbDataOut = 0;
+    *ppDataOut = nullptr;
+
+    RETURN_IF_FAILED(OpenPriFile(pFileName, &hFile, &cbData));
+    RETURN_IF_FAILED(MapPriFile(hFile.get(), ppDataOut));
 
+    *pcbDataOut = cbData;
     return S_OK;
 }
 
@@ -193,14 +233,163 @@ HRESULT BaseFile::CreateInstance(__in UINT32 flags, __in_bcount(cbData) const BY
     return S_OK;
 }
 
+namespace
+{
+
+// Files opened through BaseFile::GetSharedInstance. A process rarely has more than a handful
+// open, so they're kept in a simple list.
+struct SharedBaseFile
+{
+    DEF_FILE_IDENTITY identity;
+    UINT32 flags;
+    bool isShareable;
+    LONG refCount;
+    BaseFile* pFile;
+    SharedBaseFile* pNext;
+};
+
+// A zeroed SRW lock is an unlocked one, so the lock needs no initialization.
+_DEF_SRWLOCK s_sharedFilesLock = {};
+SharedBaseFile* s_pSharedFiles = nullptr;
+int s_numSharedFiles = 0;
+
+// Caller holds s_sharedFilesLock.
+SharedBaseFile* FindSharedFile(_In_ const DEF_FILE_IDENTITY& identity, _In_ UINT32 flags)
+{
+    for (SharedBaseFile* pEntry = s_pSharedFiles; pEntry != nullptr; pEntry = pEntry->pNext)
+    {
+        if (pEntry->isShareable && (pEntry->flags == flags) && (pEntry->identity.volumeSerialNumber == identity.volumeSerialNumber) &&
+            (pEntry->identity.fileIndex == identity.fileIndex) && (pEntry->identity.cbFile == identity.cbFile) &&
+            (pEntry->identity.lastWriteTime == identity.lastWriteTime))
+        {
+            return pEntry;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+HRESULT BaseFile::GetSharedInstance(__in UINT32 flags, __in PCWSTR pFileName, _Outptr_ const BaseFile** newFile)
+{
+    *newFile = nullptr;
+
+    RETURN_HR_IF(E_INVALIDARG, (pFileName == nullptr) || (pFileName[0] == L'\0') || ((flags & ~ValidFlags) != 0));
+
+    // The identity comes from the same handle the file is read through, so a file replaced on disk
+    // while we're looking at it can't end up cached under the old file's identity.
+    unique_DefHandle hFile;
+    size_t cbData = 0;
+    DEF_FILE_IDENTITY identity;
+    RETURN_IF_FAILED(OpenPriFile(pFileName, &hFile, &cbData));
+    RETURN_IF_FAILED(_DefGetFileIdentity(hFile.get(), &identity));
+
+    // Some file systems (network redirectors, some FAT and virtual volumes) report 0 for either value,
+    // which would make unrelated files of the same size and time look alike.  Such files aren't shared,
+    // but are still tracked here so that ReleaseSharedInstance can free them.
+    bool isShareable = (identity.volumeSerialNumber != 0) && (identity.fileIndex != 0);
+
+    if (isShareable)
+    {
+        AutoReaderWriterLock autoLock(&s_sharedFilesLock);
+        SharedBaseFile* pExisting = FindSharedFile(identity, flags);
+        if (pExisting != nullptr)
+        {
+            pExisting->refCount++;
+            *newFile = pExisting->pFile;
+            return S_OK;
+        }
+    }
+
+    // Map and validate the file without holding the lock.
+    AutoDeletePtr<BaseFile> pFile = new BaseFile();
+    RETURN_IF_NULL_ALLOC(pFile);
+    RETURN_IF_FAILED(pFile->Init(flags, pFileName, hFile.get(), cbData));
+
+    SharedBaseFile* pEntry = _DefArray_AllocZeroed(SharedBaseFile, 1);
+    RETURN_IF_NULL_ALLOC(pEntry);
+
+    AutoReaderWriterLock autoLock(&s_sharedFilesLock);
+
+    // Another thread might have opened the same file while we were mapping it.
+    SharedBaseFile* pExisting = (isShareable ? FindSharedFile(identity, flags) : nullptr);
+    if (pExisting != nullptr)
+    {
+        Def_Free(pEntry);
+        pExisting->refCount++;
+        *newFile = pExisting->pFile;
+        return S_OK;
+    }
+
+    pEntry->identity = identity;
+    pEntry->flags = flags;
+    pEntry->isShareable = isShareable;
+    pEntry->refCount = 1;
+    pEntry->pFile = pFile.Detach();
+    pEntry->pNext = s_pSharedFiles;
+    s_pSharedFiles = pEntry;
+    s_numSharedFiles++;
+
+    *newFile = pEntry->pFile;
+    return S_OK;
+}
+
+void BaseFile::ReleaseSharedInstance(__in const BaseFile* pFile)
+{
+    if (pFile == nullptr)
+    {
+        return;
+    }
+
+    BaseFile* pUnused = nullptr;
+    {
+        AutoReaderWriterLock autoLock(&s_sharedFilesLock);
+        for (SharedBaseFile** ppEntry = &s_pSharedFiles; *ppEntry != nullptr; ppEntry = &(*ppEntry)->pNext)
+        {
+            SharedBaseFile* pEntry = *ppEntry;
+            if (pEntry->pFile == pFile)
+            {
+                DEF_ASSERT(pEntry->refCount > 0);
+                if (--pEntry->refCount == 0)
+                {
+                    *ppEntry = pEntry->pNext;
+                    s_numSharedFiles--;
+                    pUnused = pEntry->pFile;
+                    Def_Free(pEntry);
+                }
+                break;
+            }
+        }
+    }
+
+    // Unmap outside the lock.
+    delete pUnused;
+}
+
+int BaseFile::GetNumSharedInstances()
+{
+    AutoReaderWriterLock autoLock(&s_sharedFilesLock, true);
+    return s_numSharedFiles;
+}
+
 HRESULT BaseFile::Init(__in UINT32 flags, __in PCWSTR pFileName)
 {
     DEF_ASSERT((pFileName != NULL) && (pFileName[0] != L'\0'));
 
     RETURN_HR_IF(E_INVALIDARG, (flags & ~ValidFlags) != 0);
 
-    bool isMapped = ((flags & MapFileFlag) != 0);
+    unique_DefHandle hFile;
     size_t cbData = 0;
+    RETURN_IF_FAILED(OpenPriFile(pFileName, &hFile, &cbData));
+
+    return Init(flags, pFileName, hFile.get(), cbData);
+}
+
+HRESULT BaseFile::Init(__in UINT32 flags, __in PCWSTR pFileName, __in HANDLE hFile, __in size_t cbData)
+{
+    // Files are mapped read-only unless the caller asks only for a private copy, so their pages are
+    // shared between processes and only the parts that are actually used get read in.
+    bool isMapped = (((flags & MapFileFlag) != 0) || ((flags & LoadFileFlag) == 0));
     union
     {
         const VOID* pcData;
@@ -216,13 +405,22 @@ HRESULT BaseFile::Init(__in UINT32 flags, __in PCWSTR pFileName)
         isMapped = IsFileOnFixedDrive(pFileName);
     }
 
-    HRESULT hr = (isMapped ? MapFileData(pFileName, &cbData, &data.pcData) : LoadFileData(pFileName, &cbData, &data.pData));
-    RETURN_IF_FAILED(hr);
+    if (isMapped && FAILED(MapPriFile(hFile, &data.pcData)))
+    {
+        // Not every file system supports mapping. Fall back to reading a copy.
+        isMapped = false;
+    }
+
+    if (!isMapped)
+    {
+        RETURN_IF_FAILED(ReadPriFile(hFile, cbData, &data.pData));
+    }
 
-    hr = InitFromData(data.pcData, cbData);
+    HRESULT hr = InitFromData(data.pcData, cbData);
     if (SUCCEEDED(hr))
     {
-        m_flags = (flags | BaseFileOwnsDataFlag);
+        // Record how the data was actually obtained so the destructor releases it the right way.
+        m_flags = ((flags & ~(MapFileFlag | LoadFileFlag)) | (isMapped ? MapFileFlag : LoadFileFlag) | BaseFileOwnsDataFlag);
     }
     else if (isMapped)
     {
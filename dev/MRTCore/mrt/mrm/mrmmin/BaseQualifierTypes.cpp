@@ -208,6 +208,92 @@ QualifierTypeBase::Evaluate(_In_ const IQualifier* qualifierOnAsset, _In_ PCWSTR
     return S_OK;
 }
 
+void IQualifierType::FreeCompiledList(_Inout_ CompiledList* pList)
+{
+    Def_Free(pList->pBuffer);
+    Def_Free(pList->ppValues);
+    pList->pBuffer = nullptr;
+    pList->pList = nullptr;
+    pList->ppValues = nullptr;
+    pList->numValues = 0;
+}
+
+bool QualifierTypeBase::TryCompileValueList(_In_ PCWSTR pValue, _Out_ CompiledList* pCompiledOut) const
+{
+    pCompiledOut->pBuffer = nullptr;
+    pCompiledOut->pList = nullptr;
+    pCompiledOut->ppValues = nullptr;
+    pCompiledOut->numValues = 0;
+
+    // ProcessQualifierValueList finds the first separator before it skips leading whitespace, so a
+    // list that starts with whitespace isn't split where the separators are.  Leave those to Evaluate.
+    if ((!AreListValuesAllowed()) || (pValue == nullptr) || ((wcschr(pValue, L';') != nullptr) && iswspace(pValue[0])))
+    {
+        return false;
+    }
+
+    size_t cchValue = wcslen(pValue);
+    UINT32 numValues = 1;
+    for (size_t i = 0; i < cchValue; i++)
+    {
+        numValues += ((pValue[i] == L';') ? 1 : 0);
+    }
+
+    PWSTR pBuffer = _DefArray_Alloc(WCHAR, (cchValue + 1) * 2);
+    PCWSTR* ppValues = _DefArray_Alloc(PCWSTR, numValues);
+    if ((pBuffer == nullptr) || (ppValues == nullptr))
+    {
+        Def_Free(pBuffer);
+        Def_Free(ppValues);
+        return false;
+    }
+
+    PWSTR pValues = &pBuffer[cchValue + 1];
+    CopyMemory(pBuffer, pValue, (cchValue + 1) * sizeof(WCHAR));
+    CopyMemory(pValues, pValue, (cchValue + 1) * sizeof(WCHAR));
+
+    UINT32 numSplit = 0;
+    ppValues[numSplit++] = pValues;
+    for (size_t i = 0; i < cchValue; i++)
+    {
+        if (pValues[i] == L';')
+        {
+            pValues[i] = L'\0';
+            ppValues[numSplit++] = &pValues[i + 1];
+        }
+    }
+
+    pCompiledOut->pBuffer = pBuffer;
+    pCompiledOut->pList = pBuffer;
+    pCompiledOut->ppValues = ppValues;
+    pCompiledOut->numValues = numValues;
+    return true;
+}
+
+HRESULT
+QualifierTypeBase::EvaluateCompiledList(_In_ const IQualifier* qualifierOnAsset, _In_ const CompiledList& contextList, _Out_ double* score)
+    const
+{
+    *score = 0.0;
+
+    StringResult valueOnAsset;
+    RETURN_IF_FAILED(qualifierOnAsset->GetOperand2Literal(&valueOnAsset));
+
+    // Same walk as Evaluate, over values that were split when the list was compiled.
+    double localScore = 0.0;
+    for (UINT32 i = 0; (i < contextList.numValues) && (localScore == 0.0); i++)
+    {
+        double singleItemScore = EvaluateSingleQualifierValue(valueOnAsset.GetRef(), contextList.ppValues[i]);
+        if (singleItemScore > 0.0)
+        {
+            localScore = ScoreInPosition(i, singleItemScore);
+        }
+    }
+
+    *score = localScore;
+    return S_OK;
+}
+
 double QualifierTypeBase::EvaluateSingleQualifierValue(_In_ PCWSTR valueOnAsset, _In_ PCWSTR valueFromProvider) const
 {
     double result = 0.0;
@@ -482,6 +568,39 @@ EnumerationQualifierType::Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWST
     return S_OK;
 }
 
+int EnumerationQualifierType::GetOrdinal(_In_ PCWSTR pValue) const
+{
+    for (int i = 0; i < m_numAllowedValues; i++)
+    {
+        if (DefString_ICompare(pValue, m_pAllowedValues[i]) == Def_Equal)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+bool EnumerationQualifierType::TryCompileValue(_In_ PCWSTR pValue, _Out_ CompiledValue* pCompiledOut) const
+{
+    pCompiledOut->value = -1;
+    pCompiledOut->isEmpty = DefString_IsEmpty(pValue) ? true : false;
+
+    if (FAILED(ValidateQualifierValue(pValue)))
+    {
+        return false;
+    }
+
+    // Ordinals come from the first allowed value that matches, so two values are equal exactly when their ordinals are.
+    pCompiledOut->value = GetOrdinal(pValue);
+    return (pCompiledOut->value >= 0);
+}
+
+double EnumerationQualifierType::EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const
+{
+    return ((assetValue.value == contextValue.value) ? 1.0 : 0.0);
+}
+
 _Pre_satisfies_(maxAllowedValue > minAllowedValue) HRESULT IntegerQualifierType::CreateInstance(
     _In_ int minAllowedValue,
     _In_ int maxAllowedValue,
@@ -538,28 +657,53 @@ IntegerQualifierType::Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR ps
     StringResult qualifierValue;
     RETURN_IF_FAILED(pQualifier->GetOperand2Literal(&qualifierValue));
 
-    int providerValue = _wtoi(pszProviderValue);
-    int qualiferValue = _wtoi(qualifierValue.GetRef());
+    *score = ScoreValues(_wtoi(pszProviderValue), _wtoi(qualifierValue.GetRef()));
+    return S_OK;
+}
 
+bool IntegerQualifierType::TryCompileValue(_In_ PCWSTR pValue, _Out_ CompiledValue* pCompiledOut) const
+{
+    pCompiledOut->value = 0;
+    pCompiledOut->isEmpty = DefString_IsEmpty(pValue) ? true : false;
+
+    // An empty value never matches, but it is a valid qualifier operand if the type allows it,
+    // and it parses as 0 there.
+    if (pCompiledOut->isEmpty)
+    {
+        return true;
+    }
+
+    if (FAILED(ValidateQualifierValue(pValue)))
+    {
+        return false;
+    }
+
+    pCompiledOut->value = _wtoi(pValue);
+    return true;
+}
+
+double IntegerQualifierType::EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const
+{
+    return (contextValue.isEmpty ? 0.0 : ScoreValues(contextValue.value, assetValue.value));
+}
+
+double IntegerQualifierType::ScoreValues(_In_ int providerValue, _In_ int qualifierValue)
+{
     // same value => 1.0
     // cond > prov => 0.75
     // cond < prov => 0.5
-    int comparisonResult = providerValue - qualiferValue;
+    int comparisonResult = providerValue - qualifierValue;
 
     if (comparisonResult == 0)
     {
-        *score = 1.0;
+        return 1.0;
     }
     else if (comparisonResult > 0)
     {
-        *score = 0.5;
-    }
-    else
-    {
-        *score = 0.75;
+        return 0.5;
     }
 
-    return S_OK;
+    return 0.75;
 }
 
 HRESULT
@@ -26,55 +26,85 @@ HRESULT ContrastQualifierType::Evaluate(_In_ const IQualifier* pQualifier, _In_
     *score = 0.0;
 
     StringResult qualifierValue;
-    double result = 0.0;
+    CompiledValue providerLevel;
+    CompiledValue assetLevel;
 
     RETURN_IF_FAILED(ValidateQualifier(pQualifier));
     RETURN_IF_FAILED(ValidateQualifierValue(pszProviderValue));
     RETURN_IF_FAILED(pQualifier->GetOperand2Literal(&qualifierValue));
 
-    PCWSTR pszQualifierValue = qualifierValue.GetRef();
+    // Both values are known to be allowed contrast values at this point, so both compile.
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_QUALIFIER_VALUE), !TryCompileValue(pszProviderValue, &providerLevel));
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_QUALIFIER_VALUE), !TryCompileValue(qualifierValue.GetRef(), &assetLevel));
+
+    *score = ScoreContrastLevels(providerLevel.value, assetLevel.value);
+
+    return S_OK;
+}
+
+bool ContrastQualifierType::TryCompileValue(_In_ PCWSTR pValue, _Out_ CompiledValue* pCompiledOut) const
+{
+    pCompiledOut->value = -1;
+    pCompiledOut->isEmpty = DefString_IsEmpty(pValue) ? true : false;
 
+    if (FAILED(ValidateQualifierValue(pValue)))
+    {
+        return false;
+    }
+
+    if (CompareStringOrdinal(CoreEnvironment::ContrastValue_Standard, -1, pValue, -1, TRUE) == CSTR_EQUAL)
+    {
+        pCompiledOut->value = ContrastStandard;
+    }
+    else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_High, -1, pValue, -1, TRUE) == CSTR_EQUAL)
+    {
+        pCompiledOut->value = ContrastHigh;
+    }
+    else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_Black, -1, pValue, -1, TRUE) == CSTR_EQUAL)
+    {
+        pCompiledOut->value = ContrastBlack;
+    }
+    else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_White, -1, pValue, -1, TRUE) == CSTR_EQUAL)
+    {
+        pCompiledOut->value = ContrastWhite;
+    }
+
+    return (pCompiledOut->value >= 0);
+}
+
+double ContrastQualifierType::EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const
+{
+    return ScoreContrastLevels(contextValue.value, assetValue.value);
+}
+
+double ContrastQualifierType::ScoreContrastLevels(_In_ int providerLevel, _In_ int assetLevel)
+{
     // same value => 1.0
     // any of standard => 0.0
-    // asset white  => 0.5
-    // others => 0.1
-    if (CompareStringOrdinal(pszProviderValue, -1, pszQualifierValue, -1, TRUE) == 2)
+    // asset high or black => 0.5
+    // asset or provider white => 0.1
+    if (providerLevel == assetLevel)
     {
-        result = 1.0;
+        return 1.0;
     }
-    else
+    else if ((providerLevel == ContrastStandard) || (assetLevel == ContrastStandard))
     {
-        if (CompareStringOrdinal(CoreEnvironment::ContrastValue_Standard, -1, pszProviderValue, -1, TRUE) == 2 ||
-            CompareStringOrdinal(CoreEnvironment::ContrastValue_Standard, -1, pszQualifierValue, -1, TRUE) == 2)
-        {
-            result = 0.0;
-        }
-        else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_High, -1, pszQualifierValue, -1, TRUE) == 2)
-        {
-            result = 0.5;
-        }
-        else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_White, -1, pszQualifierValue, -1, TRUE) == 2)
-        {
-            result = 0.1;
-        }
-        else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_White, -1, pszProviderValue, -1, TRUE) == 2)
-        {
-            result = 0.1;
-        }
-        else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_Black, -1, pszQualifierValue, -1, TRUE) == 2)
-        {
-            // make sure the asset (condition) value is a supported one by adding this additional comparison.
-            result = 0.5;
-        }
-        else
-        {
-            result = 0.0;
-        }
+        return 0.0;
+    }
+    else if (assetLevel == ContrastHigh)
+    {
+        return 0.5;
+    }
+    else if ((assetLevel == ContrastWhite) || (providerLevel == ContrastWhite))
+    {
+        return 0.1;
+    }
+    else if (assetLevel == ContrastBlack)
+    {
+        return 0.5;
     }
 
-    *score = result;
-
-    return S_OK;
+    return 0.0;
 }
 
 HRESULT ScaleQualifierType::CreateInstance(_Outptr_ ScaleQualifierType** type)
@@ -175,7 +205,6 @@ HRESULT ScaleQualifierType::Evaluate(_In_ const IQualifier* pAssetQualifier, _In
 {
     *score = 0.0;
 
-    double result = 0.0;
     StringResult assetQualifierValue;
 
     RETURN_IF_FAILED(ValidateQualifier(pAssetQualifier));
@@ -189,8 +218,20 @@ HRESULT ScaleQualifierType::Evaluate(_In_ const IQualifier* pAssetQualifier, _In
 
     RETURN_IF_FAILED(pAssetQualifier->GetOperand2Literal(&assetQualifierValue));
 
-    int contextValue = _wtoi(pContextValue);
-    int assetValue = _wtoi(assetQualifierValue.GetRef());
+    *score = ScoreScaleValues(_wtoi(assetQualifierValue.GetRef()), _wtoi(pContextValue));
+
+    return S_OK;
+}
+
+double ScaleQualifierType::EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const
+{
+    // Empty provider value is valid but doesn't match anything
+    return (contextValue.isEmpty ? 0.0 : ScoreScaleValues(assetValue.value, contextValue.value));
+}
+
+double ScaleQualifierType::ScoreScaleValues(_In_ int assetValue, _In_ int contextValue) const
+{
+    double result = 0.0;
 
     // same value => 1.0
     // (asset > context) && (asset <= context * 2) => 0.75..0.99
@@ -217,9 +258,7 @@ HRESULT ScaleQualifierType::Evaluate(_In_ const IQualifier* pAssetQualifier, _In
                      (0.01 + ComputeScoreWithinBucket(assetValue, m_minAllowedValue, contextValue / 2, 0.23));
     }
 
-    *score = result;
-
-    return S_OK;
+    return result;
 }
 
 double ScaleQualifierType::CalculateScaleFactorScore(_In_ int assetValue, _In_ int contextValue)
@@ -279,48 +318,57 @@ HRESULT DXFeatureLevelQualifierType::Evaluate(_In_ const IQualifier* pQualifier,
 {
     *score = 0.0;
 
-    double result = 0.0;
     StringResult qualifierValue;
-    int providerLevel = -1;
     int qualifierLevel = -1;
 
-    if (DefString_ICompare(pszProviderValue, CoreEnvironment::DXFeatureLevelValue_9) == Def_Equal)
+    if (SUCCEEDED(pQualifier->GetOperand2Literal(&qualifierValue)))
     {
-        providerLevel = 9;
+        qualifierLevel = GetFeatureLevel(qualifierValue.GetRef());
     }
-    else if (DefString_ICompare(pszProviderValue, CoreEnvironment::DXFeatureLevelValue_10) == Def_Equal)
+
+    *score = ScoreFeatureLevels(GetFeatureLevel(pszProviderValue), qualifierLevel);
+
+    return S_OK;
+}
+
+bool DXFeatureLevelQualifierType::TryCompileValue(_In_ PCWSTR pValue, _Out_ CompiledValue* pCompiledOut) const
+{
+    pCompiledOut->value = GetFeatureLevel(pValue);
+    pCompiledOut->isEmpty = DefString_IsEmpty(pValue) ? true : false;
+    return true;
+}
+
+double DXFeatureLevelQualifierType::EvaluateCompiled(_In_ const CompiledValue& assetValue, _In_ const CompiledValue& contextValue) const
+{
+    return ScoreFeatureLevels(contextValue.value, assetValue.value);
+}
+
+int DXFeatureLevelQualifierType::GetFeatureLevel(_In_ PCWSTR pValue)
+{
+    if (DefString_ICompare(pValue, CoreEnvironment::DXFeatureLevelValue_9) == Def_Equal)
     {
-        providerLevel = 10;
+        return 9;
     }
-    else if (DefString_ICompare(pszProviderValue, CoreEnvironment::DXFeatureLevelValue_11) == Def_Equal)
+    else if (DefString_ICompare(pValue, CoreEnvironment::DXFeatureLevelValue_10) == Def_Equal)
     {
-        providerLevel = 11;
+        return 10;
     }
-    else if (DefString_ICompare(pszProviderValue, CoreEnvironment::DXFeatureLevelValue_12) == Def_Equal)
+    else if (DefString_ICompare(pValue, CoreEnvironment::DXFeatureLevelValue_11) == Def_Equal)
     {
-        providerLevel = 12;
+        return 11;
     }
-
-    if (SUCCEEDED(pQualifier->GetOperand2Literal(&qualifierValue)))
+    else if (DefString_ICompare(pValue, CoreEnvironment::DXFeatureLevelValue_12) == Def_Equal)
     {
-        if (DefString_ICompare(qualifierValue.GetRef(), CoreEnvironment::DXFeatureLevelValue_9) == Def_Equal)
-        {
-            qualifierLevel = 9;
-        }
-        else if (DefString_ICompare(qualifierValue.GetRef(), CoreEnvironment::DXFeatureLevelValue_10) == Def_Equal)
-        {
-            qualifierLevel = 10;
-        }
-        else if (DefString_ICompare(qualifierValue.GetRef(), CoreEnvironment::DXFeatureLevelValue_11) == Def_Equal)
-        {
-            qualifierLevel = 11;
-        }
-        else if (DefString_ICompare(qualifierValue.GetRef(), CoreEnvironment::DXFeatureLevelValue_12) == Def_Equal)
-        {
-            qualifierLevel = 12;
-        }
+        return 12;
     }
 
+    return -1;
+}
+
+double DXFeatureLevelQualifierType::ScoreFeatureLevels(_In_ int providerLevel, _In_ int qualifierLevel)
+{
+    double result = 0.0;
+
     if ((providerLevel > 0) && (qualifierLevel > 0))
     {
         if (providerLevel == qualifierLevel)
@@ -367,9 +415,7 @@ HRESULT DXFeatureLevelQualifierType::Evaluate(_In_ const IQualifier* pQualifier,
         }
     }
 
-    *score = result;
-
-    return S_OK;
+    return result;
 }
 
 HRESULT DeviceFamilyQualifierType::CreateInstance(_Outptr_ DeviceFamilyQualifierType** type)
@@ -39,7 +39,10 @@ FileAtomPool::FileAtomPool() :
     m_pHashes(NULL),
     m_pOffsets(NULL),
     m_pPool(NULL),
-    m_pPoolGroup(NULL)
+    m_pPoolGroup(NULL),
+    m_numBuckets(0),
+    m_pBuckets(NULL),
+    m_pLazyBuckets(NULL)
 {}
 
 HRESULT FileAtomPool::Initialize(__in_opt const IFileSection* pSection, __in_bcount(cbData) const void* pData, __in int cbData)
@@ -67,6 +70,27 @@ HRESULT FileAtomPool::Initialize(__in_opt const IFileSection* pSection, __in_bco
         m_pOffsets = _SECTION_PARSER_NEXT_ARRAY(data, m_pHeader->nAtoms, UINT32, &hr);
         m_pPool = _SECTION_PARSER_NEXT_ARRAY(data, m_pHeader->cchPool, WCHAR, &hr);
 
+        if (m_pHeader->flags & DEFFILE_ATOMPOOL_HASH_TABLE)
+        {
+            (void)data.GetPadBytes(BaseFile::Align32Bit, &hr, nullptr);
+            const DEFFILE_ATOMPOOL_HASHTABLE* pTable = _SECTION_PARSER_NEXT(data, DEFFILE_ATOMPOOL_HASHTABLE, &hr);
+            if (pTable != nullptr)
+            {
+                // A probe only terminates at an empty bucket, so the table must be larger than the pool.
+                if ((pTable->nBuckets <= static_cast<UINT32>(m_pHeader->nAtoms)) || ((pTable->nBuckets & (pTable->nBuckets - 1)) != 0))
+                {
+                    return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
+                }
+                m_pBuckets = _SECTION_PARSER_NEXT_ARRAY(data, pTable->nBuckets, HashTableEntry, &hr);
+                m_numBuckets = pTable->nBuckets;
+            }
+        }
+        else if (m_pHeader->nAtoms >= HashTableMinAtoms)
+        {
+            // Older pools don't store a lookup table. Build one on first lookup.
+            m_numBuckets = GetHashTableNumBuckets(m_pHeader->nAtoms);
+        }
+
         m_flags = 0;
         m_poolIndex = m_pHeader->poolIndex;
         m_cbTotalSize = cbPoolTotal;
@@ -86,7 +110,14 @@ HRESULT FileAtomPool::Initialize(__in_opt const IFileSection* pSection, __in_bco
     return hr;
 }
 
-FileAtomPool::~FileAtomPool() {}
+FileAtomPool::~FileAtomPool()
+{
+    if (m_pLazyBuckets != NULL)
+    {
+        _DefFree(m_pLazyBuckets);
+        m_pLazyBuckets = NULL;
+    }
+}
 
 HRESULT FileAtomPool::CreateInstance(__in const IFileSection* pFileSection, _Outptr_ FileAtomPool** result)
 {
@@ -264,7 +295,24 @@ bool FileAtomPool::TryGetIndex(__in PCWSTR pString, __out_opt Atom::Index* pInde
         return false;
     }
 
-    if (m_pHeader->flags & DEFFILE_ATOMPOOL_HASH_NONE)
+    const HashTableEntry* pBuckets = GetHashTable();
+    if (pBuckets != nullptr)
+    {
+        UINT32 mask = m_numBuckets - 1;
+        hash = Atom::HashString(pString, static_cast<Atom::HashMethod>(m_pHeader->flags));
+        UINT32 slot = hash & mask;
+        for (UINT32 probe = 0; (probe < m_numBuckets) && (pBuckets[slot].indexPlusOne != 0); probe++)
+        {
+            if ((pBuckets[slot].hash == hash) && (CompareAtIndex(pBuckets[slot].indexPlusOne - 1, pString) == 0))
+            {
+                i = pBuckets[slot].indexPlusOne - 1;
+                found = true;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    else if (m_pHeader->flags & DEFFILE_ATOMPOOL_HASH_NONE)
     {
         for (i = 0; i < m_pHeader->nAtoms; i++)
         {
@@ -394,6 +442,100 @@ UINT32 FileAtomPool::GetSizeInBytes(__in UINT32 nAtoms, __in UINT32 cchPool)
     return maxSize;
 }
 
+UINT32 FileAtomPool::GetHashTableNumBuckets(__in UINT32 nAtoms)
+{
+    // Keep the table at most half full so probe sequences stay short.
+    UINT32 numBuckets = 8;
+    while (numBuckets < (nAtoms * 2))
+    {
+        numBuckets <<= 1;
+    }
+    return numBuckets;
+}
+
+UINT32 FileAtomPool::GetHashTableSizeInBytes(__in UINT32 nAtoms)
+{
+    return sizeof(DEFFILE_ATOMPOOL_HASHTABLE) + (GetHashTableNumBuckets(nAtoms) * sizeof(HashTableEntry));
+}
+
+void FileAtomPool::HashTable_Insert(
+    __inout_ecount(nBuckets) HashTableEntry* pBuckets,
+    __in UINT32 nBuckets,
+    __in Atom::Hash hash,
+    __in Atom::Index index)
+{
+    UINT32 mask = nBuckets - 1;
+    UINT32 slot = hash & mask;
+    while (pBuckets[slot].indexPlusOne != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    pBuckets[slot].hash = hash;
+    pBuckets[slot].indexPlusOne = index + 1;
+}
+
+HRESULT FileAtomPool::BuildHashTable(_Outptr_ HashTableEntry** result) const
+{
+    *result = nullptr;
+
+    HashTableEntry* pBuckets = _DefArray_AllocZeroed(HashTableEntry, m_numBuckets);
+    RETURN_IF_NULL_ALLOC(pBuckets);
+
+    for (Atom::Index i = 0; i < m_pHeader->nAtoms; i++)
+    {
+        if (m_pHashes != nullptr)
+        {
+            // Hashes might be sorted, so use the atom index stored with each one.
+            if ((m_pHashes[i].index >= 0) && (m_pHashes[i].index < m_pHeader->nAtoms))
+            {
+                HashTable_Insert(pBuckets, m_numBuckets, m_pHashes[i].hash, m_pHashes[i].index);
+            }
+        }
+        else if (m_pOffsets[i] < m_pHeader->cchPool)
+        {
+            Atom::Hash hash = Atom::HashString(&m_pPool[m_pOffsets[i]], static_cast<Atom::HashMethod>(m_pHeader->flags));
+            HashTable_Insert(pBuckets, m_numBuckets, hash, i);
+        }
+    }
+
+    *result = pBuckets;
+    return S_OK;
+}
+
+const FileAtomPool::HashTableEntry* FileAtomPool::GetHashTable() const
+{
+    if ((m_pBuckets != nullptr) || (m_numBuckets == 0))
+    {
+        return m_pBuckets;
+    }
+
+    HashTableEntry* pBuckets = static_cast<HashTableEntry*>(
+        InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_pLazyBuckets), nullptr, nullptr));
+    if (pBuckets == nullptr)
+    {
+        HashTableEntry* pNewBuckets;
+        if (FAILED(BuildHashTable(&pNewBuckets)))
+        {
+            // Fall back to searching the pool.
+            return nullptr;
+        }
+
+        // Another thread might have published a table while we were building ours.
+        pBuckets = static_cast<HashTableEntry*>(
+            InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_pLazyBuckets), pNewBuckets, nullptr));
+        if (pBuckets == nullptr)
+        {
+            pBuckets = pNewBuckets;
+        }
+        else
+        {
+            _DefFree(pNewBuckets);
+        }
+    }
+
+    return pBuckets;
+}
+
 UINT32 FileAtomPool::GetMaxSizeInBytesForStrings(__in_ecount(nStrings) PCWSTR* ppStrings, __in UINT32 nStrings) const
 {
     UINT32 i;
@@ -6,6 +6,13 @@
 namespace Microsoft::Resources
 {
 
+namespace
+{
+
+const UINT32 FileListPathIndexMinSlots = 16;
+
+} // namespace
+
 bool IFileList::IsValidFileIndex(__inout int indexIn) const { return ((indexIn >= 0) && (indexIn < GetTotalNumFiles())); }
 bool IFileList::IsValidFolderIndex(__inout int indexIn) const { return ((indexIn >= 0) && (indexIn < GetTotalNumFolders())); }
 
@@ -192,8 +199,29 @@ bool IFileList::TryGetPrefixFolderIndex(__in PCWSTR pFullPath, __out int* pIndex
 const DEFFILE_SECTION_TYPEID FileFileList::GetSectionTypeId() { return gFileListSectionType; }
 
 FileFileList::FileFileList() :
-    FileSectionBase(), m_pHeader(NULL), m_pFolders(NULL), m_pFiles(NULL), m_pAsciiNames(NULL), m_pUtf16Names(NULL)
-{}
+    FileSectionBase(),
+    m_pHeader(NULL),
+    m_pFolders(NULL),
+    m_pFiles(NULL),
+    m_pAsciiNames(NULL),
+    m_pUtf16Names(NULL),
+    m_pathCacheState(PathCacheNotBuilt),
+    m_pPaths(nullptr),
+    m_pFilePathOffsets(nullptr),
+    m_pFolderPathOffsets(nullptr),
+    m_pPathIndex(nullptr),
+    m_numPathIndexSlots(0)
+{
+    _DefInitializeSRWLock(&m_srwLock);
+}
+
+FileFileList::~FileFileList()
+{
+    Def_Free(m_pPaths);
+    Def_Free(m_pFilePathOffsets);
+    Def_Free(m_pFolderPathOffsets);
+    Def_Free(m_pPathIndex);
+}
 
 HRESULT FileFileList::Init(__in_opt const IFileSection* pSection, __in_bcount(cbData) const void* pData, __in int cbData)
 {
@@ -349,25 +377,62 @@ HRESULT FileFileList::GetFilePath(__in int fileIndex, __inout StringResult* pPat
     // ResourceMap reference of fileIndex is 1 based since 0 mean its own file in the runtime.
     int fileBasedFileIndex = fileIndex - 1;
 
-    if (fileBasedFileIndex - 1 >= GetTotalNumFiles())
+    if (fileBasedFileIndex >= GetTotalNumFiles())
     {
         return HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND);
     }
 
-    // We'll have to build up the file name from back to front.  First we
-    // make sure that our StringResult contains a buffer with enough room
-    // for our full path.
     const DEFFILE_FILELIST_FILE_ENTRY* pFile = &m_pFiles[fileBasedFileIndex];
-    int cchNext = pFile->cchFullPath;
+    if (EnsurePathCache())
+    {
+        RETURN_IF_FAILED(pPathOut->SetRef(&m_pPaths[m_pFilePathOffsets[fileBasedFileIndex]]));
+    }
+    else
+    {
+        PWSTR pPath;
+        RETURN_IF_FAILED(pPathOut->SetEmptyContents(pFile->cchFullPath + 1, &pPath, NULL));
+        RETURN_IF_FAILED(WriteFilePath(fileBasedFileIndex, pPath, pFile->cchFullPath));
+        pPath[pFile->cchFullPath] = L'\0';
+    }
+
+    if (pFlags)
+    {
+        *pFlags = pFile->flags;
+    }
+
+    return S_OK;
+}
+
+HRESULT FileFileList::GetFolderPath(__in int folderIndex, __inout StringResult* pPathOut) const
+{
+    RETURN_HR_IF(E_INVALIDARG, (pPathOut == nullptr) || (folderIndex < 0));
+
+    if (folderIndex >= GetTotalNumFolders())
+    {
+        return HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND);
+    }
+
+    if (EnsurePathCache())
+    {
+        return pPathOut->SetRef(&m_pPaths[m_pFolderPathOffsets[folderIndex]]);
+    }
+
+    const DEFFILE_FILELIST_FOLDER_ENTRY* pFolder = &m_pFolders[folderIndex];
     PWSTR pPath;
-    RETURN_IF_FAILED(pPathOut->SetEmptyContents(pFile->cchFullPath + 1, &pPath, NULL));
+    RETURN_IF_FAILED(pPathOut->SetEmptyContents(pFolder->cchFullPath + 1, &pPath, NULL));
+    RETURN_IF_FAILED(WriteFolderPath(folderIndex, pPath, pFolder->cchFullPath));
+    pPath[pFolder->cchFullPath] = L'\0';
 
-    // Remember, we're writing from back to front.
-    // First, write the NULL terminator.
-    pPath[cchNext] = L'\0';
+    return S_OK;
+}
+
+HRESULT FileFileList::WriteFilePath(_In_ int fileBasedFileIndex, _Out_writes_(cchPath) PWSTR pPath, _In_ int cchPath) const
+{
+    // We build up the path from back to front, starting with the file name.
+    const DEFFILE_FILELIST_FILE_ENTRY* pFile = &m_pFiles[fileBasedFileIndex];
+    int cchNext = cchPath - pFile->cchName;
 
     // Make sure the file name fits in the buffer and then copy it
-    cchNext -= pFile->cchName;
     RETURN_HR_IF(E_ABORT, cchNext < 0);
     RETURN_IF_FAILED(CopyNameSegment(0, pFile->nameOffset, pFile->cchName, &pPath[cchNext]));
 
@@ -377,10 +442,22 @@ HRESULT FileFileList::GetFilePath(__in int fileIndex, __inout StringResult* pPat
         pPath[--cchNext] = L'\\';
     }
 
+    if (pFile->parentFolderIndex < 0)
+    {
+        // We should be at the start of the buffer.
+        // Fail if we aren't.
+        RETURN_HR_IF(E_ABORT, cchNext != 0);
+        return S_OK;
+    }
+
     // Now walk the tree and write our parent folders...
-    const DEFFILE_FILELIST_FOLDER_ENTRY* pFolder = NULL;
-    int folderIndex = pFile->parentFolderIndex;
+    return WriteFolderPath(pFile->parentFolderIndex, pPath, cchNext);
+}
 
+HRESULT FileFileList::WriteFolderPath(_In_ int folderIndex, _Out_writes_(cchPath) PWSTR pPath, _In_ int cchPath) const
+{
+    // Remember, we're writing from back to front.
+    int cchNext = cchPath;
     while (folderIndex >= 0)
     {
         // Make sure our folder reference is legal
@@ -388,10 +465,11 @@ HRESULT FileFileList::GetFilePath(__in int fileIndex, __inout StringResult* pPat
         {
             return HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND);
         }
-        pFolder = &m_pFolders[folderIndex];
+        const DEFFILE_FILELIST_FOLDER_ENTRY* pFolder = &m_pFolders[folderIndex];
         cchNext -= pFolder->cchName;
 
-        // Now make sure that the folder name fits and then copy it.
+        // Now make sure that the folder name fits in the remaining buffer
+        // and then copy it.
         RETURN_HR_IF(E_ABORT, cchNext < 0);
         RETURN_IF_FAILED(CopyNameSegment(0, pFolder->nameOffset, pFolder->cchName, &pPath[cchNext]));
 
@@ -400,6 +478,7 @@ HRESULT FileFileList::GetFilePath(__in int fileIndex, __inout StringResult* pPat
         {
             pPath[--cchNext] = L'\\';
         }
+
         folderIndex = pFolder->parentFolderIndex;
     }
 
@@ -407,63 +486,187 @@ HRESULT FileFileList::GetFilePath(__in int fileIndex, __inout StringResult* pPat
     // Fail if we aren't.
     RETURN_HR_IF(E_ABORT, cchNext != 0);
 
-    if (pFlags)
+    return S_OK;
+}
+
+bool FileFileList::TryGetFileIndex(__in PCWSTR pPath, __out int* pIndexOut) const
+{
+    if ((pPath == nullptr) || (pIndexOut == nullptr))
     {
-        *pFlags = pFile->flags;
+        return false;
     }
 
-    return S_OK;
+    if (EnsurePathCache() && TryFindPath(pPath, false, pIndexOut))
+    {
+        return true;
+    }
+
+    // The index only knows full paths as GetFilePath spells them, ignoring case and separator style;
+    // anything else gets the full walk.  Both return the 0-based entry index GetFiles reports.
+    return IFileList::TryGetFileIndex(pPath, pIndexOut);
 }
 
-HRESULT FileFileList::GetFolderPath(__in int folderIndex, __inout StringResult* pPathOut) const
+bool FileFileList::TryGetFolderIndex(__in PCWSTR pPath, __out int* pIndexOut) const
 {
-    RETURN_HR_IF(E_INVALIDARG, (pPathOut == nullptr) || (folderIndex < 0));
+    if ((pPath == nullptr) || (pIndexOut == nullptr))
+    {
+        return false;
+    }
 
-    if (folderIndex >= GetTotalNumFolders())
+    if (EnsurePathCache() && TryFindPath(pPath, true, pIndexOut))
     {
-        return HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND);
+        return true;
     }
 
-    // We'll have to build up the path from back to front.  First we
-    // make sure that our StringResult contains a buffer with enough room
-    // for our full path.
-    const DEFFILE_FILELIST_FOLDER_ENTRY* pFolder = &m_pFolders[folderIndex];
-    int cchNext = pFolder->cchFullPath;
-    PWSTR pPath;
-    RETURN_IF_FAILED(pPathOut->SetEmptyContents(pFolder->cchFullPath + 1, &pPath, NULL));
+    return IFileList::TryGetFolderIndex(pPath, pIndexOut);
+}
 
-    // Remember, we're writing from back to front.
-    // First, write the NULL terminator.
-    pPath[cchNext] = L'\0';
+bool FileFileList::TryFindPath(_In_ PCWSTR pPath, _In_ bool isFolder, _Out_ int* pIndexOut) const
+{
+    *pIndexOut = -1;
 
-    while (folderIndex >= 0)
+    UINT32 hash = DefString_ComputeFoldedHash(pPath, nullptr);
+    UINT32 mask = m_numPathIndexSlots - 1;
+    for (UINT32 slot = hash & mask; m_pPathIndex[slot].index >= 0; slot = (slot + 1) & mask)
     {
-        // Make sure our folder reference is legal
-        if (folderIndex >= GetTotalNumFolders())
+        const PathIndexEntry& entry = m_pPathIndex[slot];
+        if ((entry.hash != hash) || (entry.isFolder != isFolder))
         {
-            return HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND);
+            continue;
         }
-        pFolder = &m_pFolders[folderIndex];
-        cchNext -= pFolder->cchName;
 
-        // Now make sure that the folder name fits in the remaining buffer
-        // and then copy it.
-        RETURN_HR_IF(E_ABORT, cchNext < 0);
-        RETURN_IF_FAILED(CopyNameSegment(0, pFolder->nameOffset, pFolder->cchName, &pPath[cchNext]));
+        // Stored paths keep their original case, so both sides are folded.
+        PCWSTR pStored = &m_pPaths[entry.pathOffset];
+        size_t i = 0;
+        while ((pPath[i] != L'\0') && (DefString_FoldChar(pStored[i]) == DefString_FoldChar(pPath[i])))
+        {
+            i++;
+        }
 
-        // If we aren't at the beginning of the string, prepend a backslash
-        if (cchNext > 0)
+        if ((pPath[i] == L'\0') && (pStored[i] == L'\0'))
         {
-            pPath[--cchNext] = L'\\';
+            *pIndexOut = entry.index;
+            return true;
         }
+    }
 
-        folderIndex = pFolder->parentFolderIndex;
+    return false;
+}
+
+bool FileFileList::EnsurePathCache() const
+{
+    {
+        AutoReaderWriterLock autoLock(&m_srwLock, true);
+        if (m_pathCacheState != PathCacheNotBuilt)
+        {
+            return (m_pathCacheState == PathCacheBuilt);
+        }
     }
 
-    // We should be at the start of the buffer.
-    // Fail if we aren't.
-    RETURN_HR_IF(E_ABORT, cchNext != 0);
+    AutoReaderWriterLock autoLock(&m_srwLock);
+    if (m_pathCacheState == PathCacheNotBuilt)
+    {
+        // A list we can't materialize up front is still served one path at a time.
+        m_pathCacheState = SUCCEEDED(BuildPathCache()) ? PathCacheBuilt : PathCacheUnavailable;
+    }
+    return (m_pathCacheState == PathCacheBuilt);
+}
+
+// Caller holds m_srwLock exclusively.
+HRESULT FileFileList::BuildPathCache() const
+{
+    int numFiles = GetTotalNumFiles();
+    int numFolders = GetTotalNumFolders();
+
+    // Every entry records the length of its full path, so the whole buffer is sized up front.
+    size_t cchPaths = 0;
+    for (int i = 0; i < numFiles; i++)
+    {
+        cchPaths += m_pFiles[i].cchFullPath + 1;
+    }
+    for (int i = 0; i < numFolders; i++)
+    {
+        cchPaths += m_pFolders[i].cchFullPath + 1;
+    }
+    RETURN_HR_IF(E_ABORT, (cchPaths == 0) || (cchPaths > UINT32_MAX));
+
+    // Keep the index at most half full so probe sequences stay short.
+    UINT32 numSlots = FileListPathIndexMinSlots;
+    while (numSlots < static_cast<UINT32>(numFiles + numFolders) * 2)
+    {
+        numSlots <<= 1;
+    }
+
+    PWSTR pPaths = _DefArray_Alloc(WCHAR, cchPaths);
+    UINT32* pFileOffsets = _DefArray_AllocZeroed(UINT32, numFiles + 1);
+    UINT32* pFolderOffsets = _DefArray_AllocZeroed(UINT32, numFolders + 1);
+    PathIndexEntry* pIndex = _DefArray_Alloc(PathIndexEntry, numSlots);
+
+    HRESULT hr = ((pPaths == nullptr) || (pFileOffsets == nullptr) || (pFolderOffsets == nullptr) || (pIndex == nullptr))
+                     ? E_OUTOFMEMORY
+                     : S_OK;
+
+    if (SUCCEEDED(hr))
+    {
+        for (UINT32 slot = 0; slot < numSlots; slot++)
+        {
+            pIndex[slot].index = -1;
+        }
+    }
+
+    UINT32 cchUsed = 0;
+    for (int i = 0; SUCCEEDED(hr) && (i < numFiles + numFolders); i++)
+    {
+        bool isFolder = (i >= numFiles);
+        int index = isFolder ? (i - numFiles) : i;
+        int cchFullPath = isFolder ? m_pFolders[index].cchFullPath : m_pFiles[index].cchFullPath;
+
+        PWSTR pPath = &pPaths[cchUsed];
+        hr = isFolder ? WriteFolderPath(index, pPath, cchFullPath) : WriteFilePath(index, pPath, cchFullPath);
+        if (FAILED(hr))
+        {
+            break;
+        }
+        pPath[cchFullPath] = L'\0';
+
+        // Like IFileList::TryGetFileIndex, the index returns the 0-based entry index GetFiles reports.
+        // Paths that differ only in case hash alike, with the fold CompareStringOrdinal uses.
+        UINT32 hash = DefString_ComputeFoldedHash(pPath, nullptr);
+        UINT32 slot = hash & (numSlots - 1);
+        while (pIndex[slot].index >= 0)
+        {
+            slot = (slot + 1) & (numSlots - 1);
+        }
+        pIndex[slot].hash = hash;
+        pIndex[slot].index = index;
+        pIndex[slot].pathOffset = cchUsed;
+        pIndex[slot].isFolder = isFolder;
+
+        if (isFolder)
+        {
+            pFolderOffsets[index] = cchUsed;
+        }
+        else
+        {
+            pFileOffsets[index] = cchUsed;
+        }
+        cchUsed += cchFullPath + 1;
+    }
+
+    if (FAILED(hr))
+    {
+        Def_Free(pPaths);
+        Def_Free(pFileOffsets);
+        Def_Free(pFolderOffsets);
+        Def_Free(pIndex);
+        return hr;
+    }
 
+    m_pPaths = pPaths;
+    m_pFilePathOffsets = pFileOffsets;
+    m_pFolderPathOffsets = pFolderOffsets;
+    m_pPathIndex = pIndex;
+    m_numPathIndexSlots = numSlots;
     return S_OK;
 }
 
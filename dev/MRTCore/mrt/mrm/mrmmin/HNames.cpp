@@ -355,6 +355,7 @@ HierarchicalNames::HierarchicalNames() :
     m_pAsciiNames(nullptr),
     m_pScopeNames(nullptr),
     m_pItemNames(nullptr),
+    m_ppChildIndexes(nullptr),
     m_largeNode(false)
 {}
 
@@ -431,6 +432,12 @@ HRESULT HierarchicalNames::Init(
     m_pAsciiNames = _SECTION_PARSER_NEXT_ARRAY(data, m_pHeader->cchAsciiNamesPool, char, &hr);
     RETURN_IF_FAILED(hr);
 
+    if (m_pHeader->numScopes > 0)
+    {
+        m_ppChildIndexes = _DefArray_AllocZeroed(ChildIndex*, m_pHeader->numScopes);
+        RETURN_IF_NULL_ALLOC(m_ppChildIndexes);
+    }
+
     if (m_largeNode)
     {
         RETURN_IF_FAILED(ScopesAtomPool<DEFFILE_HNAMES_SCOPE_LARGE>::CreateInstance(
@@ -486,6 +493,19 @@ HierarchicalNames::~HierarchicalNames()
 
     m_pScopeNames = NULL;
     m_pItemNames = NULL;
+
+    if (m_ppChildIndexes != nullptr)
+    {
+        for (UINT32 i = 0; i < m_pHeader->numScopes; i++)
+        {
+            if (m_ppChildIndexes[i] != nullptr)
+            {
+                _DefFree(m_ppChildIndexes[i]);
+            }
+        }
+        _DefFree(const_cast<ChildIndex**>(m_ppChildIndexes));
+        m_ppChildIndexes = nullptr;
+    }
 }
 
 _Success_(return ) bool HierarchicalNames::TryGetName(
@@ -740,7 +760,7 @@ bool HierarchicalNames::Contains(
 
     // Local copy to step through.
     PCWSTR pStr = pPath;
-    WCHAR initialChar = 0;
+    int scopeIndex = relativeToScope;
     // ignore leading separator, if present
     if (IsPathSeparator(pStr[0]))
     {
@@ -766,73 +786,29 @@ bool HierarchicalNames::Contains(
             return false;
         }
 
-        int numChildren = pScope->numChildNames;
-        const DEFFILE_HNAMES_NODE* pChildren = nullptr;
-        const DEFFILE_HNAMES_NODE_LARGE* pChildrenLarge = nullptr;
-
-        if (m_largeNode)
-        {
-            pChildrenLarge = &m_pNodesLarge[pScope->firstChildNameNode];
-        }
-        else
-        {
-            pChildren = &m_pNodes[pScope->firstChildNameNode];
-        }
-
         pMatch = nullptr;
         pSegmentEnd = nullptr;
-        initialChar = towupper(pStr[0]);
 
-        for (int i = 0; (i < numChildren); i++)
+        int childIndex;
+        if (FAILED(FindChild(scopeIndex, pScope, pStr, &childIndex)) || (childIndex < 0))
         {
-            WCHAR initChildChar = (m_largeNode ? pChildrenLarge[i].initialChar : pChildren[i].initialChar);
-            // WORKING HERE - NEED TO HANDLE ASCII IN COMPARISON
-            if ((initChildChar == initialChar) || (initChildChar == 0))
-            {
-                int diff;
-                if (m_largeNode)
-                {
-                    if (FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE_LARGE>(&pChildrenLarge[i], pStr, &diff)) || (diff > 0))
-                    {
-                        // we've either hit an error
-                        // or passed the last possiblse match.
-                        return false;
-                    }
-                }
-                else
-                {
-                    if (FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE>(&pChildren[i], pStr, &diff)) || (diff > 0))
-                    {
-                        // we've either hit an error
-                        // or passed the last possiblse match.
-                        return false;
-                    }
-                }
-
-                if (diff == 0)
-                {
-                    if (m_largeNode)
-                    {
-                        pMatch = &pChildrenLarge[i];
-                        pSegmentEnd = &pStr[pChildrenLarge[i].cchName];
-                        nameIndex = static_cast<int>(&pChildrenLarge[i] - m_pNodesLarge);
-                    }
-                    else
-                    {
-                        matchNode = HNAMES_NODE_TO_HNAMES_NODE_LARGE(&pChildren[i]);
-                        pMatch = &matchNode;
-                        pSegmentEnd = &pStr[pChildren[i].cchName];
-                        nameIndex = static_cast<int>(&pChildren[i] - m_pNodes);
-                    }
-                    break;
-                }
-            }
+            return false;
         }
 
-        if (pMatch == nullptr)
+        if (m_largeNode)
         {
-            // no match found
-            return false;
+            const DEFFILE_HNAMES_NODE_LARGE* pChild = &m_pNodesLarge[pScope->firstChildNameNode + childIndex];
+            pMatch = pChild;
+            pSegmentEnd = &pStr[pChild->cchName];
+            nameIndex = static_cast<int>(pChild - m_pNodesLarge);
+        }
+        else
+        {
+            const DEFFILE_HNAMES_NODE* pChild = &m_pNodes[pScope->firstChildNameNode + childIndex];
+            matchNode = HNAMES_NODE_TO_HNAMES_NODE_LARGE(pChild);
+            pMatch = &matchNode;
+            pSegmentEnd = &pStr[pChild->cchName];
+            nameIndex = static_cast<int>(pChild - m_pNodes);
         }
 
         // if we get here, pMatch is the child node that exactly matches the next segment we're
@@ -861,13 +837,14 @@ bool HierarchicalNames::Contains(
             return false;
         }
 
+        scopeIndex = pMatch->payload;
         if (m_largeNode)
         {
-            pScope = &m_pScopesLarge[pMatch->payload];
+            pScope = &m_pScopesLarge[scopeIndex];
         }
         else
         {
-            scopeNode = HNAMES_SCOPE_TO_HNAMES_SCOPE_LARGE(&m_pScopes[pMatch->payload]);
+            scopeNode = HNAMES_SCOPE_TO_HNAMES_SCOPE_LARGE(&m_pScopes[scopeIndex]);
             pScope = &scopeNode;
         }
         pStr = pSegmentEnd + 1;
@@ -1259,6 +1236,219 @@ HRESULT HierarchicalNames::CompareNameSegment(_In_ const T* pNode, _In_ PCWSTR p
     return S_OK;
 }
 
+HRESULT HierarchicalNames::HashNodeName(_In_ const DEFFILE_HNAMES_NODE_LARGE* pNode, _Out_ UINT32* pHashOut) const
+{
+    *pHashOut = 0;
+
+    UINT32 nameOffset = HNamesGetNodeNameOffsetLarge(pNode);
+    // Fold with the same table CompareSegments uses, so names that compare equal hash equal.
+    UINT32 hash = DEFSTRING_FOLDED_HASH_SEED;
+
+    if ((pNode->flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NAME_IS_ASCII) != 0)
+    {
+        PCSTR pName;
+        RETURN_IF_FAILED(GetAsciiName(nameOffset, pNode->cchName, &pName));
+        for (int i = 0; i < pNode->cchName; i++)
+        {
+            hash = DefString_HashFoldedChar(hash, pName[i]);
+        }
+    }
+    else
+    {
+        PCWSTR pName;
+        RETURN_IF_FAILED(GetUtf16Name(nameOffset, pNode->cchName, &pName));
+        for (int i = 0; i < pNode->cchName; i++)
+        {
+            hash = DefString_HashFoldedChar(hash, pName[i]);
+        }
+    }
+
+    *pHashOut = hash;
+    return S_OK;
+}
+
+HRESULT HierarchicalNames::BuildChildIndex(_In_ const DEFFILE_HNAMES_SCOPE_LARGE* pScope, _Outptr_ ChildIndex** result) const
+{
+    *result = nullptr;
+
+    RETURN_HR_IF(
+        HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (pScope->firstChildNameNode + pScope->numChildNames) > m_pHeader->numNodes);
+
+    // Keep the table at most half full so probe sequences stay short.
+    UINT32 numSlots = 1;
+    while (numSlots < (pScope->numChildNames * 2))
+    {
+        numSlots <<= 1;
+    }
+
+    size_t cbIndex = sizeof(ChildIndex) + ((numSlots - 1) * sizeof(ChildIndexEntry));
+    ChildIndex* pIndex = static_cast<ChildIndex*>(_DefBlob_AllocZeroed(cbIndex));
+    RETURN_IF_NULL_ALLOC(pIndex);
+    pIndex->mask = numSlots - 1;
+
+    for (UINT32 i = 0; i < pScope->numChildNames; i++)
+    {
+        const DEFFILE_HNAMES_NODE_LARGE* pChild;
+        DEFFILE_HNAMES_NODE_LARGE childNode;
+        if (m_largeNode)
+        {
+            pChild = &m_pNodesLarge[pScope->firstChildNameNode + i];
+        }
+        else
+        {
+            childNode = HNAMES_NODE_TO_HNAMES_NODE_LARGE(&m_pNodes[pScope->firstChildNameNode + i]);
+            pChild = &childNode;
+        }
+
+        UINT32 hash;
+        HRESULT hr = HashNodeName(pChild, &hash);
+        if (FAILED(hr))
+        {
+            _DefFree(pIndex);
+            return hr;
+        }
+
+        UINT32 slot = hash & pIndex->mask;
+        while (pIndex->entries[slot].childIndexPlusOne != 0)
+        {
+            slot = (slot + 1) & pIndex->mask;
+        }
+        pIndex->entries[slot].hash = hash;
+        pIndex->entries[slot].childIndexPlusOne = i + 1;
+    }
+
+    *result = pIndex;
+    return S_OK;
+}
+
+HRESULT HierarchicalNames::GetChildIndex(
+    _In_ int scopeIndex,
+    _In_ const DEFFILE_HNAMES_SCOPE_LARGE* pScope,
+    _Outptr_result_maybenull_ const ChildIndex** result) const
+{
+    *result = nullptr;
+
+    if ((m_ppChildIndexes == nullptr) || (pScope->numChildNames < ChildIndexMinChildren))
+    {
+        return S_OK;
+    }
+
+    RETURN_HR_IF(E_INVALIDARG, (scopeIndex < 0) || (static_cast<UINT32>(scopeIndex) >= m_pHeader->numScopes));
+
+    ChildIndex* pIndex = static_cast<ChildIndex*>(
+        InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_ppChildIndexes[scopeIndex]), nullptr, nullptr));
+    if (pIndex == nullptr)
+    {
+        ChildIndex* pNewIndex;
+        RETURN_IF_FAILED(BuildChildIndex(pScope, &pNewIndex));
+
+        // Another thread might have published an index for this scope while we were building ours.
+        pIndex = static_cast<ChildIndex*>(
+            InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_ppChildIndexes[scopeIndex]), pNewIndex, nullptr));
+        if (pIndex == nullptr)
+        {
+            pIndex = pNewIndex;
+        }
+        else
+        {
+            _DefFree(pNewIndex);
+        }
+    }
+
+    *result = pIndex;
+    return S_OK;
+}
+
+HRESULT HierarchicalNames::FindChild(
+    _In_ int scopeIndex,
+    _In_ const DEFFILE_HNAMES_SCOPE_LARGE* pScope,
+    _In_ PCWSTR pRequestedSegment,
+    _Out_ int* pChildOut) const
+{
+    *pChildOut = -1;
+
+    const ChildIndex* pIndex;
+    RETURN_IF_FAILED(GetChildIndex(scopeIndex, pScope, &pIndex));
+
+    const DEFFILE_HNAMES_NODE* pChildren = (m_largeNode ? nullptr : &m_pNodes[pScope->firstChildNameNode]);
+    const DEFFILE_HNAMES_NODE_LARGE* pChildrenLarge = (m_largeNode ? &m_pNodesLarge[pScope->firstChildNameNode] : nullptr);
+
+    int diff;
+    if (pIndex != nullptr)
+    {
+        UINT32 hash = DEFSTRING_FOLDED_HASH_SEED;
+        bool isAscii = true;
+        for (PCWSTR pStr = pRequestedSegment; (*pStr != L'\0') && !IsPathSeparator(*pStr); pStr++)
+        {
+            hash = DefString_HashFoldedChar(hash, *pStr);
+            isAscii = isAscii && (*pStr < 0x80);
+        }
+
+        for (UINT32 slot = hash & pIndex->mask; pIndex->entries[slot].childIndexPlusOne != 0; slot = (slot + 1) & pIndex->mask)
+        {
+            if (pIndex->entries[slot].hash != hash)
+            {
+                continue;
+            }
+
+            int i = pIndex->entries[slot].childIndexPlusOne - 1;
+            if (m_largeNode)
+            {
+                RETURN_IF_FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE_LARGE>(&pChildrenLarge[i], pRequestedSegment, &diff));
+            }
+            else
+            {
+                RETURN_IF_FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE>(&pChildren[i], pRequestedSegment, &diff));
+            }
+
+            if (diff == 0)
+            {
+                *pChildOut = i;
+                return S_OK;
+            }
+        }
+
+        if (isAscii)
+        {
+            return S_OK;
+        }
+
+        // Stored ASCII names compare with towupper, which doesn't agree with the hash fold on every
+        // non-ASCII character, so confirm a miss on a non-ASCII name with the scan below.
+    }
+
+    // Children are sorted, so a linear scan can stop as soon as it passes the requested name.
+    WCHAR initialChar = towupper(pRequestedSegment[0]);
+    for (UINT32 i = 0; i < pScope->numChildNames; i++)
+    {
+        WCHAR initChildChar = (m_largeNode ? pChildrenLarge[i].initialChar : pChildren[i].initialChar);
+        if ((initChildChar == initialChar) || (initChildChar == 0))
+        {
+            if (m_largeNode)
+            {
+                RETURN_IF_FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE_LARGE>(&pChildrenLarge[i], pRequestedSegment, &diff));
+            }
+            else
+            {
+                RETURN_IF_FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE>(&pChildren[i], pRequestedSegment, &diff));
+            }
+
+            if (diff > 0)
+            {
+                // passed the last possible match
+                return S_OK;
+            }
+
+            if (diff == 0)
+            {
+                *pChildOut = static_cast<int>(i);
+                return S_OK;
+            }
+        }
+    }
+    return S_OK;
+}
+
 HRESULT
 HierarchicalNames::GetNumDescendents(_In_ int scopeIndex, _In_ UINT32 currentDepth, _Out_opt_ int* pNumScopes, _Out_opt_ int* pNumItems)
     const
@@ -9,7 +9,11 @@ namespace Microsoft::Resources
 class MrmFileSection : public BaseFileSectionResult
 {
 public:
-    MrmFileSection() : BaseFileSectionResult(), m_sectionType(SectionTypeUnknown), isInitialized(false) { u.pFileList = nullptr; }
+    MrmFileSection() : BaseFileSectionResult(), m_sectionType(SectionTypeUnknown), isInitialized(false)
+    {
+        u.pFileList = nullptr;
+        _DefInitializeSRWLock(&m_srwLock);
+    }
 
     virtual ~MrmFileSection() { ResetSection(); }
 
@@ -24,20 +28,29 @@ public:
         return S_OK;
     }
 
-    HRESULT GetAtomPoolSection(_Out_ FileAtomPool** result)
+    // Sections are set up on first access, and any thread may be the first one to touch a given section.
+    HRESULT EnsureInitialized(_In_ const BaseFile* pParent, _In_ BaseFile::SectionIndex index)
     {
-        *result = nullptr;
-        if (m_sectionType == SectionTypeUnknown)
         {
-            RETURN_IF_FAILED(FileAtomPool::CreateInstance(this, &u.pAtomPool));
-
-            m_sectionType = SectionTypeAtomPool;
+            AutoReaderWriterLock autoLock(&m_srwLock, true);
+            if (isInitialized)
+            {
+                return S_OK;
+            }
         }
-        else if (m_sectionType != SectionTypeAtomPool)
+
+        AutoReaderWriterLock autoLock(&m_srwLock);
+        if (!isInitialized)
         {
-            u.pAtomPool = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
+            RETURN_IF_FAILED(Init(pParent, index));
         }
+        return S_OK;
+    }
+
+    HRESULT GetAtomPoolSection(_Out_ FileAtomPool** result)
+    {
+        *result = nullptr;
+        RETURN_IF_FAILED(Materialize(SectionTypeAtomPool, [&]() { return FileAtomPool::CreateInstance(this, &u.pAtomPool); }));
         *result = u.pAtomPool;
 
         return S_OK;
@@ -47,21 +60,13 @@ public:
     {
         *result = nullptr;
 
-        if (m_sectionType == SectionTypeUnknown)
-        {
+        RETURN_IF_FAILED(Materialize(SectionTypeDecisionInfo, [&]() {
             // get default qualifier mapping for the file which contains the decision info
             const RemapAtomPool* pMapping;
             (void)pResolver->GetDefaultQualifierMapping(0, &pMapping);
 
-            RETURN_IF_FAILED(DecisionInfoFileSection::CreateInstance(this, pMapping, &u.pDecisionInfo));
-
-            m_sectionType = SectionTypeDecisionInfo;
-        }
-        else if (m_sectionType != SectionTypeDecisionInfo)
-        {
-            u.pDecisionInfo = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+            return DecisionInfoFileSection::CreateInstance(this, pMapping, &u.pDecisionInfo);
+        }));
 
         *result = u.pDecisionInfo;
         return S_OK;
@@ -70,16 +75,7 @@ public:
     HRESULT GetSchemaSection(_Out_ HierarchicalSchema** result)
     {
         *result = nullptr;
-        if (m_sectionType == SectionTypeUnknown)
-        {
-            RETURN_IF_FAILED(HierarchicalSchema::CreateFromSection(this, &u.pSchema));
-            m_sectionType = SectionTypeSchema;
-        }
-        else if (m_sectionType != SectionTypeSchema)
-        {
-            u.pSchema = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(SectionTypeSchema, [&]() { return HierarchicalSchema::CreateFromSection(this, &u.pSchema); }));
         *result = u.pSchema;
         return S_OK;
     }
@@ -90,16 +86,9 @@ public:
         _Out_ ResourceMapBase** result)
     {
         *result = nullptr;
-        if (m_sectionType == SectionTypeUnknown)
-        {
-            RETURN_IF_FAILED(ResourceMapBase::CreateInstance(pResolver, pSchemaCollection, this, &u.pResourceMap));
-            m_sectionType = SectionTypeResourceMap;
-        }
-        else if (m_sectionType != SectionTypeResourceMap)
-        {
-            u.pResourceMap = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(SectionTypeResourceMap, [&]() {
+            return ResourceMapBase::CreateInstance(pResolver, pSchemaCollection, this, &u.pResourceMap);
+        }));
         *result = u.pResourceMap;
         return S_OK;
     }
@@ -110,16 +99,9 @@ public:
         _Out_ PriDescriptor** result)
     {
         *result = nullptr;
-        if (m_sectionType == SectionTypeUnknown)
-        {
-            RETURN_IF_FAILED(PriDescriptor::CreateInstance(pResolver, pSchemaCollection, this, &u.pPriDescriptor));
-            m_sectionType = SectionTypePriDescriptor;
-        }
-        else if (m_sectionType != SectionTypePriDescriptor)
-        {
-            u.pPriDescriptor = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(SectionTypePriDescriptor, [&]() {
+            return PriDescriptor::CreateInstance(pResolver, pSchemaCollection, this, &u.pPriDescriptor);
+        }));
         *result = u.pPriDescriptor;
         return S_OK;
     }
@@ -127,16 +109,7 @@ public:
     HRESULT GetFileListSection(_Out_ FileFileList** result)
     {
         *result = nullptr;
-        if (m_sectionType == SectionTypeUnknown)
-        {
-            RETURN_IF_FAILED(FileFileList::CreateInstance(this, &u.pFileList));
-            m_sectionType = SectionTypeFileList;
-        }
-        else if (m_sectionType != SectionTypeFileList)
-        {
-            u.pFileList = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(SectionTypeFileList, [&]() { return FileFileList::CreateInstance(this, &u.pFileList); }));
         *result = u.pFileList;
         return S_OK;
     }
@@ -144,16 +117,7 @@ public:
     HRESULT GetDataSection(_Out_ FileDataSection** result)
     {
         *result = nullptr;
-        if (m_sectionType == SectionTypeUnknown)
-        {
-            RETURN_IF_FAILED(FileDataSection::CreateInstance(this, &u.pData));
-            m_sectionType = SectionTypeData;
-        }
-        else if (m_sectionType != SectionTypeData)
-        {
-            u.pData = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(SectionTypeData, [&]() { return FileDataSection::CreateInstance(this, &u.pData); }));
         *result = u.pData;
         return S_OK;
     }
@@ -161,16 +125,7 @@ public:
     HRESULT GetDataItemsSection(_Out_ FileDataItemsSection** result)
     {
         *result = nullptr;
-        if (m_sectionType == SectionTypeUnknown)
-        {
-            RETURN_IF_FAILED(FileDataItemsSection::CreateInstance(this, &u.pDataItems));
-            m_sectionType = SectionTypeDataItems;
-        }
-        else if (m_sectionType != SectionTypeDataItems)
-        {
-            u.pDataItems = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(SectionTypeDataItems, [&]() { return FileDataItemsSection::CreateInstance(this, &u.pDataItems); }));
         *result = u.pDataItems;
         return S_OK;
     }
@@ -178,16 +133,7 @@ public:
     HRESULT GetReverseFileMapSection(_Out_ ReverseFileMap** result)
     {
         *result = nullptr;
-        if (m_sectionType == SectionTypeUnknown)
-        {
-            RETURN_IF_FAILED(ReverseFileMap::CreateInstance(this, &u.pReverseMap));
-            m_sectionType = SectionTypeReverseMap;
-        }
-        else if (m_sectionType != SectionTypeReverseMap)
-        {
-            u.pReverseMap = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(SectionTypeReverseMap, [&]() { return ReverseFileMap::CreateInstance(this, &u.pReverseMap); }));
         *result = u.pReverseMap;
         return S_OK;
     }
@@ -198,18 +144,13 @@ public:
         _In_ const IEnvironmentCollection* environments,
         _Out_ const EnvironmentMapping** result)
     {
-        bool typeMatch = BaseFile::SectionTypesEqual(GetSectionType(), gEnvironmentMappingSectionType);
+        *result = nullptr;
+        RETURN_HR_IF(
+            HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), !BaseFile::SectionTypesEqual(GetSectionType(), gEnvironmentMappingSectionType));
 
-        if ((m_sectionType == SectionTypeUnknown) && typeMatch)
-        {
-            RETURN_IF_FAILED(EnvironmentMapping::CreateInstance(profile, environments, GetData(), GetDataSize(), &u.pEnvironmentMap));
-            m_sectionType = SectionTypeEnvironmentMapping;
-        }
-        else if ((m_sectionType != SectionTypeEnvironmentMapping) || (!typeMatch))
-        {
-            u.pEnvironmentMap = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(SectionTypeEnvironmentMapping, [&]() {
+            return EnvironmentMapping::CreateInstance(profile, environments, GetData(), GetDataSize(), &u.pEnvironmentMap);
+        }));
         *result = u.pEnvironmentMap;
         return S_OK;
     }
@@ -220,18 +161,13 @@ public:
         _In_opt_ const ISchemaCollection* schemas,
         _Out_ const ResourceLinkSection** result)
     {
-        bool typeMatch = BaseFile::SectionTypesEqual(GetSectionType(), ResourceLinkSection::GetSectionTypeId());
+        *result = nullptr;
+        RETURN_HR_IF(
+            HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+            !BaseFile::SectionTypesEqual(GetSectionType(), ResourceLinkSection::GetSectionTypeId()));
 
-        if ((m_sectionType == SectionTypeUnknown) && typeMatch)
-        {
-            RETURN_IF_FAILED(ResourceLinkSection::CreateFromSection(sections, schemas, this, &u.pResourceLink));
-            m_sectionType = SectionTypeResourceLink;
-        }
-        else if ((m_sectionType != SectionTypeResourceLink) || (!typeMatch))
-        {
-            u.pEnvironmentMap = nullptr;
-            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
-        }
+        RETURN_IF_FAILED(Materialize(
+            SectionTypeResourceLink, [&]() { return ResourceLinkSection::CreateFromSection(sections, schemas, this, &u.pResourceLink); }));
         *result = u.pResourceLink;
         return S_OK;
     }
@@ -256,6 +192,7 @@ protected:
     };
 
     SectionType m_sectionType;
+    _DEF_SRWLOCK m_srwLock;
     union
     {
         IFileSection* pOther;
@@ -272,6 +209,29 @@ protected:
         ResourceLinkSection* pResourceLink;
     } u;
 
+    // Builds the typed view of this section the first time it is asked for. Views that already exist are
+    // handed out under the shared lock; the exclusive lock makes sure racing first callers build it only once.
+    // A section that was built as a different type is reported as invalid and left untouched.
+    template<typename TCreate>
+    HRESULT Materialize(_In_ SectionType sectionType, _In_ TCreate create)
+    {
+        {
+            AutoReaderWriterLock autoLock(&m_srwLock, true);
+            if (m_sectionType != SectionTypeUnknown)
+            {
+                return (m_sectionType == sectionType) ? S_OK : HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
+            }
+        }
+
+        AutoReaderWriterLock autoLock(&m_srwLock);
+        if (m_sectionType == SectionTypeUnknown)
+        {
+            RETURN_IF_FAILED(create());
+            m_sectionType = sectionType;
+        }
+        return (m_sectionType == sectionType) ? S_OK : HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
+    }
+
     void ResetSection()
     {
         if (u.pFileList != nullptr)
@@ -475,9 +435,10 @@ HRESULT MrmFile::Init(_In_ PriFileManager* pManager, _In_ PCWSTR pPath)
     m_pPriFileManager = pManager;
     m_pEnvironment = pManager->GetUnifiedEnvironment();
 
-    RETURN_IF_FAILED(BaseFile::CreateInstance(m_pPriFileManager->GetDefaultFileFlags(), pPath, (BaseFile**)&m_pBaseFile));
+    // Managers that load the same file share one mapping of it; each still reads its own sections.
+    RETURN_IF_FAILED(BaseFile::GetSharedInstance(m_pPriFileManager->GetDefaultFileFlags(), pPath, &m_pSharedBaseFile));
 
-    m_pMyBaseFile = m_pBaseFile;
+    m_pBaseFile = m_pSharedBaseFile;
 
     RETURN_IF_FAILED(InitSections());
     RETURN_IF_FAILED(MrmFileResolver::CreateInstance(m_pPriFileManager, &m_pFileResolver));
@@ -544,6 +505,9 @@ void MrmFile::ReleaseSections()
 
     delete m_pMyBaseFile;
     m_pMyBaseFile = nullptr;
+
+    BaseFile::ReleaseSharedInstance(m_pSharedBaseFile);
+    m_pSharedBaseFile = nullptr;
     m_pBaseFile = nullptr;
 }
 
@@ -556,10 +520,7 @@ HRESULT MrmFile::InitializeAndGetSection(_In_ BaseFile::SectionIndex sectionInde
         return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
     }
 
-    if (!m_pSections[sectionIndex].IsInitialized())
-    {
-        RETURN_IF_FAILED(m_pSections[sectionIndex].Init(m_pBaseFile, sectionIndex));
-    }
+    RETURN_IF_FAILED(m_pSections[sectionIndex].EnsureInitialized(m_pBaseFile, sectionIndex));
 
     *result = &m_pSections[sectionIndex];
     return S_OK;
@@ -615,7 +576,7 @@ const bool MrmFile::TryGetSectionIndexByType(
     if (m_pPriFileManager != nullptr)
     {
         int globalFileIndex;
-        if (FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex)))
+        if (FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex)))
         {
             return false;
         }
@@ -648,7 +609,7 @@ HRESULT MrmFile::GetAtomPoolSection(_In_ int fileIndex, _In_ BaseFile::SectionIn
     if (m_pPriFileManager)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetAtomPoolSection(globalFileIndex, sectionIndex, result));
     }
@@ -683,7 +644,7 @@ MrmFile::GetDecisionInfoSection(_In_ int fileIndex, _In_ BaseFile::SectionIndex
     if (m_pPriFileManager != nullptr)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetDecisionInfoSection(globalFileIndex, sectionIndex, result));
     }
@@ -722,7 +683,7 @@ HRESULT MrmFile::GetSchemaSection(_In_ int fileIndex, _In_ BaseFile::SectionInde
     if (m_pPriFileManager)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetSchemaSection(globalFileIndex, sectionIndex, result));
     }
@@ -760,7 +721,7 @@ HRESULT MrmFile::GetResourceMapSection(
     if (m_pPriFileManager)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetResourceMapSection(pSchemaCollection, globalFileIndex, sectionIndex, result));
     }
@@ -798,7 +759,7 @@ HRESULT MrmFile::GetPriDescriptorSection(
     if (m_pPriFileManager)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetPriDescriptorSection(pSchemaCollection, globalFileIndex, sectionIndex, result));
     }
@@ -832,7 +793,7 @@ HRESULT MrmFile::GetFileListSection(_In_ int fileIndex, _In_ BaseFile::SectionIn
     if (m_pPriFileManager)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetFileListSection(globalFileIndex, sectionIndex, result));
     }
@@ -867,7 +828,7 @@ MrmFile::GetDataItemsSection(_In_ int fileIndex, _In_ BaseFile::SectionIndex sec
     if (m_pPriFileManager)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetDataItemsSection(globalFileIndex, sectionIndex, result));
     }
@@ -901,7 +862,7 @@ HRESULT MrmFile::GetDataSection(_In_ int fileIndex, _In_ BaseFile::SectionIndex
     if (m_pPriFileManager)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetDataSection(globalFileIndex, sectionIndex, result));
     }
@@ -935,7 +896,7 @@ HRESULT MrmFile::GetReverseFileMapSection(_In_ int fileIndex, _In_ BaseFile::Sec
     if (m_pPriFileManager)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetReverseFileMapSection(globalFileIndex, sectionIndex, result));
     }
@@ -972,7 +933,7 @@ HRESULT MrmFile::GetEnvironmentMappingSection(
     if (m_pPriFileManager != nullptr)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetEnvironmentMappingSection(globalFileIndex, sectionIndex, result));
     }
@@ -1010,7 +971,7 @@ HRESULT MrmFile::GetResourceLinkSection(
     if (m_pPriFileManager != nullptr)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetResourceLinkSection(schemas, globalFileIndex, sectionIndex, result));
     }
@@ -1052,7 +1013,7 @@ HRESULT MrmFile::GetFileDefaultEnvironment(
     if (m_pPriFileManager != nullptr)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetFileDefaultEnvironment(globalFileIndex, fileEnvironmentName, fileEnvironmentVersion));
     }
@@ -1125,7 +1086,7 @@ HRESULT MrmFile::GetDefaultQualifierMapping(_In_ int fileIndex, _Out_ const Rema
     if (m_pPriFileManager != nullptr)
     {
         int globalFileIndex;
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
 
         RETURN_IF_FAILED(m_pPriFileManager->GetDefaultQualifierMapping(globalFileIndex, result));
     }
@@ -1141,8 +1102,61 @@ HRESULT MrmFile::ResolveFileFileList(_In_ const FileFileList* pFileFileList)
 {
     RETURN_HR_IF_NULL(E_DEF_NOT_READY, m_pFileResolver);
 
+    AutoReaderWriterLock autoLock(&m_fileListLock);
     RETURN_IF_FAILED(m_pFileResolver->AddReferencedFileInFileList(pFileFileList));
+    m_bFileListResolved = true;
+
+    return S_OK;
+}
+
+HRESULT MrmFile::EnsureFileListResolved() const
+{
+    {
+        AutoReaderWriterLock autoLock(&m_fileListLock, true);
+        if (m_bFileListResolved)
+        {
+            return S_OK;
+        }
+    }
+
+    AutoReaderWriterLock autoLock(&m_fileListLock);
+    if (m_bFileListResolved)
+    {
+        return S_OK;
+    }
+
+    // The descriptor was already read when the PriFile was created, so this only touches the file list itself.
+    BaseFile::SectionIndex descriptorSectionIndex = m_pBaseFile->GetFirstSectionIndex(gPriDescriptorExSectionType);
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), descriptorSectionIndex < 0);
+
+    PriDescriptor* pDescriptor;
+    RETURN_IF_FAILED(GetPriDescriptorSection(nullptr, 0, descriptorSectionIndex, &pDescriptor));
+
+    // No FileList section is normal for a non-merged PRI file.
+    const FileFileList* pFileFileList = nullptr;
+    if (pDescriptor->GetNumReferencedFileSections() > 0)
+    {
+        // Other files may be resolving at the same time; PriFileManager serializes the changes to its file table.
+        RETURN_IF_FAILED(pDescriptor->GetReferencedFileSection(0, &pFileFileList));
+        RETURN_IF_FAILED(m_pFileResolver->AddReferencedFileInFileList(pFileFileList));
+    }
+
+    m_bFileListResolved = true;
+    return S_OK;
+}
+
+HRESULT MrmFile::GetGlobalFileIndex(_In_ int fileIndex, _Out_ int* pGlobalIndex) const
+{
+    *pGlobalIndex = -1;
+    RETURN_HR_IF_NULL(E_DEF_NOT_READY, m_pFileResolver);
+
+    // In lazy section load mode the referenced files are only added once something actually reaches into one of them.
+    if (m_pPriFileManager->IsLazySectionLoadEnabled())
+    {
+        RETURN_IF_FAILED(EnsureFileListResolved());
+    }
 
+    RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, pGlobalIndex));
     return S_OK;
 }
 
@@ -1167,7 +1181,7 @@ HRESULT MrmFile::GetAbsoluteFolderPath(_In_ int fileIndex, _Inout_ StringResult*
     }
     else
     {
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
     }
 
     RETURN_IF_FAILED(m_pPriFileManager->GetAbsoluteFolderPath(globalFileIndex, pStringResult));
@@ -1196,7 +1210,7 @@ HRESULT MrmFile::GetFilePath(_In_ int fileIndex, _Inout_ StringResult* pStringRe
     }
     else
     {
-        RETURN_IF_FAILED(m_pFileResolver->GetGlobalIndex(fileIndex, &globalFileIndex));
+        RETURN_IF_FAILED(GetGlobalFileIndex(fileIndex, &globalFileIndex));
     }
 
     RETURN_IF_FAILED(m_pPriFileManager->GetFilePath(globalFileIndex, pStringResult));
@@ -96,3 +96,34 @@ void LogErrorInMemory(HRESULT hr, ULONG line, _In_opt_ PCSTR filename, _In_opt_
 #else
 void LogErrorInMemory(HRESULT, ULONG, _In_ PCSTR, _In_ PCWSTR) {}
 #endif
+
+// Every resource lookup bumps one of these, so rather than have every thread contend on a single
+// pair of counters, they're striped over cache-line sized slots picked by processor and summed
+// when read.
+static const UINT32 c_numCacheCounterSlots = 16;
+
+struct ResolvedResourceCacheCounterSlot
+{
+    volatile LONG64 hits;
+    volatile LONG64 misses;
+    BYTE padding[SYSTEM_CACHE_ALIGNMENT_SIZE - (2 * sizeof(LONG64))];
+};
+
+static DECLSPEC_CACHEALIGN ResolvedResourceCacheCounterSlot s_resolvedResourceCacheCounters[c_numCacheCounterSlots];
+
+void LogResolvedResourceCacheLookup(bool bHit)
+{
+    ResolvedResourceCacheCounterSlot* pSlot = &s_resolvedResourceCacheCounters[GetCurrentProcessorNumber() % c_numCacheCounterSlots];
+    InterlockedIncrementNoFence64(bHit ? &pSlot->hits : &pSlot->misses);
+}
+
+void GetResolvedResourceCacheCounters(_Out_ UINT64* pHits, _Out_ UINT64* pMisses)
+{
+    *pHits = 0;
+    *pMisses = 0;
+    for (UINT32 i = 0; i < c_numCacheCounterSlots; i++)
+    {
+        *pHits += static_cast<UINT64>(ReadNoFence64(&s_resolvedResourceCacheCounters[i].hits));
+        *pMisses += static_cast<UINT64>(ReadNoFence64(&s_resolvedResourceCacheCounters[i].misses));
+    }
+}
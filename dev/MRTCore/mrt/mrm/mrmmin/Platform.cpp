@@ -679,6 +679,54 @@ extern "C"
         return S_OK;
     }
 
+    HRESULT
+    _DefGetFileIdentity(__in HANDLE hFile, __out DEF_FILE_IDENTITY* pIdentity)
+    {
+        NTSTATUS Status;
+        IO_STATUS_BLOCK IoStatusBlock;
+        FILE_STANDARD_INFORMATION StandardInfo;
+        FILE_BASIC_INFORMATION BasicInfo;
+        FILE_INTERNAL_INFORMATION InternalInfo;
+        union
+        {
+            FILE_FS_VOLUME_INFORMATION VolumeInfo;
+            BYTE Buffer[sizeof(FILE_FS_VOLUME_INFORMATION) + (MAX_PATH * sizeof(WCHAR))];
+        } Volume;
+
+        RtlZeroMemory(pIdentity, sizeof(*pIdentity));
+
+        Status = NtQueryInformationFile(hFile, &IoStatusBlock, &StandardInfo, sizeof(StandardInfo), FileStandardInformation);
+        if (NT_SUCCESS(Status))
+        {
+            Status = NtQueryInformationFile(hFile, &IoStatusBlock, &BasicInfo, sizeof(BasicInfo), FileBasicInformation);
+        }
+        if (NT_SUCCESS(Status))
+        {
+            Status = NtQueryInformationFile(hFile, &IoStatusBlock, &InternalInfo, sizeof(InternalInfo), FileInternalInformation);
+        }
+        if (NT_SUCCESS(Status))
+        {
+            // Only the serial number is needed, so a volume label too long for the buffer doesn't matter.
+            Status = NtQueryVolumeInformationFile(hFile, &IoStatusBlock, &Volume, sizeof(Volume), FileFsVolumeInformation);
+            if (Status == STATUS_BUFFER_OVERFLOW)
+            {
+                Status = STATUS_SUCCESS;
+            }
+        }
+
+        if (!NT_SUCCESS(Status))
+        {
+            return HRESULT_FROM_NT(Status);
+        }
+
+        pIdentity->volumeSerialNumber = Volume.VolumeInfo.VolumeSerialNumber;
+        pIdentity->fileIndex = static_cast<ULONGLONG>(InternalInfo.IndexNumber.QuadPart);
+        pIdentity->cbFile = StandardInfo.EndOfFile.QuadPart;
+        pIdentity->lastWriteTime = BasicInfo.LastWriteTime.QuadPart;
+
+        return S_OK;
+    }
+
     DEFRESULT
     _DefGetLastError()
     {
@@ -948,6 +996,8 @@ extern "C"
 
 #else // !DEF_RTL
 
+#include <intrin.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -1025,6 +1075,31 @@ extern "C"
         return S_OK;
     }
 
+    HRESULT
+    _DefGetFileIdentity(__in HANDLE hFile, __out DEF_FILE_IDENTITY* pIdentity)
+    {
+        if (pIdentity == nullptr)
+        {
+            return E_INVALIDARG;
+        }
+
+        ZeroMemory(pIdentity, sizeof(*pIdentity));
+
+        BY_HANDLE_FILE_INFORMATION info;
+        if (!GetFileInformationByHandle(hFile, &info))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        pIdentity->volumeSerialNumber = info.dwVolumeSerialNumber;
+        pIdentity->fileIndex = (static_cast<ULONGLONG>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+        pIdentity->cbFile = (static_cast<LONGLONG>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+        pIdentity->lastWriteTime =
+            (static_cast<LONGLONG>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+
+        return S_OK;
+    }
+
     DEFRESULT
     _DefGetLastError()
     {
@@ -1204,19 +1279,271 @@ extern "C"
     UINT32
     _DefComputeCrc32(__in UINT32 partialCrc, __in_bcount(cbBuf) const BYTE* pBuf, __in UINT32 cbBuf)
     {
-        UINT32 crc;
-        UINT32 i;
+        static const DEF_CRC32_IMPLEMENTATION implementation =
+            (_DefIsCrc32ImplementationSupported(DefCrc32Implementation_Hardware) ? DefCrc32Implementation_Hardware :
+                                                                                   DefCrc32Implementation_SliceBy8);
 
-        //
-        // Compute the CRC32 checksum.
-        //
+        return _DefComputeCrc32WithImplementation(implementation, partialCrc, pBuf, cbBuf);
+    }
 
-        crc = partialCrc ^ 0xffffffffL;
+    //
+    // Tables for slicing-by-8. Entry [k][i] is the CRC of byte i followed by k zero bytes, so eight
+    // table lookups advance the CRC over eight input bytes at once. Row 0 is gCrc32Table.
+    //
+    struct DefCrc32SliceTables
+    {
+        UINT32 table[8][256];
 
-        for (i = 0; i < cbBuf; i++)
+        constexpr DefCrc32SliceTables() : table()
+        {
+            for (UINT32 i = 0; i < 256; i++)
+            {
+                UINT32 val = i;
+                for (int k = 0; k < 8; k++)
+                {
+                    val = (val & 1) ? (0xedb88320L ^ (val >> 1)) : (val >> 1);
+                }
+                table[0][i] = val;
+            }
+
+            for (int slice = 1; slice < 8; slice++)
+            {
+                for (UINT32 i = 0; i < 256; i++)
+                {
+                    table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xff];
+                }
+            }
+        }
+    };
+
+    static constexpr DefCrc32SliceTables gCrc32SliceTables;
+
+    static inline UINT32 DefCrc32ReadUInt32(__in_bcount(4) const BYTE* pBuf)
+    {
+        return (static_cast<UINT32>(pBuf[0]) | (static_cast<UINT32>(pBuf[1]) << 8) | (static_cast<UINT32>(pBuf[2]) << 16) |
+                (static_cast<UINT32>(pBuf[3]) << 24));
+    }
+
+    // All of the helpers below take and return the running CRC without pre- or post-conditioning.
+    static UINT32 DefCrc32Bytewise(__in UINT32 crc, __in_bcount(cbBuf) const BYTE* pBuf, __in size_t cbBuf)
+    {
+        for (size_t i = 0; i < cbBuf; i++)
         {
             crc = gCrc32Table[(crc ^ pBuf[i]) & 0xff] ^ (crc >> 8);
         }
+        return crc;
+    }
+
+    static UINT32 DefCrc32SliceBy8(__in UINT32 crc, __in_bcount(cbBuf) const BYTE* pBuf, __in size_t cbBuf)
+    {
+        const UINT32(*t)[256] = gCrc32SliceTables.table;
+
+        while (cbBuf >= 8)
+        {
+            UINT32 lo = DefCrc32ReadUInt32(pBuf) ^ crc;
+            UINT32 hi = DefCrc32ReadUInt32(pBuf + 4);
+
+            crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^ t[3][hi & 0xff] ^
+                  t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+
+            pBuf += 8;
+            cbBuf -= 8;
+        }
+
+        return DefCrc32Bytewise(crc, pBuf, cbBuf);
+    }
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+    //
+    // Folds 64-byte blocks with carry-less multiplication, following "Fast CRC Computation for Generic
+    // Polynomials Using PCLMULQDQ Instruction" (Intel, 2009). The constants are x^(4*128+32), x^(4*128-32),
+    // x^(128+32) and x^(128-32) mod P, x^64 mod P, and the Barrett reduction constants, all bit-reflected
+    // for the ISO 3309 polynomial. Requires cbBuf >= 64 and a multiple of 16.
+    //
+    static UINT32 DefCrc32Pclmul(__in UINT32 crc, __in_bcount(cbBuf) const BYTE* pBuf, __in size_t cbBuf)
+    {
+        const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+        const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+        const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124);
+        const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+        const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+        __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x00));
+        __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x10));
+        __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x20));
+        __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x30));
+        __m128i x5;
+
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+        pBuf += 64;
+        cbBuf -= 64;
+
+        while (cbBuf >= 64)
+        {
+            __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+            __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+            __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+            x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+
+            x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x30)));
+
+            pBuf += 64;
+            cbBuf -= 64;
+        }
+
+        // Fold the four accumulators into one.
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+        // Fold any remaining 16-byte blocks.
+        while (cbBuf >= 16)
+        {
+            x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf))), x5);
+
+            pBuf += 16;
+            cbBuf -= 16;
+        }
+
+        // Reduce 128 bits to 64.
+        x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, mask32);
+        x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        // Barrett reduction to 32 bits.
+        x2 = _mm_and_si128(x1, mask32);
+        x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+        x2 = _mm_and_si128(x2, mask32);
+        x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        return static_cast<UINT32>(_mm_extract_epi32(x1, 1));
+    }
+
+    static BOOLEAN DefCrc32HardwareSupported()
+    {
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 1);
+
+        // PCLMULQDQ is ECX bit 1 and SSE4.1 (for _mm_extract_epi32) is ECX bit 19.
+        return ((cpuInfo[2] & (1 << 1)) != 0) && ((cpuInfo[2] & (1 << 19)) != 0);
+    }
+
+    static UINT32 DefCrc32Hardware(__in UINT32 crc, __in_bcount(cbBuf) const BYTE* pBuf, __in size_t cbBuf)
+    {
+        if (cbBuf >= 64)
+        {
+            size_t cbFolded = cbBuf & ~static_cast<size_t>(15);
+            crc = DefCrc32Pclmul(crc, pBuf, cbFolded);
+            pBuf += cbFolded;
+            cbBuf -= cbFolded;
+        }
+        return DefCrc32SliceBy8(crc, pBuf, cbBuf);
+    }
+
+#elif defined(_M_ARM64)
+
+    // The ARMv8 CRC32 instructions (as opposed to CRC32C) use the ISO 3309 polynomial.
+    static BOOLEAN DefCrc32HardwareSupported()
+    {
+#ifdef PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE
+        return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) ? TRUE : FALSE;
+#else
+        return FALSE;
+#endif
+    }
+
+    static UINT32 DefCrc32Hardware(__in UINT32 crc, __in_bcount(cbBuf) const BYTE* pBuf, __in size_t cbBuf)
+    {
+        while (cbBuf >= 8)
+        {
+            unsigned __int64 data =
+                (static_cast<unsigned __int64>(DefCrc32ReadUInt32(pBuf + 4)) << 32) | DefCrc32ReadUInt32(pBuf);
+            crc = __crc32d(crc, data);
+            pBuf += 8;
+            cbBuf -= 8;
+        }
+
+        while (cbBuf > 0)
+        {
+            crc = __crc32b(crc, *pBuf);
+            pBuf++;
+            cbBuf--;
+        }
+        return crc;
+    }
+
+#else
+
+    static BOOLEAN DefCrc32HardwareSupported() { return FALSE; }
+
+    static UINT32 DefCrc32Hardware(__in UINT32 crc, __in_bcount(cbBuf) const BYTE* pBuf, __in size_t cbBuf)
+    {
+        return DefCrc32SliceBy8(crc, pBuf, cbBuf);
+    }
+
+#endif
+
+    BOOLEAN
+    _DefIsCrc32ImplementationSupported(__in DEF_CRC32_IMPLEMENTATION implementation)
+    {
+        switch (implementation)
+        {
+        case DefCrc32Implementation_Bytewise:
+        case DefCrc32Implementation_SliceBy8:
+            return TRUE;
+        case DefCrc32Implementation_Hardware:
+            return DefCrc32HardwareSupported();
+        default:
+            return FALSE;
+        }
+    }
+
+    UINT32
+    _DefComputeCrc32WithImplementation(
+        __in DEF_CRC32_IMPLEMENTATION implementation,
+        __in UINT32 partialCrc,
+        __in_bcount(cbBuf) const BYTE* pBuf,
+        __in UINT32 cbBuf)
+    {
+        UINT32 crc = partialCrc ^ 0xffffffffL;
+
+        // An unsupported hardware request falls back to slicing-by-8.
+        if (implementation == DefCrc32Implementation_Bytewise)
+        {
+            crc = DefCrc32Bytewise(crc, pBuf, cbBuf);
+        }
+        else if ((implementation == DefCrc32Implementation_Hardware) && DefCrc32HardwareSupported())
+        {
+            crc = DefCrc32Hardware(crc, pBuf, cbBuf);
+        }
+        else
+        {
+            crc = DefCrc32SliceBy8(crc, pBuf, cbBuf);
+        }
 
         return (crc ^ 0xffffffffL);
     }
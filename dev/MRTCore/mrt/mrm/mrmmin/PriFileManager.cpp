@@ -18,12 +18,32 @@ HRESULT PriFileManager::CreateInstance(_In_ UnifiedEnvironment* pEnvironment, _O
     return S_OK;
 }
 
+bool PriFileManager::TryGetFileInfo(_In_ int index, _Out_ FileManagerFileInfo* finfo) const
+{
+    AutoReaderWriterLock autoLock(&m_filesLock, true);
+    return m_pFiles->TryGet(index, finfo);
+}
+
+ManagedFile* PriFileManager::FindFileLocked(_In_ const NormalizedFilePath* pNormalizedPath) const
+{
+    FileManagerFileInfo finfo;
+    for (int i = 0; i < m_pFiles->Count(); i++)
+    {
+        if (m_pFiles->TryGet(i, &finfo) && (finfo.pFile != nullptr) &&
+            (DefString_ICompare(pNormalizedPath->GetRef(), finfo.pFile->GetPath()) == Def_Equal))
+        {
+            return finfo.pFile;
+        }
+    }
+    return nullptr;
+}
+
 HRESULT PriFileManager::GetFile(_In_ int index, _Out_ ManagedFile** result) const
 {
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(index, &finfo))
+    if (TryGetFileInfo(index, &finfo))
     {
         *result = finfo.pFile;
         return S_OK;
@@ -35,19 +55,10 @@ HRESULT PriFileManager::GetFile(_In_ const NormalizedFilePath* pNormalizedPath,
 {
     *result = nullptr;
 
-    ManagedFile* pRtrn = nullptr;
-    // See if we already have the file
-    for (int i = 0; i < m_pFiles->Count(); i++)
-    {
-        GetFile(i, &pRtrn);
-        if ((pRtrn != nullptr) && (DefString_ICompare(pNormalizedPath->GetRef(), pRtrn->GetPath()) == Def_Equal))
-        {
-            *result = pRtrn;
-            return S_OK;
-        }
-    }
+    AutoReaderWriterLock autoLock(&m_filesLock, true);
+    *result = FindFileLocked(pNormalizedPath);
 
-    return E_INVALIDARG;
+    return (*result != nullptr) ? S_OK : E_INVALIDARG;
 }
 
 HRESULT PriFileManager::GetFile(_In_ PCWSTR pFilePath, _Out_ ManagedFile** result) const
@@ -73,53 +84,49 @@ HRESULT PriFileManager::GetOrAddFile(
     RETURN_HR_IF_NULL(E_INVALIDARG, pNormalizedPath);
     RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pNormalizedPath->GetRef()));
 
-    FileManagerFileInfo finfo;
     StringResult rootPath;
     ManagedFile* pRtrn = nullptr;
 
     RETURN_IF_FAILED(ManagedFile::NormalizePackageRoot(pNormalizedPath->GetRef(), pPackageRoot, &rootPath));
 
     // See if we already have the file
-    for (int i = 0; i < m_pFiles->Count(); i++)
     {
-        if (m_pFiles->TryGet(i, &finfo))
-        {
-            pRtrn = finfo.pFile;
-        }
-        else
-        {
-            pRtrn = nullptr;
-        }
-        if ((pRtrn != nullptr) && (DefString_ICompare(pNormalizedPath->GetRef(), pRtrn->GetPath()) == Def_Equal))
+        AutoReaderWriterLock autoLock(&m_filesLock, true);
+        pRtrn = FindFileLocked(pNormalizedPath);
+    }
+
+    AutoDeletePtr<ManagedFile> pNewFile;
+    if (pRtrn == nullptr)
+    {
+        // not found - create a new file. This happens outside the lock because loading it can add the files it references.
+        int index = -1;
+        RETURN_IF_FAILED_WITH_EXPECTED(
+            ManagedFile::CreateInstance(this, index, pNormalizedPath, rootPath.GetRef(), flags, &pNewFile),
+            HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND),
+            HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND));
+
+        AutoReaderWriterLock autoLock(&m_filesLock);
+
+        // Another thread may have added the same file in the meantime, in which case the new one is discarded.
+        pRtrn = FindFileLocked(pNormalizedPath);
+        if (pRtrn == nullptr)
         {
-            RETURN_IF_FAILED(pRtrn->SetPackageRoot(rootPath.GetRef()));
+            FileManagerFileInfo finfo;
+            finfo.pFile = pNewFile;
+            RETURN_IF_FAILED(m_pFiles->Add(finfo, &index));
 
-            if ((flags & LoadPriFlags::Preload) == LoadPriFlags::Preload)
-            {
-                RETURN_IF_FAILED(pRtrn->Load());
-            }
-            *result = pRtrn;
+            pNewFile->SetGlobalIndex(index);
+            *result = pNewFile.Detach();
             return S_OK;
         }
     }
 
-    // not found - create a new file
-    int index = -1;
-    RETURN_IF_FAILED_WITH_EXPECTED(
-        ManagedFile::CreateInstance(this, index, pNormalizedPath, rootPath.GetRef(), flags, &pRtrn),
-        HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND),
-        HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND));
-
-    finfo.pFile = pRtrn;
+    RETURN_IF_FAILED(pRtrn->SetPackageRoot(rootPath.GetRef()));
 
-    HRESULT hr = m_pFiles->Add(finfo, &index);
-    if (FAILED(hr))
+    if ((flags & LoadPriFlags::Preload) == LoadPriFlags::Preload)
     {
-        delete pRtrn;
-        return hr;
+        RETURN_IF_FAILED(pRtrn->Load());
     }
-
-    pRtrn->SetGlobalIndex(index);
     *result = pRtrn;
 
     return S_OK;
@@ -151,44 +158,31 @@ HRESULT PriFileManager::AddFile(
     RETURN_HR_IF_NULL(E_INVALIDARG, pNormalizedPath);
     RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pNormalizedPath->GetRef()));
 
-    FileManagerFileInfo finfo;
     StringResult rootPath;
-    ManagedFile* pRtrn = nullptr;
 
     RETURN_IF_FAILED(ManagedFile::NormalizePackageRoot(pNormalizedPath->GetRef(), pPackageRoot, &rootPath));
 
     // See if we already have the file
-    for (int i = 0; i < m_pFiles->Count(); i++)
     {
-        if (m_pFiles->TryGet(i, &finfo))
-        {
-            pRtrn = finfo.pFile;
-        }
-        else
-        {
-            pRtrn = nullptr;
-        }
-        if ((pRtrn != nullptr) && (DefString_ICompare(pNormalizedPath->GetRef(), pRtrn->GetPath()) == Def_Equal))
-        {
-            return HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY);
-        }
+        AutoReaderWriterLock autoLock(&m_filesLock, true);
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY), FindFileLocked(pNormalizedPath) != nullptr);
     }
 
     // not found - create a new file
     int index = -1;
+    AutoDeletePtr<ManagedFile> pRtrn;
     RETURN_IF_FAILED(ManagedFile::CreateInstance(
         this, index, pNormalizedPath, rootPath.GetRef(), fPreload ? LoadPriFlags::Preload : LoadPriFlags::Default, &pRtrn));
 
+    AutoReaderWriterLock autoLock(&m_filesLock);
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY), FindFileLocked(pNormalizedPath) != nullptr);
+
+    FileManagerFileInfo finfo;
     finfo.pFile = pRtrn;
+    RETURN_IF_FAILED(m_pFiles->Add(finfo, &index));
 
-    HRESULT hr = m_pFiles->Add(finfo, &index);
-    if (FAILED(hr))
-    {
-        delete pRtrn;
-        return hr;
-    }
     pRtrn->SetGlobalIndex(index);
-    *result = pRtrn;
+    *result = pRtrn.Detach();
 
     return S_OK;
 }
@@ -221,6 +215,8 @@ HRESULT PriFileManager::InsertFile(
     RETURN_IF_FAILED(
         ManagedFile::CreateInstance(this, newIndex, pPath, pPackageRoot, fPreload ? LoadPriFlags::Preload : LoadPriFlags::Default, &pRtrn));
 
+    AutoReaderWriterLock autoLock(&m_filesLock);
+
     FileManagerFileInfo finfo;
     finfo.pFile = pRtrn;
     // Insert move all contents to
@@ -231,10 +227,9 @@ HRESULT PriFileManager::InsertFile(
     // Adjust ManagedFile global index by its new index in the m_pFiles
     for (int i = newIndex + 1; i < m_pFiles->Count(); i++)
     {
-        ManagedFile* pManagedFile;
-        RETURN_IF_FAILED(GetFile(i, &pManagedFile));
+        RETURN_HR_IF(E_INVALIDARG, !m_pFiles->TryGet(i, &finfo));
 
-        pManagedFile->SetGlobalIndex(i);
+        finfo.pFile->SetGlobalIndex(i);
     }
 
     *result = mf;
@@ -247,7 +242,7 @@ HRESULT PriFileManager::LoadFile(_In_ const ManagedFile* pFile)
     RETURN_HR_IF(E_MRM_PRI_MANAGER_MISMATCH, pFile->GetFileManager() != this);
 
     FileManagerFileInfo finfo;
-    if ((!m_pFiles->TryGet(pFile->GetGlobalIndex(), &finfo)) || (finfo.pFile != pFile))
+    if ((!TryGetFileInfo(pFile->GetGlobalIndex(), &finfo)) || (finfo.pFile != pFile))
     {
         return E_MRM_PRI_MANAGER_MISMATCH;
     }
@@ -261,7 +256,7 @@ HRESULT PriFileManager::UnloadFile(_In_ const ManagedFile* pFile)
     RETURN_HR_IF(E_MRM_PRI_MANAGER_MISMATCH, pFile->GetFileManager() != this);
 
     FileManagerFileInfo finfo;
-    if ((!m_pFiles->TryGet(pFile->GetGlobalIndex(), &finfo)) || (finfo.pFile != pFile))
+    if ((!TryGetFileInfo(pFile->GetGlobalIndex(), &finfo)) || (finfo.pFile != pFile))
     {
         return E_MRM_PRI_MANAGER_MISMATCH;
     }
@@ -275,13 +270,16 @@ HRESULT PriFileManager::RemoveFile(_In_ const ManagedFile* pFile)
     RETURN_HR_IF(E_MRM_PRI_MANAGER_MISMATCH, pFile->GetFileManager() != this);
 
     FileManagerFileInfo finfo;
-    if ((!m_pFiles->TryGet(pFile->GetGlobalIndex(), &finfo)) || (finfo.pFile != pFile))
     {
-        return E_MRM_PRI_MANAGER_MISMATCH;
-    }
+        AutoReaderWriterLock autoLock(&m_filesLock);
+        if ((!m_pFiles->TryGet(pFile->GetGlobalIndex(), &finfo)) || (finfo.pFile != pFile))
+        {
+            return E_MRM_PRI_MANAGER_MISMATCH;
+        }
 
-    FileManagerFileInfo finfoNull = {};
-    RETURN_IF_FAILED(m_pFiles->Set(pFile->GetGlobalIndex(), finfoNull));
+        FileManagerFileInfo finfoNull = {};
+        RETURN_IF_FAILED(m_pFiles->Set(pFile->GetGlobalIndex(), finfoNull));
+    }
 
     delete finfo.pFile;
     return S_OK;
@@ -304,7 +302,7 @@ HRESULT PriFileManager::GetSection(
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetSection(pSchemaCollection, 0, sectionIndex, result);
     }
@@ -319,7 +317,7 @@ const bool PriFileManager::TryGetSectionIndexByType(
     _Out_ int* nextSectionIndex) const
 {
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->TryGetSectionIndexByType(sectionType, 0, startAtSectionIndex, nextSectionIndex);
     }
@@ -332,7 +330,7 @@ HRESULT PriFileManager::GetAtomPoolSection(_In_ int fileIndex, _In_ BaseFile::Se
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetAtomPoolSection(0, sectionIndex, result);
     }
@@ -348,7 +346,7 @@ HRESULT PriFileManager::GetDecisionInfoSection(
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetDecisionInfoSection(0, sectionIndex, result);
     }
@@ -361,7 +359,7 @@ PriFileManager::GetSchemaSection(_In_ int fileIndex, _In_ BaseFile::SectionIndex
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetSchemaSection(0, sectionIndex, result);
     }
@@ -378,7 +376,7 @@ HRESULT PriFileManager::GetResourceMapSection(
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetResourceMapSection(pSchemaCollection, 0, sectionIndex, result);
     }
@@ -395,7 +393,7 @@ HRESULT PriFileManager::GetPriDescriptorSection(
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetPriDescriptorSection(pSchemaCollection, 0, sectionIndex, result);
     }
@@ -408,7 +406,7 @@ HRESULT PriFileManager::GetFileListSection(_In_ int fileIndex, _In_ BaseFile::Se
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetFileListSection(0, sectionIndex, result);
     }
@@ -422,7 +420,7 @@ PriFileManager::GetDataItemsSection(_In_ int fileIndex, _In_ BaseFile::SectionIn
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetDataItemsSection(0, sectionIndex, result);
     }
@@ -435,7 +433,7 @@ HRESULT PriFileManager::GetDataSection(_In_ int fileIndex, _In_ BaseFile::Sectio
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetDataSection(0, sectionIndex, result);
     }
@@ -449,7 +447,7 @@ PriFileManager::GetReverseFileMapSection(_In_ int fileIndex, _In_ BaseFile::Sect
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetReverseFileMapSection(0, sectionIndex, result);
     }
@@ -465,7 +463,7 @@ HRESULT PriFileManager::GetEnvironmentMappingSection(
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetEnvironmentMappingSection(0, sectionIndex, result);
     }
@@ -482,7 +480,7 @@ HRESULT PriFileManager::GetResourceLinkSection(
     *result = nullptr;
 
     FileManagerFileInfo finfo;
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetResourceLinkSection(schemas, 0, sectionIndex, result);
     }
@@ -493,7 +491,7 @@ HRESULT PriFileManager::GetResourceLinkSection(
 HRESULT PriFileManager::GetAbsoluteFolderPath(_In_ int fileIndex, _Inout_ StringResult* pStringResult) const
 {
     FileManagerFileInfo finfo;
-    if (!m_pFiles->TryGet(fileIndex, &finfo))
+    if (!TryGetFileInfo(fileIndex, &finfo))
     {
         return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
     }
@@ -511,7 +509,7 @@ HRESULT PriFileManager::GetAbsoluteFolderPath(_In_ int fileIndex, _Inout_ String
 HRESULT PriFileManager::GetFilePath(_In_ int fileIndex, _Inout_ StringResult* pStringResult) const
 {
     FileManagerFileInfo finfo;
-    if (!m_pFiles->TryGet(fileIndex, &finfo))
+    if (!TryGetFileInfo(fileIndex, &finfo))
     {
         return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
     }
@@ -533,7 +531,7 @@ HRESULT PriFileManager::GetFileDefaultEnvironment(
 {
     FileManagerFileInfo finfo;
 
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         return finfo.pFile->GetFileDefaultEnvironment(0, fileEnvironmentName, fileEnvironmentVersion);
     }
@@ -546,7 +544,7 @@ HRESULT PriFileManager::GetDefaultQualifierMapping(_In_ int fileIndex, _Out_ con
     *result = nullptr;
     FileManagerFileInfo finfo;
 
-    if (m_pFiles->TryGet(fileIndex, &finfo) && (finfo.pFile != nullptr))
+    if (TryGetFileInfo(fileIndex, &finfo) && (finfo.pFile != nullptr))
     {
         RETURN_IF_FAILED(finfo.pFile->GetDefaultQualifierMapping(0, result));
     }
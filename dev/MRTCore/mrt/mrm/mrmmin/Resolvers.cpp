@@ -2,10 +2,88 @@
 // Licensed under the MIT License. See LICENSE in the project root for license information.
 
 #include "stdafx.h"
+#include <mrm\common\mrmtracelogging.h>
 
 namespace Microsoft::Resources
 {
 
+// Interned copies of qualifier values.  Equal values share a single copy, and copies live as long as the
+// table, so a value handed out by reference stays valid after the qualifier that produced it is reset.
+class QualifierValueTable : public DefObject
+{
+public:
+    static HRESULT CreateInstance(_Outptr_ QualifierValueTable** result)
+    {
+        *result = nullptr;
+
+        AutoDeletePtr<QualifierValueTable> pRtrn = new QualifierValueTable();
+        RETURN_IF_NULL_ALLOC(pRtrn);
+        RETURN_IF_FAILED(DynamicArray<PWSTR>::CreateInstance(InitialSize, &pRtrn->m_pValues));
+
+        *result = pRtrn.Detach();
+        return S_OK;
+    }
+
+    ~QualifierValueTable()
+    {
+        if (m_pValues)
+        {
+            for (int i = 0; i < m_pValues->Count(); i++)
+            {
+                PWSTR pValue;
+                if (SUCCEEDED(m_pValues->Get(i, &pValue)))
+                {
+                    Def_Free(pValue);
+                }
+            }
+        }
+
+        delete m_pValues;
+        m_pValues = nullptr;
+    }
+
+    HRESULT Intern(_In_ PCWSTR pValue, _Outptr_ PWSTR* result)
+    {
+        *result = nullptr;
+        RETURN_HR_IF_NULL(E_INVALIDARG, pValue);
+
+        AutoReaderWriterLock autoLock(&m_srwLock);
+
+        // A resolver only ever sees a handful of distinct values for its thread aware qualifiers, and
+        // values are only interned when they change, so a scan is enough.
+        for (int i = 0; i < m_pValues->Count(); i++)
+        {
+            PWSTR pInterned;
+            if (SUCCEEDED(m_pValues->Get(i, &pInterned)) && (DefString_Compare(pValue, pInterned) == Def_Equal))
+            {
+                *result = pInterned;
+                return S_OK;
+            }
+        }
+
+        PWSTR pCopy;
+        RETURN_IF_FAILED(DefString_Dup(pValue, &pCopy));
+
+        HRESULT hr = m_pValues->Add(pCopy);
+        if (FAILED(hr))
+        {
+            Def_Free(pCopy);
+            return hr;
+        }
+
+        *result = pCopy;
+        return S_OK;
+    }
+
+private:
+    static const UINT InitialSize = 4;
+
+    QualifierValueTable() : m_pValues(nullptr) { _DefInitializeSRWLock(&m_srwLock); }
+
+    DynamicArray<PWSTR>* m_pValues;
+    _DEF_SRWLOCK m_srwLock;
+};
+
 class PerThreadQualifier : public DefObject
 {
 public:
@@ -29,30 +107,29 @@ public:
 
     ~PerThreadQualifier()
     {
-        for (int i = 0; i < m_qualifierCaches->Count(); i++)
-        {
-            StringResult* pStrResult;
-            if (SUCCEEDED(m_qualifierCaches->Get(i, &pStrResult)))
-            {
-                delete pStrResult;
-            }
-        }
+        Def_Free(m_pSlotForName);
+        m_pSlotForName = nullptr;
+
+        delete[] m_pSlotNames;
+        m_pSlotNames = nullptr;
+
+        Def_Free(m_pSlotValues);
+        m_pSlotValues = nullptr;
 
-        delete m_qualifierCaches;
-        m_qualifierCaches = nullptr;
+        delete m_pValueTable;
+        m_pValueTable = nullptr;
     }
 
-    int GetNumPerThreadQualifiers() const { return m_pProfile->GetNumThreadAwareQualifiers(); }
+    int GetNumPerThreadQualifiers() const { return m_numSlots; }
 
     HRESULT GetQualifierPerThread(_In_ int index, _Out_ Atom* pAtom)
     {
-        RETURN_HR_IF(E_INVALIDARG, index >= GetNumPerThreadQualifiers());
+        RETURN_HR_IF(E_INVALIDARG, (index < 0) || (index >= m_numSlots));
 
-        StringResult strQualiferName;
-        RETURN_IF_FAILED(m_pProfile->GetThreadAwareQualifierName(index, &strQualiferName));
-
-        RETURN_IF_FAILED(m_Environment->GetQualifierNameAtom(strQualiferName.GetRef(), pAtom, nullptr));
+        // The name wasn't in the environment when the resolver was created.
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_NOT_FOUND), m_pSlotNames[index].IsNull());
 
+        *pAtom = m_pSlotNames[index];
         return S_OK;
     }
 
@@ -63,49 +140,43 @@ public:
 
     HRESULT GetQualifierValue(_In_ int index, _Inout_ StringResult* pStringResult)
     {
-        RETURN_HR_IF(E_INVALIDARG, index >= GetNumPerThreadQualifiers());
+        RETURN_HR_IF(E_INVALIDARG, (index < 0) || (index >= m_numSlots));
 
-        StringResult* pStrValue = nullptr;
-        if (!m_qualifierCaches->TryGet(index, &pStrValue))
+        PWSTR pValue = static_cast<PWSTR>(ReadPointerAcquire(reinterpret_cast<PVOID const volatile*>(&m_pSlotValues[index])));
+        if (pValue == nullptr)
         {
             Atom name;
             AutoDeletePtr<IQualifierValueProvider> pProvider;
             RETURN_IF_FAILED(GetQualifierPerThread(index, &name));
             RETURN_IF_FAILED(GetProvider(name, &pProvider));
 
-            AutoDeletePtr<StringResult> strValue = new StringResult();
-            RETURN_IF_NULL_ALLOC(strValue);
-
-            RETURN_IF_FAILED(pProvider->GetQualifierValue(name, nullptr, strValue));
+            StringResult strValue;
+            RETURN_IF_FAILED(pProvider->GetQualifierValue(name, nullptr, &strValue));
+            RETURN_IF_FAILED(m_pValueTable->Intern(strValue.GetRef(), &pValue));
 
-            RETURN_IF_FAILED(m_qualifierCaches->SetExtent(index));
-            RETURN_IF_FAILED(m_qualifierCaches->Insert(strValue, index));
-
-            pStrValue = strValue.Detach();
+            // Threads that race to fill the slot all store the same interned pointer.
+            WritePointerRelease(reinterpret_cast<PVOID volatile*>(&m_pSlotValues[index]), pValue);
         }
 
-        RETURN_IF_FAILED(pStringResult->SetRef(pStrValue->GetRef()));
+        RETURN_IF_FAILED(pStringResult->SetRef(pValue));
 
         return S_OK;
     }
 
     HRESULT GetQualifierValue(_In_ Atom name, _Inout_ StringResult* pStringResult)
     {
-        Atom localName;
-        for (int i = 0; i < GetNumPerThreadQualifiers(); i++)
+        int index;
+        if (!TryGetSlot(name, &index))
         {
-            if (SUCCEEDED(GetQualifierPerThread(i, &localName)) && (localName == name))
-            {
-                return GetQualifierValue(i, pStringResult);
-            }
+            return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
         }
 
-        return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        return GetQualifierValue(index, pStringResult);
     }
 
     HRESULT ValueIsSameAsParent(_In_ int index, _Out_ bool* pbSameValue)
     {
-        RETURN_HR_IF(E_INVALIDARG, index >= GetNumPerThreadQualifiers());
+        RETURN_HR_IF(E_INVALIDARG, (index < 0) || (index >= m_numSlots));
 
         Atom name;
         StringResult strParentValue;
@@ -131,48 +202,35 @@ public:
         return S_OK;
     }
 
+    // Interned values stay in the value table, so clearing a slot never frees a string that a
+    // caller might still be holding.
     void ResetCache()
     {
-        if (m_qualifierCaches)
+        for (int i = 0; i < m_numSlots; i++)
         {
-            for (int i = 0; i < m_qualifierCaches->Count(); i++)
-            {
-                StringResult* pStrResult;
-                m_qualifierCaches->Get(i, &pStrResult);
-                if (pStrResult)
-                {
-                    delete pStrResult;
-                }
-            }
-            m_qualifierCaches->Reset();
+            WritePointerRelease(reinterpret_cast<PVOID volatile*>(&m_pSlotValues[i]), nullptr);
         }
     }
 
     void ResetCache(_In_ Atom qualifierToReset)
     {
-        if (m_qualifierCaches)
+        int index;
+        if (TryGetSlot(qualifierToReset, &index))
         {
-            Atom localName;
-            int numThreadQualifiers = GetNumPerThreadQualifiers();
-            for (int i = 0; i < numThreadQualifiers; i++)
-            {
-                if (SUCCEEDED(GetQualifierPerThread(i, &localName)) && (localName == qualifierToReset))
-                {
-
-                    StringResult* pStrResult;
-                    m_qualifierCaches->Get(i, &pStrResult);
-                    if (pStrResult)
-                    {
-                        delete pStrResult;
-                        m_qualifierCaches->Delete(i);
-                    }
-                }
-            }
+            WritePointerRelease(reinterpret_cast<PVOID volatile*>(&m_pSlotValues[index]), nullptr);
         }
     }
 
 private:
-    PerThreadQualifier() : m_qualifierCaches(nullptr) {}
+    PerThreadQualifier() :
+        m_numSlots(0),
+        m_namePoolIndex(Atom::PoolIndexNone),
+        m_numNames(0),
+        m_pSlotForName(nullptr),
+        m_pSlotNames(nullptr),
+        m_pSlotValues(nullptr),
+        m_pValueTable(nullptr)
+    {}
 
     HRESULT Init(_In_ const CoreProfile* pProfile, _In_ const UnifiedEnvironment* pEnvironment, _In_ const IResolver* pParentResolver)
     {
@@ -180,17 +238,71 @@ private:
         m_Environment = pEnvironment;
         m_pParentResolver = pParentResolver;
 
-        DEF_ASSERT(pProfile->GetNumThreadAwareQualifiers() != 0); // the class shoud not be created for 0 thread aware qualifiers
+        m_numSlots = pProfile->GetNumThreadAwareQualifiers();
+        DEF_ASSERT(m_numSlots != 0); // the class shoud not be created for 0 thread aware qualifiers
+
+        const IAtomPool* pNames = pEnvironment->GetDefaultEnvironment()->GetQualifierNames();
+        m_namePoolIndex = pNames->GetPoolIndex();
+        m_numNames = pNames->GetNumAtoms();
 
-        RETURN_IF_FAILED(DynamicArray<StringResult*>::CreateInstance(pProfile->GetNumThreadAwareQualifiers(), &m_qualifierCaches));
+        m_pSlotForName = _DefArray_AllocZeroed(int, m_numNames);
+        RETURN_IF_NULL_ALLOC(m_pSlotForName);
+
+        m_pSlotNames = new Atom[m_numSlots];
+        RETURN_IF_NULL_ALLOC(m_pSlotNames);
+
+        m_pSlotValues = _DefArray_AllocZeroed(PWSTR, m_numSlots);
+        RETURN_IF_NULL_ALLOC(m_pSlotValues);
+
+        RETURN_IF_FAILED(QualifierValueTable::CreateInstance(&m_pValueTable));
+
+        // Map each thread aware qualifier name to its slot so lookups by name are a single index.
+        for (int i = 0; i < m_numSlots; i++)
+        {
+            StringResult strQualiferName;
+            RETURN_IF_FAILED(pProfile->GetThreadAwareQualifierName(i, &strQualiferName));
+
+            Atom name;
+            if (FAILED(pEnvironment->GetQualifierNameAtom(strQualiferName.GetRef(), &name, nullptr)))
+            {
+                m_pSlotNames[i] = Atom::NullAtom;
+                continue;
+            }
+
+            m_pSlotNames[i] = name;
+            if ((name.GetPoolIndex() == m_namePoolIndex) && (name.GetIndex() >= 0) && (name.GetIndex() < m_numNames))
+            {
+                m_pSlotForName[name.GetIndex()] = i + 1;
+            }
+        }
 
         return S_OK;
     }
 
+    bool TryGetSlot(_In_ Atom name, _Out_ int* pIndex) const
+    {
+        *pIndex = -1;
+        if ((name.GetPoolIndex() != m_namePoolIndex) || (name.GetIndex() < 0) || (name.GetIndex() >= m_numNames) ||
+            (m_pSlotForName[name.GetIndex()] == 0))
+        {
+            return false;
+        }
+
+        *pIndex = m_pSlotForName[name.GetIndex()] - 1;
+        return true;
+    }
+
     const UnifiedEnvironment* m_Environment;
     const CoreProfile* m_pProfile;
     const IResolver* m_pParentResolver;
-    DynamicArray<StringResult*>* m_qualifierCaches;
+
+    int m_numSlots;
+    Atom::PoolIndex m_namePoolIndex;
+    int m_numNames;
+    __ecount(m_numNames) int* m_pSlotForName; // thread aware slot plus one for each qualifier name, or 0
+    __ecount(m_numSlots) Atom* m_pSlotNames;
+    __ecount(m_numSlots) PWSTR volatile* m_pSlotValues; // interned value for each slot, or null until first read
+    QualifierValueTable* m_pValueTable;
 };
 
 class ResolverBase::DecisionInfoCache : public DefObject
@@ -212,7 +324,35 @@ public:
         return S_OK;
     }
 
-    ~DecisionInfoCache() {}
+    ~DecisionInfoCache()
+    {
+        FreeSlotTables(m_pQualifierSlots);
+        FreeSlotTables(m_pQualifierSetSlots);
+
+        DecisionTable* pTable = m_pDecisionTable;
+        if (pTable != nullptr)
+        {
+            // Tables that were replaced share their entries with the current one.
+            for (UINT32 i = 0; i < pTable->numEntries; i++)
+            {
+                _DefFree(pTable->entries[i]);
+            }
+        }
+
+        while (pTable != nullptr)
+        {
+            DecisionTable* pRetired = pTable->pRetired;
+            _DefFree(pTable);
+            pTable = pRetired;
+        }
+
+        while (m_pRetiredDecisionEntries != nullptr)
+        {
+            DecisionCacheEntry* pRetired = m_pRetiredDecisionEntries->pRetired;
+            _DefFree(m_pRetiredDecisionEntries);
+            m_pRetiredDecisionEntries = pRetired;
+        }
+    }
 
     const IDecisionInfo* GetDecisionInfo() const { return m_pDecisions; }
 
@@ -237,8 +377,6 @@ public:
         UINT32 pad : 7;
     } QualifierSetCacheEntry;
 
-    static const UINT16 kDecisionAttemptedMask = 0x8000;
-
     class QualifierSetComparer
     {
     public:
@@ -447,32 +585,30 @@ public:
 
     void Reset()
     {
-        // using UNREFERENCED_PARAMETER because prefast complains about inconsisten
-        // annotation if I comment out pStatus.
+        // Every entry is tagged with the generation it was computed in, so moving to a new generation
+        // invalidates all of them at once without touching tables that lock-free readers may be using.
         AutoReaderWriterLock autoLock(&m_srwLock);
 
-        _QualifierCacheEntry* pCachedQualifiers = m_qualifierCache.GetAll();
-        for (unsigned int i = 0; i < m_qualifierCache.Count(); ++i)
+        LONG generation = m_generation;
+        if (generation == MAXLONG)
         {
-            (pCachedQualifiers + i)->bAttempted = 0;
-        }
-        m_qualifierCache.Reset();
-
-        QualifierSetCacheEntry* pCachedQualifierSets = m_qualifierSetCache.GetAll();
-        for (unsigned int i = 0; i < m_qualifierSetCache.Count(); ++i)
-        {
-            (pCachedQualifierSets + i)->attempted = 0;
-        }
-        m_qualifierSetCache.Reset();
-
-        UINT16* pCachedDecision = m_decisionCache.GetAll();
-        for (unsigned int i = 0; i < m_decisionCache.Count(); ++i)
-        {
-            *(pCachedDecision + i) &= ~kDecisionAttemptedMask;
+            // Start over rather than wrap, so a stale entry can never match a reused generation.
+            ClearSlotTable(m_pQualifierSlots);
+            ClearSlotTable(m_pQualifierSetSlots);
+            if (m_pDecisionTable != nullptr)
+            {
+                for (UINT32 i = 0; i < m_pDecisionTable->numEntries; i++)
+                {
+                    if (m_pDecisionTable->entries[i] != nullptr)
+                    {
+                        InterlockedExchange(&m_pDecisionTable->entries[i]->generation, 0);
+                    }
+                }
+            }
+            generation = 0;
         }
-        m_decisionCache.Reset();
 
-        m_decisionPerSetInfo.Reset();
+        InterlockedExchange(&m_generation, generation + 1);
     }
 
     void Reset(_In_ Atom)
@@ -486,17 +622,16 @@ public:
         int index;
         RETURN_IF_FAILED(pQualifier->GetQualifierIndex(&index));
 
-        AutoReaderWriterLock autoLock(&m_srwLock, true);
-        QualifierCacheEntry* pEntries = m_qualifierCache.GetAll();
-        if ((index < 0) || (index >= m_qualifierCache.Count()) || (!pEntries[index].bAttempted))
+        QualifierCacheEntry entry;
+        if (!TryGetQualifierEntry(index, &entry) || (!entry.bAttempted))
         {
             *pScoreOut = 0;
             *pFallbackScoreOut = 0;
             return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
         }
 
-        *pScoreOut = pEntries[index].score;
-        *pFallbackScoreOut = pEntries[index].fallbackScore;
+        *pScoreOut = entry.score;
+        *pFallbackScoreOut = entry.fallbackScore;
         return S_OK;
     }
 
@@ -510,20 +645,14 @@ public:
         RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (score < 0) || (score > IQualifier::MaxFallbackScore));
         RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (fallbackScore < 0) || (fallbackScore > IQualifier::MaxFallbackScore));
 
-        AutoReaderWriterLock autoLock(&m_srwLock);
-        if (index >= m_qualifierCache.Count())
-        {
-            // decision info has grown since we were initialized
-            // but we weren't able to grow our cache.
-            RETURN_IF_FAILED(m_qualifierCache.SetExtent(m_pDecisions->GetNumQualifiers()));
-        }
-
-        QualifierCacheEntry entry;
+        QualifierCacheEntry entry = {};
         entry.bAttempted = 1;
         entry.priority = priority;
         entry.score = score;
         entry.fallbackScore = fallbackScore;
-        RETURN_IF_FAILED(m_qualifierCache.Set(index, entry));
+
+        AutoReaderWriterLock autoLock(&m_srwLock);
+        RETURN_IF_FAILED(WriteSlot(&m_pQualifierSlots, index, m_pDecisions->GetNumQualifiers(), entry));
 
         return S_OK;
     }
@@ -539,10 +668,8 @@ public:
         int index;
         RETURN_IF_FAILED(pQualifierSet->GetIndex(&index));
 
-        AutoReaderWriterLock autoLock(&m_srwLock, true);
-
-        QualifierSetCacheEntry* pEntries = m_qualifierSetCache.GetAll();
-        if ((index < 0) || (index >= m_qualifierSetCache.Count()) || (!pEntries[index].attempted))
+        QualifierSetCacheEntry entry;
+        if (!TryGetQualifierSetEntry(index, &entry) || (!entry.attempted))
         {
             *pbIsMatchOut = *pbIsDefaultOut = *pbIsMatchOrDefaultOut = false;
             if (pBestActualMatchScoreOut)
@@ -556,34 +683,29 @@ public:
             return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
         }
 
-        *pbIsMatchOut = (pEntries[index].isMatch != 0);
-        *pbIsDefaultOut = (pEntries[index].isDefault != 0);
-        *pbIsMatchOrDefaultOut = (pEntries[index].isMatchOrDefault != 0);
+        *pbIsMatchOut = (entry.isMatch != 0);
+        *pbIsDefaultOut = (entry.isDefault != 0);
+        *pbIsMatchOrDefaultOut = (entry.isMatchOrDefault != 0);
 
         if (pBestActualMatchScoreOut)
         {
-            *pBestActualMatchScoreOut = pEntries[index].bestMatchScore;
+            *pBestActualMatchScoreOut = entry.bestMatchScore;
         }
         if (pBestActualMatchPriorityOut)
         {
-            *pBestActualMatchPriorityOut = pEntries[index].bestMatchPriority;
+            *pBestActualMatchPriorityOut = entry.bestMatchPriority;
         }
 
         return S_OK;
     }
 
-    HRESULT GetQualifierSetCacheEntry(_In_ int index, _Out_ const QualifierSetCacheEntry** ppQualifierSetResult)
+    HRESULT GetQualifierSetCacheEntry(_In_ int index, _Out_ QualifierSetCacheEntry* pQualifierSetResult)
     {
-        AutoReaderWriterLock autoLock(&m_srwLock, true);
-
-        QualifierSetCacheEntry* pEntries = m_qualifierSetCache.GetAll();
-        if ((index < 0) || (index >= m_qualifierSetCache.Count()) || (!pEntries[index].attempted))
+        if (!TryGetQualifierSetEntry(index, pQualifierSetResult) || (!pQualifierSetResult->attempted))
         {
-            *ppQualifierSetResult = NULL;
             return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
         }
 
-        *ppQualifierSetResult = &pEntries[index];
         return S_OK;
     }
 
@@ -606,15 +728,7 @@ public:
         RETURN_HR_IF(
             HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (bestActualMatchScore < 0) || (bestActualMatchScore > IQualifier::MaxFallbackScore));
 
-        AutoReaderWriterLock autoLock(&m_srwLock);
-        if (index >= m_qualifierSetCache.Count())
-        {
-            // decision info has grown since we were initialized
-            // but we weren't able to grow our cache.
-            RETURN_IF_FAILED(m_qualifierSetCache.SetExtent(m_pDecisions->GetNumQualifierSets()));
-        }
-
-        QualifierSetCacheEntry entry;
+        QualifierSetCacheEntry entry = {};
         entry.attempted = 1;
         entry.isMatch = (isMatch ? 1 : 0);
         entry.isDefault = (isDefaultMatch ? 1 : 0);
@@ -623,7 +737,8 @@ public:
         entry.bestMatchPriority = bestActualMatchPriority;
         entry.bestMatchScore = bestActualMatchScore;
 
-        RETURN_IF_FAILED(m_qualifierSetCache.Set(index, entry));
+        AutoReaderWriterLock autoLock(&m_srwLock);
+        RETURN_IF_FAILED(WriteSlot(&m_pQualifierSetSlots, index, m_pDecisions->GetNumQualifierSets(), entry));
 
         return S_OK;
     }
@@ -634,42 +749,56 @@ public:
         UINT16 setIndexInPool;
     } DecisionPerSetInfo;
 
+    // Lock-free. An entry is only used if it was completed in the current generation and wasn't
+    // rewritten while it was being copied.
     HRESULT GetDecisionResults(
         _In_ const IDecision* pDecision,
         _In_ int numResults,
         _Out_writes_(numResults) int* pSetIndexesInDecisionOut,
-        _Out_writes_(numResults) int* pSetIndexesInPoolOut)
+        _Out_writes_(numResults) int* pSetIndexesInPoolOut) const
     {
         int index;
         RETURN_IF_FAILED(pDecision->GetIndex(&index));
 
-        UINT16 offset = 0;
-
-        AutoReaderWriterLock autoLock(&m_srwLock, true);
-        if ((index < 0) || (index >= m_decisionCache.Count()) || (!m_decisionCache.TryGet(index, &offset)) ||
-            ((offset & kDecisionAttemptedMask) == 0))
+        const DecisionTable* pTable =
+            static_cast<const DecisionTable*>(ReadPointerAcquire(reinterpret_cast<PVOID const volatile*>(&m_pDecisionTable)));
+        if ((pTable == nullptr) || (index < 0) || (static_cast<UINT32>(index) >= pTable->numEntries))
         {
-            // out of range or not attempted
             return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
         }
 
-        // mask off the bit that indicates that the decision was cached
-        offset &= ~kDecisionAttemptedMask;
+        const DecisionCacheEntry* pEntry =
+            static_cast<const DecisionCacheEntry*>(ReadPointerAcquire(reinterpret_cast<PVOID const volatile*>(&pTable->entries[index])));
+        if (pEntry == nullptr)
+        {
+            return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        }
 
-        int numDecisionResults = pDecision->GetNumQualifierSets();
-        numResults = min(numResults, numDecisionResults);
+        LONG generation = ReadAcquire(&pEntry->generation);
+        if ((generation == 0) || (generation != ReadAcquire(&m_generation)))
+        {
+            // not attempted in this generation, or being written right now
+            return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        }
 
-        DEF_ASSERT((offset + numResults) <= m_decisionPerSetInfo.Count());
+        numResults = min(numResults, min(pDecision->GetNumQualifierSets(), pEntry->numSets));
 
-        const DecisionPerSetInfo* pSets = &m_decisionPerSetInfo.GetAll()[offset];
+        const DecisionPerSetInfo* pSets = pEntry->sets;
         for (int i = 0; (i < numResults); i++)
         {
             pSetIndexesInDecisionOut[i] = pSets[i].setIndexInDecision;
             pSetIndexesInPoolOut[i] = pSets[i].setIndexInPool;
         }
+
+        MemoryBarrier();
+        if (ReadNoFence(&pEntry->generation) != generation)
+        {
+            return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        }
         return S_OK;
     }
 
+    // Called with the resolver's lock held exclusively, so there is at most one writer per decision.
     HRESULT
     BeginSetDecisionResults(_In_ const IDecision* pDecision, _Out_writes_(*pNumSetsOut) DecisionPerSetInfo** result, _Out_ int* pNumSetsOut)
     {
@@ -679,35 +808,46 @@ public:
         int index;
         RETURN_IF_FAILED(pDecision->GetIndex(&index));
 
+        int numSets = pDecision->GetNumQualifierSets();
+
+        // If there are no qualifier sets, return with MRM_NO_MATCHING_CANDIDATE
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE), numSets == 0);
+
         AutoReaderWriterLock autoLock(&m_srwLock);
         DEF_ASSERT((index >= 0) && (index < m_pDecisions->GetNumDecisions()));
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), index < 0);
 
-        if (index >= m_decisionCache.Count())
-        {
-            // couldn't extend the cache
-            RETURN_IF_FAILED(m_decisionCache.SetExtent(m_pDecisions->GetNumDecisions()));
-        }
+        DecisionTable* pTable;
+        RETURN_IF_FAILED(EnsureDecisionTable(index, &pTable));
 
-        UINT16* pCachedDecision = &m_decisionCache.GetAll()[index];
+        DecisionCacheEntry* pEntry = pTable->entries[index];
+        if ((pEntry == nullptr) || (pEntry->numSets != numSets))
+        {
+            DecisionCacheEntry* pNewEntry = static_cast<DecisionCacheEntry*>(
+                _DefBlob_AllocZeroed(sizeof(DecisionCacheEntry) + ((numSets - 1) * sizeof(DecisionPerSetInfo))));
+            RETURN_IF_NULL_ALLOC(pNewEntry);
+            pNewEntry->numSets = numSets;
 
-        // We have our entry in the decision cache, now we need to figure
-        // out where the qualifier set data will go.
-        int offset = m_decisionPerSetInfo.Count();
-        int numSets = pDecision->GetNumQualifierSets();
+            if (pEntry != nullptr)
+            {
+                // Readers may still be looking at the old entry, so keep it until the cache goes away.
+                pEntry->pRetired = m_pRetiredDecisionEntries;
+                m_pRetiredDecisionEntries = pEntry;
+            }
 
-        // If there are no qualifier sets, return with MRM_NO_MATCHING_CANDIDATE
-        // If we can't extend, SetExtent reports the error.
-        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE), numSets == 0);
-        RETURN_IF_FAILED(m_decisionPerSetInfo.SetExtent(offset + numSets));
+            InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&pTable->entries[index]), pNewEntry);
+            pEntry = pNewEntry;
+        }
+        else
+        {
+            // Readers treat the entry as a miss until EndSetDecisionResults stamps it again.
+            InterlockedExchange(&pEntry->generation, 0);
+        }
 
-        DecisionPerSetInfo* pSets = &m_decisionPerSetInfo.GetAll()[offset];
-        SecureZeroMemory(pSets, numSets * sizeof(DecisionPerSetInfo));
+        SecureZeroMemory(pEntry->sets, numSets * sizeof(DecisionPerSetInfo));
 
-        // Set the offset in the cached decisions, but don't set the attempted bit
-        // until EndDecisionResults
-        *pCachedDecision = static_cast<UINT16>(offset);
         *pNumSetsOut = numSets;
-        *result = pSets;
+        *result = pEntry->sets;
 
         return S_OK;
     }
@@ -718,11 +858,12 @@ public:
         RETURN_IF_FAILED(pDecision->GetIndex(&index));
 
         AutoReaderWriterLock autoLock(&m_srwLock);
-        DEF_ASSERT((index >= 0) && (index < m_pDecisions->GetNumDecisions()) && (index < m_decisionCache.Count()));
-
-        UINT16* pCachedDecision = &m_decisionCache.GetAll()[index];
+        DEF_ASSERT(
+            (index >= 0) && (index < m_pDecisions->GetNumDecisions()) && (m_pDecisionTable != nullptr) &&
+            (static_cast<UINT32>(index) < m_pDecisionTable->numEntries) && (m_pDecisionTable->entries[index] != nullptr));
 
-        (*pCachedDecision) |= kDecisionAttemptedMask;
+        // Publishes the sorted results written since BeginSetDecisionResults.
+        WriteRelease(&m_pDecisionTable->entries[index]->generation, m_generation);
 
         return S_OK;
     }
@@ -732,19 +873,15 @@ public:
     // _Requires_lock_held_(ResolverBase::m_srwQualifierSetLock)
     int CompareQualifierSetResults(_In_ int setIndexInPool1, _In_ int setIndexInPool2, _Inout_ const IResolver* pResolver)
     {
-        if ((setIndexInPool1 < 0) || (setIndexInPool1 > m_qualifierSetCache.Count() - 1))
-        {
-            return 0;
-        }
-
-        if ((setIndexInPool2 < 0) || (setIndexInPool2 > m_qualifierSetCache.Count() - 1))
+        DecisionInfoCache::QualifierSetCacheEntry entry1;
+        DecisionInfoCache::QualifierSetCacheEntry entry2;
+        if (!TryGetQualifierSetEntry(setIndexInPool1, &entry1) || !TryGetQualifierSetEntry(setIndexInPool2, &entry2))
         {
             return 0;
         }
 
-        QualifierSetCacheEntry* pEntries = m_qualifierSetCache.GetAll();
-        const DecisionInfoCache::QualifierSetCacheEntry* pEntry1 = &pEntries[setIndexInPool1];
-        const DecisionInfoCache::QualifierSetCacheEntry* pEntry2 = &pEntries[setIndexInPool2];
+        const DecisionInfoCache::QualifierSetCacheEntry* pEntry1 = &entry1;
+        const DecisionInfoCache::QualifierSetCacheEntry* pEntry2 = &entry2;
 
         int diff = 0;
 
@@ -836,22 +973,184 @@ protected:
     const IDecisionInfo* m_pDecisions;
     const UnifiedEnvironment* m_pEnvironment;
 
-    DynamicArray<QualifierCacheEntry> m_qualifierCache;
-    DynamicArray<QualifierSetCacheEntry> m_qualifierSetCache;
-    DynamicArray<DecisionPerSetInfo> m_decisionPerSetInfo;
-    DynamicArray<UINT16> m_decisionCache;
+    // Qualifier and qualifier set entries are 32 bits each. A slot packs an entry into its low half and the
+    // generation it was computed in into its high half, so readers can check and read it with one load.
+    // Tables only move when the decision info grows. Replaced tables stay alive until the cache is
+    // destroyed, because lock-free readers may still be using them.
+    struct SlotTable
+    {
+        SlotTable* pRetired;
+        UINT32 numSlots;
+        volatile LONG64 slots[ANYSIZE_ARRAY];
+    };
+
+    // Sorted qualifier sets for one decision. generation is zero while the entry is being written.
+    struct DecisionCacheEntry
+    {
+        DecisionCacheEntry* pRetired;
+        volatile LONG generation;
+        int numSets;
+        DecisionPerSetInfo sets[ANYSIZE_ARRAY];
+    };
+
+    struct DecisionTable
+    {
+        DecisionTable* pRetired;
+        UINT32 numEntries;
+        DecisionCacheEntry* volatile entries[ANYSIZE_ARRAY];
+    };
+
+    volatile LONG m_generation;
+    SlotTable* volatile m_pQualifierSlots;
+    SlotTable* volatile m_pQualifierSetSlots;
+    DecisionTable* volatile m_pDecisionTable;
+    DecisionCacheEntry* m_pRetiredDecisionEntries;
 
     DecisionInfoCache(_In_ const IDecisionInfo* pDecisions, _In_ const UnifiedEnvironment* pEnvironment) :
         m_pDecisions(pDecisions),
         m_pEnvironment(pEnvironment),
-        m_qualifierCache(),
-        m_qualifierSetCache(),
-        m_decisionPerSetInfo(),
-        m_decisionCache()
+        m_generation(1),
+        m_pQualifierSlots(nullptr),
+        m_pQualifierSetSlots(nullptr),
+        m_pDecisionTable(nullptr),
+        m_pRetiredDecisionEntries(nullptr)
     {
         ::InitializeSRWLock(&m_srwLock);
     }
 
+    static void FreeSlotTables(_In_opt_ SlotTable* pTable)
+    {
+        while (pTable != nullptr)
+        {
+            SlotTable* pRetired = pTable->pRetired;
+            _DefFree(pTable);
+            pTable = pRetired;
+        }
+    }
+
+    static void ClearSlotTable(_In_opt_ SlotTable* pTable)
+    {
+        for (UINT32 i = 0; (pTable != nullptr) && (i < pTable->numSlots); i++)
+        {
+            InterlockedExchange64(&pTable->slots[i], 0);
+        }
+    }
+
+    // Returns false if there is no slot for the index. An entry from an earlier generation comes back with
+    // its attempted bit cleared but its other fields intact, matching what resetting the entry in place did.
+    template<typename TEntry>
+    bool TryReadSlot(_In_ SlotTable* const volatile* ppTable, _In_ int index, _Out_ TEntry* pEntry, _Out_ bool* pbCurrent) const
+    {
+        static_assert(sizeof(TEntry) == sizeof(UINT32), "cache entries must fit in half a slot");
+
+        const SlotTable* pTable = static_cast<const SlotTable*>(ReadPointerAcquire(reinterpret_cast<PVOID const volatile*>(ppTable)));
+        if ((pTable == nullptr) || (index < 0) || (static_cast<UINT32>(index) >= pTable->numSlots))
+        {
+            *pbCurrent = false;
+            SecureZeroMemory(pEntry, sizeof(*pEntry));
+            return false;
+        }
+
+        LONG64 slot = ReadAcquire64(&pTable->slots[index]);
+        UINT32 bits = static_cast<UINT32>(slot);
+        CopyMemory(pEntry, &bits, sizeof(bits));
+        *pbCurrent = (static_cast<LONG>(slot >> 32) == ReadAcquire(&m_generation));
+        return true;
+    }
+
+    bool TryGetQualifierEntry(_In_ int index, _Out_ QualifierCacheEntry* pEntry) const
+    {
+        bool bCurrent;
+        if (!TryReadSlot(&m_pQualifierSlots, index, pEntry, &bCurrent))
+        {
+            return false;
+        }
+
+        if (!bCurrent)
+        {
+            pEntry->bAttempted = 0;
+        }
+        return true;
+    }
+
+    bool TryGetQualifierSetEntry(_In_ int index, _Out_ QualifierSetCacheEntry* pEntry) const
+    {
+        bool bCurrent;
+        if (!TryReadSlot(&m_pQualifierSetSlots, index, pEntry, &bCurrent))
+        {
+            return false;
+        }
+
+        if (!bCurrent)
+        {
+            pEntry->attempted = 0;
+        }
+        return true;
+    }
+
+    // Caller holds m_srwLock exclusively.
+    template<typename TEntry>
+    HRESULT WriteSlot(_Inout_ SlotTable* volatile* ppTable, _In_ int index, _In_ int numSlotsWanted, _In_ const TEntry& entry)
+    {
+        static_assert(sizeof(TEntry) == sizeof(UINT32), "cache entries must fit in half a slot");
+
+        SlotTable* pTable = *ppTable;
+        if ((pTable == nullptr) || (static_cast<UINT32>(index) >= pTable->numSlots))
+        {
+            // First use, or decision info has grown since the table was allocated.
+            UINT32 numSlots = static_cast<UINT32>(max(numSlotsWanted, index + 1));
+            SlotTable* pNewTable = static_cast<SlotTable*>(_DefBlob_AllocZeroed(sizeof(SlotTable) + ((numSlots - 1) * sizeof(LONG64))));
+            RETURN_IF_NULL_ALLOC(pNewTable);
+            pNewTable->numSlots = numSlots;
+
+            if (pTable != nullptr)
+            {
+                for (UINT32 i = 0; i < pTable->numSlots; i++)
+                {
+                    pNewTable->slots[i] = pTable->slots[i];
+                }
+            }
+            pNewTable->pRetired = pTable;
+
+            InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(ppTable), pNewTable);
+            pTable = pNewTable;
+        }
+
+        UINT32 bits;
+        CopyMemory(&bits, &entry, sizeof(bits));
+        WriteRelease64(&pTable->slots[index], (static_cast<LONG64>(m_generation) << 32) | bits);
+        return S_OK;
+    }
+
+    // Caller holds m_srwLock exclusively.
+    HRESULT EnsureDecisionTable(_In_ int index, _Outptr_ DecisionTable** result)
+    {
+        DecisionTable* pTable = m_pDecisionTable;
+        if ((pTable == nullptr) || (static_cast<UINT32>(index) >= pTable->numEntries))
+        {
+            UINT32 numEntries = static_cast<UINT32>(max(m_pDecisions->GetNumDecisions(), index + 1));
+            DecisionTable* pNewTable = static_cast<DecisionTable*>(
+                _DefBlob_AllocZeroed(sizeof(DecisionTable) + ((numEntries - 1) * sizeof(DecisionCacheEntry*))));
+            RETURN_IF_NULL_ALLOC(pNewTable);
+            pNewTable->numEntries = numEntries;
+
+            if (pTable != nullptr)
+            {
+                for (UINT32 i = 0; i < pTable->numEntries; i++)
+                {
+                    pNewTable->entries[i] = pTable->entries[i];
+                }
+            }
+            pNewTable->pRetired = pTable;
+
+            InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&m_pDecisionTable), pNewTable);
+            pTable = pNewTable;
+        }
+
+        *result = pTable;
+        return S_OK;
+    }
+
     int CompareQualifierSetResultDetails(_In_ int setIndexInPool1, _In_ int setIndexInPool2, _In_ const IResolver* pResolver)
     {
         QualifierSetResult set1;
@@ -864,19 +1163,19 @@ protected:
 
         int q1;
         int q2;
-        _QualifierCacheEntry* pQualifiers = m_qualifierCache.GetAll();
-        _QualifierCacheEntry* pQ1;
-        _QualifierCacheEntry* pQ2;
+        _QualifierCacheEntry qualifier1;
+        _QualifierCacheEntry qualifier2;
+        const _QualifierCacheEntry* pQ1 = &qualifier1;
+        const _QualifierCacheEntry* pQ2 = &qualifier2;
 
         for (int i = 0; i < set1.GetNumQualifiers(); i++)
         {
             // Get the next qualifier from set 1
-            if (FAILED(set1.GetQualifierIndexInPool(i, &q1)) || (q1 < 0) || (q1 > m_qualifierCache.Count() - 1))
+            if (FAILED(set1.GetQualifierIndexInPool(i, &q1)) || !TryGetQualifierEntry(q1, &qualifier1))
             {
                 // error, can't continue.
                 return 0;
             }
-            pQ1 = &pQualifiers[q1];
 
             // See if set 2 also has a qualifier
             if (i >= set2.GetNumQualifiers())
@@ -886,12 +1185,11 @@ protected:
             }
 
             // Get the qualifier from set 2
-            if (FAILED(set2.GetQualifierIndexInPool(i, &q2)) || (q2 < 0) || (q2 > m_qualifierCache.Count() - 1))
+            if (FAILED(set2.GetQualifierIndexInPool(i, &q2)) || !TryGetQualifierEntry(q2, &qualifier2))
             {
                 // error, can't continue.
                 return 0;
             }
-            pQ2 = &pQualifiers[q2];
 
             if (pQ2->priority > pQ1->priority)
             {
@@ -981,12 +1279,11 @@ protected:
         if (set2.GetNumQualifiers() > set1.GetNumQualifiers())
         {
             // Set 2 is more specific.  See who wins.
-            if (FAILED(set2.GetQualifierIndexInPool(set1.GetNumQualifiers(), &q2)) || (q2 < 0) || (q2 > m_qualifierCache.Count() - 1))
+            if (FAILED(set2.GetQualifierIndexInPool(set1.GetNumQualifiers(), &q2)) || !TryGetQualifierEntry(q2, &qualifier2))
             {
                 // error, can't continue.
                 return 0;
             }
-            pQ2 = &pQualifiers[q2];
             return ((pQ2->score > 0) ? -1 : 1);
         }
 
@@ -1006,34 +1303,31 @@ protected:
 
         int q1;
         int q2;
-        _QualifierCacheEntry* pQualifiers = m_qualifierCache.GetAll();
-        _QualifierCacheEntry* pQ1;
-        _QualifierCacheEntry* pQ2;
+        _QualifierCacheEntry qualifier1;
+        _QualifierCacheEntry qualifier2;
+        const _QualifierCacheEntry* pQ1 = &qualifier1;
+        const _QualifierCacheEntry* pQ2 = &qualifier2;
 
         QualifierSetComparer comparer1;
         QualifierSetComparer comparer2;
 
         for (int i = 0; i < set1.GetNumQualifiers(); i++)
         {
-            if (FAILED(set1.GetQualifierIndexInPool(i, &q1)) || (q1 < 0) || (q1 > m_qualifierCache.Count() - 1))
+            if (FAILED(set1.GetQualifierIndexInPool(i, &q1)) || !TryGetQualifierEntry(q1, &qualifier1))
             {
                 return 0;
             }
 
-            pQ1 = &pQualifiers[q1];
-
             comparer1.SetScore(pQ1->priority, pQ1->score, pQ1->fallbackScore);
         }
 
         for (int i = 0; i < set2.GetNumQualifiers(); i++)
         {
-            if (FAILED(set2.GetQualifierIndexInPool(i, &q2)) || (q2 < 0) || (q2 > m_qualifierCache.Count() - 1))
+            if (FAILED(set2.GetQualifierIndexInPool(i, &q2)) || !TryGetQualifierEntry(q2, &qualifier2))
             {
                 return 0;
             }
 
-            pQ2 = &pQualifiers[q2];
-
             comparer2.SetScore(pQ2->priority, pQ2->score, pQ2->fallbackScore);
         }
 
@@ -1076,7 +1370,7 @@ protected:
         Atom qa1;
         Atom qa2;
         const IBuildQualifierType* type;
-        StringResult value;
+        InlineStringResult value;
 
         if (SUCCEEDED(m_pDecisions->GetQualifier(qualifier1, &qr1)) && SUCCEEDED(m_pDecisions->GetQualifier(qualifier2, &qr2)) &&
             SUCCEEDED(qr1.GetOperand1Qualifier(&qa1)) && SUCCEEDED(qr2.GetOperand1Qualifier(&qa2)) && (qa1 == qa2) &&
@@ -1095,19 +1389,329 @@ private:
     SRWLOCK m_srwLock;
 };
 
+// Qualifier operands and context values in compiled (pre-parsed) form, for qualifier types that
+// support it.  Qualifier operands never change, so every qualifier in the decision info is compiled
+// once when the resolver is created; qualifiers added to the decision info later are compiled on
+// first use.  Context values are compiled once per qualifier name and resolver generation, so a
+// context change costs one parse per qualifier name rather than one per qualifier that uses it.
+// List-valued context values (such as the language list) are kept split into their values the
+// same way, for types that have no compiled form for single values.
+// Callers hold ResolverBase::m_srwQualifierLock exclusively.
+class ResolverBase::CompiledQualifierCache : public DefObject
+{
+public:
+    static HRESULT CreateInstance(
+        _In_ const IDecisionInfo* pDecisions,
+        _In_ const UnifiedEnvironment* pEnvironment,
+        _Outptr_ CompiledQualifierCache** result)
+    {
+        *result = nullptr;
+
+        RETURN_HR_IF_NULL(E_INVALIDARG, pDecisions);
+
+        AutoDeletePtr<CompiledQualifierCache> pRtrn = new CompiledQualifierCache(pEnvironment);
+        RETURN_IF_NULL_ALLOC(pRtrn);
+
+        RETURN_IF_FAILED(DynamicArray<AssetEntry>::CreateInstance(pDecisions->GetNumQualifiers(), &pRtrn->m_pAssetValues));
+        RETURN_IF_FAILED(DynamicArray<ContextEntry>::CreateInstance(0, &pRtrn->m_pContextValues));
+        RETURN_IF_FAILED(DynamicArray<ContextListEntry>::CreateInstance(0, &pRtrn->m_pContextLists));
+
+        QualifierResult qualifier;
+        IQualifierType::CompiledValue ignored;
+        for (int i = 0; i < pDecisions->GetNumQualifiers(); i++)
+        {
+            RETURN_IF_FAILED(pDecisions->GetQualifier(i, &qualifier));
+            (void)pRtrn->TryGetAssetValue(&qualifier, &ignored);
+        }
+
+        *result = pRtrn.Detach();
+        return S_OK;
+    }
+
+    ~CompiledQualifierCache()
+    {
+        if (m_pContextLists != nullptr)
+        {
+            ContextListEntry entry;
+            for (UINT32 i = 0; i < m_pContextLists->Count(); i++)
+            {
+                if (m_pContextLists->TryGet(i, &entry) && (entry.state == Compiled))
+                {
+                    IQualifierType::FreeCompiledList(&entry.list);
+                }
+            }
+        }
+
+        delete m_pAssetValues;
+        delete m_pContextValues;
+        delete m_pContextLists;
+    }
+
+    bool TryGetAssetValue(_In_ const IQualifier* pQualifier, _Out_ IQualifierType::CompiledValue* pValueOut)
+    {
+        int index;
+        AssetEntry entry = {};
+        if (FAILED(pQualifier->GetQualifierIndex(&index)) || (index < 0))
+        {
+            return false;
+        }
+
+        if (!m_pAssetValues->TryGet(index, &entry) || (entry.state == NotCompiled))
+        {
+            Atom qualifierName;
+            const IBuildQualifierType* pType;
+            InlineStringResult literal;
+
+            // Qualifiers that fail validation are never compiled, so Evaluate reports them as before.
+            entry.state = NotCompilable;
+            if (SUCCEEDED(pQualifier->GetOperand1Attribute(&qualifierName)) &&
+                SUCCEEDED(m_pEnvironment->GetTypeOfQualifier(qualifierName, &pType)) && SUCCEEDED(pType->ValidateQualifier(pQualifier)) &&
+                SUCCEEDED(pQualifier->GetOperand2Literal(&literal)) && pType->TryCompileValue(literal.GetRef(), &entry.value))
+            {
+                entry.state = Compiled;
+            }
+
+            if (FAILED(m_pAssetValues->ExtendAndSet(index, entry)))
+            {
+                return false;
+            }
+        }
+
+        *pValueOut = entry.value;
+        return (entry.state == Compiled);
+    }
+
+    bool TryGetContextValue(_In_ Atom qualifierName, _In_ UINT64 generation, _Out_ IQualifierType::CompiledValue* pValueOut) const
+    {
+        ContextEntry entry;
+        if (!m_pContextValues->TryGet(qualifierName.GetIndex(), &entry) || (entry.state != Compiled) ||
+            (entry.generation != generation) || (!entry.qualifierName.IsEqual(qualifierName)))
+        {
+            return false;
+        }
+
+        *pValueOut = entry.value;
+        return true;
+    }
+
+    void SetContextValue(_In_ Atom qualifierName, _In_ UINT64 generation, _In_ const IQualifierType::CompiledValue& value)
+    {
+        ContextEntry entry;
+        entry.qualifierName = qualifierName;
+        entry.generation = generation;
+        entry.state = Compiled;
+        entry.value = value;
+
+        // Failure just means the value gets compiled again next time.
+        (void)m_pContextValues->ExtendAndSet(qualifierName.GetIndex(), entry);
+    }
+
+    // The list stays owned by the cache, and is valid until the next call to SetContextList.
+    bool TryGetContextList(_In_ Atom qualifierName, _In_ UINT64 generation, _Out_ IQualifierType::CompiledList* pListOut) const
+    {
+        ContextListEntry entry;
+        if (!m_pContextLists->TryGet(qualifierName.GetIndex(), &entry) || (entry.state != Compiled) || (entry.generation != generation) ||
+            (!entry.qualifierName.IsEqual(qualifierName)))
+        {
+            return false;
+        }
+
+        *pListOut = entry.list;
+        return true;
+    }
+
+    // Takes ownership of the list, even on failure.
+    bool SetContextList(_In_ Atom qualifierName, _In_ UINT64 generation, _Inout_ IQualifierType::CompiledList* pList)
+    {
+        ContextListEntry entry;
+        entry.qualifierName = qualifierName;
+        entry.generation = generation;
+        entry.state = Compiled;
+        entry.list = *pList;
+
+        ContextListEntry oldEntry;
+        if (FAILED(m_pContextLists->ExtendAndSet(qualifierName.GetIndex(), entry, &oldEntry)))
+        {
+            IQualifierType::FreeCompiledList(pList);
+            return false;
+        }
+
+        if (oldEntry.state == Compiled)
+        {
+            IQualifierType::FreeCompiledList(&oldEntry.list);
+        }
+        return true;
+    }
+
+private:
+    enum EntryState
+    {
+        NotCompiled = 0,
+        Compiled = 1,
+        NotCompilable = 2
+    };
+
+    struct AssetEntry
+    {
+        EntryState state;
+        IQualifierType::CompiledValue value;
+    };
+
+    struct ContextEntry
+    {
+        Atom qualifierName;
+        UINT64 generation;
+        EntryState state;
+        IQualifierType::CompiledValue value;
+    };
+
+    struct ContextListEntry
+    {
+        Atom qualifierName;
+        UINT64 generation;
+        EntryState state;
+        IQualifierType::CompiledList list;
+    };
+
+    CompiledQualifierCache(_In_ const UnifiedEnvironment* pEnvironment) :
+        m_pEnvironment(pEnvironment), m_pAssetValues(nullptr), m_pContextValues(nullptr), m_pContextLists(nullptr)
+    {}
+
+    const UnifiedEnvironment* m_pEnvironment;
+    DynamicArray<AssetEntry>* m_pAssetValues;
+    DynamicArray<ContextEntry>* m_pContextValues;
+    DynamicArray<ContextListEntry>* m_pContextLists;
+};
+
+// The candidates most recently selected for named resources, in a fixed-size direct-mapped table.
+// Entries are tagged with the generation they were resolved in, so moving to a new generation
+// invalidates all of them at once.  Lookups don't take any lock: each entry carries a sequence
+// number that is odd while the entry is being rewritten, and a reader that sees the sequence
+// change discards what it read.  Writers serialize on m_srwLock.  Hit and miss counts are kept
+// per cache, on a cache line of their own so that counting doesn't slow down lookups that read
+// the generation, and are also reported to the process-wide counts in MrmTraceLogging.
+class ResolverBase::ResolvedResourceCache : public DefObject
+{
+public:
+    static const UINT32 NumEntries = 512;
+
+    static HRESULT CreateInstance(_Outptr_ ResolvedResourceCache** result)
+    {
+        *result = nullptr;
+
+        AutoDeletePtr<ResolvedResourceCache> pRtrn = new ResolvedResourceCache();
+        RETURN_IF_NULL_ALLOC(pRtrn);
+
+        *result = pRtrn.Detach();
+        return S_OK;
+    }
+
+    LONG64 GetGeneration() const { return ReadAcquire64(&m_generation); }
+
+    void Reset() { InterlockedIncrement64(&m_generation); }
+
+    bool TryGet(_In_ const IRawResourceMap* pRawMap, _In_ int resourceIndex, _In_ LONG64 generation, _Out_ int* pCandidateIndexOut) const
+    {
+        *pCandidateIndexOut = -1;
+
+        const Entry* pEntry = &m_entries[GetEntryIndex(pRawMap, resourceIndex)];
+        LONG sequence = ReadAcquire(&pEntry->sequence);
+        if ((sequence & 1) != 0)
+        {
+            return false;
+        }
+
+        bool bMatch = (ReadPointerAcquire(&pEntry->pRawMap) == pRawMap) && (ReadAcquire(&pEntry->resourceIndex) == resourceIndex) &&
+                      (ReadAcquire64(&pEntry->generation) == generation);
+        LONG candidateIndex = ReadAcquire(&pEntry->candidateIndex);
+
+        if (!bMatch || (ReadAcquire(&pEntry->sequence) != sequence))
+        {
+            return false;
+        }
+
+        *pCandidateIndexOut = candidateIndex;
+        return true;
+    }
+
+    void RecordLookup(_In_ bool bHit)
+    {
+        InterlockedIncrementNoFence64(bHit ? &m_numHits : &m_numMisses);
+        LogResolvedResourceCacheLookup(bHit);
+    }
+
+    void GetCounters(_Out_ UINT64* pHitsOut, _Out_ UINT64* pMissesOut) const
+    {
+        *pHitsOut = static_cast<UINT64>(ReadNoFence64(&m_numHits));
+        *pMissesOut = static_cast<UINT64>(ReadNoFence64(&m_numMisses));
+    }
+
+    void Set(_In_ const IRawResourceMap* pRawMap, _In_ int resourceIndex, _In_ LONG64 generation, _In_ int candidateIndex)
+    {
+        AutoReaderWriterLock autoLock(&m_srwLock);
+
+        Entry* pEntry = &m_entries[GetEntryIndex(pRawMap, resourceIndex)];
+        InterlockedIncrement(&pEntry->sequence);
+        WritePointerRelease(&pEntry->pRawMap, const_cast<IRawResourceMap*>(pRawMap));
+        WriteRelease(&pEntry->resourceIndex, resourceIndex);
+        WriteRelease64(&pEntry->generation, generation);
+        WriteRelease(&pEntry->candidateIndex, candidateIndex);
+        InterlockedIncrement(&pEntry->sequence);
+    }
+
+private:
+    struct Entry
+    {
+        volatile LONG sequence;
+        volatile LONG resourceIndex;
+        volatile LONG candidateIndex;
+        PVOID volatile pRawMap;
+        volatile LONG64 generation;
+    };
+
+    static UINT32 GetEntryIndex(_In_ const IRawResourceMap* pRawMap, _In_ int resourceIndex)
+    {
+        UINT32 mapBits = static_cast<UINT32>(reinterpret_cast<UINT_PTR>(pRawMap) >> 4);
+        return (static_cast<UINT32>(resourceIndex) ^ (mapBits * 31)) & (NumEntries - 1);
+    }
+
+    // Entries start out tagged with generation 0, which never matches.
+    ResolvedResourceCache() : m_generation(1), m_numHits(0), m_numMisses(0)
+    {
+        ::InitializeSRWLock(&m_srwLock);
+        ZeroMemory(m_entries, sizeof(m_entries));
+    }
+
+    volatile LONG64 m_generation;
+    BYTE m_generationPadding[SYSTEM_CACHE_ALIGNMENT_SIZE - sizeof(LONG64)];
+    volatile LONG64 m_numHits;
+    volatile LONG64 m_numMisses;
+    BYTE m_counterPadding[SYSTEM_CACHE_ALIGNMENT_SIZE - (2 * sizeof(LONG64))];
+    SRWLOCK m_srwLock;
+    Entry m_entries[NumEntries];
+};
+
 ResolverBase::ResolverBase(_In_ const UnifiedEnvironment* pEnvironment, _In_ const IDecisionInfo* pDecisions) :
-    m_pEnvironment(pEnvironment), m_pDecisions(pDecisions), m_pCache(NULL)
+    m_pEnvironment(pEnvironment), m_pDecisions(pDecisions), m_pCache(NULL), m_pCompiledQualifiers(NULL), m_pResolvedResources(NULL),
+    m_generation(0)
 {
     ::InitializeSRWLock(&m_srwLock);
     ::InitializeSRWLock(&m_srwQualifierSetLock);
     ::InitializeSRWLock(&m_srwQualifierLock);
 }
 
-ResolverBase::~ResolverBase() { delete m_pCache; }
+ResolverBase::~ResolverBase()
+{
+    delete m_pCache;
+    delete m_pCompiledQualifiers;
+    delete m_pResolvedResources;
+}
 
 HRESULT ResolverBase::Init()
 {
     RETURN_IF_FAILED(DecisionInfoCache::CreateInstance(m_pDecisions, m_pEnvironment, &m_pCache));
+    RETURN_IF_FAILED(CompiledQualifierCache::CreateInstance(m_pDecisions, m_pEnvironment, &m_pCompiledQualifiers));
+    RETURN_IF_FAILED(ResolvedResourceCache::CreateInstance(&m_pResolvedResources));
 
     return S_OK;
 }
@@ -1125,6 +1729,8 @@ void ResolverBase::Reset()
             {
                 // the cache doesn't do anythnig interesting with per-qualifier reset yet so just reset the whole thing.
                 m_pCache->Reset();
+                m_pResolvedResources->Reset();
+                m_generation++;
             }
         }
     }
@@ -1146,6 +1752,8 @@ HRESULT ResolverBase::Reset(__in_ecount(numQualifierNames) Atom* pQualifierNames
             {
                 // the cache doesn't do anythnig interesting with per-qualifier reset yet so just reset the whole thing.
                 m_pCache->Reset();
+                m_pResolvedResources->Reset();
+                m_generation++;
             }
         }
     }
@@ -1180,7 +1788,13 @@ HRESULT ResolverBase::EvaluateQualifier(_In_ const IQualifier* pQualifier, _Out_
     // Nope. Try to evaluate it.
     Atom qualifierName;
     const IBuildQualifierType* pType = NULL;
-    StringResult value;
+    InlineStringResult value;
+    IQualifierType::CompiledValue assetValue;
+    IQualifierType::CompiledValue contextValue;
+    IQualifierType::CompiledList contextList;
+    bool bAssetCompiled = false;
+    bool bContextCompiled = false;
+    bool bListCompiled = false;
 
     // The method can be called by (1) under m_srwLock and m_srwQualifierSetLock exclusive lock, or (2) no lock
     AutoReaderWriterLock autoLock(&m_srwQualifierLock);
@@ -1193,13 +1807,40 @@ HRESULT ResolverBase::EvaluateQualifier(_In_ const IQualifier* pQualifier, _Out_
 
     if (SUCCEEDED(hr))
     {
-        hr = GetQualifierValue(qualifierName, &value);
+        bAssetCompiled = m_pCompiledQualifiers->TryGetAssetValue(pQualifier, &assetValue);
+        bContextCompiled = bAssetCompiled && m_pCompiledQualifiers->TryGetContextValue(qualifierName, m_generation, &contextValue);
+        bListCompiled = !bAssetCompiled && m_pCompiledQualifiers->TryGetContextList(qualifierName, m_generation, &contextList);
+        if (!bContextCompiled && !bListCompiled)
+        {
+            hr = GetQualifierValue(qualifierName, &value);
+        }
     }
 
     if (SUCCEEDED(hr))
     {
+        if (bAssetCompiled && !bContextCompiled && pType->TryCompileValue(value.GetRef(), &contextValue))
+        {
+            m_pCompiledQualifiers->SetContextValue(qualifierName, m_generation, contextValue);
+            bContextCompiled = true;
+        }
+        else if (!bAssetCompiled && !bListCompiled && pType->TryCompileValueList(value.GetRef(), &contextList))
+        {
+            bListCompiled = m_pCompiledQualifiers->SetContextList(qualifierName, m_generation, &contextList);
+        }
+
         // looks good, get a score
-        (void)pType->Evaluate(pQualifier, value.GetRef(), &score);
+        if (bContextCompiled)
+        {
+            score = pType->EvaluateCompiled(assetValue, contextValue);
+        }
+        else if (bListCompiled)
+        {
+            (void)pType->EvaluateCompiledList(pQualifier, contextList, &score);
+        }
+        else
+        {
+            (void)pType->Evaluate(pQualifier, value.GetRef(), &score);
+        }
     }
 
     if (hr == HRESULT_FROM_WIN32(ERROR_MRM_UNKNOWN_QUALIFIER))
@@ -1311,14 +1952,48 @@ ResolverBase::EvaluateDecision(_In_ const IDecision* pDecision, _Out_ int* pResu
     return S_OK;
 }
 
+bool ResolverBase::TryGetResolvedCandidate(
+    _In_ const IRawResourceMap* pRawMap,
+    _In_ int resourceIndex,
+    _Out_ int* pCandidateIndexOut,
+    _Out_ LONG64* pGenerationOut) const
+{
+    *pGenerationOut = m_pResolvedResources->GetGeneration();
+
+    bool bHit = m_pResolvedResources->TryGet(pRawMap, resourceIndex, *pGenerationOut, pCandidateIndexOut);
+    m_pResolvedResources->RecordLookup(bHit);
+    return bHit;
+}
+
+void ResolverBase::GetResolvedResourceCacheCounters(_Out_ UINT64* pHitsOut, _Out_ UINT64* pMissesOut) const
+{
+    m_pResolvedResources->GetCounters(pHitsOut, pMissesOut);
+}
+
+void ResolverBase::SetResolvedCandidate(
+    _In_ const IRawResourceMap* pRawMap,
+    _In_ int resourceIndex,
+    _In_ LONG64 generation,
+    _In_ int candidateIndex) const
+{
+    m_pResolvedResources->Set(pRawMap, resourceIndex, generation, candidateIndex);
+}
+
 HRESULT ResolverBase::EvaluateDecision(
     _In_ const IDecision* pDecision,
     _In_ int numResults,
     _Out_writes_(numResults) int* pResultIndexesOut,
     _Out_writes_(numResults) int* pResultSetIndexesOut) const
 {
+    // Cache hits don't take any lock.
+    if (SUCCEEDED(m_pCache->GetDecisionResults(pDecision, numResults, pResultIndexesOut, pResultSetIndexesOut)))
+    {
+        return S_OK;
+    }
+
     AutoReaderWriterLock autoLock(&m_srwLock); // protect pResults object for potential race condition
 
+    // Another thread might have evaluated this decision while we were waiting for the lock.
     if (SUCCEEDED(m_pCache->GetDecisionResults(pDecision, numResults, pResultIndexesOut, pResultSetIndexesOut)))
     {
         return S_OK;
@@ -1333,7 +2008,7 @@ HRESULT ResolverBase::EvaluateDecision(
     bool bIsMatch;
     bool bIsFallbackMatch;
     bool bIsMatchOrDefault;
-    const DecisionInfoCache::QualifierSetCacheEntry* pEntry;
+    DecisionInfoCache::QualifierSetCacheEntry entry;
 
     // We'll put matches at the head and non-matches at the tail
     int nextMatch = 0;
@@ -1342,7 +2017,7 @@ HRESULT ResolverBase::EvaluateDecision(
     {
         if (FAILED(pDecision->GetQualifierSet(i, &qualifierSet, &indexInPool)) ||
             FAILED(EvaluateQualifierSet(&qualifierSet, &bIsMatch, &bIsFallbackMatch, &bIsMatchOrDefault)) ||
-            FAILED(m_pCache->GetQualifierSetCacheEntry(indexInPool, &pEntry)))
+            FAILED(m_pCache->GetQualifierSetCacheEntry(indexInPool, &entry)))
         {
             // something went badly wrong.  Count this set as a failure.
             bIsMatch = bIsFallbackMatch = bIsMatchOrDefault = false;
@@ -1518,6 +2193,23 @@ public:
         return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
     }
 
+    // Reports whether the atom already has exactly the specified value, either set explicitly or
+    // cached from its provider.
+    bool HasQualifierValue(_In_ Atom atom, _In_ PCWSTR pValue)
+    {
+        AutoReaderWriterLock autoLock(&m_srwLock, true);
+
+        UINT32 atomIx = atom.GetIndex();
+        if ((atom.GetPoolIndex() != m_pPool->GetPoolIndex()) || (atomIx >= static_cast<UINT32>(m_cacheSize)) || (atomIx >= 32) ||
+            ((m_presentValues & (1 << atomIx)) == 0))
+        {
+            return false;
+        }
+
+        DEFCOMPARISON result = Def_CompareError;
+        return SUCCEEDED(m_pCachedValues[atomIx].Compare(pValue, &result)) && (result == Def_Equal);
+    }
+
     HRESULT SetQualifierValue(_In_ Atom atom, _In_ PCWSTR pValue, _In_ bool bCopy)
     {
         AutoReaderWriterLock autoLock(&m_srwLock, false);
@@ -1726,10 +2418,21 @@ HRESULT ProviderResolver::SetQualifier(_In_ PCWSTR pQualifierName, _In_ PCWSTR p
 
 HRESULT ProviderResolver::SetQualifier(_In_ Atom qualifier, _In_ PCWSTR pNewValue)
 {
+    // Setting a qualifier to the value it already has changes nothing, so keep the caches.
+    if (m_pQualifiers->HasQualifierValue(qualifier, pNewValue))
+    {
+        return S_OK;
+    }
+
     (void)Reset(&qualifier, 1);
 
     RETURN_IF_FAILED(m_pQualifiers->SetQualifierValue(qualifier, pNewValue, true));
 
+    // Cache hits don't take the resolver lock, so a resolve that ran between the reset above and
+    // storing the new value may have cached results for the old one. Move to a new generation now
+    // that the value is in place.
+    (void)ResolverBase::Reset(&qualifier, 1);
+
     return S_OK;
 }
 
@@ -1827,6 +2530,22 @@ public:
         return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
     }
 
+    // Reports whether the atom has been set to exactly the specified value.
+    bool HasQualifierValue(_In_ Atom atom, _In_ PCWSTR pValue)
+    {
+        AutoReaderWriterLock autoLock(&m_srwLock, true);
+
+        UINT32 atomIx = atom.GetIndex();
+        if ((atom.GetPoolIndex() != m_pPool->GetPoolIndex()) || (atomIx >= static_cast<UINT32>(m_cacheSize)) || (atomIx >= 32) ||
+            ((m_presentValues & (1 << atomIx)) == 0))
+        {
+            return false;
+        }
+
+        DEFCOMPARISON result = Def_CompareError;
+        return SUCCEEDED(m_pCachedValues[atomIx].Compare(pValue, &result)) && (result == Def_Equal);
+    }
+
     HRESULT SetQualifierValue(_In_ Atom atom, _In_ PCWSTR pValue, _In_ bool bCopy)
     {
         AutoReaderWriterLock autoLock(&m_srwLock, false);
@@ -2001,12 +2720,22 @@ HRESULT OverrideResolver::SetQualifier(_In_ PCWSTR pQualifierName, _In_ PCWSTR p
 
 HRESULT OverrideResolver::SetQualifier(_In_ Atom qualifier, _In_ PCWSTR pNewValue)
 {
+    // Only an explicitly set value counts here; a value inherited from the parent or read per thread
+    // still needs this resolver to take its own score cache. See ProviderResolver::SetQualifier.
+    if (m_bHasScoreCache && m_pQualifiers->HasQualifierValue(qualifier, pNewValue))
+    {
+        return S_OK;
+    }
+
     (void)Reset(&qualifier, 1);
 
     // Once Resolver has its unique value, it will have its own score cache.
     m_bHasScoreCache = true;
     RETURN_IF_FAILED(m_pQualifiers->SetQualifierValue(qualifier, pNewValue, true));
 
+    // See ProviderResolver::SetQualifier.
+    (void)ResolverBase::Reset(&qualifier, 1);
+
     return S_OK;
 }
 
@@ -430,7 +430,7 @@ private:
         }
 
         // It's a path, and we have a package root.  Prepare to concatenate.
-        StringResult tmp;
+        InlineStringResult tmp;
         RETURN_IF_FAILED(GetStringResultFromBlobResult(pBlobResult, MrmEnvironment::MapResourceValueTypeToEncoding(valueType), &tmp));
 
         bool absolutePath;
@@ -758,6 +758,296 @@ bool ResourceCandidateResult::TryGetBlobValue(_Inout_ BlobResult* pBlobOut) cons
     return false;
 }
 
+CandidateStringCache::CandidateStringCache() : m_pMaps(nullptr) { _DefInitializeSRWLock(&m_srwLock); }
+
+HRESULT CandidateStringCache::CreateInstance(_Outptr_ CandidateStringCache** result)
+{
+    *result = nullptr;
+
+    AutoDeletePtr<CandidateStringCache> pRtrn = new CandidateStringCache();
+    RETURN_IF_NULL_ALLOC(pRtrn);
+    RETURN_IF_FAILED(DynamicArray<DecodedValues>::CreateInstance(1, &pRtrn->m_pMaps));
+
+    *result = pRtrn.Detach();
+    return S_OK;
+}
+
+CandidateStringCache::~CandidateStringCache()
+{
+    if (m_pMaps != nullptr)
+    {
+        for (int i = 0; i < m_pMaps->Count(); i++)
+        {
+            DecodedValues values;
+            if (SUCCEEDED(m_pMaps->Get(i, &values)))
+            {
+                for (int value = 0; value < values.numValues; value++)
+                {
+                    Def_Free(values.pValues[value]);
+                }
+                Def_Free(values.pValues);
+            }
+        }
+    }
+
+    delete m_pMaps;
+    m_pMaps = nullptr;
+}
+
+HRESULT CandidateStringCache::GetDecodedValues(_In_ const IRawResourceMap* pRawMap, _Out_ DecodedValues* pValuesOut)
+{
+    {
+        AutoReaderWriterLock autoLock(&m_srwLock, true);
+        for (int i = 0; i < m_pMaps->Count(); i++)
+        {
+            if (SUCCEEDED(m_pMaps->Get(i, pValuesOut)) && (pValuesOut->pRawMap == pRawMap))
+            {
+                return S_OK;
+            }
+        }
+    }
+
+    AutoReaderWriterLock autoLock(&m_srwLock);
+
+    // Another thread might have added the map while we waited for the lock.
+    for (int i = 0; i < m_pMaps->Count(); i++)
+    {
+        if (SUCCEEDED(m_pMaps->Get(i, pValuesOut)) && (pValuesOut->pRawMap == pRawMap))
+        {
+            return S_OK;
+        }
+    }
+
+    DecodedValues values;
+    values.pRawMap = pRawMap;
+    values.numValues = pRawMap->GetTotalNumResourceValues();
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), values.numValues <= 0);
+
+    values.pValues = _DefArray_AllocZeroed(PWSTR, values.numValues);
+    RETURN_IF_NULL_ALLOC(values.pValues);
+
+    HRESULT hr = m_pMaps->Add(values);
+    if (FAILED(hr))
+    {
+        Def_Free(values.pValues);
+        return hr;
+    }
+
+    *pValuesOut = values;
+    return S_OK;
+}
+
+HRESULT CandidateStringCache::GetStringValue(_In_ const ResourceCandidateResult* pCandidate, _Outptr_ PCWSTR* ppValueOut, _Out_ size_t* pLengthOut)
+{
+    *ppValueOut = nullptr;
+    *pLengthOut = 0;
+
+    InlineStringResult value;
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_RESOURCE_TYPE_MISMATCH), !pCandidate->TryGetStringValue(&value));
+
+    if (value.GetType() == DefResultType_Reference)
+    {
+        // Refers to the mapped file or to a string owned by the resource map.
+        *ppValueOut = value.GetRef();
+        *pLengthOut = value.GetLength();
+        return S_OK;
+    }
+
+    DecodedValues values;
+    RETURN_IF_FAILED(GetDecodedValues(pCandidate->GetRawResourceMap(), &values));
+
+    int index = pCandidate->GetValueIndex();
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (index < 0) || (index >= values.numValues));
+
+    PWSTR pDecoded = static_cast<PWSTR>(
+        InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&values.pValues[index]), nullptr, nullptr));
+    if (pDecoded == nullptr)
+    {
+        size_t cchDecoded;
+        RETURN_IF_FAILED(value.ReleaseContents(&pDecoded, &cchDecoded));
+
+        PWSTR pExisting = static_cast<PWSTR>(
+            InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&values.pValues[index]), pDecoded, nullptr));
+        if (pExisting != nullptr)
+        {
+            // Another thread decoded the same value first.
+            Def_Free(pDecoded);
+            pDecoded = pExisting;
+        }
+    }
+
+    *ppValueOut = pDecoded;
+    *pLengthOut = wcslen(pDecoded);
+    return S_OK;
+}
+
+namespace
+{
+
+const UINT32 ResourceNameCacheInitialSlots = 64;
+
+} // namespace
+
+ResourceNameCache::ResourceNameCache() : m_pEntries(nullptr), m_numSlots(0), m_numEntries(0) { _DefInitializeSRWLock(&m_srwLock); }
+
+HRESULT ResourceNameCache::CreateInstance(_Outptr_ ResourceNameCache** result)
+{
+    *result = nullptr;
+
+    AutoDeletePtr<ResourceNameCache> pRtrn = new ResourceNameCache();
+    RETURN_IF_NULL_ALLOC(pRtrn);
+
+    pRtrn->m_pEntries = _DefArray_AllocZeroed(Entry, ResourceNameCacheInitialSlots);
+    RETURN_IF_NULL_ALLOC(pRtrn->m_pEntries);
+    pRtrn->m_numSlots = ResourceNameCacheInitialSlots;
+
+    *result = pRtrn.Detach();
+    return S_OK;
+}
+
+ResourceNameCache::~ResourceNameCache()
+{
+    if (m_pEntries != nullptr)
+    {
+        for (UINT32 i = 0; i < m_numSlots; i++)
+        {
+            if (m_pEntries[i].pName != nullptr)
+            {
+                Def_Free(m_pEntries[i].pName);
+            }
+        }
+        Def_Free(m_pEntries);
+        m_pEntries = nullptr;
+    }
+}
+
+// Caller holds m_srwLock.
+bool ResourceNameCache::TryFind(
+    _In_ const IResourceMapBase* pMap,
+    _In_ int scopeIndex,
+    _In_ PCWSTR pName,
+    _In_ UINT32 hash,
+    _Out_ int* pResourceIndexOut) const
+{
+    *pResourceIndexOut = -1;
+
+    UINT32 mask = m_numSlots - 1;
+    for (UINT32 slot = hash & mask; m_pEntries[slot].pName != nullptr; slot = (slot + 1) & mask)
+    {
+        const Entry& entry = m_pEntries[slot];
+        if ((entry.hash != hash) || (entry.pMap != pMap) || (entry.scopeIndex != scopeIndex))
+        {
+            continue;
+        }
+
+        // Stored names are already folded; names are compared case-insensitively and either path
+        // separator matches the other.
+        size_t i = 0;
+        while ((pName[i] != L'\0') && (entry.pName[i] == DefString_FoldPathChar(pName[i])))
+        {
+            i++;
+        }
+
+        if ((pName[i] == L'\0') && (entry.pName[i] == L'\0'))
+        {
+            *pResourceIndexOut = entry.resourceIndex;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Caller holds m_srwLock exclusively.
+HRESULT ResourceNameCache::Add(
+    _In_ const IResourceMapBase* pMap,
+    _In_ int scopeIndex,
+    _In_reads_(cchName) PCWSTR pName,
+    _In_ size_t cchName,
+    _In_ UINT32 hash,
+    _In_ int resourceIndex)
+{
+    if (static_cast<UINT32>(m_numEntries + 1) * 2 > m_numSlots)
+    {
+        // Keep the table at most half full so probe sequences stay short.
+        UINT32 numSlots = m_numSlots * 2;
+        Entry* pEntries = _DefArray_AllocZeroed(Entry, numSlots);
+        RETURN_IF_NULL_ALLOC(pEntries);
+
+        for (UINT32 i = 0; i < m_numSlots; i++)
+        {
+            if (m_pEntries[i].pName != nullptr)
+            {
+                UINT32 slot = m_pEntries[i].hash & (numSlots - 1);
+                while (pEntries[slot].pName != nullptr)
+                {
+                    slot = (slot + 1) & (numSlots - 1);
+                }
+                pEntries[slot] = m_pEntries[i];
+            }
+        }
+
+        Def_Free(m_pEntries);
+        m_pEntries = pEntries;
+        m_numSlots = numSlots;
+    }
+
+    PWSTR pFolded = _DefArray_AllocZeroed(WCHAR, cchName + 1);
+    RETURN_IF_NULL_ALLOC(pFolded);
+    for (size_t i = 0; i < cchName; i++)
+    {
+        pFolded[i] = DefString_FoldPathChar(pName[i]);
+    }
+
+    UINT32 slot = hash & (m_numSlots - 1);
+    while (m_pEntries[slot].pName != nullptr)
+    {
+        slot = (slot + 1) & (m_numSlots - 1);
+    }
+
+    m_pEntries[slot].pMap = pMap;
+    m_pEntries[slot].pName = pFolded;
+    m_pEntries[slot].hash = hash;
+    m_pEntries[slot].scopeIndex = scopeIndex;
+    m_pEntries[slot].resourceIndex = resourceIndex;
+    m_numEntries++;
+    return S_OK;
+}
+
+HRESULT
+ResourceNameCache::GetResource(_In_ const ResourceMapSubtree* pSubtree, _In_ PCWSTR pName, _Inout_ NamedResourceResult* pResourceOut)
+{
+    RETURN_HR_IF_EXPECTED(E_INVALIDARG, (pName == nullptr) || (*pName == 0));
+
+    const IResourceMapBase* pMap = pSubtree->GetFullResourceMap();
+    int scopeIndex = pSubtree->GetSubtreeRootIndex();
+
+    size_t cchName;
+    UINT32 hash = DefString_ComputeFoldedPathHash(pName, &cchName);
+    int resourceIndex;
+
+    {
+        AutoReaderWriterLock autoLock(&m_srwLock, true);
+        if (TryFind(pMap, scopeIndex, pName, hash, &resourceIndex))
+        {
+            return pMap->GetResourceByIndex(resourceIndex, pResourceOut);
+        }
+    }
+
+    RETURN_IF_FAILED_WITH_EXPECTED(pSubtree->GetResource(pName, pResourceOut), HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND));
+
+    AutoReaderWriterLock autoLock(&m_srwLock);
+
+    // Another thread might have added the name while we were looking it up.
+    if (!TryFind(pMap, scopeIndex, pName, hash, &resourceIndex))
+    {
+        // Failure just means the name is looked up again next time.
+        (void)Add(pMap, scopeIndex, pName, cchName, hash, pResourceOut->GetResourceIndexInSchema());
+    }
+
+    return S_OK;
+}
+
 HRESULT ResourceCandidateResult::GetQualifiers(_Inout_ QualifierSetResult* pQualifiersOut) const
 {
     RETURN_HR_IF_NULL(E_DEF_NOT_READY, m_pRawMap);
@@ -993,7 +1283,7 @@ PCWSTR ResourceMapSubtree::GetFullScopeName() const { return m_strResMapFullScop
 
 int ResourceMapSubtree::GetNumChildren() const
 {
-    StringResult name;
+    InlineStringResult name;
     int numChildren = 0;
 
     if (m_pSchema->TryGetScopeInfo(m_scopeIndex, &name, &numChildren))
@@ -6,6 +6,17 @@
 namespace Microsoft::Resources
 {
 
+namespace
+{
+
+// HierarchicalNames::Contains ignores a single leading separator, so the path index does too.
+inline PCWSTR SkipLeadingSeparator(_In_ PCWSTR pPath) { return ((pPath[0] == L'/') || (pPath[0] == L'\\')) ? pPath + 1 : pPath; }
+
+const UINT32 PathIndexMinSlots = 16;
+const size_t PathIndexInitialCchPerPath = 32;
+
+} // namespace
+
 HRESULT ReverseFileMap::Init(__in_opt const IFileSection* pSection, __in_bcount(cbData) const void* pData, __in int cbData)
 {
     RETURN_IF_FAILED(FileSectionBase::Init(pSection, pData, cbData));
@@ -66,17 +77,186 @@ HRESULT ReverseFileMap::CreateInstance(__in_bcount(cbData) const void* pData, __
     return S_OK;
 }
 
-ReverseFileMap::ReverseFileMap() : m_pHeader(NULL), m_pEntries(NULL), m_pNames(NULL) {}
+ReverseFileMap::ReverseFileMap() :
+    m_pHeader(NULL),
+    m_pEntries(NULL),
+    m_pNames(NULL),
+    m_pathIndexState(PathIndexNotBuilt),
+    m_pPathIndex(nullptr),
+    m_numPathIndexSlots(0),
+    m_pPathIndexPaths(nullptr)
+{
+    _DefInitializeSRWLock(&m_srwLock);
+}
 
-ReverseFileMap::~ReverseFileMap() { delete m_pNames; }
+ReverseFileMap::~ReverseFileMap()
+{
+    Def_Free(m_pPathIndex);
+    Def_Free(m_pPathIndexPaths);
+    delete m_pNames;
+}
 
 const DEFFILE_SECTION_TYPEID ReverseFileMap::GetSectionTypeId() { return gReverseFileMapSectionType; }
 
 bool ReverseFileMap::TryGetReverseMapCandidateIndex(__in PCWSTR pCandidateValue, __out int* pReverseMapIndexOut) const
 {
-    int scopeIndexOut;
-    int nameIndexOut;
-    return m_pNames->Contains(pCandidateValue, &scopeIndexOut, pReverseMapIndexOut, &nameIndexOut);
+    if (!EnsurePathIndex())
+    {
+        int scopeIndexOut;
+        int nameIndexOut;
+        return m_pNames->Contains(pCandidateValue, &scopeIndexOut, pReverseMapIndexOut, &nameIndexOut);
+    }
+
+    *pReverseMapIndexOut = -1;
+    if (DefString_IsEmpty(pCandidateValue))
+    {
+        return false;
+    }
+
+    // Candidate paths match case-insensitively and either path separator matches the other.
+    PCWSTR pPath = SkipLeadingSeparator(pCandidateValue);
+    UINT32 hash = DefString_ComputeFoldedPathHash(pPath, nullptr);
+    UINT32 mask = m_numPathIndexSlots - 1;
+    for (UINT32 slot = hash & mask; m_pPathIndex[slot].reverseMapIndex >= 0; slot = (slot + 1) & mask)
+    {
+        const PathIndexEntry& entry = m_pPathIndex[slot];
+        if (entry.hash != hash)
+        {
+            continue;
+        }
+
+        // Stored paths are already folded.
+        PCWSTR pStored = &m_pPathIndexPaths[entry.pathOffset];
+        size_t i = 0;
+        while ((pPath[i] != L'\0') && (pStored[i] == DefString_FoldPathChar(pPath[i])))
+        {
+            i++;
+        }
+
+        if ((pPath[i] == L'\0') && (pStored[i] == L'\0'))
+        {
+            *pReverseMapIndexOut = entry.reverseMapIndex;
+            return true;
+        }
+    }
+
+    // HierarchicalNames compares stored ASCII names with towupper, which doesn't agree with the index
+    // fold on every non-ASCII character, so let it confirm a miss on a non-ASCII path.
+    for (PCWSTR pStr = pPath; *pStr != L'\0'; pStr++)
+    {
+        if (*pStr >= 0x80)
+        {
+            int scopeIndexOut;
+            int nameIndexOut;
+            return m_pNames->Contains(pCandidateValue, &scopeIndexOut, pReverseMapIndexOut, &nameIndexOut);
+        }
+    }
+
+    return false;
+}
+
+bool ReverseFileMap::EnsurePathIndex() const
+{
+    {
+        AutoReaderWriterLock autoLock(&m_srwLock, true);
+        if (m_pathIndexState != PathIndexNotBuilt)
+        {
+            return (m_pathIndexState == PathIndexBuilt);
+        }
+    }
+
+    AutoReaderWriterLock autoLock(&m_srwLock);
+    if (m_pathIndexState == PathIndexNotBuilt)
+    {
+        // If the index can't be built we keep walking the names one segment at a time.
+        m_pathIndexState = SUCCEEDED(BuildPathIndex()) ? PathIndexBuilt : PathIndexUnavailable;
+    }
+    return (m_pathIndexState == PathIndexBuilt);
+}
+
+// Caller holds m_srwLock exclusively.
+HRESULT ReverseFileMap::BuildPathIndex() const
+{
+    // The reverse map index of a candidate is the index of its path among the item names. Every item is
+    // indexed, so the index answers exactly what HierarchicalNames::Contains would; GetCandidateInfo
+    // range checks the result as before.
+    int numPaths = m_pNames->GetNumItems();
+
+    // Keep the table at most half full so probe sequences stay short.
+    UINT32 numSlots = PathIndexMinSlots;
+    while (numSlots < static_cast<UINT32>(numPaths) * 2)
+    {
+        numSlots <<= 1;
+    }
+
+    PathIndexEntry* pIndex = _DefArray_Alloc(PathIndexEntry, numSlots);
+    RETURN_IF_NULL_ALLOC(pIndex);
+    for (UINT32 slot = 0; slot < numSlots; slot++)
+    {
+        pIndex[slot].reverseMapIndex = -1;
+    }
+
+    size_t cchPathsMax = (numPaths + 1) * PathIndexInitialCchPerPath;
+    size_t cchPaths = 0;
+    PWSTR pPaths = _DefArray_Alloc(WCHAR, cchPathsMax);
+    if (pPaths == nullptr)
+    {
+        Def_Free(pIndex);
+        return E_OUTOFMEMORY;
+    }
+
+    HRESULT hr = S_OK;
+    StringResult path;
+    for (int i = 0; i < numPaths; i++)
+    {
+        if (!m_pNames->TryGetItemInfo(i, &path))
+        {
+            hr = HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
+            break;
+        }
+
+        PCWSTR pPath = SkipLeadingSeparator(path.GetRef());
+        size_t cchPath = wcslen(pPath) + 1;
+        if (cchPaths + cchPath > cchPathsMax)
+        {
+            size_t cchNewMax = max(cchPathsMax * 2, cchPaths + cchPath);
+            if (!_DefArray_TryEnsureSize(&pPaths, WCHAR, cchPathsMax, cchNewMax))
+            {
+                hr = E_OUTOFMEMORY;
+                break;
+            }
+            cchPathsMax = cchNewMax;
+        }
+
+        for (size_t ich = 0; ich < cchPath; ich++)
+        {
+            pPaths[cchPaths + ich] = DefString_FoldPathChar(pPath[ich]);
+        }
+
+        UINT32 hash = DefString_ComputeFoldedPathHash(&pPaths[cchPaths], nullptr);
+        UINT32 slot = hash & (numSlots - 1);
+        while (pIndex[slot].reverseMapIndex >= 0)
+        {
+            slot = (slot + 1) & (numSlots - 1);
+        }
+
+        pIndex[slot].hash = hash;
+        pIndex[slot].reverseMapIndex = i;
+        pIndex[slot].pathOffset = static_cast<UINT32>(cchPaths);
+        cchPaths += cchPath;
+    }
+
+    if (FAILED(hr))
+    {
+        Def_Free(pIndex);
+        Def_Free(pPaths);
+        return hr;
+    }
+
+    m_pPathIndex = pIndex;
+    m_numPathIndexSlots = numSlots;
+    m_pPathIndexPaths = pPaths;
+    return S_OK;
 }
 
 HRESULT
@@ -162,6 +162,28 @@ public:
         return S_OK;
     }
 
+    HRESULT
+    EvaluateCompiledList(_In_ const IQualifier* pQualifier, _In_ const CompiledList& contextList, _Out_ double* score) const override
+    {
+        *score = 0.0;
+
+        if (contextList.pList[0] != L'\0')
+        {
+            StringResult qualifierValue;
+            RETURN_IF_FAILED(ValidateQualifier(pQualifier));
+            RETURN_IF_FAILED(pQualifier->GetOperand2Literal(&qualifierValue));
+
+            // The BCP-47 distance takes the whole list, so only the base method uses the split values.
+            (void)_DefGetDistanceOfClosestLanguageInList(qualifierValue.GetRef(), contextList.pList, L';', score);
+            if (*score < 0.0)
+            {
+                RETURN_IF_FAILED(QualifierTypeBase::EvaluateCompiledList(pQualifier, contextList, score));
+            }
+        }
+
+        return S_OK;
+    }
+
     int GetMaxQualifierEntries() const override { return 256; }
 
 protected:
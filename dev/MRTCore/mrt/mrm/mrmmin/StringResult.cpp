@@ -96,6 +96,12 @@ _Use_decl_annotations_ HRESULT StringResult::Init(DEFSTRINGRESULT* pString)
 
 StringResult::~StringResult(void) { DefStringResult_Clear(&m_string, TRUE); }
 
+InlineStringResult::InlineStringResult()
+{
+    // Cannot fail: m_string is empty and the buffer is valid.
+    (void)DefStringResult_SetInlineBuffer(m_pString, m_inlineBuffer, ARRAYSIZE(m_inlineBuffer));
+}
+
 _Use_decl_annotations_ HRESULT StringResult::SetRef(PCWSTR pStr) { return DefStringResult_SetRef(m_pString, pStr); }
 _Use_decl_annotations_ HRESULT StringResult::SetCopy(PCWSTR pStr) { return DefStringResult_SetCopy(m_pString, pStr); }
 _Use_decl_annotations_ HRESULT StringResult::SetContents(PWSTR pBuffer, size_t cchBuffer)
@@ -340,14 +346,21 @@ GetStringResultFromBlobResult(BlobResult* pBlobResult, DEFSTRING_ENCODING blobEn
 
         if (blobEncoding == DEFSTRING_ENCODING_UTF8)
         {
-            RETURN_IF_FAILED(DefString_ConvertUtf8ToUtf16(reinterpret_cast<PCSTR>(pBlob), cbBlob, &cchResultString, &pszResultString));
-        }
-        else
-        {
-            cchResultString = cbBlob;
-            RETURN_IF_FAILED(DefString_ConvertAsciiToUtf16(reinterpret_cast<PCSTR>(pBlob), cbBlob, &pszResultString));
+            // Convert straight into the result's own buffer, which needs no allocation for a short
+            // string when the result has inline storage.
+            PCSTR pszBlob = reinterpret_cast<PCSTR>(pBlob);
+            int cchNeeded = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, pszBlob, static_cast<int>(cbBlob), nullptr, 0);
+            RETURN_LAST_ERROR_IF(cchNeeded == 0);
+
+            RETURN_IF_FAILED(pStringResult->SetEmptyContents(cchNeeded, &pszResultString, &cchResultString));
+            RETURN_LAST_ERROR_IF(
+                MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, pszBlob, static_cast<int>(cbBlob), pszResultString, cchNeeded) == 0);
+            return S_OK;
         }
 
+        cchResultString = cbBlob;
+        RETURN_IF_FAILED(DefString_ConvertAsciiToUtf16(reinterpret_cast<PCSTR>(pBlob), cbBlob, &pszResultString));
+
 #pragma prefast(suppress : 26035, "Caller has to ensure that blob is NULL terminated")
         HRESULT hr = pStringResult->SetContents(pszResultString, cchResultString);
         if (FAILED(hr))
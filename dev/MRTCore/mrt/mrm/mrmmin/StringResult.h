@@ -15,6 +15,14 @@ HRESULT DefStringResult_InitRef(_Inout_ DEFSTRINGRESULT* pSelf, _In_opt_ PCWSTR
 
 HRESULT DefStringResult_InitBuf(_Inout_ DEFSTRINGRESULT* pSelf, _In_opt_ PCWSTR pInitStr);
 
+/*! Supplies small-string storage owned by the caller
+ *
+ * Contents that fit in the inline buffer are stored there instead of in a
+ * heap buffer.  The inline buffer is never freed and must outlive pSelf;
+ * DefStringResult_ReleaseContents() hands out a heap copy of it.
+ */
+HRESULT DefStringResult_SetInlineBuffer(_Inout_ DEFSTRINGRESULT* pSelf, _Inout_updates_(cchInlineBuf) PWSTR pInlineBuf, _In_ size_t cchInlineBuf);
+
 // Returns a read-only ref to the result's contents.
 HRESULT DefStringResult_GetRef(_In_ const DEFSTRINGRESULT* pSelf, _Out_ PCWSTR* ref);
 
@@ -20,6 +20,50 @@ void* _Def_Inspect(__in void* pSelf, __in PCWSTR typeStr, Def_DescribeCallback d
     return pSelf;
 }
 
+// Returns the inline buffer if it is free and big enough, otherwise a new heap buffer.
+static PWSTR _DefStringResult_AllocBuffer(_In_ const DEFSTRINGRESULT* pSelf, _In_ size_t cchMinBufferSize, _Out_ size_t* pcchBufferOut)
+{
+    if ((pSelf->pInlineBuf != nullptr) && (pSelf->pBuf != pSelf->pInlineBuf) && (cchMinBufferSize <= pSelf->cchInlineBuf))
+    {
+        *pcchBufferOut = pSelf->cchInlineBuf;
+        return pSelf->pInlineBuf;
+    }
+
+    *pcchBufferOut = cchMinBufferSize;
+    return _DefArray_AllocZeroed(WCHAR, cchMinBufferSize);
+}
+
+static void _DefStringResult_FreeBuffer(_In_ const DEFSTRINGRESULT* pSelf, _In_opt_ PWSTR pBuf)
+{
+    if ((pBuf != nullptr) && (pBuf != pSelf->pInlineBuf))
+    {
+        _DefFree(pBuf);
+    }
+}
+
+// Moves the contents of the inline buffer, if in use, to a heap buffer so that pBuf can leave the container.
+static HRESULT _DefStringResult_DetachInlineBuffer(_Inout_ DEFSTRINGRESULT* pSelf)
+{
+    if ((pSelf->pBuf == nullptr) || (pSelf->pBuf != pSelf->pInlineBuf))
+    {
+        return S_OK;
+    }
+
+    PWSTR pNewBuf = _DefArray_AllocZeroed(WCHAR, pSelf->cchBuf);
+    if (pNewBuf == nullptr)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    CopyMemory(pNewBuf, pSelf->pBuf, pSelf->cchBuf * sizeof(WCHAR));
+    if (pSelf->pRef == pSelf->pBuf)
+    {
+        pSelf->pRef = pNewBuf;
+    }
+    pSelf->pBuf = pNewBuf;
+    return S_OK;
+}
+
 HRESULT _DefStringResult_Alloc(_Outptr_ DEFSTRINGRESULT** result)
 {
     *result = _DefAllocZeroed(DEFSTRINGRESULT);
@@ -110,6 +154,7 @@ static HRESULT _DefStringResult_EnsureEmptyBuffer(_Inout_ DEFSTRINGRESULT* pSelf
 {
     PWCHAR pNewBuf = nullptr;
     PWCHAR pOldBuf = nullptr;
+    size_t cchNewBuf = 0;
 
     if (pSelf == nullptr)
     {
@@ -134,7 +179,7 @@ static HRESULT _DefStringResult_EnsureEmptyBuffer(_Inout_ DEFSTRINGRESULT* pSelf
         pOldBuf = pSelf->pBuf;
     }
 
-    pNewBuf = _DefArray_AllocZeroed(WCHAR, cchMinBufferSize);
+    pNewBuf = _DefStringResult_AllocBuffer(pSelf, cchMinBufferSize, &cchNewBuf);
     if (pNewBuf == nullptr)
     {
         return E_OUTOFMEMORY;
@@ -143,12 +188,9 @@ static HRESULT _DefStringResult_EnsureEmptyBuffer(_Inout_ DEFSTRINGRESULT* pSelf
     pNewBuf[0] = L'\0';
 
     pSelf->pBuf = pNewBuf;
-    pSelf->cchBuf = (UINT32)cchMinBufferSize;
+    pSelf->cchBuf = (UINT32)cchNewBuf;
     pSelf->pRef = pSelf->pBuf;
-    if (pOldBuf)
-    {
-        Def_Free(pOldBuf);
-    }
+    _DefStringResult_FreeBuffer(pSelf, pOldBuf);
 #pragma prefast(suppress : 26045, "_DefArray_AllocZeroed ensures len(pNewBuf) == cchMinBufferSize")
     return S_OK;
 }
@@ -157,6 +199,7 @@ static HRESULT _DefStringResult_EnsureBuffer(_Inout_ DEFSTRINGRESULT* pSelf, _In
 {
     HRESULT hr = S_OK;
     size_t cchCurrent = 0;
+    size_t cchNewBuf = 0;
     PWSTR pOldBuf = nullptr;
     PWSTR pNewBuf = nullptr;
 
@@ -210,7 +253,7 @@ static HRESULT _DefStringResult_EnsureBuffer(_Inout_ DEFSTRINGRESULT* pSelf, _In
         return S_OK;
     }
 
-    pNewBuf = _DefArray_AllocZeroed(WCHAR, cchMinBufferSize);
+    pNewBuf = _DefStringResult_AllocBuffer(pSelf, cchMinBufferSize, &cchNewBuf);
     if (pNewBuf == nullptr)
     {
         return E_OUTOFMEMORY;
@@ -221,22 +264,19 @@ static HRESULT _DefStringResult_EnsureBuffer(_Inout_ DEFSTRINGRESULT* pSelf, _In
     // Copy the previous contents
     if (pSelf->pRef && pSelf->pRef[0])
     {
-        hr = _DefStringCchCopy(pNewBuf, cchMinBufferSize, pSelf->pRef);
+        hr = _DefStringCchCopy(pNewBuf, cchNewBuf, pSelf->pRef);
         if (FAILED(hr))
         {
-            Def_Free(pNewBuf);
+            _DefStringResult_FreeBuffer(pSelf, pNewBuf);
             return hr;
         }
     }
 
     pSelf->pBuf = pNewBuf;
-    pSelf->cchBuf = (UINT32)cchMinBufferSize;
+    pSelf->cchBuf = (UINT32)cchNewBuf;
     pSelf->pRef = pNewBuf;
 
-    if (pOldBuf)
-    {
-        Def_Free(pOldBuf);
-    }
+    _DefStringResult_FreeBuffer(pSelf, pOldBuf);
 #pragma prefast(suppress : 26045, "_DefArray_AllocZeroed ensures len(pNewBuf) == cchMinBufferSize")
     return S_OK;
 }
@@ -251,6 +291,8 @@ static HRESULT _DefStringResult_InitEmpty(_Inout_ DEFSTRINGRESULT* pSelf, _In_ s
     }
 
     pSelf->pRef = nullptr;
+    pSelf->pInlineBuf = nullptr;
+    pSelf->cchInlineBuf = 0;
 
     // Empty
     if (cchBuf == 0)
@@ -261,7 +303,7 @@ static HRESULT _DefStringResult_InitEmpty(_Inout_ DEFSTRINGRESULT* pSelf, _In_ s
     }
 
     // Not Empty
-    pTempStr = _DefArray_AllocZeroed(wchar_t, cchBuf);
+    pTempStr = _DefArray_AllocZeroed(WCHAR, cchBuf);
     if (pTempStr == nullptr)
     {
         return E_OUTOFMEMORY;
@@ -301,6 +343,9 @@ DefStringResult_InitBuf(_Inout_ DEFSTRINGRESULT* pSelf, _In_opt_ PCWSTR pInitStr
         return E_INVALIDARG;
     }
 
+    pSelf->pInlineBuf = nullptr;
+    pSelf->cchInlineBuf = 0;
+
     if (pInitStr == nullptr)
     {
         _DefStringResult_InitEmpty(pSelf, 0);
@@ -323,7 +368,7 @@ DefStringResult_InitBuf(_Inout_ DEFSTRINGRESULT* pSelf, _In_opt_ PCWSTR pInitStr
         else
         {
             // Alloc new buffer
-            PWSTR pNewBuf = _DefArray_AllocZeroed(wchar_t, cchInitStr);
+            PWSTR pNewBuf = _DefArray_AllocZeroed(WCHAR, cchInitStr);
             if (pNewBuf == nullptr)
             {
                 return E_OUTOFMEMORY;
@@ -346,6 +391,29 @@ DefStringResult_InitBuf(_Inout_ DEFSTRINGRESULT* pSelf, _In_opt_ PCWSTR pInitStr
     return S_OK;
 }
 
+HRESULT
+DefStringResult_SetInlineBuffer(_Inout_ DEFSTRINGRESULT* pSelf, _Inout_updates_(cchInlineBuf) PWSTR pInlineBuf, _In_ size_t cchInlineBuf)
+{
+    CHECK_DEFSTRING(pSelf);
+
+    if ((pInlineBuf == nullptr) || (cchInlineBuf == 0) || (cchInlineBuf > DEFRESULT_MAX))
+    {
+        return E_INVALIDARG;
+    }
+
+    // Contents held in a previous inline buffer must not outlive it.
+    HRESULT hr = _DefStringResult_DetachInlineBuffer(pSelf);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pInlineBuf[0] = L'\0';
+    pSelf->pInlineBuf = pInlineBuf;
+    pSelf->cchInlineBuf = (UINT32)cchInlineBuf;
+    return S_OK;
+}
+
 HRESULT
 DefStringResult_GetCopy(_In_ const DEFSTRINGRESULT* pSelf, _Inout_ DEFSTRINGRESULT* pStringOut)
 {
@@ -692,10 +760,20 @@ DefStringResult_ReleaseContents(
         return E_INVALIDARG;
     }
 
+    // The caller takes ownership, so contents held in the inline buffer are handed out as a heap copy.
+    HRESULT hr = _DefStringResult_DetachInlineBuffer(pSelf);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
     *ppBufferOut = pSelf->pBuf;
     *pcchBufferOut = pSelf->cchBuf;
 
-    return _DefStringResult_InitEmpty(pSelf, 0);
+    pSelf->pBuf = nullptr;
+    pSelf->cchBuf = 0;
+    pSelf->pRef = nullptr;
+    return S_OK;
 }
 
 HRESULT
@@ -740,6 +818,17 @@ _DefStringResult_Swap(_Inout_ DEFSTRINGRESULT* pSelf, _Inout_ DEFSTRINGRESULT* p
         return S_OK;
     }
 
+    // Inline buffers stay with their containers.
+    HRESULT hr = _DefStringResult_DetachInlineBuffer(pSelf);
+    if (SUCCEEDED(hr))
+    {
+        hr = _DefStringResult_DetachInlineBuffer(pOther);
+    }
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
     DEFSTRINGRESULT temp;
 
     temp.cchBuf = pSelf->cchBuf;
@@ -976,7 +1065,7 @@ DefStringResult_Clear(_Inout_ DEFSTRINGRESULT* pSelf, _In_ __BOOL releaseBuffer)
     pSelf->pRef = nullptr;
     if (pSelf->pBuf && releaseBuffer)
     {
-        _DefFree(pSelf->pBuf);
+        _DefStringResult_FreeBuffer(pSelf, pSelf->pBuf);
         pSelf->pBuf = nullptr;
         pSelf->cchBuf = 0;
     }
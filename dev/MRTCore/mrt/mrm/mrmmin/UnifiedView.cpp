@@ -120,6 +120,12 @@ public:
     {
         // Add referenced file in the FileList Section to the Managed file that needs to handle the fileIndex based
         // section retrieval from ResourceMap during runtime.
+        // In lazy section load mode the MrmFile does this itself the first time a fileIndex is resolved.
+        if (m_pView->IsLazySectionLoadEnabled())
+        {
+            return S_OK;
+        }
+
         PriFile* pPriFile;
         RETURN_IF_FAILED(GetPri(&pPriFile));
         RETURN_HR_IF_NULL(HRESULT_FROM_WIN32(ERROR_NOT_FOUND), pPriFile);
@@ -147,6 +147,50 @@ DefString_IsSuffixWithOptions(__in PCWSTR pSuffix, __in PCWSTR pString, __in DEF
     return (Def_Equal == DefString_CompareWithOptions(pSuffix, pString, options));
 }
 
+WCHAR DefString_FoldNonAsciiChar(_In_ WCHAR ch)
+{
+    // Without LCMAP_LINGUISTIC_CASING, LCMapStringEx upper-cases with the same file system casing
+    // table CompareStringOrdinal uses to ignore case, one code unit at a time.
+    WCHAR folded;
+    if (LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_UPPERCASE, &ch, 1, &folded, 1, NULL, NULL, 0) != 1)
+    {
+        folded = ch;
+    }
+    return folded;
+}
+
+UINT32 DefString_ComputeFoldedHash(_In_ PCWSTR pString, _Out_opt_ size_t* pcchString)
+{
+    UINT32 hash = DEFSTRING_FOLDED_HASH_SEED;
+    PCWSTR pStr = pString;
+    for (; *pStr != L'\0'; pStr++)
+    {
+        hash = DefString_HashFoldedChar(hash, *pStr);
+    }
+
+    if (pcchString != NULL)
+    {
+        *pcchString = static_cast<size_t>(pStr - pString);
+    }
+    return hash;
+}
+
+UINT32 DefString_ComputeFoldedPathHash(_In_ PCWSTR pString, _Out_opt_ size_t* pcchString)
+{
+    UINT32 hash = DEFSTRING_FOLDED_HASH_SEED;
+    PCWSTR pStr = pString;
+    for (; *pStr != L'\0'; pStr++)
+    {
+        hash = (hash ^ DefString_FoldPathChar(*pStr)) * 16777619;
+    }
+
+    if (pcchString != NULL)
+    {
+        *pcchString = static_cast<size_t>(pStr - pString);
+    }
+    return hash;
+}
+
 #define ASCII_BOUNDARY 0x7F
 
 #define UTF8_ONE_BYTE_BOUNDARY 0x7F